@@ -0,0 +1,459 @@
+﻿///
+/// ベンチマーククラスの実装
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 18, 2026
+///
+#include "Benchmark.h"
+
+// 標準ライブラリ
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+//
+// JSON の配列から数値のベクトルを取り出す
+//
+template <typename T>
+static bool getNumbers(const picojson::object& object, const std::string& key, std::vector<T>& numbers)
+{
+  // key に一致するオブジェクトを探す
+  const auto&& value{ object.find(key) };
+
+  // オブジェクトが無いか配列でなかったら戻る
+  if (value == object.end() || !value->second.is<picojson::array>()) return false;
+
+  // 配列の数値の要素を格納する
+  numbers.clear();
+  for (const auto& element : value->second.get<picojson::array>())
+    if (element.is<double>()) numbers.emplace_back(static_cast<T>(element.get<double>()));
+
+  return true;
+}
+
+//
+// JSON の配列に数値のベクトルを設定する
+//
+template <typename T>
+static void setNumbers(picojson::object& object, const std::string& key, const std::vector<T>& numbers)
+{
+  picojson::array array;
+  for (const auto number : numbers) array.emplace_back(static_cast<double>(number));
+  object.emplace(key, array);
+}
+
+//
+// 描画モードの名前
+//
+static const char* getModeName(Menu::DrawMode mode)
+{
+  return mode == Menu::DRAW_MIRROR ? "mirror" : "receiver";
+}
+
+//
+// コンストラクタ
+//
+Benchmark::Benchmark(const std::string& filename) :
+  output{ "makyoh_benchmark_result.json" },
+  heightMaps{ "height_map_128.png", "height_map_256.png", "height_map_512.png" },
+  procedural{ 1024, 2048, 4096 },
+  samples{ 16, 64, 256 },
+  resolutions{ { 1280, 720 }, { 1920, 1080 } },
+  modes{ Menu::DRAW_MIRROR, Menu::DRAW_RECEIVER },
+  warmup{ 30 },
+  frames{ 120 },
+  path
+  {
+    Key{ { 0.0f, 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f } },
+    Key{ { 0.0f, 1.0f, 0.0f, 0.5f }, { 0.2f, 0.0f, 0.0f } },
+    Key{ { 1.0f, 0.0f, 0.0f, 0.3f }, { 0.0f, 0.1f, 0.5f } },
+    Key{ { 0.0f, 1.0f, 0.0f, -0.5f }, { -0.2f, 0.0f, 0.0f } }
+  },
+  current{ 0 },
+  frame{ 0 },
+  fboSize{ 0, 0 }
+{
+  // 仕様ファイルが読み込めなかったらデフォルト値の仕様ファイルを作る
+  if (!load(filename)) save(filename);
+
+  // 計測するフレームの前に少なくとも条件を切り替えるフレームは捨てる
+  warmup = std::max(warmup, 1);
+  frames = std::max(frames, 1);
+
+  // 手続き的に生成する高さマップは一時ディレクトリに保存して画像ファイルと同じように読み込む
+  auto maps{ heightMaps };
+  for (const auto size : procedural)
+  {
+    std::error_code error;
+    const auto directory{ std::filesystem::temp_directory_path(error) };
+    if (error || size <= 0) continue;
+    const auto name{ (directory / ("makyoh_procedural_" + std::to_string(size) + ".tga")).u8string() };
+    if (std::filesystem::exists(std::filesystem::u8path(name), error) || generate(size, name)) maps.emplace_back(name);
+  }
+
+  // 高さマップの読み込みがなるべく少なくなる順にすべての組み合わせを並べる
+  for (const auto& heightMap : maps)
+  {
+    for (const auto& resolution : resolutions)
+    {
+      for (const auto mode : modes)
+      {
+        // 鏡だけを描くときは標本点数を使わないので最初の標本点数だけを計測する
+        for (const auto count : samples)
+        {
+          cases.emplace_back(Case{ heightMap, count, resolution, mode });
+          if (mode == Menu::DRAW_MIRROR) break;
+        }
+      }
+    }
+  }
+}
+
+//
+// デストラクタ
+//
+Benchmark::~Benchmark()
+{
+}
+
+//
+// 仕様ファイルを読み込む
+//
+bool Benchmark::load(const std::string& filename)
+{
+  // 仕様ファイルを開く
+  std::ifstream file{ Utf8ToTChar(filename) };
+
+  // 開けなかったらエラー
+  if (!file) return false;
+
+  // JSON の読み込み
+  picojson::value value;
+  file >> value;
+  file.close();
+
+  // JSON として読めていなかったらエラー
+  if (!value.is<picojson::object>()) return false;
+
+  // 仕様の取り出し
+  const auto& object{ value.get<picojson::object>() };
+
+  // オブジェクトが空だったらエラー
+  if (object.empty()) return false;
+
+  // 計測結果の書き出し先
+  getString(object, "output", output);
+
+  // 鏡の高さマップ
+  if (object.count("height_maps") > 0) heightMaps.clear();
+  getString(object, "height_maps", heightMaps);
+  getNumbers(object, "procedural", procedural);
+
+  // 鏡の標本点数
+  getNumbers(object, "samples", samples);
+  for (auto& count : samples) count = std::clamp(count, 1, MAX_MIRROR_SAMPLES);
+
+  // ウィンドウサイズ
+  const auto&& resolution{ object.find("resolutions") };
+  if (resolution != object.end() && resolution->second.is<picojson::array>())
+  {
+    resolutions.clear();
+    for (const auto& element : resolution->second.get<picojson::array>())
+    {
+      if (!element.is<picojson::array>()) continue;
+      const auto& size{ element.get<picojson::array>() };
+      if (size.size() < 2 || !size[0].is<double>() || !size[1].is<double>()) continue;
+      resolutions.push_back({ static_cast<GLsizei>(size[0].get<double>()), static_cast<GLsizei>(size[1].get<double>()) });
+    }
+  }
+
+  // 描画モード
+  std::vector<std::string> modeNames;
+  if (getString(object, "modes", modeNames))
+  {
+    modes.clear();
+    for (const auto& name : modeNames)
+    {
+      if (name == getModeName(Menu::DRAW_MIRROR)) modes.push_back(Menu::DRAW_MIRROR);
+      else if (name == getModeName(Menu::DRAW_RECEIVER)) modes.push_back(Menu::DRAW_RECEIVER);
+    }
+  }
+
+  // 計測せずに捨てるフレーム数と計測するフレーム数
+  getValue(object, "warmup", warmup);
+  getValue(object, "frames", frames);
+
+  // 視点の経路
+  const auto&& keys{ object.find("path") };
+  if (keys != object.end() && keys->second.is<picojson::array>())
+  {
+    path.clear();
+    for (const auto& element : keys->second.get<picojson::array>())
+    {
+      if (!element.is<picojson::object>()) continue;
+      Key key{ { 0.0f, 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f } };
+      getValue(element.get<picojson::object>(), "rotation", key.rotation);
+      getValue(element.get<picojson::object>(), "translation", key.translation);
+      path.push_back(key);
+    }
+  }
+
+  return true;
+}
+
+//
+// 仕様ファイルを書き出す
+//
+bool Benchmark::save(const std::string& filename) const
+{
+  // 仕様ファイルを開く
+  std::ofstream file{ Utf8ToTChar(filename) };
+
+  // 開けなかったらエラー
+  if (!file) return false;
+
+  // 仕様の書き出しに使うオブジェクト
+  picojson::object object;
+
+  // 計測結果の書き出し先
+  setString(object, "output", output);
+
+  // 鏡の高さマップ
+  setString(object, "height_maps", heightMaps);
+  setNumbers(object, "procedural", procedural);
+
+  // 鏡の標本点数
+  setNumbers(object, "samples", samples);
+
+  // ウィンドウサイズ
+  picojson::array resolutionArray;
+  for (const auto& resolution : resolutions)
+    resolutionArray.emplace_back(picojson::array{ picojson::value(static_cast<double>(resolution[0])),
+      picojson::value(static_cast<double>(resolution[1])) });
+  object.emplace("resolutions", resolutionArray);
+
+  // 描画モード
+  std::vector<std::string> modeNames;
+  for (const auto mode : modes) modeNames.emplace_back(getModeName(mode));
+  setString(object, "modes", modeNames);
+
+  // 計測せずに捨てるフレーム数と計測するフレーム数
+  setValue(object, "warmup", warmup);
+  setValue(object, "frames", frames);
+
+  // 視点の経路
+  picojson::array keyArray;
+  for (const auto& key : path)
+  {
+    picojson::object element;
+    setValue(element, "rotation", key.rotation);
+    setValue(element, "translation", key.translation);
+    keyArray.emplace_back(element);
+  }
+  object.emplace("path", keyArray);
+
+  // 仕様をシリアライズして JSON で保存
+  picojson::value v{ object };
+  file << v.serialize(true);
+  file.close();
+
+  return true;
+}
+
+//
+// 手続き的に鏡の高さマップを生成して画像ファイルに保存する
+//
+bool Benchmark::generate(int size, const std::string& filename)
+{
+  // 同じ大きさなら毎回同じ高さマップになるように乱数の種を固定する
+  std::mt19937 random{ static_cast<std::mt19937::result_type>(size) };
+  std::uniform_real_distribution<float> uniform{ 0.0f, 1.0f };
+
+  // 向きと周波数と位相が乱数の正弦波を重ねる
+  constexpr int waves{ 12 };
+  constexpr auto pi{ 3.14159265358979f };
+
+  // sin(ax + by + c) = sin(ax) cos(by + c) + cos(ax) sin(by + c) なので行と列の値を先に求めておく
+  std::vector<std::array<float, 2>> column(static_cast<std::size_t>(size) * waves);
+  std::vector<std::array<float, 2>> row(static_cast<std::size_t>(size) * waves);
+  std::array<float, waves> amplitude;
+  for (int k = 0; k < waves; ++k)
+  {
+    const auto frequency{ 1.0f + 31.0f * uniform(random) * uniform(random) };
+    const auto direction{ 2.0f * pi * uniform(random) };
+    const auto phase{ 2.0f * pi * uniform(random) };
+    const auto a{ 2.0f * pi * frequency * std::cos(direction) / static_cast<float>(size) };
+    const auto b{ 2.0f * pi * frequency * std::sin(direction) / static_cast<float>(size) };
+    amplitude[k] = 1.0f / frequency;
+
+    for (int i = 0; i < size; ++i)
+    {
+      column[static_cast<std::size_t>(i) * waves + k] = { std::sin(a * i), std::cos(a * i) };
+      row[static_cast<std::size_t>(i) * waves + k] = { std::cos(b * i + phase), std::sin(b * i + phase) };
+    }
+  }
+
+  // 振幅の合計で正規化して 8bit にする
+  float total{ 0.0f };
+  for (const auto a : amplitude) total += a;
+  std::vector<GLubyte> data(static_cast<std::size_t>(size) * size);
+  for (int y = 0; y < size; ++y)
+  {
+    for (int x = 0; x < size; ++x)
+    {
+      float h{ 0.0f };
+      for (int k = 0; k < waves; ++k)
+      {
+        const auto& c{ column[static_cast<std::size_t>(x) * waves + k] };
+        const auto& r{ row[static_cast<std::size_t>(y) * waves + k] };
+        h += amplitude[k] * (c[0] * r[0] + c[1] * r[1]);
+      }
+      data[static_cast<std::size_t>(y) * size + x] = static_cast<GLubyte>(std::lround((h / total * 0.5f + 0.5f) * 255.0f));
+    }
+  }
+
+  return ggSaveTga(filename, data.data(), size, size, 1);
+}
+
+//
+// 計測している組み合わせの結果をまとめて次の組み合わせに進む
+//
+void Benchmark::next(const std::string& error)
+{
+  const auto& c{ cases[current] };
+
+  // 組み合わせの条件
+  picojson::object result;
+  setString(result, "height_map", c.heightMap);
+  setString(result, "mode", getModeName(c.mode));
+  setValue(result, "samples", c.samples);
+  setValue(result, "resolution", c.resolution);
+
+  // 設定できなかったらその理由だけを残す
+  if (!error.empty())
+  {
+    setString(result, "error", error);
+  }
+  else
+  {
+    // 実際に描画したフレームバッファのサイズと計測したフレーム数
+    setValue(result, "framebuffer", fboSize);
+    setValue(result, "frames", records.size());
+
+    // 処理ごとの統計
+    picojson::object passes;
+    for (int pass = 0; pass < FrameTimer::PASSES; ++pass)
+    {
+      // 計測できたフレームの処理時間を集める
+      std::vector<GLfloat> times;
+      for (const auto& record : records) if (record[pass] >= 0.0f) times.push_back(record[pass]);
+      if (times.empty()) continue;
+      std::sort(times.begin(), times.end());
+
+      // 最近傍順位法によるパーセンタイル値
+      const auto percentile{ [&times](double p)
+      {
+        const auto rank{ static_cast<std::size_t>(std::ceil(p * static_cast<double>(times.size()))) };
+        return times[std::clamp(rank, static_cast<std::size_t>(1), times.size()) - 1];
+      } };
+
+      picojson::object statistics;
+      setValue(statistics, "median", percentile(0.50));
+      setValue(statistics, "p95", percentile(0.95));
+      setValue(statistics, "p99", percentile(0.99));
+      passes.emplace(FrameTimer::getName(static_cast<FrameTimer::Pass>(pass)), statistics);
+    }
+    result.emplace("passes", passes);
+  }
+  results.emplace_back(result);
+
+  // 次の組み合わせに進む
+  records.clear();
+  frame = 0;
+  ++current;
+}
+
+//
+// 視点の経路に沿ったシーン全体の変換行列を得る
+//
+GgMatrix Benchmark::getModelView() const
+{
+  // キーフレームが無ければ動かさない
+  if (path.empty()) return ggIdentity();
+
+  // 計測するフレームの最初に経路の始点に来るようにして計測するフレーム数で一周する
+  const auto n{ static_cast<int>(path.size()) };
+  const auto position{ ((frame - warmup) % frames + frames) % frames };
+  const auto t{ static_cast<GLfloat>(position) * static_cast<GLfloat>(n) / static_cast<GLfloat>(frames) };
+  const auto i{ std::min(static_cast<int>(t), n - 1) };
+  const auto u{ t - static_cast<GLfloat>(i) };
+  const auto& a{ path[i] };
+  const auto& b{ path[(i + 1) % n] };
+
+  // 回転は球面線形補間し平行移動量は線形補間する
+  const auto q{ ggSlerp(ggRotateQuaternion(a.rotation.data()), ggRotateQuaternion(b.rotation.data()), u) };
+  const auto x{ a.translation[0] + (b.translation[0] - a.translation[0]) * u };
+  const auto y{ a.translation[1] + (b.translation[1] - a.translation[1]) * u };
+  const auto z{ a.translation[2] + (b.translation[2] - a.translation[2]) * u };
+
+  return ggTranslate(x, y, z) * q.getMatrix();
+}
+
+//
+// フレームの処理時間を記録する
+//
+void Benchmark::record(const FrameTimer& timer, GLsizei width, GLsizei height)
+{
+  // すべての組み合わせを計測し終えていたら何もしない
+  if (!*this) return;
+
+  // 一つ前のフレームが計測するフレームならその記録を取り出す
+  const auto count{ timer.getCount() };
+  if (frame > warmup && count >= 2)
+  {
+    std::array<GLfloat, FrameTimer::PASSES> record;
+    for (int pass = 0; pass < FrameTimer::PASSES; ++pass)
+      record[pass] = timer.get(static_cast<FrameTimer::Pass>(pass), count - 2);
+    records.push_back(record);
+  }
+
+  // 実際に描画したフレームバッファのサイズ
+  fboSize = { width, height };
+
+  // 計測する最後のフレームの記録を取り出したら次の組み合わせに進む
+  if (++frame > warmup + frames) next();
+}
+
+//
+// 計測結果を JSON ファイルに書き出す
+//
+bool Benchmark::write() const
+{
+  // 結果のファイルを開く
+  std::ofstream file{ Utf8ToTChar(output) };
+
+  // 開けなかったらエラー
+  if (!file) return false;
+
+  // 計測した環境と条件
+  picojson::object object;
+  const auto* const renderer{ reinterpret_cast<const char*>(glGetString(GL_RENDERER)) };
+  const auto* const version{ reinterpret_cast<const char*>(glGetString(GL_VERSION)) };
+  setString(object, "renderer", renderer ? renderer : "");
+  setString(object, "version", version ? version : "");
+  setValue(object, "warmup", warmup);
+  setValue(object, "frames", frames);
+
+  // 組み合わせごとの結果
+  object.emplace("cases", results);
+
+  // 結果をシリアライズして JSON で保存
+  picojson::value v{ object };
+  file << v.serialize(true);
+  file.close();
+
+  return true;
+}
@@ -0,0 +1,211 @@
+﻿#pragma once
+
+///
+/// ベンチマーククラスの定義
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 18, 2026
+///
+
+// メニューの描画
+#include "Menu.h"
+
+///
+/// ベンチマーク
+///
+/// @note
+/// 仕様ファイルに書かれた高さマップ, 標本点数, 解像度, 描画モードのすべての組み合わせについて,
+/// 決められた視点の経路に沿って描画したときの処理時間を計測して JSON ファイルに書き出す.
+/// 組み合わせごとに最初の何フレームかは計測せずに捨て, 残りのフレームの処理時間の
+/// 中央値, 95 パーセンタイル値, 99 パーセンタイル値を描画パスごとに求める.
+///
+class Benchmark
+{
+public:
+
+  ///
+  /// 計測する条件の組み合わせ
+  ///
+  struct Case
+  {
+    /// 鏡の高さマップのファイル名
+    std::string heightMap;
+
+    /// 鏡の標本点数
+    int samples;
+
+    /// ウィンドウサイズ
+    std::array<GLsizei, 2> resolution;
+
+    /// 描画モード
+    Menu::DrawMode mode;
+  };
+
+private:
+
+  // 視点の経路のキーフレーム
+  struct Key
+  {
+    // 回転 (回転軸と回転角)
+    std::array<GLfloat, 4> rotation;
+
+    // 平行移動量
+    std::array<GLfloat, 3> translation;
+  };
+
+  // 計測結果の書き出し先のファイル名
+  std::string output;
+
+  // 画像ファイルから読み込む鏡の高さマップ
+  std::vector<std::string> heightMaps;
+
+  // 手続き的に生成する鏡の高さマップの一辺の画素数
+  std::vector<int> procedural;
+
+  // 鏡の標本点数
+  std::vector<int> samples;
+
+  // ウィンドウサイズ
+  std::vector<std::array<GLsizei, 2>> resolutions;
+
+  // 描画モード
+  std::vector<Menu::DrawMode> modes;
+
+  // 計測せずに捨てるフレーム数
+  int warmup;
+
+  // 計測するフレーム数
+  int frames;
+
+  // 視点の経路のキーフレーム (計測するフレーム数で一周する)
+  std::vector<Key> path;
+
+  // 計測する条件の組み合わせ
+  std::vector<Case> cases;
+
+  // 計測している組み合わせの番号
+  std::size_t current;
+
+  // 計測している組み合わせで描画したフレーム数
+  int frame;
+
+  // 計測している組み合わせのフレームごとの処理時間
+  std::vector<std::array<GLfloat, FrameTimer::PASSES>> records;
+
+  // 計測している組み合わせで実際に得られたフレームバッファのサイズ
+  std::array<GLsizei, 2> fboSize;
+
+  // 計測を終えた組み合わせの結果
+  picojson::array results;
+
+  // 仕様ファイルを読み込む
+  bool load(const std::string& filename);
+
+  // 仕様ファイルを書き出す
+  bool save(const std::string& filename) const;
+
+  // 手続き的に鏡の高さマップを生成して画像ファイルに保存する
+  static bool generate(int size, const std::string& filename);
+
+  // 計測している組み合わせの結果をまとめて次の組み合わせに進む
+  void next(const std::string& error = "");
+
+public:
+
+  ///
+  /// コンストラクタ
+  ///
+  /// @param filename ベンチマークの仕様ファイル名
+  ///
+  /// @note
+  /// 仕様ファイルが読み込めなければデフォルトの仕様ファイルを作る.
+  ///
+  Benchmark(const std::string& filename);
+
+  ///
+  /// コピーコンストラクタは使用しない
+  ///
+  Benchmark(const Benchmark& benchmark) = delete;
+
+  ///
+  /// デストラクタ
+  ///
+  virtual ~Benchmark();
+
+  ///
+  /// 代入演算子は使用しない
+  ///
+  Benchmark& operator=(const Benchmark& benchmark) = delete;
+
+  ///
+  /// 計測していない組み合わせが残っているかどうか
+  ///
+  explicit operator bool() const
+  {
+    return current < cases.size();
+  }
+
+  ///
+  /// 計測している組み合わせの最初のフレームかどうか
+  ///
+  /// @return 条件を切り替えるフレームなら true
+  ///
+  bool isStarting() const
+  {
+    return frame == 0;
+  }
+
+  ///
+  /// 計測している組み合わせを取り出す
+  ///
+  const auto& getCase() const
+  {
+    return cases[current];
+  }
+
+  ///
+  /// 計測している組み合わせを設定できなかったので飛ばす
+  ///
+  /// @param error 設定できなかった理由
+  ///
+  void skip(const std::string& error)
+  {
+    next(error);
+  }
+
+  ///
+  /// 視点の経路に沿ったシーン全体の変換行列を得る
+  ///
+  /// @return ウィンドウのマウス操作の代わりに使う変換行列
+  ///
+  GgMatrix getModelView() const;
+
+  ///
+  /// フレームの処理時間を記録する
+  ///
+  /// @param timer フレームの処理時間の計測
+  /// @param width フレームバッファの横の画素数
+  /// @param height フレームバッファの縦の画素数
+  ///
+  /// @note
+  /// glFinish() で描画の完了を待ってから FrameTimer::update() を呼び出した後で毎フレーム一度呼び出す.
+  /// GPU の描画パスの結果は一つ前のフレームの記録に入るので, その記録を取り出す.
+  ///
+  void record(const FrameTimer& timer, GLsizei width, GLsizei height);
+
+  ///
+  /// 計測結果を JSON ファイルに書き出す
+  ///
+  /// @return 書き出せたら true
+  ///
+  bool write() const;
+
+  ///
+  /// 計測結果の書き出し先のファイル名を取り出す
+  ///
+  const auto& getOutput() const
+  {
+    return output;
+  }
+};
@@ -0,0 +1,302 @@
+﻿///
+/// 境界ボリューム階層クラスの実装
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 18, 2026
+///
+#include "Bvh.h"
+
+// 標準ライブラリ
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+  // 葉に置く三角形の数の目安
+  constexpr std::size_t leafSize{ 4 };
+
+  // 分割できなくても葉にする三角形の数の上限
+  constexpr std::size_t leafLimit{ 16 };
+
+  // SAH で分割位置を探すときのビンの数
+  constexpr int binCount{ 16 };
+
+  // 木の深さの上限 (シェーダのスタックの大きさより小さくする)
+  constexpr int maxDepth{ 30 };
+
+  // 凸性の判定に使う許容誤差 (正規化した形状の大きさに対する比)
+  constexpr GLfloat convexTolerance{ 1.0e-4f };
+
+  // 凸性の判定をあきらめる三角形の数と頂点の数の積
+  constexpr double convexLimit{ 1.0e8 };
+
+  //
+  // 軸並行境界箱
+  //
+  struct Box
+  {
+    std::array<GLfloat, 3> min
+    {
+      std::numeric_limits<GLfloat>::max(),
+      std::numeric_limits<GLfloat>::max(),
+      std::numeric_limits<GLfloat>::max()
+    };
+
+    std::array<GLfloat, 3> max
+    {
+      std::numeric_limits<GLfloat>::lowest(),
+      std::numeric_limits<GLfloat>::lowest(),
+      std::numeric_limits<GLfloat>::lowest()
+    };
+
+    // 点を含むように広げる
+    void extend(const GLfloat* point)
+    {
+      for (int i = 0; i < 3; ++i)
+      {
+        min[i] = std::min(min[i], point[i]);
+        max[i] = std::max(max[i], point[i]);
+      }
+    }
+
+    // 境界箱を含むように広げる
+    void extend(const Box& box)
+    {
+      for (int i = 0; i < 3; ++i)
+      {
+        min[i] = std::min(min[i], box.min[i]);
+        max[i] = std::max(max[i], box.max[i]);
+      }
+    }
+
+    // 表面積の半分 (空なら 0)
+    GLfloat area() const
+    {
+      if (min[0] > max[0]) return 0.0f;
+      const GLfloat x{ max[0] - min[0] }, y{ max[1] - min[1] }, z{ max[2] - min[2] };
+      return x * y + y * z + z * x;
+    }
+  };
+
+  //
+  // 分割する三角形
+  //
+  struct Primitive
+  {
+    // 三角形の境界箱
+    Box box;
+
+    // 境界箱の中心
+    std::array<GLfloat, 3> center;
+
+    // 三角形の番号
+    GLuint index;
+  };
+
+  //
+  // begin から end までの三角形の部分木を作る
+  //
+  void build(std::vector<Primitive>& primitives, std::size_t begin, std::size_t end, int depth,
+    std::vector<std::array<GLfloat, 4>>& nodes)
+  {
+    // 三角形の境界箱と中心の範囲を求める
+    Box bounds, centers;
+    for (auto i = begin; i < end; ++i)
+    {
+      bounds.extend(primitives[i].box);
+      centers.extend(primitives[i].center.data());
+    }
+
+    // とりあえず葉として節点を追加する
+    const auto self{ nodes.size() };
+    const auto count{ end - begin };
+    nodes.push_back({ bounds.min[0], bounds.min[1], bounds.min[2], static_cast<GLfloat>(begin) });
+    nodes.push_back({ bounds.max[0], bounds.max[1], bounds.max[2], static_cast<GLfloat>(count) });
+    if (count <= leafSize || depth >= maxDepth) return;
+
+    // 分割しないときのコスト
+    const auto area{ bounds.area() };
+    auto best{ static_cast<GLfloat>(count) * area };
+    int bestAxis{ -1 }, bestBin{ 0 };
+
+    // ビンに分けて分割位置ごとのコストを求める
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      const auto extent{ centers.max[axis] - centers.min[axis] };
+      if (extent <= 0.0f) continue;
+
+      // 三角形を中心の位置でビンに振り分ける
+      std::array<Box, binCount> boxes;
+      std::array<std::size_t, binCount> counts{};
+      for (auto i = begin; i < end; ++i)
+      {
+        const auto bin{ std::min(static_cast<int>(binCount * (primitives[i].center[axis] - centers.min[axis]) / extent),
+          binCount - 1) };
+        boxes[bin].extend(primitives[i].box);
+        ++counts[bin];
+      }
+
+      // 右側から境界箱を広げながら右側のコストを求める
+      std::array<GLfloat, binCount> rightCost{};
+      Box right;
+      std::size_t rightCount{ 0 };
+      for (int bin = binCount - 1; bin > 0; --bin)
+      {
+        right.extend(boxes[bin]);
+        rightCount += counts[bin];
+        rightCost[bin] = static_cast<GLfloat>(rightCount) * right.area();
+      }
+
+      // 左側から境界箱を広げながら全体のコストを求める
+      Box left;
+      std::size_t leftCount{ 0 };
+      for (int bin = 0; bin < binCount - 1; ++bin)
+      {
+        left.extend(boxes[bin]);
+        leftCount += counts[bin];
+        if (leftCount == 0 || leftCount == count) continue;
+
+        // 節点をたどるコストを三角形ひとつとの交差判定と同じとする
+        const auto cost{ area + static_cast<GLfloat>(leftCount) * left.area() + rightCost[bin + 1] };
+        if (cost < best)
+        {
+          best = cost;
+          bestAxis = axis;
+          bestBin = bin;
+        }
+      }
+    }
+
+    // 分割位置
+    auto middle{ begin };
+
+    if (bestAxis >= 0)
+    {
+      // 分割したほうが安ければビンの境界で振り分ける
+      const auto axis{ bestAxis };
+      const auto extent{ centers.max[axis] - centers.min[axis] };
+      middle = static_cast<std::size_t>(std::partition(primitives.begin() + begin, primitives.begin() + end,
+        [&](const Primitive& p)
+        {
+          return std::min(static_cast<int>(binCount * (p.center[axis] - centers.min[axis]) / extent),
+            binCount - 1) <= bestBin;
+        }) - primitives.begin());
+    }
+    else
+    {
+      // 分割しないほうが安くても三角形が多すぎれば最も長い軸の中央値で分ける
+      if (count <= leafLimit) return;
+      int axis{ 0 };
+      for (int i = 1; i < 3; ++i)
+        if (centers.max[i] - centers.min[i] > centers.max[axis] - centers.min[axis]) axis = i;
+      if (centers.max[axis] <= centers.min[axis]) return;
+      middle = begin + count / 2;
+      std::nth_element(primitives.begin() + begin, primitives.begin() + middle, primitives.begin() + end,
+        [axis](const Primitive& a, const Primitive& b) { return a.center[axis] < b.center[axis]; });
+    }
+
+    // 内部節点にして左の子をすぐ後ろに, 右の子をその後ろに作る
+    nodes[self + 1][3] = 0.0f;
+    build(primitives, begin, middle, depth + 1, nodes);
+    nodes[self][3] = static_cast<GLfloat>(nodes.size() / 2);
+    build(primitives, middle, end, depth + 1, nodes);
+  }
+}
+
+//
+// コンストラクタ
+//
+Bvh::Bvh(const std::vector<GgVertex>& vert, const std::vector<GLuint>& face) :
+  convex{ false }
+{
+  // 三角形が無ければ作らない
+  if (face.size() < 3) return;
+
+  // 三角形ごとの境界箱を求める
+  const auto count{ face.size() / 3 };
+  std::vector<Primitive> primitives(count);
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    auto& p{ primitives[i] };
+    for (int j = 0; j < 3; ++j) p.box.extend(vert[face[i * 3 + j]].position.data());
+    for (int j = 0; j < 3; ++j) p.center[j] = (p.box.min[j] + p.box.max[j]) * 0.5f;
+    p.index = static_cast<GLuint>(i);
+  }
+
+  // 木を作る
+  nodes.reserve(count * 2);
+  build(primitives, 0, count, 0, nodes);
+
+  // 葉の順に三角形の頂点の位置を並べる
+  triangles.reserve(count * 3);
+  for (const auto& p : primitives)
+  {
+    for (int j = 0; j < 3; ++j)
+    {
+      const auto& v{ vert[face[p.index * 3 + j]].position };
+      triangles.push_back({ v[0], v[1], v[2], 1.0f });
+    }
+  }
+
+  // 頂点の数が多すぎれば凸性を調べずに凸でないとみなす
+  if (static_cast<double>(count) * static_cast<double>(vert.size()) > convexLimit) return;
+
+  // すべての頂点がすべての三角形の平面の裏側にあれば凸とする
+  convex = true;
+  for (std::size_t i = 0; i < count && convex; ++i)
+  {
+    const auto& a{ vert[face[i * 3 + 0]].position };
+    const auto& b{ vert[face[i * 3 + 1]].position };
+    const auto& c{ vert[face[i * 3 + 2]].position };
+    const GLfloat u[]{ b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+    const GLfloat v[]{ c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+    const GLfloat n[]{ u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0] };
+    const auto length{ sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]) };
+
+    // 面積の無い三角形は調べない
+    if (length <= 0.0f) continue;
+
+    for (const auto& vertex : vert)
+    {
+      const auto& p{ vertex.position };
+      if ((p[0] - a[0]) * n[0] + (p[1] - a[1]) * n[1] + (p[2] - a[2]) * n[2] > convexTolerance * length)
+      {
+        convex = false;
+        break;
+      }
+    }
+  }
+}
+
+//
+// デストラクタ
+//
+Bvh::~Bvh()
+{
+}
+
+//
+// 平坦化した節点と三角形を別の境界ボリューム階層の後ろに追加する
+//
+GLint Bvh::append(std::vector<std::array<GLfloat, 4>>& allNodes,
+  std::vector<std::array<GLfloat, 4>>& allTriangles) const
+{
+  // 追加する位置
+  const auto nodeOffset{ static_cast<GLfloat>(allNodes.size() / 2) };
+  const auto triangleOffset{ static_cast<GLfloat>(allTriangles.size() / 3) };
+
+  // 子の節点か三角形の番号をずらしながら節点を追加する
+  for (std::size_t i = 0; i < nodes.size(); i += 2)
+  {
+    auto node{ nodes[i] };
+    node[3] += nodes[i + 1][3] > 0.0f ? triangleOffset : nodeOffset;
+    allNodes.push_back(node);
+    allNodes.push_back(nodes[i + 1]);
+  }
+
+  // 三角形を追加する
+  allTriangles.insert(allTriangles.end(), triangles.begin(), triangles.end());
+
+  return static_cast<GLint>(nodeOffset);
+}
@@ -0,0 +1,91 @@
+﻿#pragma once
+
+///
+/// 境界ボリューム階層クラスの定義
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 18, 2026
+///
+
+// 補助プログラム
+#include "gg.h"
+using namespace gg;
+
+///
+/// 受光面の形状の三角形の境界ボリューム階層 (BVH)
+///
+/// @note
+/// GgSimpleObj と同じく正規化して読み込んだ受光面の形状の頂点と三角形から,
+/// 表面積ヒューリスティック (SAH) で分割した軸並行境界箱の二分木を作る.
+/// 木は深さ優先の順に平坦化してバッファテクスチャに格納できる形にしておく.
+/// 節点は 2 画素で, 1 画素目が境界箱の最小値と右の子 (葉なら最初の三角形) の番号,
+/// 2 画素目が境界箱の最大値と三角形の数 (内部節点なら 0) である. 左の子はすぐ次の節点に置く.
+/// 三角形は 3 画素で, 葉の順に並べた頂点の位置である.
+///
+class Bvh
+{
+  // 平坦化した節点
+  std::vector<std::array<GLfloat, 4>> nodes;
+
+  // 葉の順に並べた三角形の頂点の位置
+  std::vector<std::array<GLfloat, 4>> triangles;
+
+  // 形状が凸なら true
+  bool convex;
+
+public:
+
+  ///
+  /// コンストラクタ
+  ///
+  /// @param vert ggLoadSimpleObj() で読み込んだ受光面の形状の頂点属性
+  /// @param face ggLoadSimpleObj() で読み込んだ受光面の形状の三角形の頂点インデックス
+  ///
+  Bvh(const std::vector<GgVertex>& vert, const std::vector<GLuint>& face);
+
+  ///
+  /// デストラクタ
+  ///
+  virtual ~Bvh();
+
+  ///
+  /// 境界ボリューム階層が作成できていれば true
+  ///
+  explicit operator bool() const
+  {
+    return !nodes.empty();
+  }
+
+  ///
+  /// 形状が凸なら true
+  ///
+  /// @note
+  /// 凸な形状は自分自身の表面から出る光線を遮らない.
+  ///
+  bool isConvex() const
+  {
+    return convex;
+  }
+
+  ///
+  /// 境界ボリューム階層が使うメモリのバイト数を得る
+  ///
+  std::size_t getSize() const
+  {
+    return (nodes.size() + triangles.size()) * sizeof nodes[0];
+  }
+
+  ///
+  /// 平坦化した節点と三角形を別の境界ボリューム階層の後ろに追加する
+  ///
+  /// @param allNodes 節点を追加する配列
+  /// @param allTriangles 三角形を追加する配列
+  /// @return 追加した根の節点の番号
+  ///
+  /// @note
+  /// 追加するときに子の節点の番号と三角形の番号を追加する位置に合わせてずらす.
+  ///
+  GLint append(std::vector<std::array<GLfloat, 4>>& allNodes,
+    std::vector<std::array<GLfloat, 4>>& allTriangles) const;
+};
@@ -0,0 +1,123 @@
+﻿///
+/// 縮小した反射光の描画先クラスの実装
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 18, 2026
+///
+#include "CausticBuffer.h"
+
+//
+// コンストラクタ
+//
+CausticBuffer::CausticBuffer(const std::array<GLenum, 2>& formats, bool mipmap) :
+  formats{ formats },
+  mipmap{ mipmap },
+  width{ 0 },
+  height{ 0 },
+  fbo{ 0 },
+  color{},
+  depth{ 0 }
+{
+  // 反射光と 2 番目のテクスチャを作成する
+  glGenTextures(static_cast<GLsizei>(color.size()), color.data());
+  for (const auto texture : color)
+  {
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  }
+
+  // ミップマップを作るなら 2 番目のテクスチャは詳細度を指定して参照する
+  if (mipmap) glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  // デプスバッファに使うレンダーバッファを作成する
+  glGenRenderbuffers(1, &depth);
+
+  // フレームバッファオブジェクトを作成する
+  glGenFramebuffers(1, &fbo);
+}
+
+//
+// デストラクタ
+//
+CausticBuffer::~CausticBuffer()
+{
+  glDeleteFramebuffers(1, &fbo);
+  glDeleteRenderbuffers(1, &depth);
+  glDeleteTextures(static_cast<GLsizei>(color.size()), color.data());
+}
+
+//
+// 縮小した描画先への描画を開始する
+//
+void CausticBuffer::begin(GLsizei w, GLsizei h)
+{
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+
+  // 画素数が変わったらバッファを作り直す
+  if (w != width || h != height)
+  {
+    width = w;
+    height = h;
+
+    // コンストラクタで指定した内部フォーマットで作る
+    for (std::size_t i = 0; i < color.size(); ++i)
+    {
+      glBindTexture(GL_TEXTURE_2D, color[i]);
+      glTexImage2D(GL_TEXTURE_2D, 0, formats[i], width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+      glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + static_cast<GLenum>(i),
+        GL_TEXTURE_2D, color[i], 0);
+    }
+
+    // 2 番目のテクスチャのミップマップの領域を確保する
+    if (mipmap) glGenerateMipmap(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glBindRenderbuffer(GL_RENDERBUFFER, depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+  }
+
+  // 反射光と 2 番目のテクスチャに描く
+  static constexpr GLenum buffers[]{ GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+  glDrawBuffers(2, buffers);
+  glViewport(0, 0, width, height);
+
+  // 受光面の無い画素は 2 番目のテクスチャも 0 にする
+  static constexpr GLfloat zero[]{ 0.0f, 0.0f, 0.0f, 0.0f };
+  static constexpr GLfloat farthest{ 1.0f };
+  glClearBufferfv(GL_COLOR, 0, zero);
+  glClearBufferfv(GL_COLOR, 1, zero);
+  glClearBufferfv(GL_DEPTH, 0, &farthest);
+}
+
+//
+// 縮小した描画先への描画を終了する
+//
+void CausticBuffer::end() const
+{
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+  // ミップマップの各詳細度はタイルの平均になる
+  if (!mipmap) return;
+  glBindTexture(GL_TEXTURE_2D, color[1]);
+  glGenerateMipmap(GL_TEXTURE_2D);
+  glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+//
+// 反射光と 2 番目のテクスチャを連続するテクスチャユニットに結合する
+//
+void CausticBuffer::bind(GLuint unit) const
+{
+  for (std::size_t i = 0; i < color.size(); ++i)
+  {
+    glActiveTexture(GL_TEXTURE0 + unit + static_cast<GLuint>(i));
+    glBindTexture(GL_TEXTURE_2D, color[i]);
+  }
+}
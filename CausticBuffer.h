@@ -0,0 +1,110 @@
+﻿#pragma once
+
+///
+/// 縮小した反射光の描画先クラスの定義
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 18, 2026
+///
+
+// 補助プログラム
+#include "gg.h"
+using namespace gg;
+
+///
+/// 縮小した投影光源による反射光の描画先
+///
+/// @note
+/// 受光面の投影光源による反射光は画面より低い周波数の成分が多いので,
+/// 縮小した描画先に反射光と法線ベクトルと奥行きを描き, 元の大きさの描画で
+/// 法線ベクトルと奥行きを手がかりにした結合バイラテラルフィルタで拡大する.
+/// 反射光の試し描きでは 2 番目のテクスチャに輝度の標準偏差を描き, ミップマップでタイルの平均を求める.
+///
+class CausticBuffer
+{
+  // 反射光と 2 番目のテクスチャの内部フォーマット
+  const std::array<GLenum, 2> formats;
+
+  // 2 番目のテクスチャのミップマップを作るなら true
+  const bool mipmap;
+
+  // 描画先の画素数
+  GLsizei width, height;
+
+  // フレームバッファオブジェクト
+  GLuint fbo;
+
+  // 反射光と 2 番目 (法線ベクトルと奥行きか輝度の標準偏差) のテクスチャ
+  std::array<GLuint, 2> color;
+
+  // デプスバッファに使うレンダーバッファ
+  GLuint depth;
+
+public:
+
+  ///
+  /// コンストラクタ
+  ///
+  /// @param formats 反射光と 2 番目のテクスチャの内部フォーマット
+  /// @param mipmap 2 番目のテクスチャのミップマップを end() で作るなら true
+  ///
+  CausticBuffer(const std::array<GLenum, 2>& formats = { GL_RGBA16F, GL_RGBA32F }, bool mipmap = false);
+
+  ///
+  /// コピーコンストラクタは使用しない
+  ///
+  CausticBuffer(const CausticBuffer& buffer) = delete;
+
+  ///
+  /// デストラクタ
+  ///
+  virtual ~CausticBuffer();
+
+  ///
+  /// 代入演算子は使用しない
+  ///
+  CausticBuffer& operator=(const CausticBuffer& buffer) = delete;
+
+  ///
+  /// 縮小した描画先への描画を開始する
+  ///
+  /// @param w 縮小した描画先の横の画素数
+  /// @param h 縮小した描画先の縦の画素数
+  ///
+  /// @note
+  /// 描画が終わったら end() を呼び出してビューポートを元に戻す.
+  ///
+  void begin(GLsizei w, GLsizei h);
+
+  ///
+  /// 縮小した描画先への描画を終了する
+  ///
+  /// @note
+  /// ミップマップを作るなら 2 番目のテクスチャの各詳細度はタイルの平均になる.
+  ///
+  void end() const;
+
+  ///
+  /// 反射光と 2 番目のテクスチャを連続するテクスチャユニットに結合する
+  ///
+  /// @param unit 反射光のテクスチャを結合するテクスチャユニットの番号
+  ///
+  void bind(GLuint unit) const;
+
+  ///
+  /// 縮小した描画先の横の画素数を取り出す
+  ///
+  auto getWidth() const
+  {
+    return width;
+  }
+
+  ///
+  /// 縮小した描画先の縦の画素数を取り出す
+  ///
+  auto getHeight() const
+  {
+    return height;
+  }
+};
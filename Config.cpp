@@ -28,17 +28,32 @@ Config::Config() :
   illuminantTarget{ 0.0f, 0.0f, 0.0f, 1.0f },
   illuminantSpread{ 100.0f },
   illuminantMap{ "illuminant_map.png" },
+  illuminantType{ ILLUMINANT_RECTANGLE },
+  illuminantExponent{ 500.0f },
   mirrorMaterialDiffuse{ 0.1f, 0.1f, 0.1f, 0.0f },
   mirrorMaterialSpecular{ 0.9f, 0.9f, 0.9f, 0.0f },
   mirrorMaterialShininess{ 100.0f },
-  mirrorPosition{ 0.0f, 0.0f, 0.0f, 1.0f },
-  mirrorTarget{ 0.0f, 0.0f, 1.0f, 1.0f },
-  mirrorHeightMap{ "height_map_128.png" },
-  mirrorHeightScale{ 1.0f },
+  mirrors{ { { 0.0f, 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, 1.0f, 1.0f }, "height_map_128.png", 1.0f,
+    "", 80.0f, 2.0f, 1.0f, 110.0f, 0.34f, 20.0f } },
+  mirrorHeightCompression{ false },
+  mirrorSlopeFilter{ true },
+  mirrorTileBudget{ 64 },
   mirrorSampleCount{ 100 },
-  receiverModel{ "logo.obj" },
-  receiverPosition{ 0.0f, 0.0f, 5.0f, 1.0f },
-  receiverOrientation{ 0.0f, 0.0f, 0.0f, 1.0f }
+  adaptiveSampling{ false },
+  frameBudget{ 16.6f },
+  varianceSampling{ false },
+  variancePilot{ 0.25f },
+  varianceLimit{ 4.0f },
+  progressiveRefinement{ false },
+  onDemandRendering{ false },
+  causticScale{ 1 },
+  causticScaleInteractive{ false },
+  temporalReprojection{ false },
+  temporalFrames{ 16 },
+  resourceCacheBudget{ 256 },
+  receivers{ { "logo.obj", { 0.0f, 0.0f, 5.0f, 1.0f }, { 0.0f, 0.0f, 0.0f, 1.0f },
+    false, { 0.8f, 0.8f, 0.8f, 1.0f }, { 0.2f, 0.2f, 0.2f, 1.0f }, 30.0f } },
+  receiverShadow{ false }
 {
 }
 
@@ -114,26 +129,130 @@ bool Config::load(const std::string& filename)
   // 投影光源マップ
   getString(object, "illuminant_map", illuminantMap);
 
+  // 投影光源の種類
+  getValue(object, "illuminant_type", illuminantType);
+  if (illuminantType < ILLUMINANT_RECTANGLE || illuminantType > ILLUMINANT_POINT)
+    illuminantType = ILLUMINANT_RECTANGLE;
+  getValue(object, "illuminant_exponent", illuminantExponent);
+
   // 鏡
   getVector(object, "mirror_diffuse", mirrorMaterialDiffuse);
   getVector(object, "mirror_specular", mirrorMaterialSpecular);
   getValue(object, "mirror_shininess", mirrorMaterialShininess);
-  getVector(object, "mirror_position", mirrorPosition);
-  getVector(object, "mirror_target", mirrorTarget);
   getValue(object, "mirror_sample_count", mirrorSampleCount);
   if (mirrorSampleCount <= 0) mirrorSampleCount = 1;
   if (mirrorSampleCount > MAX_MIRROR_SAMPLES) mirrorSampleCount = MAX_MIRROR_SAMPLES;
-
-  // 鏡の高さマップ
-  getString(object, "mirror_height_map", mirrorHeightMap);
-
-  // 鏡の高さマップのスケール
-  getValue(object, "mirror_height_scale", mirrorHeightScale);
-
-  // 受光面
-  getString(object, "receiver_model", receiverModel);
-  getVector(object, "receiver_position", receiverPosition);
-  getVector(object, "receiver_orientation", receiverOrientation);
+  getValue(object, "adaptive_sampling", adaptiveSampling);
+  getValue(object, "frame_budget", frameBudget);
+  if (frameBudget < 1.0f) frameBudget = 1.0f;
+  getValue(object, "variance_sampling", varianceSampling);
+  getValue(object, "variance_pilot", variancePilot);
+  if (variancePilot < 0.05f) variancePilot = 0.05f;
+  if (variancePilot > 0.9f) variancePilot = 0.9f;
+  getValue(object, "variance_limit", varianceLimit);
+  if (varianceLimit < 1.0f) varianceLimit = 1.0f;
+  if (varianceLimit > 16.0f) varianceLimit = 16.0f;
+  getValue(object, "progressive_refinement", progressiveRefinement);
+  getValue(object, "on_demand_rendering", onDemandRendering);
+  getValue(object, "caustic_scale", causticScale);
+  if (causticScale != 1 && causticScale != 2 && causticScale != 4) causticScale = 1;
+  getValue(object, "caustic_scale_interactive", causticScaleInteractive);
+  getValue(object, "temporal_reprojection", temporalReprojection);
+  getValue(object, "temporal_frames", temporalFrames);
+  if (temporalFrames < 1) temporalFrames = 1;
+  if (temporalFrames > 64) temporalFrames = 64;
+
+  // 最初の鏡の配置 (ひとつしか鏡が無かったときの構成ファイルとの互換性のため)
+  getVector(object, "mirror_position", mirrors[0].position);
+  getVector(object, "mirror_target", mirrors[0].target);
+
+  // 最初の鏡の高さマップ
+  getString(object, "mirror_height_map", mirrors[0].heightMap);
+
+  // 最初の鏡の高さマップのスケール
+  getValue(object, "mirror_height_scale", mirrors[0].heightScale);
+
+  // すべての鏡の配置
+  const auto& array{ object.find("mirrors") };
+  if (array != object.end() && array->second.is<picojson::array>())
+  {
+    std::vector<Mirror> list;
+    for (const auto& value : array->second.get<picojson::array>())
+    {
+      // オブジェクトでなければ無視する
+      if (!value.is<picojson::object>()) continue;
+      const auto& element{ value.get<picojson::object>() };
+
+      // 指定されていない項目は最初の鏡に合わせる
+      auto mirror{ mirrors[0] };
+      getVector(element, "position", mirror.position);
+      getVector(element, "target", mirror.target);
+      getString(element, "height_map", mirror.heightMap);
+      getValue(element, "height_scale", mirror.heightScale);
+      getString(element, "relief_map", mirror.reliefMap);
+      getValue(element, "plate_diameter", mirror.plateDiameter);
+      getValue(element, "plate_thickness", mirror.plateThickness);
+      getValue(element, "relief_depth", mirror.reliefDepth);
+      getValue(element, "young_modulus", mirror.plateModulus);
+      getValue(element, "poisson_ratio", mirror.platePoisson);
+      getValue(element, "polishing_pressure", mirror.polishingPressure);
+      list.push_back(mirror);
+
+      // 鏡の数の上限を超えたら残りは無視する
+      if (list.size() == MAX_MIRRORS) break;
+    }
+    if (!list.empty()) mirrors = std::move(list);
+  }
+
+  // 鏡の高さマップの圧縮
+  getValue(object, "mirror_height_compression", mirrorHeightCompression);
+
+  // 鏡の勾配の分布による反射光の広がり
+  getValue(object, "mirror_slope_filter", mirrorSlopeFilter);
+
+  // タイル化した鏡の高さマップのタイルキャッシュの容量
+  getValue(object, "mirror_tile_budget", mirrorTileBudget);
+  if (mirrorTileBudget <= 0) mirrorTileBudget = 1;
+
+  // 最初の受光面 (ひとつしか受光面が無かったときの構成ファイルとの互換性のため)
+  getString(object, "receiver_model", receivers[0].model);
+  getVector(object, "receiver_position", receivers[0].position);
+  getVector(object, "receiver_orientation", receivers[0].orientation);
+
+  // すべての受光面の配置
+  const auto& receiverArray{ object.find("receivers") };
+  if (receiverArray != object.end() && receiverArray->second.is<picojson::array>())
+  {
+    std::vector<Receiver> list;
+    for (const auto& value : receiverArray->second.get<picojson::array>())
+    {
+      // オブジェクトでなければ無視する
+      if (!value.is<picojson::object>()) continue;
+      const auto& element{ value.get<picojson::object>() };
+
+      // 指定されていない項目は最初の受光面に合わせる
+      auto receiver{ receivers[0] };
+      getString(element, "model", receiver.model);
+      getVector(element, "position", receiver.position);
+      getVector(element, "orientation", receiver.orientation);
+      getValue(element, "custom_material", receiver.customMaterial);
+      getVector(element, "diffuse", receiver.diffuse);
+      getVector(element, "specular", receiver.specular);
+      getValue(element, "shininess", receiver.shininess);
+      list.push_back(receiver);
+
+      // 受光面の数の上限を超えたら残りは無視する
+      if (list.size() == MAX_RECEIVERS) break;
+    }
+    if (!list.empty()) receivers = std::move(list);
+  }
+
+  // 受光面どうしの遮蔽
+  getValue(object, "receiver_shadow", receiverShadow);
+
+  // 資源キャッシュの容量
+  getValue(object, "resource_cache_budget", resourceCacheBudget);
+  if (resourceCacheBudget < 0) resourceCacheBudget = 0;
 
   // オブジェクトが空だったらエラー
   if (object.empty()) return false;
@@ -185,24 +304,92 @@ bool Config::save(const std::string& filename) const
   // 投影光源マップ
   setString(object, "illuminant_map", illuminantMap);
 
+  // 投影光源の種類
+  setValue(object, "illuminant_type", illuminantType);
+  setValue(object, "illuminant_exponent", illuminantExponent);
+
   // 鏡
   setVector(object, "mirror_diffuse", mirrorMaterialDiffuse);
   setVector(object, "mirror_specular", mirrorMaterialSpecular);
   setValue(object, "mirror_shininess", mirrorMaterialShininess);
-  setVector(object, "mirror_position", mirrorPosition);
-  setVector(object, "mirror_target", mirrorTarget);
   setValue(object, "mirror_sample_count", mirrorSampleCount);
-
-  // 鏡の高さマップ
-  setString(object, "mirror_height_map", mirrorHeightMap);
-
-  // 鏡の高さマップのスケール
-  setValue(object, "mirror_height_scale", mirrorHeightScale);
-
-  // 受光面
-  setString(object, "receiver_model", receiverModel);
-  setVector(object, "receiver_position", receiverPosition);
-  setVector(object, "receiver_orientation", receiverOrientation);
+  setValue(object, "adaptive_sampling", adaptiveSampling);
+  setValue(object, "frame_budget", frameBudget);
+  setValue(object, "variance_sampling", varianceSampling);
+  setValue(object, "variance_pilot", variancePilot);
+  setValue(object, "variance_limit", varianceLimit);
+  setValue(object, "progressive_refinement", progressiveRefinement);
+  setValue(object, "on_demand_rendering", onDemandRendering);
+  setValue(object, "caustic_scale", causticScale);
+  setValue(object, "caustic_scale_interactive", causticScaleInteractive);
+  setValue(object, "temporal_reprojection", temporalReprojection);
+  setValue(object, "temporal_frames", temporalFrames);
+
+  // 最初の鏡の配置 (ひとつしか鏡が無かったときの構成ファイルとの互換性のため)
+  setVector(object, "mirror_position", mirrors[0].position);
+  setVector(object, "mirror_target", mirrors[0].target);
+
+  // 最初の鏡の高さマップ
+  setString(object, "mirror_height_map", mirrors[0].heightMap);
+
+  // 最初の鏡の高さマップのスケール
+  setValue(object, "mirror_height_scale", mirrors[0].heightScale);
+
+  // すべての鏡の配置
+  picojson::array array;
+  for (const auto& mirror : mirrors)
+  {
+    picojson::object element;
+    setVector(element, "position", mirror.position);
+    setVector(element, "target", mirror.target);
+    setString(element, "height_map", mirror.heightMap);
+    setValue(element, "height_scale", mirror.heightScale);
+    setString(element, "relief_map", mirror.reliefMap);
+    setValue(element, "plate_diameter", mirror.plateDiameter);
+    setValue(element, "plate_thickness", mirror.plateThickness);
+    setValue(element, "relief_depth", mirror.reliefDepth);
+    setValue(element, "young_modulus", mirror.plateModulus);
+    setValue(element, "poisson_ratio", mirror.platePoisson);
+    setValue(element, "polishing_pressure", mirror.polishingPressure);
+    array.emplace_back(element);
+  }
+  object.emplace("mirrors", array);
+
+  // 鏡の高さマップの圧縮
+  setValue(object, "mirror_height_compression", mirrorHeightCompression);
+
+  // 鏡の勾配の分布による反射光の広がり
+  setValue(object, "mirror_slope_filter", mirrorSlopeFilter);
+
+  // タイル化した鏡の高さマップのタイルキャッシュの容量
+  setValue(object, "mirror_tile_budget", mirrorTileBudget);
+
+  // 最初の受光面 (ひとつしか受光面が無かったときの構成ファイルとの互換性のため)
+  setString(object, "receiver_model", receivers[0].model);
+  setVector(object, "receiver_position", receivers[0].position);
+  setVector(object, "receiver_orientation", receivers[0].orientation);
+
+  // すべての受光面の配置
+  picojson::array receiverArray;
+  for (const auto& receiver : receivers)
+  {
+    picojson::object element;
+    setString(element, "model", receiver.model);
+    setVector(element, "position", receiver.position);
+    setVector(element, "orientation", receiver.orientation);
+    setValue(element, "custom_material", receiver.customMaterial);
+    setVector(element, "diffuse", receiver.diffuse);
+    setVector(element, "specular", receiver.specular);
+    setValue(element, "shininess", receiver.shininess);
+    receiverArray.emplace_back(element);
+  }
+  object.emplace("receivers", receiverArray);
+
+  // 受光面どうしの遮蔽
+  setValue(object, "receiver_shadow", receiverShadow);
+
+  // 資源キャッシュの容量
+  setValue(object, "resource_cache_budget", resourceCacheBudget);
 
   // 構成出データをシリアライズして JSON で保存
   picojson::value v{ object };
@@ -21,6 +21,22 @@ using namespace gg;
 // 鏡の標本点数の上限
 constexpr auto MAX_MIRROR_SAMPLES{ 1000 };
 
+// 鏡の数の上限
+constexpr auto MAX_MIRRORS{ 32 };
+
+// 受光面の数の上限
+constexpr auto MAX_RECEIVERS{ 16 };
+
+///
+/// 投影光源の種類
+///
+enum IlluminantType
+{
+  ILLUMINANT_RECTANGLE = 0,                           ///< 投影光源マップを貼った矩形
+  ILLUMINANT_PARALLEL,                                ///< 平行光線
+  ILLUMINANT_POINT                                    ///< 点光源
+};
+
 ///
 /// 構成データ
 ///
@@ -29,6 +45,9 @@ class Config
   // メニュークラスから参照する
   friend class Menu;
 
+  // 描画するシーンのクラスから参照する
+  friend class Scene;
+
   // ウィンドウサイズ
   std::array<GLsizei, 2> windowSize;
 
@@ -71,6 +90,12 @@ class Config
   // 投影光源マップのファイル名
   std::string illuminantMap;
 
+  // 投影光源の種類
+  int illuminantType;
+
+  // 平行光線と点光源の鏡面の微細な粗さを表す指数
+  GLfloat illuminantExponent;
+
   // 鏡の拡散反射係数
   GgVector mirrorMaterialDiffuse;
 
@@ -80,29 +105,124 @@ class Config
   // 鏡の輝き係数
   GLfloat mirrorMaterialShininess;
 
-  // 鏡の位置
-  GgVector mirrorPosition;
+  // 鏡ごとの構成データ
+  struct Mirror
+  {
+    // 鏡の位置
+    GgVector position;
+
+    // 鏡の目標
+    GgVector target;
+
+    // 鏡の高さマップのファイル名
+    std::string heightMap;
+
+    // 鏡の高さマップのスケール
+    GLfloat heightScale;
+
+    // 研磨時のたわみから高さマップを求める鏡の背面の模様のファイル名 (空なら高さマップをそのまま使う)
+    std::string reliefMap;
+
+    // 鏡の直径 (mm)
+    GLfloat plateDiameter;
+
+    // 鏡の模様の無いところの厚さ (mm)
+    GLfloat plateThickness;
+
+    // 背面の模様の最も高いところの厚さの増分 (mm)
+    GLfloat reliefDepth;
+
+    // 鏡の素材のヤング率 (GPa)
+    GLfloat plateModulus;
+
+    // 鏡の素材のポアソン比
+    GLfloat platePoisson;
+
+    // 研磨時に鏡面にかける圧力 (kPa)
+    GLfloat polishingPressure;
+  };
 
-  // 鏡の目標
-  GgVector mirrorTarget;
+  // 鏡の配置 (少なくともひとつはある)
+  std::vector<Mirror> mirrors;
 
-  // 鏡の高さマップのファイル名
-  std::string mirrorHeightMap;
+  // 鏡の高さマップを RGTC1 で圧縮するなら true
+  bool mirrorHeightCompression;
 
-  // 鏡の高さマップのスケール
-  GLfloat mirrorHeightScale;
+  // 標本点が受け持つ範囲の鏡の勾配の分布で反射光を広げるなら true
+  bool mirrorSlopeFilter;
+
+  // タイル化した鏡の高さマップのタイルキャッシュに使うビデオメモリの量 (MB)
+  int mirrorTileBudget;
 
   // 鏡のサンプル点数
   int mirrorSampleCount;
 
-  // 受光面の形状ファイル名
-  std::string receiverModel;
+  // 描画時間に合わせて鏡のサンプル点数を自動的に調整するなら true
+  bool adaptiveSampling;
+
+  // 自動調整で目標にする GPU の描画時間 (ms)
+  GLfloat frameBudget;
+
+  // 試し描きした反射光の輝度の標準偏差に比例して画素ごとに鏡の標本点を配分するなら true
+  bool varianceSampling;
+
+  // 試し描きに使う鏡の標本点数の鏡の標本点数に対する割合
+  GLfloat variancePilot;
+
+  // 画素ごとに配分する鏡の標本点数の上限の鏡の標本点数に対する倍率
+  GLfloat varianceLimit;
+
+  // シーンが変化しなければ標本点を替えながら結果を蓄積するなら true
+  bool progressiveRefinement;
+
+  // 入力や読み込みが無い間は描画を止めてイベントを待つなら true
+  bool onDemandRendering;
+
+  // 投影光源による反射光を描く描画先の縮小率の逆数 (1, 2, 4)
+  int causticScale;
+
+  // シーンを操作している間だけ反射光を縮小して描くなら true
+  bool causticScaleInteractive;
+
+  // 視点を動かしている間は前のフレームの反射光を再投影して混ぜるなら true
+  bool temporalReprojection;
+
+  // 再投影して混ぜるフレーム数の上限
+  int temporalFrames;
+
+  // 読み込んだテクスチャと形状を保持するキャッシュの容量 (MB)
+  int resourceCacheBudget;
+
+  // 受光面ごとの構成データ
+  struct Receiver
+  {
+    // 受光面の形状ファイル名
+    std::string model;
+
+    // 受光面の位置
+    GgVector position;
+
+    // 受光面の回転とスケール
+    GgVector orientation;
+
+    // 形状ファイルの材質の代わりに以下の材質を使うなら true
+    bool customMaterial;
+
+    // 受光面の拡散反射係数
+    GgVector diffuse;
+
+    // 受光面の鏡面反射係数
+    GgVector specular;
+
+    // 受光面の輝き係数
+    GLfloat shininess;
+  };
 
-  // 受光面の位置
-  GgVector receiverPosition;
+  // 受光面の配置 (少なくともひとつはある)
+  std::vector<Receiver> receivers;
 
-  // 受光面の回転とスケール
-  GgVector receiverOrientation;
+  // 受光面どうしの遮蔽を調べるなら true
+  bool receiverShadow;
 
 public:
 
@@ -0,0 +1,216 @@
+﻿///
+/// フレームの処理時間の計測クラスの実装
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 18, 2026
+///
+#include "FrameTimer.h"
+
+// 標準ライブラリ
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+//
+// コンストラクタ
+//
+FrameTimer::FrameTimer(std::size_t capacity) :
+  capacity{ capacity },
+  ring{},
+  current{ 0 },
+  frames{ 0 },
+  gpuTime{ -1.0f },
+  frameStart{ std::chrono::steady_clock::now() }
+{
+  // クエリを作成する
+  for (auto& set : ring) glGenQueries(PASSES, set.queries.data());
+
+  // 今のフレームの処理時間を未計測にする
+  elapsed.fill(-1.0f);
+}
+
+//
+// デストラクタ
+//
+FrameTimer::~FrameTimer()
+{
+  // クエリを削除する
+  for (auto& set : ring) glDeleteQueries(PASSES, set.queries.data());
+}
+
+//
+// 処理の計測を開始する
+//
+void FrameTimer::begin(Pass pass)
+{
+  if (isGpu(pass))
+  {
+    auto& set{ ring[current] };
+    glBeginQuery(GL_TIME_ELAPSED, set.queries[pass]);
+    set.issued[pass] = true;
+    set.frame = frames;
+  }
+  else
+  {
+    start[pass] = std::chrono::steady_clock::now();
+  }
+}
+
+//
+// 処理の計測を終了する
+//
+void FrameTimer::end(Pass pass)
+{
+  if (isGpu(pass))
+  {
+    glEndQuery(GL_TIME_ELAPSED);
+  }
+  else
+  {
+    const std::chrono::duration<GLfloat, std::milli> duration{ std::chrono::steady_clock::now() - start[pass] };
+    elapsed[pass] = duration.count();
+  }
+}
+
+//
+// フレームの計測を終えて次のフレームに進める
+//
+void FrameTimer::update()
+{
+  // フレーム全体の処理時間を求める
+  const auto now{ std::chrono::steady_clock::now() };
+  elapsed[FRAME] = std::chrono::duration<GLfloat, std::milli>{ now - frameStart }.count();
+  frameStart = now;
+
+  // 今のフレームの CPU の処理時間を記録する
+  records.push_back(elapsed);
+  elapsed.fill(-1.0f);
+  ++frames;
+
+  // 古いフレームのクエリの組から順に結果が得られているものを取り出す
+  gpuTime = -1.0f;
+  for (std::size_t i = 1; i <= sets; ++i) collect(ring[(current + i) % sets], false);
+
+  // 次のフレームで使うクエリの組に切り替え, まだ結果が得られていなければ一巡したので待って取り出す
+  current = (current + 1) % sets;
+  collect(ring[current], true);
+
+  // 保持するフレーム数を超えたら古いものから捨てる
+  while (records.size() > capacity) records.pop_front();
+}
+
+//
+// クエリの組の結果のうち得られているものを取り出してそのフレームの記録に加える
+//
+void FrameTimer::collect(QuerySet& set, bool wait)
+{
+  // 結果を取り出していないクエリが無ければ何もしない
+  if (std::find(set.issued.begin(), set.issued.end(), true) == set.issued.end()) return;
+
+  // クエリを発行したフレームの記録 (捨てていれば結果だけ取り出す)
+  const auto oldest{ frames - records.size() };
+  auto* const record{ set.frame >= oldest ? &records[set.frame - oldest] : nullptr };
+
+  for (int pass = 0; pass < PASSES; ++pass)
+  {
+    if (!set.issued[pass]) continue;
+
+    // 待たないときは結果がまだ得られていなければ次の機会に回す
+    if (!wait)
+    {
+      GLuint available{ GL_FALSE };
+      glGetQueryObjectuiv(set.queries[pass], GL_QUERY_RESULT_AVAILABLE, &available);
+      if (!available) continue;
+    }
+
+    GLuint64 time;
+    glGetQueryObjectui64v(set.queries[pass], GL_QUERY_RESULT, &time);
+    set.issued[pass] = false;
+    if (record) (*record)[pass] = static_cast<GLfloat>(time * 1.0e-6);
+  }
+
+  // すべての結果が得られたら GPU の描画パスの処理時間の合計を求める
+  if (!record || std::find(set.issued.begin(), set.issued.end(), true) != set.issued.end()) return;
+  GLfloat sum{ -1.0f };
+  for (int pass = 0; pass < PASSES; ++pass)
+  {
+    if (!isGpu(static_cast<Pass>(pass)) || (*record)[pass] < 0.0f) continue;
+    sum = std::max(sum, 0.0f) + (*record)[pass];
+  }
+  gpuTime = sum;
+}
+
+//
+// 処理の名前を取り出す
+//
+const char* FrameTimer::getName(Pass pass)
+{
+  static constexpr const char* names[PASSES]
+  {
+    "menu",
+    "mirror",
+    "sample",
+    "pilot",
+    "caustic",
+    "receiver",
+    "imgui",
+    "swap",
+    "frame"
+  };
+
+  return names[pass];
+}
+
+//
+// 処理時間の統計を求める
+//
+std::array<GLfloat, 3> FrameTimer::getStatistics(Pass pass) const
+{
+  // 計測したフレームの処理時間を集める
+  std::vector<GLfloat> times;
+  times.reserve(records.size());
+  for (const auto& record : records) if (record[pass] >= 0.0f) times.push_back(record[pass]);
+  if (times.empty()) return { 0.0f, 0.0f, 0.0f };
+
+  // 最小値と平均値
+  GLfloat sum{ 0.0f };
+  for (const auto time : times) sum += time;
+  const auto minimum{ *std::min_element(times.begin(), times.end()) };
+  const auto average{ sum / static_cast<GLfloat>(times.size()) };
+
+  // 99 パーセンタイル値
+  const auto nth{ times.begin() + (times.size() - 1) * 99 / 100 };
+  std::nth_element(times.begin(), nth, times.end());
+
+  return { minimum, average, *nth };
+}
+
+//
+// 記録している処理時間を CSV 形式で保存する
+//
+bool FrameTimer::save(const std::string& filename) const
+{
+  // ファイルを開く
+  std::ofstream file{ std::filesystem::u8path(filename) };
+  if (!file) return false;
+
+  // 見出し
+  file << "frame";
+  for (int pass = 0; pass < PASSES; ++pass) file << ',' << getName(static_cast<Pass>(pass)) << "_ms";
+  file << '\n';
+
+  // フレームごとの処理時間 (計測していなければ空欄)
+  for (std::size_t frame = 0; frame < records.size(); ++frame)
+  {
+    file << frame;
+    for (const auto time : records[frame])
+    {
+      file << ',';
+      if (time >= 0.0f) file << time;
+    }
+    file << '\n';
+  }
+
+  return static_cast<bool>(file);
+}
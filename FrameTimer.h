@@ -0,0 +1,221 @@
+﻿#pragma once
+
+///
+/// フレームの処理時間の計測クラスの定義
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 18, 2026
+///
+
+// 補助プログラム
+#include "gg.h"
+using namespace gg;
+
+// 標準ライブラリ
+#include <chrono>
+#include <deque>
+
+///
+/// フレームの処理時間の計測
+///
+/// @note
+/// GPU の描画パスは GL_TIME_ELAPSED のクエリで, CPU の処理は std::chrono で計測する.
+/// クエリは数フレーム分の組を環状に使い回し, 結果が得られた組から取り出して発行したフレームの記録に加える.
+/// 結果が遅れて得られても捨てずに記録し, 描画が待たされるのは組を一巡しても結果が得られていないときだけになる.
+/// 計測結果は直近のフレームの分だけ保持する.
+///
+class FrameTimer
+{
+public:
+
+  /// 計測する処理
+  enum Pass
+  {
+    MENU = 0,                                         ///< メニューの作成 (CPU)
+    MIRROR,                                           ///< 鏡の描画パス (GPU)
+    SAMPLE,                                           ///< 鏡の標本点マップの描画パス (GPU)
+    PILOT,                                            ///< 反射光の分散を見積もる試し描きのパス (GPU)
+    CAUSTIC,                                          ///< 縮小した反射光の描画パス (GPU)
+    RECEIVER,                                         ///< 受光面の描画パス (GPU)
+    IMGUI,                                            ///< メニューの描画パス (GPU)
+    SWAP,                                             ///< カラーバッファの入れ替え (CPU)
+    FRAME,                                            ///< フレーム全体 (CPU)
+    PASSES                                            ///< 計測する処理の数
+  };
+
+private:
+
+  // 処理ごとの計測結果 (ミリ秒, 計測していなければ負)
+  using Record = std::array<GLfloat, PASSES>;
+
+  // 保持するフレーム数
+  const std::size_t capacity;
+
+  // 直近のフレームの計測結果 (末尾が最新)
+  std::deque<Record> records;
+
+  // 一つのフレームの GPU の描画パスのクエリの組
+  struct QuerySet
+  {
+    // 描画パスごとのクエリ
+    std::array<GLuint, PASSES> queries;
+
+    // 結果を取り出していないクエリを発行していれば true
+    std::array<bool, PASSES> issued;
+
+    // クエリを発行したフレームの番号
+    std::size_t frame;
+  };
+
+  // 環状に使い回すクエリの組の数
+  static constexpr std::size_t sets{ 4 };
+
+  // 環状に使い回すクエリの組
+  std::array<QuerySet, sets> ring;
+
+  // 今のフレームで使うクエリの組
+  std::size_t current;
+
+  // これまでに記録したフレーム数
+  std::size_t frames;
+
+  // 最後に結果がすべて得られたフレームの GPU の描画パスの処理時間の合計
+  GLfloat gpuTime;
+
+  // CPU の処理の開始時刻
+  std::array<std::chrono::steady_clock::time_point, PASSES> start;
+
+  // 今のフレームの CPU の処理時間
+  Record elapsed;
+
+  // フレームの開始時刻
+  std::chrono::steady_clock::time_point frameStart;
+
+  // 処理が GPU で計測するものなら true
+  static bool isGpu(Pass pass)
+  {
+    return pass == MIRROR || pass == SAMPLE || pass == PILOT || pass == CAUSTIC || pass == RECEIVER || pass == IMGUI;
+  }
+
+  // クエリの組の結果のうち得られているものを取り出してそのフレームの記録に加える
+  void collect(QuerySet& set, bool wait);
+
+public:
+
+  ///
+  /// コンストラクタ
+  ///
+  /// @param capacity 計測結果を保持するフレーム数
+  ///
+  FrameTimer(std::size_t capacity = 240);
+
+  ///
+  /// コピーコンストラクタは使用しない
+  ///
+  FrameTimer(const FrameTimer& timer) = delete;
+
+  ///
+  /// デストラクタ
+  ///
+  virtual ~FrameTimer();
+
+  ///
+  /// 代入演算子は使用しない
+  ///
+  FrameTimer& operator=(const FrameTimer& timer) = delete;
+
+  ///
+  /// 処理の計測を開始する
+  ///
+  /// @param pass 計測する処理
+  ///
+  /// @note
+  /// GL_TIME_ELAPSED のクエリは入れ子にできないので GPU の描画パスは重ねて計測しない.
+  ///
+  void begin(Pass pass);
+
+  ///
+  /// 処理の計測を終了する
+  ///
+  /// @param pass 計測している処理
+  ///
+  void end(Pass pass);
+
+  ///
+  /// 別のスレッドで計測した CPU の処理時間を今のフレームに記録する
+  ///
+  /// @param pass 計測した処理
+  /// @param time 処理時間のミリ秒
+  ///
+  void set(Pass pass, GLfloat time)
+  {
+    elapsed[pass] = time;
+  }
+
+  ///
+  /// フレームの計測を終えて次のフレームに進める
+  ///
+  /// @note
+  /// カラーバッファを入れ替えた後に毎フレーム一度呼び出す.
+  /// GPU の描画パスの結果は得られた時点でクエリを発行したフレームの記録に加える.
+  /// 記録を書き換えるのはここだけなので, 別のスレッドで記録を読むときはこれと排他制御する.
+  ///
+  void update();
+
+  ///
+  /// 処理の名前を取り出す
+  ///
+  /// @param pass 処理
+  ///
+  static const char* getName(Pass pass);
+
+  ///
+  /// 記録しているフレーム数を取り出す
+  ///
+  auto getCount() const
+  {
+    return static_cast<int>(records.size());
+  }
+
+  ///
+  /// 記録している処理時間を取り出す
+  ///
+  /// @param pass 処理
+  /// @param frame 記録しているフレームの番号 (0 が最も古い)
+  /// @return 処理時間のミリ秒, 計測していなければ負の値
+  ///
+  GLfloat get(Pass pass, int frame) const
+  {
+    return records[frame][pass];
+  }
+
+  ///
+  /// 最後に結果が得られた GPU の描画パスの処理時間の合計を取り出す
+  ///
+  /// @return GPU の描画パスの処理時間の合計のミリ秒, 結果が得られていなければ負の値
+  ///
+  /// @note
+  /// update() の後で毎フレーム一度呼び出す. 直前の update() で結果がそろったフレームが無ければ負の値を返す.
+  ///
+  GLfloat getGpuTime() const
+  {
+    return gpuTime;
+  }
+
+  ///
+  /// 処理時間の統計を求める
+  ///
+  /// @param pass 処理
+  /// @return 記録しているフレームの処理時間の最小値, 平均値, 99 パーセンタイル値のミリ秒
+  ///
+  std::array<GLfloat, 3> getStatistics(Pass pass) const;
+
+  ///
+  /// 記録している処理時間を CSV 形式で保存する
+  ///
+  /// @param filename 保存するファイル名
+  /// @return 保存できたら true
+  ///
+  bool save(const std::string& filename) const;
+};
@@ -75,6 +75,11 @@ GgApp::GgApp(int major, int minor)
 #endif
   }
 
+#if defined(DEBUG) && !defined(GL_GLES_PROTOTYPES)
+  // デバッグビルドではドライバがエラーや性能の警告を詳しく通知するデバッグコンテキストを使う
+  glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);
+#endif
+
 #if defined(GG_USE_OCULUS_RIFT)
   // Oculus Rift では SRGB でレンダリングする
   glfwWindowHint(GLFW_SRGB_CAPABLE, GL_TRUE);
@@ -149,6 +154,9 @@ void GgApp::Window::HumanInterface::calcTranslation(int button, const std::array
 //
 void GgApp::Window::resize(GLFWwindow* window, int width, int height)
 {
+  // 描画を再開する
+  wake(window);
+
   // このインスタンスの this ポインタを得る
   auto* const instance{ static_cast<Window*>(glfwGetWindowUserPointer(window)) };
 
@@ -180,6 +188,9 @@ void GgApp::Window::resize(GLFWwindow* window, int width, int height)
 //
 void GgApp::Window::keyboard(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
+  // 描画を再開する
+  wake(window);
+
 #if defined(IMGUI_VERSION)
   // ImGui がキーボードを使うときはキーボードの処理を行わない
   if (ImGui::GetIO().WantCaptureKeyboard) return;
@@ -271,6 +282,9 @@ void GgApp::Window::keyboard(GLFWwindow* window, int key, int scancode, int acti
 //
 void GgApp::Window::mouse(GLFWwindow* window, int button, int action, int mods)
 {
+  // 描画を再開する
+  wake(window);
+
 #if defined(IMGUI_VERSION)
   // ImGui がマウスを使うときは Window クラスのマウス位置を更新しない
   if (ImGui::GetIO().WantCaptureMouse) return;
@@ -316,6 +330,9 @@ void GgApp::Window::mouse(GLFWwindow* window, int button, int action, int mods)
 //
 void GgApp::Window::wheel(GLFWwindow* window, double x, double y)
 {
+  // 描画を再開する
+  wake(window);
+
 #if defined(IMGUI_VERSION)
   // ImGui がマウスを使うときは Window クラスのマウス位置を更新しない
   if (ImGui::GetIO().WantCaptureMouse) return;
@@ -342,6 +359,36 @@ void GgApp::Window::wheel(GLFWwindow* window, double x, double y)
   }
 }
 
+//
+// マウスカーソルを動かしたときの処理
+//
+void GgApp::Window::cursor(GLFWwindow* window, double x, double y)
+{
+  // 描画を再開する
+  wake(window);
+}
+
+//
+// ウィンドウの再描画が必要になったときの処理
+//
+void GgApp::Window::refresh(GLFWwindow* window)
+{
+  // 描画を再開する
+  wake(window);
+}
+
+//
+// イベントを受け取ったら描画を再開する
+//
+void GgApp::Window::wake(GLFWwindow* window)
+{
+  // このインスタンスの this ポインタを得る
+  auto* const instance{ static_cast<Window*>(glfwGetWindowUserPointer(window)) };
+
+  // メニューの表示が落ち着くまで描画する
+  if (instance) instance->requestRedraw(eventFrames);
+}
+
 //
 // Window クラスのコンストラクタ
 //
@@ -355,6 +402,8 @@ GgApp::Window::Window(const std::string& title, int width, int height, int fulls
   aspect{ 1.0f },
   velocity{ 1.0f, 1.0f, 0.1f },
   status{ false },
+  redraw{ eventFrames },
+  waitTimeout{ -1.0 },
   interfaceNo{ 0 },
   userPointer{ nullptr },
   resizeFunc{ nullptr },
@@ -411,6 +460,12 @@ GgApp::Window::Window(const std::string& title, int width, int height, int fulls
   // ウィンドウのサイズ変更時に呼び出す処理を登録する
   glfwSetFramebufferSizeCallback(window, resize);
 
+  // マウスカーソルを動かしたときの処理を登録する
+  glfwSetCursorPosCallback(window, cursor);
+
+  // ウィンドウの再描画が必要になったときの処理を登録する
+  glfwSetWindowRefreshCallback(window, refresh);
+
   // 垂直同期タイミングに合わせる
   glfwSwapInterval(1);
 
@@ -441,7 +496,19 @@ GgApp::Window::Window(const std::string& title, int width, int height, int fulls
 GgApp::Window::operator bool()
 {
   // イベントを取り出す
-  glfwPollEvents();
+  if (waitTimeout < 0.0 || redraw > 0)
+  {
+    glfwPollEvents();
+  }
+  else
+  {
+    // 描画の要求が無ければイベントが来るまで待つ
+    while (redraw <= 0 && !shouldClose()) glfwWaitEventsTimeout(waitTimeout);
+  }
+
+  // このフレームを描画すれば要求をひとつ満たす
+  int current{ redraw.load() };
+  while (current > 0 && !redraw.compare_exchange_weak(current, current - 1));
 
   // ウィンドウを閉じるべきなら false を返す
   if (shouldClose()) return false;
@@ -450,8 +517,8 @@ GgApp::Window::operator bool()
   auto& current_if{ interfaceData[interfaceNo] };
 
 #if defined(IMGUI_VERSION)
-  // ImGui の新規フレームを作成する
-  ImGui_ImplOpenGL3_NewFrame();
+  // ImGui の新規フレームを作成する (コンテキストを描画スレッドに渡していれば描画の準備は描画スレッドで行う)
+  if (glfwGetCurrentContext() == window) ImGui_ImplOpenGL3_NewFrame();
   ImGui_ImplGlfw_NewFrame();
   ImGui::NewFrame();
 
@@ -487,9 +554,23 @@ GgApp::Window::operator bool()
 }
 
 //
-// カラーバッファを入れ替える
+// 呼び出したスレッドから OpenGL のコンテキストを外す
 //
-void GgApp::Window::swapBuffers() const
+void GgApp::Window::releaseContext() const
+{
+#if defined(IMGUI_VERSION)
+  // フォントのテクスチャなどのメニューの描画に使う資源を作っておく
+  ImGui_ImplOpenGL3_NewFrame();
+#endif
+
+  // コンテキストを外す
+  glfwMakeContextCurrent(nullptr);
+}
+
+//
+// メニューを描画する
+//
+void GgApp::Window::drawMenu() const
 {
 #if defined(IMGUI_VERSION)
   // ImGui の描画データがあればフレームをレンダリングする
@@ -497,9 +578,72 @@ void GgApp::Window::swapBuffers() const
   ImDrawData* data{ ImGui::GetDrawData() };
   if (data) ImGui_ImplOpenGL3_RenderDrawData(data);
 #endif
+}
 
-  // エラーチェック
-  ggError();
+#if defined(IMGUI_VERSION)
+//
+// メニューの描画データを作る
+//
+void GgApp::Window::renderMenu(MenuData& menu) const
+{
+  // ImGui のフレームを描画データにして複製する
+  ImGui::Render();
+  menu.copy(ImGui::GetDrawData());
+}
+
+//
+// 複製した描画データでメニューを描画する
+//
+void GgApp::Window::drawMenu(MenuData& menu) const
+{
+  // 描画データがあればフレームをレンダリングする
+  ImDrawData* data{ menu.get() };
+  if (data) ImGui_ImplOpenGL3_RenderDrawData(data);
+}
+
+//
+// 複製した描画リストを破棄する
+//
+void GgApp::MenuData::clear()
+{
+  for (auto* list : data.CmdLists) IM_DELETE(list);
+  data.Clear();
+}
+
+//
+// 描画データを複製する
+//
+void GgApp::MenuData::copy(const ImDrawData* source)
+{
+  // 前に複製した描画リストを破棄する
+  clear();
+  if (!source) return;
+
+  // 描画リストを複製する
+  for (const auto* list : source->CmdLists) data.CmdLists.push_back(list->CloneOutput());
+  data.CmdListsCount = data.CmdLists.Size;
+  data.TotalIdxCount = source->TotalIdxCount;
+  data.TotalVtxCount = source->TotalVtxCount;
+  data.DisplayPos = source->DisplayPos;
+  data.DisplaySize = source->DisplaySize;
+  data.FramebufferScale = source->FramebufferScale;
+  data.Valid = source->Valid;
+}
+#endif
+
+//
+// カラーバッファを入れ替える
+//
+void GgApp::Window::swapBuffers(bool menu) const
+{
+  // メニューを描画する
+  if (menu) drawMenu();
+
+  // デバッグ出力を受け取っていなければエラーを問い合わせる (リリースビルドでは何もしない)
+  if (!ggDebugOutput())
+  {
+    ggError();
+  }
 
   // カラーバッファを入れ替える
   glfwSwapBuffers(window);
@@ -521,8 +665,8 @@ void GgApp::Window::updateViewport()
   // ウィンドウの縦横比を保存する
   aspect = static_cast<GLfloat>(fboSize[0]) / static_cast<GLfloat>(fboSize[1]);
 
-  // ビューポートを設定する
-  restoreViewport();
+  // コンテキストを描画スレッドに渡していなければビューポートを設定する
+  if (glfwGetCurrentContext() == window) restoreViewport();
 }
 
 #if defined(GG_USE_OCULUS_RIFT)
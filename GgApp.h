@@ -53,6 +53,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 using namespace gg;
 
 // 標準ライブラリ
+#include <atomic>
 #include <cassert>
 #include <stdexcept>
 #include <iostream>
@@ -127,6 +128,67 @@ public:
   ///
   int main(int argc, const char* const* argv);
 
+#if defined(IMGUI_VERSION)
+  ///
+  /// 別スレッドで描画するメニューの描画データ.
+  ///
+  /// @note
+  /// ImGui::Render() で作った描画データは次の ImGui::NewFrame() で作り直されるので,
+  /// 描画リストを複製してメニューを作るスレッドと別のスレッドで描画できるようにする.
+  /// ImGui のメモリの確保と解放は一つのスレッドで行うので, 複製と破棄はメニューを作るスレッドで行う.
+  ///
+  class MenuData
+  {
+    // 複製した描画リストを参照する描画データ
+    ImDrawData data;
+
+    // 複製した描画リストを破棄する
+    void clear();
+
+  public:
+
+    ///
+    /// コンストラクタ.
+    ///
+    MenuData() = default;
+
+    ///
+    /// コピーコンストラクタは使用しない
+    ///
+    MenuData(const MenuData& menu) = delete;
+
+    ///
+    /// デストラクタ.
+    ///
+    virtual ~MenuData()
+    {
+      clear();
+    }
+
+    ///
+    /// 代入演算子は使用しない
+    ///
+    MenuData& operator=(const MenuData& menu) = delete;
+
+    ///
+    /// 描画データを複製する.
+    ///
+    /// @param source 複製元の描画データ, nullptr なら空にする.
+    ///
+    void copy(const ImDrawData* source);
+
+    ///
+    /// 描画データを取り出す.
+    ///
+    /// @return 描画データ, 複製していなければ nullptr.
+    ///
+    auto* get()
+    {
+      return data.Valid ? &data : nullptr;
+    }
+  };
+#endif
+
   ///
   /// ウィンドウ関連の処理.
   ///
@@ -158,6 +220,15 @@ public:
     // マウスボタンの状態
     std::array<bool, GG_BUTTON_COUNT> status;
 
+    // イベントを待たずに描画するフレーム数 (描画スレッドからも要求する)
+    std::atomic<int> redraw;
+
+    // イベントを待つ時間の上限 (秒), 負ならイベントを待たない
+    double waitTimeout;
+
+    // イベントを受け取ったときに描画するフレーム数 (メニューの表示が落ち着くまで)
+    static constexpr int eventFrames{ 3 };
+
     // ユーザインタフェースのデータ構造
     struct HumanInterface
     {
@@ -236,6 +307,21 @@ public:
     //
     static void wheel(GLFWwindow* window, double x, double y);
 
+    //
+    // マウスカーソルを動かしたときの処理
+    //
+    static void cursor(GLFWwindow* window, double x, double y);
+
+    //
+    // ウィンドウの再描画が必要になったときの処理
+    //
+    static void refresh(GLFWwindow* window);
+
+    //
+    // イベントを受け取ったら描画を再開する
+    //
+    static void wake(GLFWwindow* window);
+
   public:
 
     ///
@@ -256,9 +342,9 @@ public:
     Window(const Window& w) = delete;
 
     ///
-    /// ムーブコンストラクタはデフォルトのものを使用する
+    /// ムーブコンストラクタは使用しない
     ///
-    Window(Window&& w) = default;
+    Window(Window&& w) = delete;
 
     ///
     /// デストラクタ.
@@ -278,9 +364,9 @@ public:
     Window& operator=(const Window& w) = delete;
 
     ///
-    /// ムーブ代入演算子はデフォルトのものを使用する
+    /// ムーブ代入演算子は使用しない
     ///
-    Window& operator=(Window&& w) = default;
+    Window& operator=(Window&& w) = delete;
 
     ///
     /// ウィンドウの識別子のポインタを取得する.
@@ -320,10 +406,95 @@ public:
     ///
     explicit operator bool();
 
+    ///
+    /// イベントを待つ時間の上限を設定する.
+    ///
+    /// @param timeout イベントを待つ時間の上限 (秒), 負ならイベントを待たずに毎フレーム描画する.
+    ///
+    /// @note
+    /// 0 以上にすると, 入力イベントか requestRedraw() による要求が無い間は
+    /// ループを継続すべきかどうかを調べるところでイベントを待って描画を止める.
+    ///
+    void setWaitTimeout(double timeout)
+    {
+      waitTimeout = timeout;
+    }
+
+    ///
+    /// イベントが無くても描画するよう要求する.
+    ///
+    /// @param frames 描画するフレーム数.
+    ///
+    void requestRedraw(int frames = 1)
+    {
+      int current{ redraw.load() };
+      while (current < frames && !redraw.compare_exchange_weak(current, frames));
+    }
+
+    ///
+    /// イベントを待っているメインスレッドを起こして描画するよう要求する.
+    ///
+    /// @param frames 描画するフレーム数.
+    ///
+    /// @note
+    /// 描画スレッドから呼び出す.
+    ///
+    void postRedraw(int frames = 1)
+    {
+      requestRedraw(frames);
+      glfwPostEmptyEvent();
+    }
+
+    ///
+    /// このウィンドウの OpenGL のコンテキストを呼び出したスレッドのカレントにする.
+    ///
+    void makeContextCurrent() const
+    {
+      glfwMakeContextCurrent(window);
+    }
+
+    ///
+    /// 呼び出したスレッドから OpenGL のコンテキストを外す.
+    ///
+    /// @note
+    /// 描画スレッドにコンテキストを渡す前にメインスレッドで呼び出す.
+    /// メニューのフォントのテクスチャなどの描画に使う資源はここで作っておく.
+    ///
+    void releaseContext() const;
+
+    ///
+    /// メニューを描画する.
+    ///
+    void drawMenu() const;
+
+#if defined(IMGUI_VERSION)
+    ///
+    /// メニューの描画データを作る.
+    ///
+    /// @param menu 描画データの複製の格納先.
+    ///
+    /// @note
+    /// メインスレッドで ImGui のフレームを作り終えたら呼び出す.
+    ///
+    void renderMenu(MenuData& menu) const;
+
+    ///
+    /// 複製した描画データでメニューを描画する.
+    ///
+    /// @param menu renderMenu() で作った描画データの複製.
+    ///
+    /// @note
+    /// OpenGL のコンテキストを持つ描画スレッドで呼び出す.
+    ///
+    void drawMenu(MenuData& menu) const;
+#endif
+
     ///
     /// カラーバッファを入れ替える.
     ///
-    void swapBuffers() const;
+    /// @param menu メニューを描画してから入れ替えるなら true, drawMenu() で描画済みなら false.
+    ///
+    void swapBuffers(bool menu = true) const;
 
     ///
     /// ビューポートを元のサイズに復帰する.
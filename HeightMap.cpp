@@ -0,0 +1,468 @@
+﻿///
+/// 高さマップクラスの実装
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 18, 2026
+///
+#include "HeightMap.h"
+
+// 標準ライブラリ
+#include <algorithm>
+#include <cstdint>
+
+// 画像の読み込みライブラリ (実装は Menu.cpp で展開している)
+#include "stb_image.h"
+
+///
+/// 高さマップを RGTC1 (BC4) で圧縮する
+///
+/// @param source 単一チャンネル 16bit の高さマップ
+/// @param width 高さマップの横の画素数
+/// @param height 高さマップの縦の画素数
+/// @param blocks 圧縮したブロックを格納する vector
+///
+/// @note
+/// 4×4 画素のブロックごとに最大値と最小値を端点とする 8 段階のパレットを作り,
+/// 各画素にもっとも近いパレットの番号を割り当てる. 端点は 8bit に丸めるが,
+/// パレットの選択は 16bit の値で行う.
+///
+static void encodeRGTC1(const GLushort* source, GLsizei width, GLsizei height,
+  std::vector<GLubyte>& blocks)
+{
+  // ブロック数
+  const auto bx{ (width + 3) / 4 };
+  const auto by{ (height + 3) / 4 };
+
+  // 1 ブロックは 8 バイト
+  blocks.resize(static_cast<std::size_t>(bx) * by * 8);
+  auto* block{ blocks.data() };
+
+  for (GLsizei j = 0; j < by; ++j)
+  {
+    for (GLsizei i = 0; i < bx; ++i)
+    {
+      // ブロック内の画素値 (画像の端では端の画素を繰り返す)
+      std::array<GLushort, 16> texel;
+      for (int k = 0; k < 16; ++k)
+      {
+        const auto x{ std::min(i * 4 + (k & 3), width - 1) };
+        const auto y{ std::min(j * 4 + (k >> 2), height - 1) };
+        texel[k] = source[static_cast<std::size_t>(y) * width + x];
+      }
+
+      // ブロック内の最小値と最大値を 8bit に丸めて端点にする
+      const auto [lo, hi]{ std::minmax_element(texel.begin(), texel.end()) };
+      const auto r0{ static_cast<GLubyte>((*hi * 255u + 32767u) / 65535u) };
+      const auto r1{ static_cast<GLubyte>((*lo * 255u + 32767u) / 65535u) };
+
+      // 端点 r0 > r1 なら 8 段階のパレットになる
+      block[0] = r0;
+      block[1] = r1;
+
+      // 画素ごとのパレット番号 (3bit × 16)
+      std::uint64_t index{ 0 };
+
+      if (r0 > r1)
+      {
+        // 端点の 16bit の値
+        const auto base{ r1 * 257 };
+        const auto range{ (r0 - r1) * 257 };
+
+        for (int k = 0; k < 16; ++k)
+        {
+          // r1 を 0, r0 を 7 としたときの位置
+          const auto t{ std::clamp((static_cast<int>(texel[k]) - base) * 7 + range / 2, 0, range * 7) / range };
+
+          // 位置をパレット番号に変換する (7 → 0, 0 → 1, 6..1 → 2..7)
+          const std::uint64_t code{ t == 7 ? 0u : t == 0 ? 1u : 8u - static_cast<unsigned int>(t) };
+          index |= code << (k * 3);
+        }
+      }
+
+      // パレット番号を格納する
+      for (int k = 0; k < 6; ++k) block[2 + k] = static_cast<GLubyte>(index >> (k * 8));
+
+      // 次のブロック
+      block += 8;
+    }
+  }
+}
+
+//
+// コンストラクタ
+//
+HeightMap::HeightMap() :
+  width{ 0 },
+  height{ 0 },
+  wide{ false }
+{
+}
+
+//
+// 画像ファイルから高さマップを読み込むコンストラクタ
+//
+HeightMap::HeightMap(const std::string& name) :
+  HeightMap{}
+{
+  load(name);
+}
+
+//
+// 高さのデータから高さマップを作るコンストラクタ
+//
+HeightMap::HeightMap(GLsizei width, GLsizei height, std::vector<GLushort>&& data) :
+  width{ width },
+  height{ height },
+  wide{ true },
+  data{ std::move(data) }
+{
+}
+
+//
+// デストラクタ
+//
+HeightMap::~HeightMap()
+{
+}
+
+//
+// 画像ファイルから高さマップを読み込む
+//
+bool HeightMap::load(const std::string& name)
+{
+  // 画像サイズ
+  int w, h;
+
+  // 画像のチャンネル数
+  int channels;
+
+  // 画像を 16bit で読み込む (8bit の画像は 16bit に拡張される)
+  const auto image{ stbi_load_16(name.c_str(), &w, &h, &channels, 0) };
+
+  // 画像が読み込めなかったら戻る
+  if (!image) return false;
+
+  // 画像サイズを保存する
+  width = w;
+  height = h;
+
+  // 元の画像の精度を保存する
+  wide = stbi_is_16_bit(name.c_str()) != 0;
+
+  // シェーダが参照する最初のチャンネルだけを取り出す
+  const auto size{ static_cast<std::size_t>(width) * height };
+  data.resize(size);
+  for (std::size_t i = 0; i < size; ++i) data[i] = image[i * channels];
+
+  // 読み込んだ画像のメモリを開放する
+  stbi_image_free(image);
+
+  return true;
+}
+
+//
+// 高さマップのテクスチャを作成する
+//
+GLuint HeightMap::createTexture(bool compress) const
+{
+  // 高さマップが無ければ戻る
+  if (data.empty()) return 0;
+
+  // 圧縮する場合
+  if (compress)
+  {
+    // RGTC1 で圧縮する
+    std::vector<GLubyte> blocks;
+    encodeRGTC1(data.data(), width, height, blocks);
+
+    // テクスチャを作成する
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+
+    // 圧縮したテクスチャを割り当てる
+    glCompressedTexImage2D(GL_TEXTURE_2D, 0, GL_COMPRESSED_RED_RGTC1, width, height, 0,
+      static_cast<GLsizei>(blocks.size()), blocks.data());
+
+    // バイリニア（ミップマップなし），エッジでクランプ
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    return texture;
+  }
+
+#if !defined(GL_GLES_PROTOTYPES)
+  // 16bit の画像はそのままの精度で GL_R16 にする
+  if (wide) return ggLoadTexture(data.data(), width, height,
+    GL_RED, GL_UNSIGNED_SHORT, GL_R16, GL_CLAMP_TO_EDGE, false);
+#endif
+
+  // 8bit の画像は GL_R8 にする
+  std::vector<GLubyte> narrow(data.size());
+  std::transform(data.begin(), data.end(), narrow.begin(),
+    [](GLushort h) { return static_cast<GLubyte>(h >> 8); });
+  return ggLoadTexture(narrow.data(), width, height,
+    GL_RED, GL_UNSIGNED_BYTE, GL_R8, GL_CLAMP_TO_EDGE, false);
+}
+
+//
+// 高さマップの画素数を変更した高さを得る
+//
+std::vector<GLushort> HeightMap::resample(GLsizei w, GLsizei h) const
+{
+  // 同じ画素数ならそのまま返す
+  if (w == width && h == height) return data;
+
+  std::vector<GLushort> result(static_cast<std::size_t>(w) * h);
+  if (data.empty()) return result;
+
+  for (GLsizei j = 0; j < h; ++j)
+  {
+    // 変更後の画素の中心に対応する元の画素位置
+    const auto y{ std::clamp((j + 0.5f) * height / h - 0.5f, 0.0f, static_cast<float>(height - 1)) };
+    const auto y0{ static_cast<GLsizei>(y) };
+    const auto y1{ std::min(y0 + 1, height - 1) };
+    const auto fy{ y - y0 };
+
+    for (GLsizei i = 0; i < w; ++i)
+    {
+      const auto x{ std::clamp((i + 0.5f) * width / w - 0.5f, 0.0f, static_cast<float>(width - 1)) };
+      const auto x0{ static_cast<GLsizei>(x) };
+      const auto x1{ std::min(x0 + 1, width - 1) };
+      const auto fx{ x - x0 };
+
+      // 周囲の 4 画素を補間する
+      const auto at{ [this](GLsizei x, GLsizei y) { return static_cast<float>(data[static_cast<std::size_t>(y) * width + x]); } };
+      const auto top{ at(x0, y0) + (at(x1, y0) - at(x0, y0)) * fx };
+      const auto bottom{ at(x0, y1) + (at(x1, y1) - at(x0, y1)) * fx };
+      result[static_cast<std::size_t>(j) * w + i] = static_cast<GLushort>(top + (bottom - top) * fy + 0.5f);
+    }
+  }
+
+  return result;
+}
+
+//
+// 複数の高さマップをレイヤにしたテクスチャ配列を作成する
+//
+GLuint HeightMap::createTextureArray(const std::vector<const HeightMap*>& maps, bool compress)
+{
+  // テクスチャ配列の画素数と精度はもっとも大きな高さマップに合わせる
+  GLsizei w{ 0 }, h{ 0 };
+  bool wide{ false };
+  for (const auto* map : maps)
+  {
+    if (!map || !*map) continue;
+    w = std::max(w, map->width);
+    h = std::max(h, map->height);
+    wide = wide || map->wide;
+  }
+
+  // 高さマップがひとつも無ければ戻る
+  if (w == 0 || h == 0) return 0;
+
+  // レイヤ数
+  const auto layers{ static_cast<GLsizei>(maps.size()) };
+
+  // 1 レイヤの画素数
+  const auto size{ static_cast<std::size_t>(w) * h };
+
+  // テクスチャ配列を作成する
+  GLuint texture;
+  glGenTextures(1, &texture);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+
+  if (compress)
+  {
+    // すべてのレイヤを RGTC1 で圧縮してつなげる
+    std::vector<GLubyte> blocks;
+    for (const auto* map : maps)
+    {
+      const auto layer{ map && *map ? map->resample(w, h) : std::vector<GLushort>(size, 0) };
+      std::vector<GLubyte> block;
+      encodeRGTC1(layer.data(), w, h, block);
+      blocks.insert(blocks.end(), block.begin(), block.end());
+    }
+
+    // 圧縮したテクスチャ配列を割り当てる
+    glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_COMPRESSED_RED_RGTC1, w, h, layers, 0,
+      static_cast<GLsizei>(blocks.size()), blocks.data());
+  }
+  else
+  {
+    // 元の画像の精度に合わせたテクスチャ配列を確保する
+#if !defined(GL_GLES_PROTOTYPES)
+    const GLenum internal{ wide ? GLenum(GL_R16) : GLenum(GL_R8) };
+#else
+    const GLenum internal{ GL_R8 };
+    wide = false;
+#endif
+    const GLenum type{ wide ? GLenum(GL_UNSIGNED_SHORT) : GLenum(GL_UNSIGNED_BYTE) };
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, internal, w, h, layers, 0, GL_RED, type, nullptr);
+
+    // レイヤごとに転送する
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (GLsizei i = 0; i < layers; ++i)
+    {
+      const auto* map{ maps[i] };
+      const auto layer{ map && *map ? map->resample(w, h) : std::vector<GLushort>(size, 0) };
+
+      if (wide)
+      {
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, w, h, 1, GL_RED, type, layer.data());
+      }
+      else
+      {
+        std::vector<GLubyte> narrow(size);
+        std::transform(layer.begin(), layer.end(), narrow.begin(),
+          [](GLushort h) { return static_cast<GLubyte>(h >> 8); });
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, w, h, 1, GL_RED, type, narrow.data());
+      }
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  }
+
+  // バイリニア（ミップマップなし），エッジでクランプ
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+  return texture;
+}
+
+//
+// 複数の高さマップの勾配の 1 次と 2 次のモーメントをレイヤにしたテクスチャ配列を作成する
+//
+std::array<GLuint, 2> HeightMap::createMomentArray(const std::vector<const HeightMap*>& maps)
+{
+  // テクスチャ配列の画素数はもっとも大きな高さマップに合わせる
+  GLsizei w{ 0 }, h{ 0 };
+  for (const auto* map : maps)
+  {
+    if (!map || !*map) continue;
+    w = std::max(w, map->width);
+    h = std::max(h, map->height);
+  }
+
+  // 高さマップがひとつも無ければ戻る
+  if (w == 0 || h == 0) return {};
+
+  // レイヤ数
+  const auto layers{ static_cast<GLsizei>(maps.size()) };
+
+  // 1 画素になるまでの詳細度の数
+  GLsizei levels{ 1 };
+  while ((std::max(w, h) >> levels) > 0) ++levels;
+
+  // 勾配と勾配の積のテクスチャ配列のすべての詳細度を確保する
+  static constexpr GLenum internal[]{ GL_RG16F, GL_RGB16F };
+  static constexpr GLenum format[]{ GL_RG, GL_RGB };
+  std::array<GLuint, 2> textures;
+  glGenTextures(2, textures.data());
+  for (int k = 0; k < 2; ++k)
+  {
+    glBindTexture(GL_TEXTURE_2D_ARRAY, textures[k]);
+    for (GLsizei level = 0; level < levels; ++level)
+      glTexImage3D(GL_TEXTURE_2D_ARRAY, level, internal[k], std::max(w >> level, 1), std::max(h >> level, 1),
+        layers, 0, format[k], GL_FLOAT, nullptr);
+
+    // トライリニア，エッジでクランプ
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels - 1);
+  }
+
+  // 1 レイヤの画素数
+  const auto size{ static_cast<std::size_t>(w) * h };
+
+  // 勾配 (x, y) と勾配の積 (x², y², xy)
+  std::vector<GLfloat> first(size * 2), second(size * 3);
+
+  // 縮小した勾配と勾配の積
+  std::vector<GLfloat> nextFirst, nextSecond;
+
+  for (GLsizei i = 0; i < layers; ++i)
+  {
+    const auto* map{ maps[i] };
+    const auto layer{ map && *map ? map->resample(w, h) : std::vector<GLushort>(size, 0) };
+
+    // 詳細度 0 の勾配は [0, 1] に正規化した両隣の画素の高さの差にする (端の画素は繰り返す)
+    ggParallelFor(0, h, 0, [&](std::size_t begin, std::size_t end)
+      {
+        constexpr auto scale{ 1.0f / 65535.0f };
+        for (auto y = static_cast<GLsizei>(begin); y < static_cast<GLsizei>(end); ++y)
+        {
+          const auto* row{ layer.data() + static_cast<std::size_t>(y) * w };
+          const auto* up{ layer.data() + static_cast<std::size_t>(std::min(y + 1, h - 1)) * w };
+          const auto* down{ layer.data() + static_cast<std::size_t>(std::max(y - 1, 0)) * w };
+          for (GLsizei x = 0; x < w; ++x)
+          {
+            const auto gx{ (static_cast<GLfloat>(row[std::min(x + 1, w - 1)]) - row[std::max(x - 1, 0)]) * scale };
+            const auto gy{ (static_cast<GLfloat>(up[x]) - down[x]) * scale };
+            const auto j{ static_cast<std::size_t>(y) * w + x };
+            first[j * 2 + 0] = gx;
+            first[j * 2 + 1] = gy;
+            second[j * 3 + 0] = gx * gx;
+            second[j * 3 + 1] = gy * gy;
+            second[j * 3 + 2] = gx * gy;
+          }
+        }
+      });
+
+    // 詳細度を下げながら転送する
+    GLsizei lw{ w }, lh{ h };
+    for (GLsizei level = 0;; ++level)
+    {
+      glBindTexture(GL_TEXTURE_2D_ARRAY, textures[0]);
+      glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, i, lw, lh, 1, GL_RG, GL_FLOAT, first.data());
+      glBindTexture(GL_TEXTURE_2D_ARRAY, textures[1]);
+      glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, i, lw, lh, 1, GL_RGB, GL_FLOAT, second.data());
+      if (level + 1 == levels) break;
+
+      // 縦横とも半分にした画素に元の 2×2 画素の平均を格納する (奇数の画素数なら最後の画素を繰り返す)
+      const auto nw{ std::max(lw >> 1, 1) };
+      const auto nh{ std::max(lh >> 1, 1) };
+      nextFirst.resize(static_cast<std::size_t>(nw) * nh * 2);
+      nextSecond.resize(static_cast<std::size_t>(nw) * nh * 3);
+      ggParallelFor(0, nh, 0, [&](std::size_t begin, std::size_t end)
+        {
+          for (auto y = static_cast<GLsizei>(begin); y < static_cast<GLsizei>(end); ++y)
+          {
+            const auto y0{ static_cast<std::size_t>(std::min(y * 2, lh - 1)) * lw };
+            const auto y1{ static_cast<std::size_t>(std::min(y * 2 + 1, lh - 1)) * lw };
+            for (GLsizei x = 0; x < nw; ++x)
+            {
+              const auto x0{ static_cast<std::size_t>(std::min(x * 2, lw - 1)) };
+              const auto x1{ static_cast<std::size_t>(std::min(x * 2 + 1, lw - 1)) };
+              const auto j{ static_cast<std::size_t>(y) * nw + x };
+              for (std::size_t c = 0; c < 2; ++c)
+                nextFirst[j * 2 + c] = (first[(y0 + x0) * 2 + c] + first[(y0 + x1) * 2 + c]
+                  + first[(y1 + x0) * 2 + c] + first[(y1 + x1) * 2 + c]) * 0.25f;
+              for (std::size_t c = 0; c < 3; ++c)
+                nextSecond[j * 3 + c] = (second[(y0 + x0) * 3 + c] + second[(y0 + x1) * 3 + c]
+                  + second[(y1 + x0) * 3 + c] + second[(y1 + x1) * 3 + c]) * 0.25f;
+            }
+          }
+        });
+
+      first.swap(nextFirst);
+      second.swap(nextSecond);
+      lw = nw;
+      lh = nh;
+    }
+
+    // 次のレイヤの詳細度 0 の領域を確保しなおす
+    first.resize(size * 2);
+    second.resize(size * 3);
+  }
+  glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+  return textures;
+}
@@ -0,0 +1,174 @@
+﻿#pragma once
+
+///
+/// 高さマップクラスの定義
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 18, 2026
+///
+
+// 補助プログラム
+#include "gg.h"
+using namespace gg;
+
+///
+/// 高さマップ
+///
+/// @note
+/// シェーダは高さマップの赤チャンネルしか参照しないので,
+/// 読み込んだ画像の最初のチャンネルだけを 16bit で保持する.
+///
+class HeightMap
+{
+  // 高さマップの横の画素数
+  GLsizei width;
+
+  // 高さマップの縦の画素数
+  GLsizei height;
+
+  // 元の画像が 16bit 精度なら true
+  bool wide;
+
+  // 単一チャンネルの高さ (8bit の画像も 16bit に拡張して保持する)
+  std::vector<GLushort> data;
+
+public:
+
+  ///
+  /// コンストラクタ
+  ///
+  HeightMap();
+
+  ///
+  /// 画像ファイルから高さマップを読み込むコンストラクタ
+  ///
+  /// @param name 読み込む画像ファイル名
+  ///
+  HeightMap(const std::string& name);
+
+  ///
+  /// 高さのデータから高さマップを作るコンストラクタ
+  ///
+  /// @param width 高さマップの横の画素数
+  /// @param height 高さマップの縦の画素数
+  /// @param data 単一チャンネル 16bit の高さ
+  ///
+  HeightMap(GLsizei width, GLsizei height, std::vector<GLushort>&& data);
+
+  ///
+  /// デストラクタ
+  ///
+  virtual ~HeightMap();
+
+  ///
+  /// 画像ファイルから高さマップを読み込む
+  ///
+  /// @param name 読み込む画像ファイル名
+  /// @return 読み込みに成功したら true
+  ///
+  bool load(const std::string& name);
+
+  ///
+  /// 高さマップが有効かどうか調べる
+  ///
+  /// @return 高さマップが読み込まれていれば true
+  ///
+  explicit operator bool() const noexcept
+  {
+    return !data.empty();
+  }
+
+  ///
+  /// 高さマップの横の画素数を得る
+  ///
+  auto getWidth() const
+  {
+    return width;
+  }
+
+  ///
+  /// 高さマップの縦の画素数を得る
+  ///
+  auto getHeight() const
+  {
+    return height;
+  }
+
+  ///
+  /// 元の画像が 16bit 精度かどうか調べる
+  ///
+  auto isWide() const
+  {
+    return wide;
+  }
+
+  ///
+  /// 高さのデータを取り出す
+  ///
+  const auto& get() const
+  {
+    return data;
+  }
+
+  ///
+  /// 高さマップのテクスチャを作成する
+  ///
+  /// @param compress true なら RGTC1 (BC4) で圧縮したテクスチャを作成する
+  /// @return テクスチャ名, 高さマップが無効なら 0
+  ///
+  /// @note
+  /// 非圧縮の場合は元の画像の精度に合わせて GL_R8 か GL_R16 になる.
+  ///
+  GLuint createTexture(bool compress = false) const;
+
+  ///
+  /// 高さマップの画素数を変更した高さを得る
+  ///
+  /// @param w 変更後の横の画素数
+  /// @param h 変更後の縦の画素数
+  /// @return 画素の中心を合わせてバイリニア補間した単一チャンネル 16bit の高さ
+  ///
+  std::vector<GLushort> resample(GLsizei w, GLsizei h) const;
+
+  ///
+  /// 複数の高さマップをレイヤにしたテクスチャ配列を作成する
+  ///
+  /// @param maps 各レイヤの高さマップ, nullptr のレイヤは平坦な高さマップにする
+  /// @param compress true なら RGTC1 (BC4) で圧縮したテクスチャ配列を作成する
+  /// @return テクスチャ配列のテクスチャ名, 高さマップがひとつも無ければ 0
+  ///
+  /// @note
+  /// テクスチャ配列の画素数はもっとも大きな高さマップに合わせ,
+  /// それより小さな高さマップは拡大して格納する.
+  /// ひとつでも 16bit 精度の高さマップがあれば GL_R16 にする.
+  ///
+  static GLuint createTextureArray(const std::vector<const HeightMap*>& maps, bool compress = false);
+
+  ///
+  /// 複数の高さマップの勾配の 1 次と 2 次のモーメントをレイヤにしたテクスチャ配列を作成する
+  ///
+  /// @param maps 各レイヤの高さマップ, nullptr のレイヤは平坦な高さマップにする
+  /// @return 勾配 (x, y) の GL_RG16F と勾配の積 (x², y², xy) の GL_RGB16F のテクスチャ配列のテクスチャ名,
+  /// 高さマップがひとつも無ければどちらも 0
+  ///
+  /// @note
+  /// 勾配はシェーダと同じく詳細度 0 の両隣の画素の高さの差 (右 - 左, 上 - 下) とし,
+  /// 縮小したミップマップの画素には範囲内の平均を格納する (LEAN mapping).
+  /// 参照する範囲の勾配の平均を b, 積の平均を m とすれば勾配の共分散は m - b b^T で求められる.
+  /// テクスチャ配列の画素数は createTextureArray() と同じくもっとも大きな高さマップに合わせる.
+  ///
+  static std::array<GLuint, 2> createMomentArray(const std::vector<const HeightMap*>& maps);
+
+  ///
+  /// 高さマップのテクスチャのバイト数を得る
+  ///
+  /// @param compress true なら RGTC1 (BC4) で圧縮したテクスチャのバイト数を得る
+  /// @return createTexture() で作成するテクスチャのバイト数
+  ///
+  std::size_t getTextureSize(bool compress = false) const
+  {
+    if (compress) return static_cast<std::size_t>((width + 3) / 4) * ((height + 3) / 4) * 8;
+    return static_cast<std::size_t>(width) * height * (wide ? 2 : 1);
+  }
+};
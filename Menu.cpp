@@ -7,9 +7,15 @@
 ///
 #include "Menu.h"
 
+// 描画するシーン
+#include "Scene.h"
+
 // 乱数
 #include <random>
 
+// 時間
+#include <chrono>
+
 // 画像の読み込みライブラリ
 #define STB_IMAGE_IMPLEMENTATION
 #define STBI_NO_FAILURE_STRINGS
@@ -21,9 +27,28 @@ constexpr nfdfilteritem_t jsonFilter[]{ { "JSON", "json" } };
 // 画像ファイル名のフィルタ
 constexpr nfdfilteritem_t imageFilter[]{ "Images", "png,gif,jpg,jpeg,jfif,bmp,dib,tga,psd,pgm,ppm" };
 
+// 高さマップのファイル名のフィルタ
+constexpr nfdfilteritem_t heightFilter[]
+{
+  { "Images", "png,gif,jpg,jpeg,jfif,bmp,dib,tga,psd,pgm,ppm" },
+  { "Tiled height map", "tiles" }
+};
+
+// タイル化した高さマップのファイル名の拡張子
+constexpr char tiledExtension[]{ ".tiles" };
+
+// 資源キャッシュに登録する資源の種類
+constexpr char heightKind[]{ u8"高さマップ" };
+constexpr char reliefKind[]{ u8"背面の模様" };
+constexpr char illuminantKind[]{ u8"投影光源マップ" };
+constexpr char receiverKind[]{ u8"受光面" };
+
 // 形状ファイル名のフィルタ
 constexpr nfdfilteritem_t shapeFilter[]{ "Wavefront OBJ", "obj" };
 
+// 処理時間の計測結果のファイルの拡張子
+constexpr nfdfilteritem_t csvFilter[]{ "CSV", "csv" };
+
 // エラーが無ければ nullptr
 const char* errorMessage{ nullptr };
 
@@ -111,37 +136,96 @@ static void setPose(GgMatrix& matrix, const GgVector& position, const GgVector&
 }
 
 ///
-/// テクスチャを作成して画像ファイルを読み込む
+/// テクスチャ名を破棄するときにテクスチャを削除するポインタにする
 ///
-/// @param name 読み込む画像ファイル名
-/// @return テクスチャ名
+/// @param texture テクスチャ名
+/// @return テクスチャ名のポインタ, テクスチャ名が 0 なら nullptr
+///
+static std::shared_ptr<GLuint> makeTexture(GLuint texture)
+{
+  if (texture == 0) return nullptr;
+  return std::shared_ptr<GLuint>(new GLuint{ texture }, [](GLuint* texture)
+    {
+      glDeleteTextures(1, texture);
+      delete texture;
+    });
+}
+
+///
+/// 別スレッドで展開した画像
 ///
-static GLuint loadImage(const std::string& name)
+struct Menu::Image
 {
-  // 画像サイズ
+  /// 画像サイズ
   int width, height;
 
-  // 画像のチャンネル数
+  /// 画像のチャンネル数
   int channels;
 
+  /// 画素データ
+  std::unique_ptr<stbi_uc, decltype(&stbi_image_free)> pixels;
+};
+
+///
+/// 画像ファイルを展開する
+///
+/// @param name 読み込む画像ファイル名
+/// @return 展開した画像, 読み込めなかったら nullptr
+///
+/// @note
+/// OpenGL を使わないので描画スレッド以外から呼び出してもよい.
+///
+static std::shared_ptr<const Menu::Image> decodeImage(const std::string& name)
+{
   // 画像を読み込む
-  const auto image{ stbi_load(name.c_str(), &width, &height, &channels, 0) };
+  int width, height, channels;
+  const auto pixels{ stbi_load(name.c_str(), &width, &height, &channels, 0) };
 
   // 画像が読み込めなかったら戻る
-  if (!image) return 0;
+  if (!pixels) return nullptr;
 
+  return std::make_shared<const Menu::Image>(Menu::Image{ width, height, channels, { pixels, stbi_image_free } });
+}
+
+///
+/// 展開した画像からテクスチャを作成する
+///
+/// @param image 展開した画像
+/// @param bytes テクスチャのバイト数の格納先
+/// @return テクスチャ名のポインタ
+///
+static std::shared_ptr<GLuint> loadImage(const Menu::Image& image, std::size_t& bytes)
+{
   // 画像のフォーマットは読み込んだファイルに合わせる
   GLenum format[]{ GL_RGBA, GL_RED, GL_RG, GL_RGB, GL_RGBA };
 
   // テクスチャに読み込む
-  const auto tex{ ggLoadTexture(image, width, height,
-    format[channels], GL_UNSIGNED_BYTE, format[channels], GL_CLAMP_TO_EDGE, false)};
+  const auto tex{ ggLoadTexture(image.pixels.get(), image.width, image.height,
+    format[image.channels], GL_UNSIGNED_BYTE, format[image.channels], GL_CLAMP_TO_EDGE, false)};
+
+  // 鏡の勾配の分布で広げた反射光は縮小した投影光源マップを参照する
+  glGenerateMipmap(GL_TEXTURE_2D);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 
-  // 読み込んだ画像のメモリを開放する
-  stbi_image_free(image);
+  // ミップマップを含めたテクスチャのバイト数
+  bytes = static_cast<std::size_t>(image.width) * image.height * image.channels * 4 / 3;
 
   // テクスチャ名を返す
-  return tex;
+  return makeTexture(tex);
+}
+
+///
+/// 以前に作ったタイル化した高さマップのファイルが元のファイルより新しいかどうか
+///
+/// @param path 高さマップのファイル名
+/// @return タイル化した高さマップのファイルを使うなら true
+///
+static bool hasNewerTiles(const std::string& path)
+{
+  std::error_code error;
+  const auto source{ std::filesystem::last_write_time(std::filesystem::u8path(path), error) };
+  const auto tiles{ error ? source : std::filesystem::last_write_time(std::filesystem::u8path(path + tiledExtension), error) };
+  return !error && tiles >= source;
 }
 
 //
@@ -150,13 +234,23 @@ static GLuint loadImage(const std::string& name)
 Menu::Menu(const Config& config) :
   defaults{ config },
   settings{ config },
+  cache{ static_cast<std::size_t>(config.resourceCacheBudget) << 20 },
   light{ std::make_unique<GgSimpleShader::LightBuffer>() },
   illuminant{ std::make_unique<GgSimpleShader::LightBuffer>() },
-  illuminantMap{ loadImage(config.illuminantMap) },
-  mirrorMaterialBuffer{ [] { GLuint ubo; glGenBuffers(1, &ubo); return ubo; }() },
-  mirrorHeightMap{ loadImage(config.mirrorHeightMap) },
+  mirrorMaterialBuffer{ GL_UNIFORM_BUFFER },
   mirrorSampleBuffer{ [] { GLuint ubo; glGenBuffers(1, &ubo); return ubo; }() },
-  receiverModel{ std::make_unique<GgSimpleObj>(config.receiverModel, true) },
+  mirrorInstanceBuffer{ GL_UNIFORM_BUFFER },
+  selectedMirror{ 0 },
+  occluderBuffer{},
+  occluderTexture{},
+  selectedReceiver{ 0 },
+  showTimer{ false },
+  controller{ config.mirrorSampleCount },
+  revision{ 0 },
+  wasActive{ false },
+  tiles{},
+  showDebug{ false },
+  debugSeverity{ 1 },
   drawMode{ DRAW_MIRROR }
 {
 #if defined(IMGUI_VERSION)
@@ -191,20 +285,36 @@ Menu::Menu(const Config& config) :
   setIlluminantIntensity();
   setIlluminantPose();
 
-  // 鏡の材質のユニフォームバッファオブジェクトを作成する
-  glBindBuffer(GL_UNIFORM_BUFFER, mirrorMaterialBuffer);
-  glBufferData(GL_UNIFORM_BUFFER, sizeof(GgSimpleShader::Material), nullptr, GL_STATIC_DRAW);
-  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  // 投影光源マップを読み込む
+  createIlluminantMap(config.illuminantMap);
 
-  // 鏡の材質と姿勢を初期化する
+  // 鏡の材質を初期化する
   setMirrorMaterial();
-  setMirrorPose();
+
+  // すべての鏡の姿勢と高さマップを初期化する
+  resetMirrors();
 
   // 鏡の標本点を生成する
   generateMirrorSample(MAX_MIRROR_SAMPLES);
 
-  // 受光面の姿勢を初期化する
-  setReceiverPose();
+  // 受光面の材質のユニフォームバッファオブジェクトを作成する
+  receiverMaterial = std::make_unique<GgSimpleShader::MaterialBuffer>(nullptr, MAX_RECEIVERS, GL_DYNAMIC_DRAW);
+
+  // 受光面の境界ボリューム階層を格納するバッファオブジェクトとバッファテクスチャを作成する
+  glGenBuffers(static_cast<GLsizei>(occluderBuffer.size()), occluderBuffer.data());
+  glGenTextures(static_cast<GLsizei>(occluderTexture.size()), occluderTexture.data());
+  for (std::size_t i = 0; i < occluderBuffer.size(); ++i)
+  {
+    glBindBuffer(GL_TEXTURE_BUFFER, occluderBuffer[i]);
+    glBufferData(GL_TEXTURE_BUFFER, sizeof(std::array<GLfloat, 4>), nullptr, GL_STATIC_DRAW);
+    glBindTexture(GL_TEXTURE_BUFFER, occluderTexture[i]);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, occluderBuffer[i]);
+  }
+  glBindTexture(GL_TEXTURE_BUFFER, 0);
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+  // すべての受光面の形状と姿勢と材質を初期化する
+  resetReceivers();
 }
 
 //
@@ -212,17 +322,12 @@ Menu::Menu(const Config& config) :
 //
 Menu::~Menu()
 {
-  // 鏡の材質のユニフォームバッファオブジェクトを削除する
-  glDeleteBuffers(1, &mirrorMaterialBuffer);
-
   // 鏡の標本点のユニフォームバッファオブジェクトを削除する
   glDeleteBuffers(1, &mirrorSampleBuffer);
 
-  // 鏡の高さマップのテクスチャを削除する
-  glDeleteTextures(1, &mirrorHeightMap);
-
-  // 投影光源マップのテクスチャを削除する
-  glDeleteTextures(1, &illuminantMap);
+  // 受光面の境界ボリューム階層のバッファテクスチャとバッファオブジェクトを削除する
+  glDeleteTextures(static_cast<GLsizei>(occluderTexture.size()), occluderTexture.data());
+  glDeleteBuffers(static_cast<GLsizei>(occluderBuffer.size()), occluderBuffer.data());
 
   // Native File Dialog Extended を終了する
   NFD_Quit();
@@ -231,13 +336,13 @@ Menu::~Menu()
 //
 // ファイルパスを取得する
 //
-bool Menu::getFilePath(std::string& path, const nfdfilteritem_t* filter)
+bool Menu::getFilePath(std::string& path, const nfdfilteritem_t* filter, nfdfiltersize_t count)
 {
   // ファイルダイアログから得るパス
   nfdchar_t* filepath{ nullptr };
 
   // ファイルダイアログを開く
-  if (NFD_OpenDialog(&filepath, filter, 1, nullptr) == NFD_OKAY)
+  if (NFD_OpenDialog(&filepath, filter, count, nullptr) == NFD_OKAY)
   {
     path = TCharToUtf8(filepath);
     return true;
@@ -246,6 +351,37 @@ bool Menu::getFilePath(std::string& path, const nfdfilteritem_t* filter)
   return false;
 }
 
+//
+// 資源を別スレッドで読み込む
+//
+void Menu::startLoading(std::function<std::function<bool()>()>&& decode)
+{
+  // 前の読み込みが終わっていなければ待ってから切り替える
+  finishLoading(true);
+
+  // ファイルの読み込みと展開を別スレッドで始める
+  pendingLoad = std::async(std::launch::async, std::move(decode));
+}
+
+//
+// 別スレッドで読み込んだ資源に切り替える
+//
+void Menu::finishLoading(bool wait)
+{
+  // 読み込み中の資源が無ければ何もしない
+  if (!pendingLoad.valid()) return;
+
+  // 待たないときは読み込みが終わっていなければ次のフレームで調べ直す
+  if (!wait && pendingLoad.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+
+  // 読み込んだ資源に描画スレッドで切り替える (失敗したら errorMessage が設定される)
+  const auto apply{ pendingLoad.get() };
+  if (apply) apply();
+
+  // 描画結果が変わるのでシーンの版数を進める
+  ++revision;
+}
+
 //
 // 設定ファイルを読み込む
 //
@@ -257,12 +393,24 @@ void Menu::loadConfig()
   // ファイルダイアログを開く
   if (NFD_OpenDialog(&filepath, jsonFilter, 1, NULL) == NFD_OKAY)
   {
-    // 現在の構成を構成ファイルの内容にする
-    if (!settings.load(filepath))
-    {
-      // 読み込めなかった
-      errorMessage = u8"設定ファイルが読み込めません";
-    }
+    // 鏡や受光面の資源を作り直すので構成は描画スレッドで切り替える
+    std::lock_guard<std::mutex> lock{ mutex };
+    post([this, path = std::string(filepath)]()
+      {
+        // 読み込み中の資源は構成が変わる前に反映しておく
+        finishLoading(true);
+
+        // 現在の構成を構成ファイルの内容にする
+        if (!settings.load(path))
+        {
+          // 読み込めなかった
+          errorMessage = u8"設定ファイルが読み込めません";
+        }
+
+        // 鏡や受光面の数が変わるかもしれないので作り直す
+        resetMirrors();
+        resetReceivers();
+      });
 
     // ファイルパスの取り出しに使ったメモリを開放する
     NFD_FreePath(filepath);
@@ -280,6 +428,9 @@ void Menu::saveConfig() const
   // ファイルダイアログを開く
   if (NFD_SaveDialog(&filepath, jsonFilter, 1, NULL, "*.json") == NFD_OKAY)
   {
+    // ダイアログを閉じてからメニューをロックする
+    std::lock_guard<std::mutex> lock{ mutex };
+
     // 現在の設定で構成を更新する
     const_cast<Config&>(defaults) = settings;
 
@@ -296,36 +447,328 @@ void Menu::saveConfig() const
 }
 
 //
-// 鏡の高さマップを読み込む
+// 鏡の高さマップのファイルを読み込む
 //
-void Menu::loadMirrorHeightMap()
+bool Menu::readMirrorHeightMap(std::size_t index, const std::string& path, std::shared_ptr<HeightMap> decoded)
 {
-  // 鏡の高さマップのファイル名
-  std::string path{ settings.illuminantMap };
+  // タイル化した高さマップは鏡がひとつのときしか使えない
+  const auto single{ settings.mirrors.size() == 1 };
 
-  // ファイルダイアログから得るパス
-  if (getFilePath(path, imageFilter))
-  {
-    // 鏡の高さマップを読み込んでテクスチャを作成する
-    const auto height{ loadImage(path) };
+  // タイル化した高さマップのファイル名
+  auto tiledPath{ path };
 
-    // 読み込みに成功したら
-    if (height != 0)
+  // タイル化した高さマップのファイルでなければ
+  const auto extension{ sizeof tiledExtension - 1 };
+  if (path.size() < extension || path.compare(path.size() - extension, extension, tiledExtension) != 0)
+  {
+    // 以前に作ったタイル化したファイルが元のファイルより新しければそれを使う
+    if (single && hasNewerTiles(path)) return readMirrorHeightMap(index, path + tiledExtension);
+
+    // 高さマップが一枚のテクスチャに収まらなければ true
+    bool oversized{ false };
+
+    // 鏡の高さマップをキャッシュから取り出すか読み込む
+    auto height{ cache.get<HeightMap>(heightKind, path, "",
+      [&](std::size_t& bytes) -> std::shared_ptr<HeightMap>
+      {
+        // 鏡の高さマップを単一チャンネルで読み込む (別スレッドで展開済みならそれを使う)
+        auto heightMap{ decoded ? std::move(decoded) : std::make_shared<HeightMap>(path) };
+        if (!*heightMap) return nullptr;
+
+        // テクスチャの最大サイズ
+        GLint maxSize;
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+
+        // 一枚のテクスチャに収まらなければ鏡がひとつのときだけタイル化したファイルを作る
+        if (heightMap->getWidth() > maxSize || heightMap->getHeight() > maxSize)
+        {
+          oversized = true;
+          if (!single) return nullptr;
+          tiledPath += tiledExtension;
+          if (!TiledHeightMap::build(*heightMap, tiledPath)) tiledPath.clear();
+          return nullptr;
+        }
+
+        // 高さのデータのバイト数
+        bytes = heightMap->get().size() * sizeof(GLushort);
+        return heightMap;
+      }) };
+
+    // 読み込めたら
+    if (height)
     {
-      // ファイル名を保存する
-      settings.mirrorHeightMap = path;
+      // ファイル名を保存する (高さマップを使うときは背面の模様は使わない)
+      settings.mirrors[index].heightMap = path;
+      settings.mirrors[index].reliefMap.clear();
 
-      // それまで使っていたテクスチャを破棄して
-      glDeleteTextures(1, &mirrorHeightMap);
+      // 高さマップを切り替える
+      mirrorHeightData[index] = std::move(height);
+      mirrorTiledHeightMap.reset();
 
-      // テクスチャ名を保存する
-      mirrorHeightMap = height;
+      return true;
     }
-    else
+
+    // 読み込みに失敗したらエラーにする
+    if (!oversized)
     {
-      // 読み込みに失敗したらエラーにする
       errorMessage = u8"高さマップが読み込めません";
+      return false;
     }
+
+    // タイル化に失敗したらエラーにする
+    if (tiledPath.empty())
+    {
+      errorMessage = u8"高さマップをタイル化できません";
+      return false;
+    }
+  }
+
+  // 鏡が複数あればタイル化した高さマップは使えない
+  if (!single)
+  {
+    errorMessage = u8"鏡が複数あるときはタイル化した高さマップは使えません";
+    return false;
+  }
+
+  // タイル化した高さマップをキャッシュから取り出すか開く
+  const auto budget{ static_cast<std::size_t>(settings.mirrorTileBudget) << 20 };
+  auto tiled{ cache.get<TiledHeightMap>(heightKind, tiledPath, "",
+    [&](std::size_t& bytes) -> std::shared_ptr<TiledHeightMap>
+    {
+      auto tiled{ std::make_shared<TiledHeightMap>(tiledPath, budget) };
+      if (!*tiled) return nullptr;
+      bytes = budget;
+      return tiled;
+    }) };
+
+  // 開けなかったらエラーにする
+  if (!tiled)
+  {
+    errorMessage = u8"タイル化した高さマップが読み込めません";
+    return false;
+  }
+
+  // ファイル名を保存する (高さマップを使うときは背面の模様は使わない)
+  settings.mirrors[index].heightMap = tiledPath;
+  settings.mirrors[index].reliefMap.clear();
+
+  // タイル化した高さマップに切り替える
+  mirrorTiledHeightMap = std::move(tiled);
+  mirrorHeightData[index].reset();
+
+  return true;
+}
+
+//
+// 鏡の高さマップとその勾配のモーメントのテクスチャ配列を作成する
+//
+void Menu::createMirrorHeightArray()
+{
+  // 鏡の番号をレイヤ番号にする
+  std::vector<const HeightMap*> maps;
+  for (const auto& heightMap : mirrorHeightData) maps.push_back(heightMap.get());
+
+  // タイル化していればテクスチャ配列は作らない
+  mirrorHeightMap = mirrorTiledHeightMap ? nullptr
+    : makeTexture(HeightMap::createTextureArray(maps, settings.mirrorHeightCompression));
+
+  // 勾配の分布で反射光を広げるときだけ勾配のモーメントのテクスチャ配列を作る
+  const auto moments{ mirrorHeightMap && settings.mirrorSlopeFilter
+    ? HeightMap::createMomentArray(maps) : std::array<GLuint, 2>{} };
+  for (std::size_t k = 0; k < moments.size(); ++k) mirrorMomentMap[k] = makeTexture(moments[k]);
+}
+
+//
+// 鏡の高さマップを作成する
+//
+bool Menu::createMirrorHeightMap(std::size_t index, const std::string& path, std::shared_ptr<HeightMap> decoded)
+{
+  // 鏡の高さマップを読み込む
+  if (!readMirrorHeightMap(index, path, std::move(decoded))) return false;
+
+  // テクスチャ配列を作り直す
+  createMirrorHeightArray();
+
+  return true;
+}
+
+//
+// 鏡の高さマップを読み込む
+//
+void Menu::loadMirrorHeightMap()
+{
+  // 選択している鏡とその高さマップのファイル名
+  std::unique_lock<std::mutex> lock{ mutex };
+  const auto index{ selectedMirror };
+  std::string path{ settings.mirrors[index].heightMap };
+  lock.unlock();
+
+  // ファイルダイアログから得るパスの高さマップを描画スレッドで読み込む
+  if (getFilePath(path, heightFilter, static_cast<nfdfiltersize_t>(std::size(heightFilter))))
+  {
+    lock.lock();
+    post([this, index, path]() { requestMirrorHeightMap(index, path); });
+  }
+}
+
+//
+// 鏡の高さマップを別スレッドで展開してから作成する
+//
+void Menu::requestMirrorHeightMap(std::size_t index, const std::string& path)
+{
+  // コマンドを実行する前に鏡が削除されていたら何もしない
+  if (index >= settings.mirrors.size()) return;
+
+  // キャッシュにあるかタイル化したファイルを使うなら展開する必要がないのですぐに切り替える
+  const auto extension{ sizeof tiledExtension - 1 };
+  if (cache.contains(heightKind, path, "") || hasNewerTiles(path)
+    || (path.size() >= extension && path.compare(path.size() - extension, extension, tiledExtension) == 0))
+  {
+    createMirrorHeightMap(index, path);
+    return;
+  }
+
+  // 高さマップの展開は別スレッドで行い, テクスチャの作成は描画スレッドで行う
+  startLoading([this, index, path]()
+    {
+      auto decoded{ std::make_shared<HeightMap>(path) };
+      return std::function<bool()>{ [this, index, path, decoded]()
+        {
+          // 読み込み中に鏡が削除されていたら何もしない
+          if (index >= settings.mirrors.size()) return false;
+          return createMirrorHeightMap(index, path, decoded);
+        } };
+    });
+}
+
+//
+// 鏡の背面の模様の板の条件を取り出す
+//
+MirrorRelief::Plate Menu::getMirrorPlate(std::size_t index) const
+{
+  const auto& mirror{ settings.mirrors[index] };
+  return { mirror.plateDiameter, mirror.plateThickness, mirror.reliefDepth,
+    mirror.plateModulus, mirror.platePoisson, mirror.polishingPressure };
+}
+
+//
+// 鏡の背面の模様から研磨時のたわみを求めて高さマップにする
+//
+bool Menu::readMirrorRelief(std::size_t index, const std::string& path,
+  std::shared_ptr<MirrorRelief> decoded, std::shared_ptr<HeightMap> solved, GLfloat scale)
+{
+  // 背面の模様をキャッシュから取り出すか読み込む
+  const auto relief{ cache.get<MirrorRelief>(reliefKind, path, "",
+    [&](std::size_t& bytes) -> std::shared_ptr<MirrorRelief>
+    {
+      // 背面の模様を単一チャンネルで読み込む (別スレッドで展開済みならそれを使う)
+      auto relief{ decoded ? std::move(decoded) : std::make_shared<MirrorRelief>(path) };
+      if (!*relief) return nullptr;
+
+      // 模様の高さのデータのバイト数
+      bytes = relief->get().size() * sizeof(GLfloat);
+      return relief;
+    }) };
+
+  // 別スレッドでたわみを求めていなければここで求める
+  if (relief && !solved) solved = relief->solve(getMirrorPlate(index), scale);
+
+  // 読み込めなかったらエラーにする
+  if (!solved)
+  {
+    errorMessage = u8"背面の模様が読み込めません";
+    return false;
+  }
+
+  // 求めた高さマップはタイル化しないので一枚のテクスチャに収まらなければエラーにする
+  GLint maxSize;
+  glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+  if (solved->getWidth() > maxSize || solved->getHeight() > maxSize)
+  {
+    errorMessage = u8"背面の模様が大きすぎます";
+    return false;
+  }
+
+  // ファイル名とたわみに合わせた高さのスケールを保存する
+  settings.mirrors[index].reliefMap = path;
+  settings.mirrors[index].heightScale = scale;
+
+  // 高さマップを切り替える
+  mirrorHeightData[index] = std::move(solved);
+  mirrorTiledHeightMap.reset();
+
+  return true;
+}
+
+//
+// 鏡の背面の模様から高さマップを作成する
+//
+bool Menu::createMirrorRelief(std::size_t index, const std::string& path,
+  std::shared_ptr<MirrorRelief> decoded, std::shared_ptr<HeightMap> solved, GLfloat scale)
+{
+  // 鏡の背面の模様から高さマップを求める
+  if (!readMirrorRelief(index, path, std::move(decoded), std::move(solved), scale)) return false;
+
+  // テクスチャ配列を作り直す
+  createMirrorHeightArray();
+
+  return true;
+}
+
+//
+// 鏡の背面の模様の展開とたわみの計算を別スレッドで行ってから高さマップを作成する
+//
+void Menu::requestMirrorRelief(std::size_t index, const std::string& path)
+{
+  // コマンドを実行する前に鏡が削除されていたら何もしない
+  if (index >= settings.mirrors.size()) return;
+
+  // 板の条件は描画スレッドで取り出しておく
+  const auto plate{ getMirrorPlate(index) };
+
+  // キャッシュにあれば展開は省く
+  const auto cached{ cache.contains(reliefKind, path, "")
+    ? cache.get<MirrorRelief>(reliefKind, path, "", [](std::size_t&) -> std::shared_ptr<MirrorRelief> { return nullptr; })
+    : nullptr };
+
+  // 模様の展開とたわみの計算は別スレッドで行い, テクスチャの作成は描画スレッドで行う
+  startLoading([this, index, path, plate, cached]()
+    {
+      auto decoded{ cached ? cached : std::make_shared<MirrorRelief>(path) };
+      GLfloat scale;
+      auto solved{ decoded->solve(plate, scale) };
+      return std::function<bool()>{ [this, index, path, decoded, solved, scale]()
+        {
+          // 読み込み中に鏡が削除されていたら何もしない
+          if (index >= settings.mirrors.size()) return false;
+
+          // 読み込めなければ描画スレッドで読み直さずにエラーにする
+          if (!solved)
+          {
+            errorMessage = u8"背面の模様が読み込めません";
+            return false;
+          }
+          return createMirrorRelief(index, path, decoded, solved, scale);
+        } };
+    });
+}
+
+//
+// 鏡の背面の模様を読み込む
+//
+void Menu::loadMirrorRelief()
+{
+  // 選択している鏡とその背面の模様のファイル名
+  std::unique_lock<std::mutex> lock{ mutex };
+  const auto index{ selectedMirror };
+  std::string path{ settings.mirrors[index].reliefMap };
+  lock.unlock();
+
+  // ファイルダイアログから得るパスの背面の模様を描画スレッドで読み込む
+  if (getFilePath(path, imageFilter))
+  {
+    lock.lock();
+    post([this, index, path]() { requestMirrorRelief(index, path); });
   }
 }
 
@@ -335,32 +778,75 @@ void Menu::loadMirrorHeightMap()
 void Menu::loadIlluminantMap()
 {
   // 投影光源マップのファイル名
+  std::unique_lock<std::mutex> lock{ mutex };
   std::string path{ settings.illuminantMap };
+  lock.unlock();
 
-  // ファイルダイアログから得るパス
+  // ファイルダイアログから得るパスの投影光源マップを描画スレッドで読み込む
   if (getFilePath(path, imageFilter))
   {
-    // 投影光源マップを読み込んでテクスチャを作成する
-    const auto color{ loadImage(path) };
+    lock.lock();
+    post([this, path]() { requestIlluminantMap(path); });
+  }
+}
 
-    // 読み込みに成功したら
-    if (color != 0)
-    {
-      // ファイル名を保存する
-      settings.illuminantMap = path;
+//
+// 投影光源マップを別スレッドで展開してから作成する
+//
+void Menu::requestIlluminantMap(const std::string& path)
+{
+  // キャッシュにあれば展開する必要がないのですぐに切り替える
+  if (cache.contains(illuminantKind, path, ""))
+  {
+    createIlluminantMap(path);
+    return;
+  }
 
-      // それまで使っていたテクスチャを破棄して
-      glDeleteTextures(1, &illuminantMap);
+  // 画像の展開は別スレッドで行い, テクスチャの作成は描画スレッドで行う
+  startLoading([this, path]()
+    {
+      const auto decoded{ decodeImage(path) };
+      return std::function<bool()>{ [this, path, decoded]()
+        {
+          // 展開できなければ描画スレッドで読み直さずにエラーにする
+          if (!decoded)
+          {
+            errorMessage = u8"光源マップが読み込めません";
+            return false;
+          }
+          return createIlluminantMap(path, decoded);
+        } };
+    });
+}
 
-      // テクスチャ名を保存する
-      illuminantMap = color;
-    }
-    else
+//
+// 投影光源マップを作成する
+//
+bool Menu::createIlluminantMap(const std::string& path, std::shared_ptr<const Image> decoded)
+{
+  // 投影光源マップのテクスチャをキャッシュから取り出すか作成する
+  auto color{ cache.get<GLuint>(illuminantKind, path, "",
+    [&](std::size_t& bytes) -> std::shared_ptr<GLuint>
     {
-      // 読み込みに失敗したらエラーにする
-      errorMessage = u8"光源マップが読み込めません";
-    }
+      // 別スレッドで展開していなければここで展開する
+      if (!decoded) decoded = decodeImage(path);
+      return decoded ? loadImage(*decoded, bytes) : nullptr;
+    }) };
+
+  // 読み込みに失敗したらエラーにする
+  if (!color)
+  {
+    errorMessage = u8"光源マップが読み込めません";
+    return false;
   }
+
+  // ファイル名を保存する
+  settings.illuminantMap = path;
+
+  // テクスチャを切り替える (それまで使っていたテクスチャはキャッシュに残る)
+  illuminantMap = std::move(color);
+
+  return true;
 }
 
 //
@@ -368,31 +854,217 @@ void Menu::loadIlluminantMap()
 //
 void Menu::loadReceiverModel()
 {
-  // ファイルダイアログから得るパス
-  nfdchar_t* filepath;
+  // 選択している受光面とその形状ファイル名
+  std::unique_lock<std::mutex> lock{ mutex };
+  const auto index{ selectedReceiver };
+  std::string path{ settings.receivers[index].model };
+  lock.unlock();
+
+  // ファイルダイアログから得るパスの形状ファイルを描画スレッドで読み込む
+  if (getFilePath(path, shapeFilter))
+  {
+    lock.lock();
+    post([this, index, path]() { createReceiverModel(index, path); });
+  }
+}
 
-  // ファイルダイアログを開く
-  if (NFD_OpenDialog(&filepath, shapeFilter, 1, NULL) == NFD_OKAY)
+//
+// 受光面の形状を作成する
+//
+bool Menu::createReceiverModel(std::size_t index, const std::string& path)
+{
+  // コマンドを実行する前に受光面が削除されていたら何もしない
+  if (index >= settings.receivers.size()) return false;
+
+  // 形状ファイルは形状か境界ボリューム階層がキャッシュに無いときに一度だけ読み込む
+  std::vector<std::array<GLuint, 3>> group;
+  std::vector<GgSimpleShader::Material> material;
+  std::vector<GgVertex> vert;
+  std::vector<GLuint> face;
+  bool parsed{ false }, loaded{ false };
+  const auto load{ [&]()
+    {
+      if (!parsed) loaded = ggLoadSimpleObj(path, group, material, vert, face, true);
+      parsed = true;
+      return loaded;
+    } };
+
+  // 受光面の形状をキャッシュから取り出すか読み込む
+  auto model{ cache.get<GgSimpleObj>(receiverKind, path, "",
+    [&](std::size_t& bytes) -> std::shared_ptr<GgSimpleObj>
+    {
+      if (!load()) return nullptr;
+      auto object{ std::make_shared<GgSimpleObj>(group, material, vert, face) };
+      if (!*object) return nullptr;
+
+      // 頂点と指標のバイト数
+      const auto* const elements{ dynamic_cast<const GgElements*>(object->get()) };
+      bytes = object->get()->getCount() * sizeof(GgVertex)
+        + (elements ? elements->getIndexCount() * sizeof(GLuint) : 0);
+
+      return object;
+    }) };
+
+  // 読み込めなかったらエラーにする
+  if (!model)
   {
-    auto path{ TCharToUtf8(filepath) };
-    GgSimpleObj object(filepath, true);
-    if (object)
+    errorMessage = u8"形状ファイルが読み込めません";
+    return false;
+  }
+
+  // 受光面の形状ファイル名を保存する
+  settings.receivers[index].model = path;
+
+  // 受光面の形状を切り替える
+  receiverModel[index] = std::move(model);
+
+  // 受光面の形状の境界ボリューム階層をキャッシュから取り出すか作成する
+  receiverBvh[index] = cache.get<Bvh>(receiverKind, path, "bvh",
+    [&](std::size_t& bytes) -> std::shared_ptr<Bvh>
     {
-      // 受光面の形状ファイル名を保存する
-      settings.receiverModel = path;
+      if (!load()) return nullptr;
+      auto bvh{ std::make_shared<Bvh>(vert, face) };
+      if (!*bvh) return nullptr;
+      bytes = bvh->getSize();
+      return bvh;
+    });
 
-      // 受光面のモデルを読み込む
-      receiverModel = std::make_unique<GgSimpleObj>(object);
-    }
-    else
+  // すべての受光面の境界ボリューム階層をまとめ直す
+  createOccluder();
+
+  return true;
+}
+
+//
+// すべての受光面の境界ボリューム階層をまとめてバッファオブジェクトに格納する
+//
+void Menu::createOccluder()
+{
+  // 受光面ごとの境界ボリューム階層を連結する
+  std::vector<std::array<GLfloat, 4>> nodes, triangles;
+  occluder.assign(receiverBvh.size(), { -1, 0 });
+  for (std::size_t i = 0; i < receiverBvh.size(); ++i)
+  {
+    const auto& bvh{ receiverBvh[i] };
+    if (bvh) occluder[i] = { bvh->append(nodes, triangles), bvh->isConvex() ? 1 : 0 };
+  }
+
+  // バッファテクスチャの大きさの上限を超えたら遮蔽を調べない
+  GLint limit;
+  glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &limit);
+  if (nodes.size() > static_cast<std::size_t>(limit) || triangles.size() > static_cast<std::size_t>(limit))
+  {
+    errorMessage = u8"受光面の形状が大きすぎて遮蔽を調べられません";
+    occluder.assign(receiverBvh.size(), { -1, 0 });
+    return;
+  }
+
+  // バッファオブジェクトに転送する
+  const std::array<const std::vector<std::array<GLfloat, 4>>*, 2> data{ &nodes, &triangles };
+  for (std::size_t i = 0; i < occluderBuffer.size(); ++i)
+  {
+    glBindBuffer(GL_TEXTURE_BUFFER, occluderBuffer[i]);
+    glBufferData(GL_TEXTURE_BUFFER, data[i]->size() * sizeof(std::array<GLfloat, 4>),
+      data[i]->data(), GL_STATIC_DRAW);
+  }
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+//
+// 受光面の材質を設定する
+//
+void Menu::setReceiverMaterial(std::size_t index)
+{
+  // コマンドを実行する前に受光面が削除されていたら何もしない
+  if (index >= settings.receivers.size()) return;
+
+  const auto& receiver{ settings.receivers[index] };
+  receiverMaterial->load(GgSimpleShader::Material{ receiver.diffuse, receiver.diffuse,
+    receiver.specular, receiver.shininess }, static_cast<GLint>(index));
+}
+
+//
+// 構成データに合わせてすべての受光面を作り直す
+//
+void Menu::resetReceivers()
+{
+  // 受光面がひとつも無ければデフォルトの受光面を置く
+  if (settings.receivers.empty()) settings.receivers = Config{}.receivers;
+
+  // 受光面の数の上限を超えないようにする
+  if (settings.receivers.size() > MAX_RECEIVERS) settings.receivers.resize(MAX_RECEIVERS);
+
+  // 受光面ごとのデータを作り直す
+  const auto count{ settings.receivers.size() };
+  receiverModel.assign(count, nullptr);
+  receiverBvh.assign(count, nullptr);
+  receiverPose.resize(count);
+  selectedReceiver = 0;
+
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    // 受光面の形状を読み込む (読み込めなくても空の形状にしておく)
+    const auto path{ settings.receivers[i].model };
+    if (!createReceiverModel(i, path))
     {
-      // 読み込めなかったらエラーにする
-      errorMessage = u8"形状ファイルが読み込めません";
+      receiverModel[i] = std::make_shared<GgSimpleObj>(path, true);
+      createOccluder();
     }
 
-    // ファイルパスの取り出しに使ったメモリを開放する
-    NFD_FreePath(filepath);
+    // 受光面の姿勢と材質を設定する
+    setReceiverPose(i);
+    setReceiverMaterial(i);
+  }
+}
+
+//
+// 選択している受光面を複製して追加する
+//
+void Menu::addReceiver()
+{
+  // 受光面の数の上限に達していたら追加しない
+  if (settings.receivers.size() >= MAX_RECEIVERS)
+  {
+    errorMessage = u8"これ以上受光面を追加できません";
+    return;
   }
+
+  // 選択している受光面を少しずらして複製する
+  auto receiver{ settings.receivers[selectedReceiver] };
+  receiver.position[0] += 0.5f * receiver.position[3];
+  settings.receivers.push_back(receiver);
+  receiverModel.push_back(receiverModel[selectedReceiver]);
+  receiverBvh.push_back(receiverBvh[selectedReceiver]);
+  receiverPose.emplace_back();
+  createOccluder();
+
+  // 追加した受光面を選択する
+  selectedReceiver = settings.receivers.size() - 1;
+  setReceiverPose(selectedReceiver);
+  setReceiverMaterial(selectedReceiver);
+}
+
+//
+// 選択している受光面を削除する
+//
+void Menu::removeReceiver()
+{
+  // 最後のひとつは削除しない
+  if (settings.receivers.size() <= 1) return;
+
+  // 選択している受光面を削除する
+  settings.receivers.erase(settings.receivers.begin() + selectedReceiver);
+  receiverModel.erase(receiverModel.begin() + selectedReceiver);
+  receiverBvh.erase(receiverBvh.begin() + selectedReceiver);
+  receiverPose.erase(receiverPose.begin() + selectedReceiver);
+  createOccluder();
+  if (selectedReceiver >= settings.receivers.size()) selectedReceiver = settings.receivers.size() - 1;
+
+  // 受光面ごとの材質を詰め直す
+  for (auto i = selectedReceiver; i < settings.receivers.size(); ++i) setReceiverMaterial(i);
+
+  // 選択している受光面の視界にする
+  setReceiverPose(selectedReceiver);
 }
 
 //
@@ -439,13 +1111,12 @@ void Menu::setIlluminantPose()
 //
 void Menu::setMirrorMaterial()
 {
-  glBindBuffer(GL_UNIFORM_BUFFER, mirrorMaterialBuffer);
-  auto* const material{ static_cast<GgSimpleShader::Material*>(glMapBuffer(GL_UNIFORM_BUFFER, GL_WRITE_ONLY)) };
-  material->ambient = material->diffuse = settings.mirrorMaterialDiffuse;
-  material->specular = settings.mirrorMaterialSpecular;
-  material->shininess = settings.mirrorMaterialShininess;
-  glUnmapBuffer(GL_UNIFORM_BUFFER);
-  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  // GPU が読んでいるかもしれない領域を避けて次の領域に書き込む
+  GgSimpleShader::Material material;
+  material.ambient = material.diffuse = settings.mirrorMaterialDiffuse;
+  material.specular = settings.mirrorMaterialSpecular;
+  material.shininess = settings.mirrorMaterialShininess;
+  mirrorMaterialBuffer.send(&material);
 }
 
 //
@@ -453,10 +1124,6 @@ void Menu::setMirrorMaterial()
 //
 void Menu::generateMirrorSample(int samples)
 {
-  // シェーダストレージバッファオブジェクトを作成する
-  glBindBuffer(GL_UNIFORM_BUFFER, mirrorSampleBuffer);
-  glBufferData(GL_UNIFORM_BUFFER, sizeof(std::array<GLfloat, 2>) * samples, nullptr, GL_STATIC_DRAW);
-
   // 擬似乱数生成器
   std::mt19937 engine(11);
 
@@ -464,8 +1131,8 @@ void Menu::generateMirrorSample(int samples)
   std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
   
   // 鏡の標本点を生成する
-  auto* const sample{ static_cast<std::array<GLfloat, 4>*>(glMapBuffer(GL_UNIFORM_BUFFER, GL_WRITE_ONLY)) };
-  for (int i = 0; i < samples;)
+  mirrorSample.clear();
+  while (static_cast<int>(mirrorSample.size()) < samples)
   {
     // 一様乱数を生成する
     const auto u{ dist(engine) };
@@ -475,43 +1142,371 @@ void Menu::generateMirrorSample(int samples)
     if (u * u + v * v >= 1.0f) continue;
 
     // 標本点を格納する
-    sample[i++] = { u, v, 0.0f, 1.0f };
+    mirrorSample.push_back({ u, v, 0.0f, 1.0f });
   }
-  glUnmapBuffer(GL_UNIFORM_BUFFER);
+
+  // ユニフォームバッファオブジェクトに転送する
+  glBindBuffer(GL_UNIFORM_BUFFER, mirrorSampleBuffer);
+  glBufferData(GL_UNIFORM_BUFFER, sizeof(std::array<GLfloat, 4>) * mirrorSample.size(),
+    mirrorSample.data(), GL_STATIC_DRAW);
   glBindBuffer(GL_UNIFORM_BUFFER, 0);
 }
 
+//
+// ベンチマークの条件を設定する
+//
+bool Menu::setBenchmark(const std::string& path, int samples, DrawMode mode)
+{
+  std::lock_guard<std::mutex> lock{ mutex };
+
+  // 計測結果が実行ごとに変わらないようにする
+  settings.adaptiveSampling = false;
+  settings.progressiveRefinement = false;
+  settings.onDemandRendering = false;
+  settings.temporalReprojection = false;
+
+  // すべての鏡に同じ高さマップを使う (読み込んだものはキャッシュから取り出す)
+  for (std::size_t i = 0; i < settings.mirrors.size(); ++i)
+    if (!readMirrorHeightMap(i, path)) return false;
+  createMirrorHeightArray();
+
+  // 鏡の標本点数と描画モードを設定する
+  settings.mirrorSampleCount = std::clamp(samples, 1, MAX_MIRROR_SAMPLES);
+  controller.reset(settings.mirrorSampleCount);
+  drawMode = mode;
+
+  // 描画結果が変わる
+  ++revision;
+
+  return true;
+}
+
+//
+// 回帰試験の条件を設定する
+//
+bool Menu::setRegression(const std::string& heightMap, const std::string& receiver,
+  const GgVector& orientation, const std::string& illuminantMap, int samples)
+{
+  std::lock_guard<std::mutex> lock{ mutex };
+
+  // 読み込み中の資源があれば反映してから条件を設定する
+  finishLoading(true);
+
+  // 描画結果が実行ごとに変わらないようにする
+  settings.adaptiveSampling = false;
+  settings.progressiveRefinement = true;
+  settings.onDemandRendering = false;
+  settings.temporalReprojection = false;
+
+  // 全体光源の位置は受光面のモデル座標系で与えるので, 鏡に向けた受光面は全体光源の拡散反射光と
+  // 鏡面反射光で塗りつぶされてしまう. 反射光の模様を比べられるように環境光だけで照らす
+  light->loadDiffuse(GgVector{ 0.0f, 0.0f, 0.0f, 0.0f });
+  light->loadSpecular(GgVector{ 0.0f, 0.0f, 0.0f, 0.0f });
+
+  // すべての鏡に同じ高さマップを使う
+  for (std::size_t i = 0; i < settings.mirrors.size(); ++i)
+    if (!readMirrorHeightMap(i, heightMap)) return false;
+  createMirrorHeightArray();
+
+  // すべての受光面に同じ形状を使い, 形状ごとに指定した向きにする
+  for (std::size_t i = 0; i < settings.receivers.size(); ++i)
+  {
+    if (!createReceiverModel(i, receiver)) return false;
+    settings.receivers[i].orientation = orientation;
+    setReceiverPose(i);
+  }
+
+  // 投影光源マップを読み込む
+  if (!createIlluminantMap(illuminantMap)) return false;
+
+  // 鏡の標本点数と描画モードを設定する
+  settings.mirrorSampleCount = std::clamp(samples, 1, MAX_MIRROR_SAMPLES);
+  controller.reset(settings.mirrorSampleCount);
+  drawMode = DRAW_RECEIVER;
+
+  // 描画結果が変わる
+  ++revision;
+
+  return true;
+}
+
+//
+// 計測した描画時間から鏡の標本点数を調整する
+//
+void Menu::adaptMirrorSampleCount()
+{
+  std::lock_guard<std::mutex> lock{ mutex };
+
+  // 自動調整が有効で受光面を描画しているときだけ調整する
+  if (!settings.adaptiveSampling || drawMode != DRAW_RECEIVER) return;
+
+  // 描画時間が得られたフレームだけ調整する
+  const auto time{ timer.getGpuTime() };
+  if (time < 0.0f) return;
+
+  settings.mirrorSampleCount = controller.update(time, settings.frameBudget, 1, MAX_MIRROR_SAMPLES);
+}
+
 //
 // 鏡の姿勢を設定する
 //
-void Menu::setMirrorPose()
+void Menu::setMirrorPose(std::size_t index)
 {
   // 鏡の姿勢を設定する
-  setPose(mirrorPose, settings.mirrorPosition, settings.mirrorTarget);
+  setPose(mirrorPose[index], settings.mirrors[index].position, settings.mirrors[index].target);
+}
+
+//
+// 構成データに合わせてすべての鏡を作り直す
+//
+void Menu::resetMirrors()
+{
+  // 読み込み中の鏡の高さマップは鏡の番号が変わる前に反映しておく
+  finishLoading(true);
+
+  // 鏡がひとつも無ければデフォルトの鏡を置く
+  if (settings.mirrors.empty()) settings.mirrors = Config{}.mirrors;
+
+  // 鏡の数の上限を超えないようにする
+  if (settings.mirrors.size() > MAX_MIRRORS) settings.mirrors.resize(MAX_MIRRORS);
+
+  // 鏡ごとのデータを作り直す
+  const auto count{ settings.mirrors.size() };
+  mirrorPose.resize(count);
+  mirrorHeightData.assign(count, nullptr);
+  mirrorTiledHeightMap.reset();
+  selectedMirror = 0;
+
+  // 鏡ごとの姿勢と高さマップを設定する (読み込めなかった高さマップは平坦にする)
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    setMirrorPose(i);
+
+    // 背面の模様があればそのたわみを高さマップにし, 求められなければ高さマップを読み込む
+    const auto& mirror{ settings.mirrors[i] };
+    if (mirror.reliefMap.empty() || !readMirrorRelief(i, mirror.reliefMap))
+      readMirrorHeightMap(i, mirror.heightMap);
+  }
+
+  // 高さマップのテクスチャ配列を作成する
+  createMirrorHeightArray();
+}
+
+//
+// 選択している鏡を複製して追加する
+//
+void Menu::addMirror()
+{
+  // 読み込み中の鏡の高さマップは鏡の番号が変わる前に反映しておく
+  finishLoading(true);
+
+  // 鏡の数の上限に達していたら追加しない
+  if (settings.mirrors.size() >= MAX_MIRRORS)
+  {
+    errorMessage = u8"これ以上鏡を追加できません";
+    return;
+  }
+
+  // タイル化した高さマップの鏡は複製できない
+  if (mirrorTiledHeightMap)
+  {
+    errorMessage = u8"タイル化した高さマップの鏡は複製できません";
+    return;
+  }
+
+  // 選択している鏡を少しずらして複製する
+  auto mirror{ settings.mirrors[selectedMirror] };
+  mirror.position[0] += 0.5f * mirror.position[3];
+  mirror.target[0] += 0.5f * mirror.target[3];
+  settings.mirrors.push_back(mirror);
+  mirrorHeightData.push_back(mirrorHeightData[selectedMirror]);
+  mirrorPose.emplace_back();
+
+  // 追加した鏡を選択する
+  selectedMirror = settings.mirrors.size() - 1;
+  setMirrorPose(selectedMirror);
+
+  // テクスチャ配列を作り直す
+  createMirrorHeightArray();
+}
+
+//
+// 選択している鏡を削除する
+//
+void Menu::removeMirror()
+{
+  // 読み込み中の鏡の高さマップは鏡の番号が変わる前に反映しておく
+  finishLoading(true);
+
+  // 最後のひとつは削除しない
+  if (settings.mirrors.size() <= 1) return;
+
+  // 選択している鏡を削除する
+  settings.mirrors.erase(settings.mirrors.begin() + selectedMirror);
+  mirrorHeightData.erase(mirrorHeightData.begin() + selectedMirror);
+  mirrorPose.erase(mirrorPose.begin() + selectedMirror);
+  if (selectedMirror >= settings.mirrors.size()) selectedMirror = settings.mirrors.size() - 1;
+
+  // テクスチャ配列を作り直す
+  createMirrorHeightArray();
 }
 
 //
 // 受光面の姿勢を設定する
 //
-void Menu::setReceiverPose()
+void Menu::setReceiverPose(std::size_t index)
 {
   // 受光面の姿勢を設定する
-  const auto& scale{ settings.receiverOrientation[3] };
-  const auto rotation{ ggEulerQuaternion(settings.receiverOrientation) };
-  receiverPose = ggTranslate(settings.receiverPosition) * rotation.getMatrix()
-    * ggScale(scale, scale, scale);
-
-  // 受光面の視界を設定する
-  const auto& translate{ settings.receiverPosition };
+  const auto& receiver{ settings.receivers[index] };
+  const auto& scale{ receiver.orientation[3] };
+  const auto rotation{ ggEulerQuaternion(receiver.orientation) };
+  receiverPose[index] = ggProduct(ggTranslate(receiver.position), rotation.getMatrix(),
+    ggScale(scale, scale, scale));
+
+  // 選択している受光面なら受光面からの視界を設定する
+  if (index != selectedReceiver) return;
+  const auto& translate{ receiver.position };
   receiverView = rotation.getMatrix().transpose()
     * ggTranslate(-translate[0], -translate[1], -translate[2], translate[3]);
 }
 
+//
+// 処理時間の計測結果を CSV ファイルに書き出す
+//
+void Menu::saveTimer() const
+{
+  // ファイルダイアログから得るパス
+  nfdchar_t* filepath;
+
+  // ファイルダイアログを開く
+  if (NFD_SaveDialog(&filepath, csvFilter, 1, NULL, "*.csv") == NFD_OKAY)
+  {
+    // ダイアログを閉じてからメニューをロックする
+    std::lock_guard<std::mutex> lock{ mutex };
+
+    // 計測結果を保存する
+    if (!timer.save(TCharToUtf8(filepath)))
+    {
+      // 保存できなかった
+      errorMessage = u8"計測結果が保存できません";
+    }
+
+    // ファイルパスの取り出しに使ったメモリを開放する
+    NFD_FreePath(filepath);
+  }
+}
+
+//
+// 処理時間の計測結果を表示する
+//
+void Menu::drawTimer()
+{
+#if defined(IMGUI_VERSION)
+  // ウィンドウの位置・サイズとタイトル
+  ImGui::SetNextWindowPos(ImVec2(304, 4), ImGuiCond_Once);
+  ImGui::SetNextWindowSize(ImVec2(360, 0), ImGuiCond_Once);
+  ImGui::Begin(u8"処理時間", &showTimer);
+
+  // 処理ごとの処理時間のグラフと統計
+  for (int i = 0; i < FrameTimer::PASSES; ++i)
+  {
+    const auto pass{ static_cast<FrameTimer::Pass>(i) };
+    const auto [minimum, average, p99] { timer.getStatistics(pass) };
+    const auto overlay{ std::string(FrameTimer::getName(pass)) };
+    char label[64];
+    snprintf(label, sizeof label, "%.2f/%.2f/%.2f##%s", minimum, average, p99, overlay.c_str());
+
+    // 計測していないフレームは 0 として描く
+    std::pair<const FrameTimer*, FrameTimer::Pass> data{ &timer, pass };
+    ImGui::PlotLines(label,
+      [](void* data, int frame)
+      {
+        const auto& [timer, pass] { *static_cast<std::pair<const FrameTimer*, FrameTimer::Pass>*>(data) };
+        return std::max(timer->get(pass, frame), 0.0f);
+      },
+      &data, timer.getCount(), 0, overlay.c_str(), 0.0f, std::max(p99 * 1.5f, 1.0f), ImVec2(160, 32));
+  }
+  ImGui::TextUnformatted(u8"右の数値は 最小/平均/99% (ms)");
+
+  // 計測結果の書き出し
+  if (ImGui::Button(u8"CSV に書き出す")) dialog = [this]() { saveTimer(); };
+
+  ImGui::End();
+#endif
+}
+
+//
+// OpenGL のデバッグ出力のメッセージを表示する
+//
+void Menu::drawDebug()
+{
+#if defined(IMGUI_VERSION)
+  // ウィンドウの位置・サイズとタイトル
+  ImGui::SetNextWindowPos(ImVec2(304, 320), ImGuiCond_Once);
+  ImGui::SetNextWindowSize(ImVec2(480, 240), ImGuiCond_Once);
+  ImGui::Begin(u8"OpenGL のメッセージ", &showDebug);
+
+  // デバッグ出力が使えなければメッセージは受け取れない
+  if (!ggDebugOutput())
+  {
+    ImGui::TextUnformatted(u8"デバッグ出力 (KHR_debug) が使えません");
+    ImGui::End();
+    return;
+  }
+
+  // 表示する重大度の下限
+  static constexpr const char* severityName[]{ u8"通知", u8"低", u8"中", u8"高" };
+  for (int i = 0; i < 4; ++i)
+  {
+    if (i > 0) ImGui::SameLine();
+    ImGui::RadioButton(severityName[i], &debugSeverity, i);
+  }
+  ImGui::SameLine();
+  if (ImGui::Button(u8"消去")) ggClearDebugMessages();
+
+  // 新しいものから順に表示する
+  ImGui::BeginChild("##messages");
+  const auto messages{ ggGetDebugMessages() };
+  for (auto message = messages.rbegin(); message != messages.rend(); ++message)
+  {
+    // 重大度の番号と色
+    const auto severity{ message->severity == GL_DEBUG_SEVERITY_HIGH ? 3
+      : message->severity == GL_DEBUG_SEVERITY_MEDIUM ? 2
+      : message->severity == GL_DEBUG_SEVERITY_LOW ? 1 : 0 };
+    if (severity < debugSeverity) continue;
+    static constexpr ImVec4 severityColor[]
+    {
+      ImVec4(0.6f, 0.6f, 0.6f, 1.0f),
+      ImVec4(0.8f, 0.8f, 0.8f, 1.0f),
+      ImVec4(1.0f, 0.8f, 0.0f, 1.0f),
+      ImVec4(1.0f, 0.2f, 0.0f, 1.0f)
+    };
+
+    // 種類
+    const auto* const type{ message->type == GL_DEBUG_TYPE_ERROR ? "error"
+      : message->type == GL_DEBUG_TYPE_PERFORMANCE ? "performance"
+      : message->type == GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR ? "deprecated"
+      : message->type == GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR ? "undefined"
+      : message->type == GL_DEBUG_TYPE_PORTABILITY ? "portability" : "other" };
+
+    ImGui::PushStyleColor(ImGuiCol_Text, severityColor[severity]);
+    ImGui::TextWrapped("[%s %s %u] %s", severityName[severity], type, message->id, message->message.c_str());
+    ImGui::PopStyleColor();
+  }
+  ImGui::EndChild();
+
+  ImGui::End();
+#endif
+}
+
 //
 // メニューを描画する
 //
 void Menu::draw()
 {
+  // 描画スレッドがコマンドを実行している間は待つ
+  std::unique_lock<std::mutex> lock{ mutex };
+
 #if defined(IMGUI_VERSION)
   //
   // ImGui によるユーザインタフェース
@@ -527,17 +1522,17 @@ void Menu::draw()
   // 全体光源
   ImGui::SeparatorText(u8"全体光源");
   if (ImGui::DragFloat3(u8"位置##全体", settings.lightPosition.data(), 0.01f, -10.0f, 10.0f, "%.2f"))
-    light->loadPosition(settings.lightPosition);
+    post([this]() { light->loadPosition(settings.lightPosition); });
   if (ImGui::ColorEdit3(u8"色##全体", settings.lightColor.data(), ImGuiColorEditFlags_Float))
-    setLight();
+    post([this]() { setLight(); });
   if (ImGui::SliderFloat(u8"強度##全体", &settings.lightIntensity, 0.0f, 10.0f, "%.2f"))
-    setLight();
+    post([this]() { setLight(); });
   if (ImGui::SliderFloat(u8"環境光成分##全体", &settings.lightAmbient, 0.0f, 1.0f, "%.2f"))
-    light->loadAmbient(settings.lightColor * settings.lightIntensity * settings.lightAmbient);
+    post([this]() { light->loadAmbient(settings.lightColor * settings.lightIntensity * settings.lightAmbient); });
   if (ImGui::Button(u8"位置を初期化##全体"))
   {
     settings.lightPosition = defaults.lightPosition;
-    light->loadPosition(settings.lightPosition);
+    post([this]() { light->loadPosition(settings.lightPosition); });
   }
   ImGui::SameLine();
   if (ImGui::Button(u8"強度を初期化##全体"))
@@ -545,7 +1540,7 @@ void Menu::draw()
     settings.lightColor = defaults.lightColor;
     settings.lightIntensity = defaults.lightIntensity;
     settings.lightAmbient = defaults.lightAmbient;
-    setLight();
+    post([this]() { setLight(); });
   }
 
   // 投影光源
@@ -556,11 +1551,14 @@ void Menu::draw()
     setIlluminantPose();
 #ifdef USE_ILLUMINANT_COLOR
   if (ImGui::ColorEdit3(u8"色##投影", settings.illuminantColor.data(), ImGuiColorEditFlags_Float))
-    setIlluminantIntensity();
+    post([this]() { setIlluminantIntensity(); });
   if (ImGui::SliderFloat(u8"強度##投影", &settings.illuminantIntensity, 0.0f, 10.0f, "%.2f"))
-    setIlluminantIntensity();
+    post([this]() { setIlluminantIntensity(); });
   if (ImGui::SliderFloat(u8"環境光成分##投影", &settings.illuminantAmbient, 0.0f, 1.0f, "%.2f"))
-    illuminant->loadAmbient(settings.illuminantColor * settings.illuminantIntensity * settings.illuminantAmbient);
+    post([this]()
+      {
+        illuminant->loadAmbient(settings.illuminantColor * settings.illuminantIntensity * settings.illuminantAmbient);
+      });
   ImGui::SliderFloat(u8"広がり##投影", &settings.illuminantSpread, 0.0f, 180.0f, "%.2f");
 #endif
   if (ImGui::Button(u8"姿勢を初期化##投影"))
@@ -577,32 +1575,90 @@ void Menu::draw()
     settings.illuminantIntensity = defaults.illuminantIntensity;
     settings.illuminantAmbient = defaults.illuminantAmbient;
     settings.illuminantSpread = defaults.illuminantSpread;
-    setIlluminantIntensity();
+    post([this]() { setIlluminantIntensity(); });
   }
   ImGui::SameLine();
 #endif
+  ImGui::BeginDisabled(isLoading());
   if (ImGui::Button(u8"光源マップ##投影"))
-    loadIlluminantMap();
+    dialog = [this]() { loadIlluminantMap(); };
+  ImGui::EndDisabled();
+  ImGui::RadioButton(u8"矩形##投影", &settings.illuminantType, ILLUMINANT_RECTANGLE);
+  ImGui::SameLine();
+  ImGui::RadioButton(u8"平行##投影", &settings.illuminantType, ILLUMINANT_PARALLEL);
+  ImGui::SameLine();
+  ImGui::RadioButton(u8"点##投影", &settings.illuminantType, ILLUMINANT_POINT);
+  if (settings.illuminantType != ILLUMINANT_RECTANGLE)
+    ImGui::SliderFloat(u8"粗さ指数##投影", &settings.illuminantExponent, 1.0f, 10000.0f, "%.0f",
+      ImGuiSliderFlags_Logarithmic);
 
   // 鏡
   ImGui::SeparatorText(u8"鏡");
-  if (ImGui::DragFloat3(u8"位置##鏡", settings.mirrorPosition.data(), 0.01f, -10.0f, 10.0f, "%.2f"))
-    setMirrorPose();
-  if (ImGui::DragFloat3(u8"目標##鏡", settings.mirrorTarget.data(), 0.01f, -10.0f, 10.0f, "%.2f"))
-    setMirrorPose();
+  const auto mirrorName{ [](std::size_t i) { return u8"鏡 " + std::to_string(i + 1); } };
+  ImGui::SetNextItemWidth(100.0f);
+  if (ImGui::BeginCombo(u8"##鏡の選択", mirrorName(selectedMirror).c_str()))
+  {
+    for (std::size_t i = 0; i < settings.mirrors.size(); ++i)
+      if (ImGui::Selectable(mirrorName(i).c_str(), i == selectedMirror)) selectedMirror = i;
+    ImGui::EndCombo();
+  }
+  ImGui::SameLine();
+  ImGui::BeginDisabled(isLoading());
+  if (ImGui::Button(u8"追加##鏡")) post([this]() { addMirror(); });
+  ImGui::SameLine();
+  if (ImGui::Button(u8"削除##鏡")) post([this]() { removeMirror(); });
+  ImGui::EndDisabled();
+  auto& mirror{ settings.mirrors[selectedMirror] };
+  if (ImGui::DragFloat3(u8"位置##鏡", mirror.position.data(), 0.01f, -10.0f, 10.0f, "%.2f"))
+    setMirrorPose(selectedMirror);
+  if (ImGui::DragFloat3(u8"目標##鏡", mirror.target.data(), 0.01f, -10.0f, 10.0f, "%.2f"))
+    setMirrorPose(selectedMirror);
   if (ImGui::ColorEdit3(u8"拡散反射係数", settings.mirrorMaterialDiffuse.data(), ImGuiColorEditFlags_Float))
-    setMirrorMaterial();
+    post([this]() { setMirrorMaterial(); });
   if (ImGui::ColorEdit3(u8"鏡面反射係数", settings.mirrorMaterialSpecular.data(), ImGuiColorEditFlags_Float))
-    setMirrorMaterial();
+    post([this]() { setMirrorMaterial(); });
   if (ImGui::SliderFloat(u8"輝き係数", &settings.mirrorMaterialShininess, 0.0f, 200.0f, "%.2f"))
-    setMirrorMaterial();
-  ImGui::SliderFloat(u8"高さスケール##鏡", &settings.mirrorHeightScale, -1.0f, 1.0f, "%.3f");
+    post([this]() { setMirrorMaterial(); });
+  ImGui::SliderFloat(u8"高さスケール##鏡", &mirror.heightScale, -1.0f, 1.0f, "%.3f");
+  ImGui::BeginDisabled(settings.adaptiveSampling);
   ImGui::SliderInt(u8"標本点数##鏡", &settings.mirrorSampleCount, 1, MAX_MIRROR_SAMPLES);
+  ImGui::EndDisabled();
+  if (ImGui::Checkbox(u8"自動調整##標本点数", &settings.adaptiveSampling))
+    controller.reset(settings.mirrorSampleCount);
+  ImGui::SameLine();
+  ImGui::SetNextItemWidth(100.0f);
+  ImGui::SliderFloat(u8"目標 (ms)##標本点数", &settings.frameBudget, 1.0f, 100.0f, "%.1f");
+  ImGui::Checkbox(u8"分散で配分##標本点数", &settings.varianceSampling);
+  ImGui::SameLine();
+  ImGui::SetNextItemWidth(80.0f);
+  ImGui::BeginDisabled(!settings.varianceSampling);
+  ImGui::SliderFloat(u8"試し描き##標本点数", &settings.variancePilot, 0.05f, 0.9f, "%.2f");
+  ImGui::SameLine();
+  ImGui::SetNextItemWidth(80.0f);
+  ImGui::SliderFloat(u8"上限##標本点数", &settings.varianceLimit, 1.0f, 16.0f, "%.1f");
+  ImGui::EndDisabled();
+  ImGui::Checkbox(u8"静止したら段階的に詳細化", &settings.progressiveRefinement);
+  ImGui::Checkbox(u8"必要なときだけ描画", &settings.onDemandRendering);
+  ImGui::TextUnformatted(u8"反射光の解像度");
+  for (const auto scale : { 1, 2, 4 })
+  {
+    ImGui::SameLine();
+    const auto label{ (scale == 1 ? std::string("1") : "1/" + std::to_string(scale)) + u8"##反射光の解像度" };
+    if (ImGui::RadioButton(label.c_str(), settings.causticScale == scale)) settings.causticScale = scale;
+  }
+  ImGui::Checkbox(u8"操作中だけ反射光の解像度を下げる", &settings.causticScaleInteractive);
+  ImGui::Checkbox(u8"前のフレームの反射光を再投影", &settings.temporalReprojection);
+  ImGui::SameLine();
+  ImGui::SetNextItemWidth(80.0f);
+  ImGui::BeginDisabled(!settings.temporalReprojection);
+  ImGui::SliderInt(u8"フレーム##再投影", &settings.temporalFrames, 1, 64);
+  ImGui::EndDisabled();
+  const auto& initial{ defaults.mirrors[selectedMirror < defaults.mirrors.size() ? selectedMirror : 0] };
   if (ImGui::Button(u8"姿勢を初期化##鏡"))
   {
-    settings.mirrorPosition = defaults.mirrorPosition;
-    settings.mirrorTarget = defaults.mirrorTarget;
-    setMirrorPose();
+    mirror.position = initial.position;
+    mirror.target = initial.target;
+    setMirrorPose(selectedMirror);
   }
   ImGui::SameLine();
   if (ImGui::Button(u8"材質を初期化##鏡"))
@@ -610,33 +1666,136 @@ void Menu::draw()
     settings.mirrorMaterialDiffuse = defaults.mirrorMaterialDiffuse;
     settings.mirrorMaterialSpecular = defaults.mirrorMaterialSpecular;
     settings.mirrorMaterialShininess = defaults.mirrorMaterialShininess;
-    settings.mirrorHeightScale = defaults.mirrorHeightScale;
-    setMirrorMaterial();
+    mirror.heightScale = initial.heightScale;
+    post([this]() { setMirrorMaterial(); });
   }
   ImGui::SameLine();
+  ImGui::BeginDisabled(isLoading());
   if (ImGui::Button(u8"高さマップ##鏡"))
-    loadMirrorHeightMap();
+    dialog = [this]() { loadMirrorHeightMap(); };
+  ImGui::EndDisabled();
+  ImGui::SameLine();
+  ImGui::BeginDisabled(isLoading());
+  if (ImGui::Button(u8"背面の模様##鏡"))
+    dialog = [this]() { loadMirrorRelief(); };
+  ImGui::EndDisabled();
+  ImGui::SameLine();
+  if (ImGui::Checkbox(u8"圧縮##鏡", &settings.mirrorHeightCompression))
+    post([this]() { createMirrorHeightArray(); });
+  ImGui::SameLine();
+  if (ImGui::Checkbox(u8"勾配の分布##鏡", &settings.mirrorSlopeFilter))
+    post([this]() { createMirrorHeightArray(); });
+  if (!mirror.reliefMap.empty())
+  {
+    // 板の条件を変えたら操作を終えたときにたわみを求め直す (求めている間は操作させない)
+    bool changed{ false };
+    ImGui::BeginDisabled(isLoading());
+    ImGui::SliderFloat(u8"直径 (mm)##背面の模様", &mirror.plateDiameter, 10.0f, 300.0f, "%.1f");
+    changed |= ImGui::IsItemDeactivatedAfterEdit();
+    ImGui::SliderFloat(u8"厚さ (mm)##背面の模様", &mirror.plateThickness, 0.1f, 20.0f, "%.2f");
+    changed |= ImGui::IsItemDeactivatedAfterEdit();
+    ImGui::SliderFloat(u8"模様の深さ (mm)##背面の模様", &mirror.reliefDepth, 0.0f, 10.0f, "%.2f");
+    changed |= ImGui::IsItemDeactivatedAfterEdit();
+    ImGui::SliderFloat(u8"ヤング率 (GPa)##背面の模様", &mirror.plateModulus, 1.0f, 400.0f, "%.1f");
+    changed |= ImGui::IsItemDeactivatedAfterEdit();
+    ImGui::SliderFloat(u8"ポアソン比##背面の模様", &mirror.platePoisson, 0.0f, 0.49f, "%.3f");
+    changed |= ImGui::IsItemDeactivatedAfterEdit();
+    ImGui::SliderFloat(u8"研磨の圧力 (kPa)##背面の模様", &mirror.polishingPressure, 1.0f, 1000.0f, "%.1f",
+      ImGuiSliderFlags_Logarithmic);
+    changed |= ImGui::IsItemDeactivatedAfterEdit();
+    ImGui::EndDisabled();
+    if (changed) post([this, index = selectedMirror, path = mirror.reliefMap]() { requestMirrorRelief(index, path); });
+  }
+  if (mirrorTiledHeightMap)
+    ImGui::Text(u8"タイル %d / %d", tiles[0], tiles[1]);
 
   // 受光面
   ImGui::SeparatorText(u8"受光面");
-  if (ImGui::DragFloat3(u8"位置##受光面", settings.receiverPosition.data(), 0.01f, -10.0f, 10.0f, "%.2f"))
-    setReceiverPose();
-  GgVector orientation{ settings.receiverOrientation * 57.2957795f };
+  const auto receiverName{ [](std::size_t i) { return u8"受光面 " + std::to_string(i + 1); } };
+  ImGui::SetNextItemWidth(100.0f);
+  if (ImGui::BeginCombo(u8"##受光面の選択", receiverName(selectedReceiver).c_str()))
+  {
+    for (std::size_t i = 0; i < settings.receivers.size(); ++i)
+    {
+      if (ImGui::Selectable(receiverName(i).c_str(), i == selectedReceiver))
+      {
+        // 選択した受光面からの視界に切り替える
+        selectedReceiver = i;
+        setReceiverPose(selectedReceiver);
+      }
+    }
+    ImGui::EndCombo();
+  }
+  ImGui::SameLine();
+  if (ImGui::Button(u8"追加##受光面")) post([this]() { addReceiver(); });
+  ImGui::SameLine();
+  if (ImGui::Button(u8"削除##受光面")) post([this]() { removeReceiver(); });
+  auto& receiver{ settings.receivers[selectedReceiver] };
+  if (ImGui::DragFloat3(u8"位置##受光面", receiver.position.data(), 0.01f, -10.0f, 10.0f, "%.2f"))
+    setReceiverPose(selectedReceiver);
+  GgVector orientation{ receiver.orientation * 57.2957795f };
   if (ImGui::DragFloat3(u8"回転##受光面", orientation.data(), 0.01f, -180.0f, 180.0f, "%.2f"))
   {
-    settings.receiverOrientation = orientation * 0.0174532925f;
-    setReceiverPose();
+    // スケールは変更しない
+    const auto scale{ receiver.orientation[3] };
+    receiver.orientation = orientation * 0.0174532925f;
+    receiver.orientation[3] = scale;
+    setReceiverPose(selectedReceiver);
+  }
+  const auto postReceiverMaterial{ [this]()
+    {
+      post([this, index = selectedReceiver]() { setReceiverMaterial(index); });
+    } };
+  if (ImGui::Checkbox(u8"材質を指定##受光面", &receiver.customMaterial))
+    postReceiverMaterial();
+  if (receiver.customMaterial)
+  {
+    if (ImGui::ColorEdit3(u8"拡散反射係数##受光面", receiver.diffuse.data(), ImGuiColorEditFlags_Float))
+      postReceiverMaterial();
+    if (ImGui::ColorEdit3(u8"鏡面反射係数##受光面", receiver.specular.data(), ImGuiColorEditFlags_Float))
+      postReceiverMaterial();
+    if (ImGui::SliderFloat(u8"輝き係数##受光面", &receiver.shininess, 0.0f, 200.0f, "%.2f"))
+      postReceiverMaterial();
   }
   if (ImGui::Button(u8"姿勢を初期化##受光面"))
   {
-    settings.receiverModel = defaults.receiverModel;
-    settings.receiverPosition = defaults.receiverPosition;
-    settings.receiverOrientation = defaults.receiverOrientation;
-    setReceiverPose();
+    const auto& initial{ defaults.receivers[selectedReceiver < defaults.receivers.size() ? selectedReceiver : 0] };
+    receiver.position = initial.position;
+    receiver.orientation = initial.orientation;
+    setReceiverPose(selectedReceiver);
   }
   ImGui::SameLine();
   if (ImGui::Button(u8"形状ファイル##受光面"))
-    loadReceiverModel();
+    dialog = [this]() { loadReceiverModel(); };
+  ImGui::Checkbox(u8"受光面による遮蔽", &settings.receiverShadow);
+
+  // 最近使ったファイル
+  ImGui::SeparatorText(u8"最近使ったファイル");
+  ImGui::BeginDisabled(isLoading());
+  if (ImGui::BeginCombo(u8"##最近使ったファイル", u8"切り替え"))
+  {
+    for (const auto& [kind, path] : cache.getRecent())
+    {
+      // 資源の種類とファイル名を表示する
+      const auto name{ std::filesystem::u8path(path).filename().u8string() };
+      const auto label{ kind + ": " + name + "##" + path };
+      if (ImGui::Selectable(label.c_str()))
+      {
+        // 選択した資源に描画スレッドで切り替える
+        const auto m{ selectedMirror }, r{ selectedReceiver };
+        const std::string file{ path };
+        if (kind == heightKind) post([this, m, file]() { requestMirrorHeightMap(m, file); });
+        else if (kind == reliefKind) post([this, m, file]() { requestMirrorRelief(m, file); });
+        else if (kind == illuminantKind) post([this, file]() { requestIlluminantMap(file); });
+        else if (kind == receiverKind) post([this, r, file]() { createReceiverModel(r, file); });
+      }
+    }
+    ImGui::EndCombo();
+  }
+  ImGui::EndDisabled();
+  ImGui::SameLine();
+  ImGui::Text("%.0f / %.0f MB", cache.getUsed() / 1048576.0, cache.getBudget() / 1048576.0);
+  if (isLoading()) ImGui::TextUnformatted(u8"読み込み中...");
 
   // 描画モード
   ImGui::SeparatorText(u8"描画モード");
@@ -644,13 +1803,20 @@ void Menu::draw()
   ImGui::SameLine();
   if (ImGui::RadioButton(u8"受光面", drawMode == DRAW_RECEIVER)) drawMode = DRAW_RECEIVER;
   ImGui::SameLine();
-  ImGui::Text(u8"(%.1f fps)", ImGui::GetIO().Framerate);
+  const auto frame{ timer.getStatistics(FrameTimer::FRAME)[1] };
+  ImGui::Text(u8"(%.1f fps)", frame > 0.0f ? 1000.0f / frame : 0.0f);
+  ImGui::SameLine();
+  ImGui::Checkbox(u8"計測", &showTimer);
+  ImGui::SameLine();
+  ImGui::Checkbox(u8"GL", &showDebug);
 
   // 設定ファイル
   ImGui::SeparatorText(u8"設定ファイル");
-  if (ImGui::Button(u8"読み込み")) loadConfig();
+  ImGui::BeginDisabled(isLoading());
+  if (ImGui::Button(u8"読み込み")) dialog = [this]() { loadConfig(); };
+  ImGui::EndDisabled();
   ImGui::SameLine();
-  if (ImGui::Button(u8"書き出し")) saveConfig();
+  if (ImGui::Button(u8"書き出し")) dialog = [this]() { saveConfig(); };
 
   // エラーメッセージが設定されていたら
   if (errorMessage)
@@ -679,5 +1845,65 @@ void Menu::draw()
 
   // メニュー表示終了
   ImGui::End();
+
+  // 処理時間の計測結果を表示する
+  if (showTimer) drawTimer();
+
+  // OpenGL のデバッグ出力のメッセージを表示する
+  if (showDebug) drawDebug();
+
+  // メニューを操作しているか操作を終えたばかりならシーンの版数を進める
+  const auto active{ ImGui::IsAnyItemActive() };
+  if (active || wasActive) ++revision;
+  wasActive = active;
+
+  // ファイルダイアログはロックを外してから開く
+  if (dialog)
+  {
+    lock.unlock();
+    dialog();
+    dialog = nullptr;
+  }
 #endif
 }
+
+//
+// メインスレッドから受け取ったコマンドを実行して描画するシーンを複製する
+//
+Scene Menu::apply()
+{
+  std::lock_guard<std::mutex> lock{ mutex };
+
+  // メインスレッドから受け取ったコマンドを追加した順に実行する
+  if (!commands.empty())
+  {
+    for (const auto& command : commands) command();
+    commands.clear();
+
+    // 描画結果が変わるのでシーンの版数を進める
+    ++revision;
+  }
+
+  // 別スレッドで読み込み終えた資源があれば切り替える
+  finishLoading();
+
+  // 鏡の高さマップのタイルが読み込まれたらシーンの版数を進める
+  const auto current{ mirrorTiledHeightMap
+    ? std::array<int, 2>{ mirrorTiledHeightMap->getResidentCount(), mirrorTiledHeightMap->getSlotCount() }
+    : std::array<int, 2>{} };
+  if (current[0] != tiles[0]) ++revision;
+  tiles = current;
+
+  // コマンドを実行した後の状態を複製する
+  return Scene{ *this };
+}
+
+//
+// フレームの計測を終えて次のフレームに進める
+//
+void Menu::updateTimer()
+{
+  // メニューが計測結果を表示している間は待つ
+  std::lock_guard<std::mutex> lock{ mutex };
+  timer.update();
+}
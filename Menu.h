@@ -14,23 +14,90 @@
 // 構成データ
 #include "Config.h"
 
+// 高さマップ
+#include "HeightMap.h"
+
+// タイル化した高さマップ
+#include "TiledHeightMap.h"
+
+// 鏡の背面の模様
+#include "MirrorRelief.h"
+
+// 資源キャッシュ
+#include "ResourceCache.h"
+
+// 境界ボリューム階層
+#include "Bvh.h"
+
+// フレームの処理時間の計測
+#include "FrameTimer.h"
+
+// 標本点数の制御
+#include "SampleController.h"
+
 // ファイルダイアログ
 #include "nfd.h"
 
+// 標準ライブラリ
+#include <future>
+#include <mutex>
+
+// 描画するシーン
+class Scene;
+
+///
+/// 鏡のインスタンスのユニフォームバッファオブジェクトのデータ
+///
+struct MirrorInstance
+{
+  /// 鏡の姿勢行列
+  std::array<GgMatrix, MAX_MIRRORS> pose;
+
+  /// 鏡の高さマップのスケール, 高さマップのテクスチャ配列のレイヤ番号
+  std::array<std::array<GLfloat, 4>, MAX_MIRRORS> param;
+};
+
 ///
 /// メニューの描画
 ///
 class Menu
 {
-  // 図形の描画クラスから参照する
+public:
+
+  ///
+  /// 別スレッドで展開した画像
+  ///
+  struct Image;
+
+private:
+
+  // 描画するシーンのクラスから参照する
   friend class Scene;
 
+  // メインスレッドでメニューを作る処理と描画スレッドでコマンドを実行してシーンを複製する処理の排他制御
+  mutable std::mutex mutex;
+
+  // メインスレッドで作り描画スレッドで実行するコマンド (OpenGL の資源を操作する)
+  std::vector<std::function<void()>> commands;
+
+  // 描画スレッドで実行するコマンドを追加する (ロックして呼び出す)
+  void post(std::function<void()>&& command)
+  {
+    commands.push_back(std::move(command));
+  }
+
+  // メニューを作り終えてロックを外してから開くファイルダイアログ
+  std::function<void()> dialog;
+
   // オリジナルの構成データ
   const Config& defaults;
 
   // 構成データのコピー
   Config settings;
 
+  // 読み込んだテクスチャと形状のキャッシュ
+  ResourceCache cache;
+
   // 設定ファイルを読み込む
   void loadConfig();
 
@@ -50,7 +117,13 @@ class Menu
   void setIlluminantIntensity();
 
   // 投影光源マップのテクスチャ
-  GLuint illuminantMap;
+  std::shared_ptr<GLuint> illuminantMap;
+
+  // 投影光源マップを作成する (decoded が nullptr でなければ展開済みの画像を使う)
+  bool createIlluminantMap(const std::string& path, std::shared_ptr<const Image> decoded = nullptr);
+
+  // 投影光源マップを別スレッドで展開してから作成する
+  void requestIlluminantMap(const std::string& path);
 
   // 投影光源マップを読み込む
   void loadIlluminantMap();
@@ -61,47 +134,190 @@ class Menu
   // 投影光源の姿勢を設定する
   void setIlluminantPose();
 
-  // 鏡の材質データのユニフォームバッファオブジェクト
-  const GLuint mirrorMaterialBuffer;
+  // 鏡の材質データのユニフォームバッファオブジェクト (変更するたびに領域を切り替える)
+  GgRingBuffer<GgSimpleShader::Material> mirrorMaterialBuffer;
 
   // 鏡の材質を設定する
   void setMirrorMaterial();
 
-  // 鏡の高さマップのテクスチャ
-  GLuint mirrorHeightMap;
+  // 鏡ごとの高さマップ (タイル化していれば nullptr)
+  std::vector<std::shared_ptr<const HeightMap>> mirrorHeightData;
+
+  // すべての鏡の高さマップをレイヤにしたテクスチャ配列
+  std::shared_ptr<GLuint> mirrorHeightMap;
+
+  // すべての鏡の高さマップの勾配の 1 次と 2 次のモーメントをレイヤにしたテクスチャ配列
+  std::array<std::shared_ptr<GLuint>, 2> mirrorMomentMap;
+
+  // タイル化した鏡の高さマップ (タイル化していなければ nullptr)
+  std::shared_ptr<TiledHeightMap> mirrorTiledHeightMap;
+
+  // 鏡の高さマップのファイルを読み込む (decoded が nullptr でなければ展開済みの高さマップを使う)
+  bool readMirrorHeightMap(std::size_t index, const std::string& path,
+    std::shared_ptr<HeightMap> decoded = nullptr);
+
+  // 鏡の高さマップとその勾配のモーメントのテクスチャ配列を作成する
+  void createMirrorHeightArray();
+
+  // 鏡の高さマップを作成する (decoded が nullptr でなければ展開済みの高さマップを使う)
+  bool createMirrorHeightMap(std::size_t index, const std::string& path,
+    std::shared_ptr<HeightMap> decoded = nullptr);
+
+  // 鏡の高さマップを別スレッドで展開してから作成する
+  void requestMirrorHeightMap(std::size_t index, const std::string& path);
 
   // 鏡の高さマップを読み込む
   void loadMirrorHeightMap();
 
+  // 鏡の背面の模様の板の条件を取り出す
+  MirrorRelief::Plate getMirrorPlate(std::size_t index) const;
+
+  // 鏡の背面の模様から研磨時のたわみを求めて高さマップにする
+  // (decoded が nullptr でなければ展開済みの模様を, solved が nullptr でなければ求めておいた高さマップを使う)
+  bool readMirrorRelief(std::size_t index, const std::string& path,
+    std::shared_ptr<MirrorRelief> decoded = nullptr, std::shared_ptr<HeightMap> solved = nullptr, GLfloat scale = 0.0f);
+
+  // 鏡の背面の模様から高さマップを作成する
+  bool createMirrorRelief(std::size_t index, const std::string& path,
+    std::shared_ptr<MirrorRelief> decoded = nullptr, std::shared_ptr<HeightMap> solved = nullptr, GLfloat scale = 0.0f);
+
+  // 鏡の背面の模様の展開とたわみの計算を別スレッドで行ってから高さマップを作成する
+  void requestMirrorRelief(std::size_t index, const std::string& path);
+
+  // 鏡の背面の模様を読み込む
+  void loadMirrorRelief();
+
   // 鏡の標本点のユニフォームバッファオブジェクト
   GLuint mirrorSampleBuffer;
 
+  // 鏡の標本点
+  std::vector<std::array<GLfloat, 4>> mirrorSample;
+
   // 鏡の標本点を生成する
   void generateMirrorSample(int samples);
 
-  // 鏡の姿勢
-  GgMatrix mirrorPose;
+  // 鏡ごとの姿勢
+  std::vector<GgMatrix> mirrorPose;
 
   // 鏡の姿勢を設定する
-  void setMirrorPose();
+  void setMirrorPose(std::size_t index);
+
+  // 鏡のインスタンスのユニフォームバッファオブジェクト (毎フレーム領域を切り替える)
+  GgRingBuffer<MirrorInstance> mirrorInstanceBuffer;
 
-  // 受光面の形状ファイル名
-  std::unique_ptr<const GgSimpleObj> receiverModel;
+  // 選択している鏡
+  std::size_t selectedMirror;
 
-  // 受光面からの視界
+  // 構成データに合わせてすべての鏡を作り直す
+  void resetMirrors();
+
+  // 選択している鏡を複製して追加する
+  void addMirror();
+
+  // 選択している鏡を削除する
+  void removeMirror();
+
+  // 受光面ごとの形状
+  std::vector<std::shared_ptr<const GgSimpleObj>> receiverModel;
+
+  // 受光面の形状を作成する
+  bool createReceiverModel(std::size_t index, const std::string& path);
+
+  // 受光面ごとの形状の境界ボリューム階層
+  std::vector<std::shared_ptr<const Bvh>> receiverBvh;
+
+  // すべての受光面の境界ボリューム階層の節点と三角形を格納するバッファオブジェクト
+  std::array<GLuint, 2> occluderBuffer;
+
+  // 同じバッファオブジェクトを参照するバッファテクスチャ
+  std::array<GLuint, 2> occluderTexture;
+
+  // 受光面ごとの境界ボリューム階層の根の節点の番号 (無ければ -1) と凸なら 1
+  std::vector<std::array<GLint, 2>> occluder;
+
+  // すべての受光面の境界ボリューム階層をまとめてバッファオブジェクトに格納する
+  void createOccluder();
+
+  // 受光面ごとの材質 (形状ファイルの材質を使わない受光面のもの)
+  std::unique_ptr<const GgSimpleShader::MaterialBuffer> receiverMaterial;
+
+  // 受光面の材質を設定する
+  void setReceiverMaterial(std::size_t index);
+
+  // 選択している受光面からの視界
   GgMatrix receiverView;
 
-  // 受光面の姿勢
-  GgMatrix receiverPose;
+  // 受光面ごとの姿勢
+  std::vector<GgMatrix> receiverPose;
 
   // 受光面の姿勢を設定する
-  void setReceiverPose();
+  void setReceiverPose(std::size_t index);
 
   // 受光面の形状ファイルを読み込む
   void loadReceiverModel();
 
+  // 選択している受光面
+  std::size_t selectedReceiver;
+
+  // 構成データに合わせてすべての受光面を作り直す
+  void resetReceivers();
+
+  // 選択している受光面を複製して追加する
+  void addReceiver();
+
+  // 選択している受光面を削除する
+  void removeReceiver();
+
+  // フレームの処理時間の計測
+  FrameTimer timer;
+
+  // 処理時間の計測結果を表示するなら true
+  bool showTimer;
+
+  // 描画時間に合わせて鏡の標本点数を調整する制御
+  SampleController controller;
+
+  // 描画結果に影響する変更があるたびに進めるシーンの版数
+  unsigned int revision;
+
+  // 前のフレームでメニューを操作していたら true
+  bool wasActive;
+
+  // 前のフレームで常駐していた鏡の高さマップのタイルの数とタイルキャッシュのスロットの数
+  std::array<int, 2> tiles;
+
+  // 別スレッドで読み込み中の資源に切り替える関数
+  std::future<std::function<bool()>> pendingLoad;
+
+  // 資源を別スレッドで読み込む (decode は読み込んだ資源に描画スレッドで切り替える関数を返す)
+  void startLoading(std::function<std::function<bool()>()>&& decode);
+
+  // 別スレッドで読み込んだ資源に切り替える (wait が true なら読み込みの完了を待つ)
+  void finishLoading(bool wait = false);
+
+  // 資源を別スレッドで読み込んでいれば true
+  bool isLoading() const
+  {
+    return pendingLoad.valid();
+  }
+
+  // 処理時間の計測結果を表示する
+  void drawTimer();
+
+  // 処理時間の計測結果を CSV ファイルに書き出す
+  void saveTimer() const;
+
+  // OpenGL のデバッグ出力のメッセージを表示するなら true
+  bool showDebug;
+
+  // 表示する OpenGL のデバッグ出力のメッセージの重大度の下限 (0: 通知, 1: 低, 2: 中, 3: 高)
+  int debugSeverity;
+
+  // OpenGL のデバッグ出力のメッセージを表示する
+  void drawDebug();
+
   // ファイルパスを取得する
-  bool getFilePath(std::string& path, const nfdfilteritem_t* filter);
+  bool getFilePath(std::string& path, const nfdfilteritem_t* filter, nfdfiltersize_t count = 1);
 
 public:
 
@@ -134,11 +350,11 @@ public:
   Menu(const Menu& menu) = delete;
 
   ///
-  /// ムーブコンストラクタはデフォルトのものを使用する
+  /// ムーブコンストラクタは使用しない
   ///
   /// @param menu ムーブ元のメニュー
   ///
-  Menu(Menu&& menu) = default;
+  Menu(Menu&& menu) = delete;
 
   ///
   /// デストラクタ.
@@ -153,130 +369,87 @@ public:
   Menu& operator=(const Menu& menu) = delete;
 
   ///
-  /// ムーブ代入演算子はデフォルトのものを使用する
+  /// ムーブ代入演算子は使用しない
   ///
   /// @param menu ムーブ代入元のメニュー
   ///
-  Menu& operator=(Menu&& menu) = default;
+  Menu& operator=(Menu&& menu) = delete;
 
   ///
-  /// 全体光源データを取り出す
-  ///
-  /// @return 全体光源データ
-  ///
-  const auto& getLight() const
-  {
-    return *light;
-  }
-
+  /// ベンチマークの条件を設定する
   ///
-  /// 投影光源データを取り出す
+  /// @param path すべての鏡に使う高さマップのファイル名
+  /// @param samples 鏡の標本点数
+  /// @param mode 描画モード
+  /// @return 設定できたら true, 高さマップが読み込めなければ false
   ///
-  /// @return 投影光源データ
+  /// @note
+  /// 計測結果が実行ごとに変わらないように標本点数の自動調整と段階的詳細化, 必要なときだけの描画は止める.
   ///
-  const auto& getIlluminantIntensity() const
-  {
-    return *illuminant;
-  }
+  bool setBenchmark(const std::string& path, int samples, DrawMode mode);
 
   ///
-  /// 投影光源マップのテクスチャを取り出す
+  /// 回帰試験の条件を設定する
   ///
-  /// @return 投影光源マップのテクスチャ
+  /// @param heightMap すべての鏡に使う高さマップのファイル名
+  /// @param receiver すべての受光面に使う形状ファイル名
+  /// @param orientation すべての受光面の x, y, z 軸中心の回転角 (ラジアン) と拡大率
+  /// @param illuminantMap 投影光源マップのファイル名
+  /// @param samples 1 フレームで使う鏡の標本点数
+  /// @return 設定できたら true, どれかのファイルが読み込めなければ false
   ///
-  auto getIlluminantMap() const
-  {
-    return illuminantMap;
-  }
-
-  ///
-  /// 投影光源の姿勢を取り出す
+  /// @note
+  /// 描画結果が実行ごとに変わらないように標本点数の自動調整と再投影を止め,
+  /// すべての標本点を使い終えるまで段階的詳細化で蓄積する.
   ///
-  const auto& getIlluminantPose() const
-  {
-    return illuminantPose;
-  }
+  bool setRegression(const std::string& heightMap, const std::string& receiver,
+    const GgVector& orientation, const std::string& illuminantMap, int samples);
 
   ///
-  /// 鏡の高さマップのテクスチャを取り出す
-  ///
-  auto getHeightMap() const
-  {
-    return mirrorHeightMap;
-  }
-
+  /// 計測した描画時間から鏡の標本点数を調整する
   ///
-  /// 鏡の姿勢を取り出す
+  /// @note
+  /// 自動調整が有効で受光面を描画しているときだけ調整する. 描画スレッドで updateTimer() の後に毎フレーム一度呼び出す.
   ///
-  const auto& getMirrorPose() const
-  {
-    return mirrorPose;
-  }
+  void adaptMirrorSampleCount();
 
   ///
-  /// 鏡の材質のユニフォームバッファオブジェクトを結合ポイントに結合する
+  /// フレームの処理時間の計測を取り出す
   ///
-  void bindMirrorMaterial(GLuint bindingPoint) const
-  {
-    glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, mirrorMaterialBuffer);
-  }
-
+  /// @note
+  /// 計測は描画スレッドで行う. 計測結果はメニューでも表示するので, update() は updateTimer() で呼び出す.
   ///
-  /// 鏡の標本点のユニフォームバッファオブジェクトを結合ポイントに結合する
-  ///
-  void bindMirrorSample(GLuint bindingPoint) const
+  auto& getTimer()
   {
-    glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, mirrorSampleBuffer);
+    return timer;
   }
 
   ///
-  /// 鏡の標本数を取り出す
+  /// フレームの計測を終えて次のフレームに進める
   ///
-  auto getMirrorSampleCount() const
-  {
-    return settings.mirrorSampleCount;
-  }  
-
-  ///
-  /// 鏡の高さマップのスケールを取り出す
+  /// @note
+  /// 描画スレッドでカラーバッファを入れ替えた後に毎フレーム一度呼び出す.
   ///
-  auto getMirrorHeightScale() const
-  {
-    return settings.mirrorHeightScale;
-  }
+  void updateTimer();
 
   ///
-  /// 受光面の視界を取り出す
-  ///
-  const auto& getReceiverView() const
-  {
-    return receiverView;
-  }
-
+  /// メニューを描画する
   ///
-  /// 受光面の姿勢を取り出す
+  /// @note
+  /// メインスレッドで ImGui の新規フレームを作成した後に呼び出す.
+  /// OpenGL の資源を操作する処理はコマンドにして, 描画スレッドが apply() で実行するまで溜めておく.
+  /// ファイルダイアログはロックを外してから開くので, ダイアログを開いている間も描画スレッドは止まらない.
   ///
-  const auto& getReceiverPose() const
-  {
-    return receiverPose;
-  }
+  void draw();
 
   ///
-  /// モデルデータを取り出す
+  /// メインスレッドから受け取ったコマンドを実行して描画するシーンを複製する
   ///
-  const auto& getReceiverModel() const
-  {
-    return *receiverModel;
-  }
-
-  // 描画モードを取り出す
-  auto getDrawMode() const
-  {
-    return drawMode;
-  }
-
+  /// @return このフレームで描画するシーン
   ///
-  /// 描画する
+  /// @note
+  /// 描画スレッドで毎フレーム描画を始める前に一度呼び出す. コマンドは追加した順に実行する.
+  /// 別スレッドで読み込み終えた資源への切り替えやタイルの読み込みによる版数の更新もここで行う.
   ///
-  void draw();
+  Scene apply();
 };
@@ -0,0 +1,397 @@
+﻿///
+/// 鏡の背面の模様クラスの実装
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 18, 2026
+///
+#include "MirrorRelief.h"
+
+// 標準ライブラリ
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+// 画像の読み込みライブラリ (実装は Menu.cpp で展開している)
+#include "stb_image.h"
+
+/// @cond
+namespace
+{
+  ///
+  /// マルチグリッド法の格子
+  ///
+  /// @note
+  /// 画素の中心に値を置き, 鏡の円の内側の画素と外側の画素 (画像の外側を含む) の境界で値を 0 とする.
+  /// 境界の位置が格子の細かさによらないように, 外側の画素の値は隣の内側の画素の値の符号を反転したものとみなす.
+  ///
+  struct Level
+  {
+    /// 横と縦の画素数
+    GLsizei width, height;
+
+    /// 横と縦の画素間隔の 2 乗の逆数
+    float ax, ay;
+
+    /// 鏡の円の内側の画素なら 1
+    std::vector<std::uint8_t> inside;
+
+    /// 解
+    std::vector<float> u;
+
+    /// 右辺
+    std::vector<float> f;
+
+    /// 残差
+    std::vector<float> r;
+
+    ///
+    /// コンストラクタ
+    ///
+    /// @param width 横の画素数
+    /// @param height 縦の画素数
+    /// @param diameter 画像の縦横に対応する鏡の直径 (m)
+    ///
+    Level(GLsizei width, GLsizei height, float diameter) :
+      width{ width },
+      height{ height },
+      ax{ static_cast<float>(width) * width / (diameter * diameter) },
+      ay{ static_cast<float>(height) * height / (diameter * diameter) },
+      inside(static_cast<std::size_t>(width) * height),
+      u(inside.size()),
+      f(inside.size()),
+      r(inside.size())
+    {
+      for (GLsizei y = 0; y < height; ++y)
+      {
+        const auto cy{ (y + 0.5f) * 2.0f / height - 1.0f };
+        for (GLsizei x = 0; x < width; ++x)
+        {
+          const auto cx{ (x + 0.5f) * 2.0f / width - 1.0f };
+          inside[static_cast<std::size_t>(y) * width + x] = cx * cx + cy * cy < 1.0f;
+        }
+      }
+    }
+
+    ///
+    /// 画素が鏡の円の内側かどうか
+    ///
+    /// @param x 画素の横の位置
+    /// @param y 画素の縦の位置
+    /// @return 画像の内側かつ鏡の円の内側なら true
+    ///
+    bool contains(GLsizei x, GLsizei y) const
+    {
+      return x >= 0 && x < width && y >= 0 && y < height && inside[static_cast<std::size_t>(y) * width + x];
+    }
+
+    ///
+    /// 隣の画素の値を取り出す
+    ///
+    /// @param v 値の配列
+    /// @param x 隣の画素の横の位置
+    /// @param y 隣の画素の縦の位置
+    /// @param c 元の画素の値
+    /// @return 隣の画素の値, 鏡の円の外側なら -c
+    ///
+    float at(const std::vector<float>& v, GLsizei x, GLsizei y, float c) const
+    {
+      return contains(x, y) ? v[static_cast<std::size_t>(y) * width + x] : -c;
+    }
+
+    ///
+    /// 画素の離散ラプラシアンを求める
+    ///
+    float laplacian(GLsizei x, GLsizei y) const
+    {
+      const auto c{ u[static_cast<std::size_t>(y) * width + x] };
+      return ax * (at(u, x - 1, y, c) + at(u, x + 1, y, c) - 2.0f * c)
+        + ay * (at(u, x, y - 1, c) + at(u, x, y + 1, c) - 2.0f * c);
+    }
+  };
+}
+/// @endcond
+
+///
+/// 赤黒ガウス・ザイデル法で解を平滑化する
+///
+/// @param level 格子
+/// @param iterations 赤と黒の画素をそれぞれ更新する回数
+///
+static void smooth(Level& level, int iterations)
+{
+  for (int k = 0; k < iterations * 2; ++k)
+  {
+    // x + y が偶数の画素と奇数の画素を交互に更新すれば同じ色の画素は並列に更新できる
+    const auto color{ k & 1 };
+    ggParallelFor(0, level.height, 0, [&](std::size_t begin, std::size_t end)
+      {
+        for (auto y = static_cast<GLsizei>(begin); y < static_cast<GLsizei>(end); ++y)
+        {
+          for (auto x = (y + color) & 1; x < level.width; x += 2)
+          {
+            const auto i{ static_cast<std::size_t>(y) * level.width + x };
+            if (!level.inside[i]) continue;
+
+            // 外側の隣の画素の値は -u なので対角成分に含める
+            auto sum{ -level.f[i] };
+            auto diagonal{ 2.0f * (level.ax + level.ay) };
+            const auto add{ [&](GLsizei x, GLsizei y, float a)
+              {
+                if (level.contains(x, y)) sum += a * level.u[static_cast<std::size_t>(y) * level.width + x];
+                else diagonal += a;
+              } };
+            add(x - 1, y, level.ax);
+            add(x + 1, y, level.ax);
+            add(x, y - 1, level.ay);
+            add(x, y + 1, level.ay);
+            level.u[i] = sum / diagonal;
+          }
+        }
+      });
+  }
+}
+
+///
+/// 残差を求める
+///
+/// @param level 格子
+/// @return 残差のノルム
+///
+static double residual(Level& level)
+{
+  ggParallelFor(0, level.height, 0, [&](std::size_t begin, std::size_t end)
+    {
+      for (auto y = static_cast<GLsizei>(begin); y < static_cast<GLsizei>(end); ++y)
+      {
+        for (GLsizei x = 0; x < level.width; ++x)
+        {
+          const auto i{ static_cast<std::size_t>(y) * level.width + x };
+          level.r[i] = level.inside[i] ? level.f[i] - level.laplacian(x, y) : 0.0f;
+        }
+      }
+    });
+
+  double sum{ 0.0 };
+  for (const auto r : level.r) sum += static_cast<double>(r) * r;
+  return std::sqrt(sum);
+}
+
+///
+/// 細かい格子の残差を粗い格子の右辺に制限する
+///
+/// @param fine 残差を求めた細かい格子
+/// @param coarse 右辺を格納して解を 0 にする粗い格子
+///
+static void coarsen(const Level& fine, Level& coarse)
+{
+  ggParallelFor(0, coarse.height, 0, [&](std::size_t begin, std::size_t end)
+    {
+      for (auto y = static_cast<GLsizei>(begin); y < static_cast<GLsizei>(end); ++y)
+      {
+        // 画素数が奇数なら最後の画素を繰り返す
+        const auto y0{ y * 2 };
+        const auto y1{ std::min(y0 + 1, fine.height - 1) };
+        for (GLsizei x = 0; x < coarse.width; ++x)
+        {
+          const auto x0{ x * 2 };
+          const auto x1{ std::min(x0 + 1, fine.width - 1) };
+          const auto i{ static_cast<std::size_t>(y) * coarse.width + x };
+          const auto r{ [&](GLsizei x, GLsizei y) { return fine.r[static_cast<std::size_t>(y) * fine.width + x]; } };
+          coarse.f[i] = coarse.inside[i] ? (r(x0, y0) + r(x1, y0) + r(x0, y1) + r(x1, y1)) * 0.25f : 0.0f;
+          coarse.u[i] = 0.0f;
+        }
+      }
+    });
+}
+
+///
+/// 粗い格子の解を細かい格子に双線形補間して加える
+///
+/// @param coarse 補正量を求めた粗い格子
+/// @param fine 解を補正する細かい格子
+///
+static void prolong(const Level& coarse, Level& fine)
+{
+  ggParallelFor(0, fine.height, 0, [&](std::size_t begin, std::size_t end)
+    {
+      for (auto y = static_cast<GLsizei>(begin); y < static_cast<GLsizei>(end); ++y)
+      {
+        // 細かい画素の中心は粗い格子では (y - 0.5) / 2 の位置にある
+        const auto cy{ (y - 1) >> 1 };
+        const auto fy{ (y & 1) ? 0.25f : 0.75f };
+        for (GLsizei x = 0; x < fine.width; ++x)
+        {
+          const auto i{ static_cast<std::size_t>(y) * fine.width + x };
+          if (!fine.inside[i]) continue;
+          const auto cx{ (x - 1) >> 1 };
+          const auto fx{ (x & 1) ? 0.25f : 0.75f };
+
+          // 細かい画素にもっとも近い粗い画素は内側にあり, 外側の画素はその値の符号を反転したものとする
+          const auto nx{ cx + ((x & 1) ? 0 : 1) };
+          const auto ny{ cy + ((y & 1) ? 0 : 1) };
+          const auto c{ coarse.contains(nx, ny) ? coarse.u[static_cast<std::size_t>(ny) * coarse.width + nx] : 0.0f };
+          const auto top{ coarse.at(coarse.u, cx, cy, c) * (1.0f - fx) + coarse.at(coarse.u, cx + 1, cy, c) * fx };
+          const auto bottom{ coarse.at(coarse.u, cx, cy + 1, c) * (1.0f - fx) + coarse.at(coarse.u, cx + 1, cy + 1, c) * fx };
+          fine.u[i] += top * (1.0f - fy) + bottom * fy;
+        }
+      }
+    });
+}
+
+///
+/// V サイクルで解を補正する
+///
+/// @param levels 細かい順に並べた格子
+/// @param k 補正する格子の番号
+///
+static void cycle(std::vector<Level>& levels, std::size_t k)
+{
+  auto& level{ levels[k] };
+
+  // 最も粗い格子は画素数が少ないので平滑化を繰り返して解く
+  if (k + 1 == levels.size())
+  {
+    smooth(level, 50);
+    return;
+  }
+
+  // 前平滑化した残差を粗い格子で解いて補正し, 後平滑化する
+  smooth(level, 2);
+  residual(level);
+  coarsen(level, levels[k + 1]);
+  cycle(levels, k + 1);
+  prolong(levels[k + 1], level);
+  smooth(level, 2);
+}
+
+///
+/// 最も細かい格子の右辺のポアソン方程式をマルチグリッド法で解く
+///
+/// @param levels 細かい順に並べた格子, 最も細かい格子の右辺を設定しておく
+/// @param cycles V サイクルの反復回数の上限
+///
+static void solvePoisson(std::vector<Level>& levels, int cycles)
+{
+  auto& fine{ levels.front() };
+  std::fill(fine.u.begin(), fine.u.end(), 0.0f);
+
+  // 右辺のノルム
+  double norm{ 0.0 };
+  for (const auto f : fine.f) norm += static_cast<double>(f) * f;
+  norm = std::sqrt(norm);
+
+  // 残差が右辺の 10^-5 以下になるか, 単精度の丸め誤差で残差が減らなくなるまで繰り返す
+  auto last{ std::numeric_limits<double>::max() };
+  for (int i = 0; i < cycles; ++i)
+  {
+    cycle(levels, 0);
+    const auto r{ residual(fine) };
+    if (r <= 1.0e-5 * norm || r > 0.5 * last) break;
+    last = r;
+  }
+}
+
+//
+// コンストラクタ
+//
+MirrorRelief::MirrorRelief() :
+  width{ 0 },
+  height{ 0 }
+{
+}
+
+//
+// 画像ファイルから背面の模様を読み込むコンストラクタ
+//
+MirrorRelief::MirrorRelief(const std::string& name) :
+  MirrorRelief{}
+{
+  load(name);
+}
+
+//
+// デストラクタ
+//
+MirrorRelief::~MirrorRelief()
+{
+}
+
+//
+// 画像ファイルから背面の模様を読み込む
+//
+bool MirrorRelief::load(const std::string& name)
+{
+  // 画像を 16bit で読み込む
+  int w, h, channels;
+  const auto image{ stbi_load_16(name.c_str(), &w, &h, &channels, 0) };
+
+  // 画像が読み込めなかったら戻る
+  if (!image) return false;
+
+  // 画像サイズを保存する
+  width = w;
+  height = h;
+
+  // 最初のチャンネルを [0, 1] の模様の高さにする
+  const auto size{ static_cast<std::size_t>(width) * height };
+  data.resize(size);
+  for (std::size_t i = 0; i < size; ++i) data[i] = image[i * channels] / 65535.0f;
+
+  // 読み込んだ画像のメモリを開放する
+  stbi_image_free(image);
+
+  return true;
+}
+
+//
+// 研磨の圧力による板のたわみを求めて鏡の高さマップにする
+//
+std::shared_ptr<HeightMap> MirrorRelief::solve(const Plate& plate, GLfloat& scale, int cycles) const
+{
+  scale = 0.0f;
+  if (data.empty()) return nullptr;
+
+  // 長さはメートル, 圧力はパスカルにする
+  const auto diameter{ std::max(plate.diameter, 1.0e-3f) * 1.0e-3f };
+  const auto pressure{ plate.pressure * 1.0e3f };
+  const auto poisson{ std::clamp(plate.poisson, 0.0f, 0.499f) };
+  const auto rigidity{ std::max(plate.modulus, 1.0e-3f) * 1.0e9f / (12.0f * (1.0f - poisson * poisson)) };
+
+  // 画素数を半分にしながら格子を作る
+  std::vector<Level> levels;
+  levels.emplace_back(width, height, diameter);
+  while (std::min(levels.back().width, levels.back().height) > 4)
+    levels.emplace_back((levels.back().width + 1) / 2, (levels.back().height + 1) / 2, diameter);
+  auto& fine{ levels.front() };
+
+  // 曲げモーメントの和 M = D ∇²w を ∇²M = p, 円周で M = 0 として求める
+  for (std::size_t i = 0; i < fine.f.size(); ++i) fine.f[i] = fine.inside[i] ? pressure : 0.0f;
+  solvePoisson(levels, cycles);
+
+  // たわみ w を ∇²w = M / D, 円周で w = 0 として求める
+  ggParallelFor(0, fine.f.size(), 0, [&](std::size_t begin, std::size_t end)
+    {
+      for (auto i = begin; i < end; ++i)
+      {
+        const auto t{ std::max(plate.thickness + plate.depth * data[i], 1.0e-3f) * 1.0e-3f };
+        fine.f[i] = fine.inside[i] ? fine.u[i] / (rigidity * t * t * t) : 0.0f;
+      }
+    });
+  solvePoisson(levels, cycles);
+
+  // 最大のたわみを 1 に正規化して 16bit の高さにする (円の外側は円周と同じ 0)
+  const auto peak{ *std::max_element(fine.u.begin(), fine.u.end()) };
+  std::vector<GLushort> heights(fine.u.size());
+  if (peak > 0.0f)
+  {
+    for (std::size_t i = 0; i < heights.size(); ++i)
+      heights[i] = static_cast<GLushort>(std::clamp(fine.u[i] / peak, 0.0f, 1.0f) * 65535.0f + 0.5f);
+
+    // 両隣の画素の高さの差にスケールを掛けた勾配が実際の勾配 (Δw / 2Δx) になるようにする
+    scale = peak * width / (2.0f * diameter);
+  }
+
+  return std::make_shared<HeightMap>(width, height, std::move(heights));
+}
@@ -0,0 +1,137 @@
+﻿#pragma once
+
+///
+/// 鏡の背面の模様クラスの定義
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 18, 2026
+///
+
+// 高さマップ
+#include "HeightMap.h"
+
+///
+/// 鏡の背面の模様
+///
+/// @note
+/// 魔鏡の表面の微細な凹凸は, 背面に鋳出した模様による板の厚さの違いから生じる.
+/// 研磨の圧力 p を受けた板は厚さ h の薄いところほど大きくたわみ, そのまま平らに研磨されるので,
+/// 圧力を除くとたわみ w がそのまま表面の凹凸として残る.
+/// 曲げ剛性 D = E h^3 / 12(1 - ν^2) の板のたわみは ∇²(D ∇²w) = p に従うので,
+/// 鏡の円周で単純支持 (w = 0, ∇²w = 0) されているものとして,
+/// ∇²M = p と ∇²w = M / D の二つのポアソン方程式をマルチグリッド法で順に解く.
+///
+class MirrorRelief
+{
+  // 背面の模様の横の画素数
+  GLsizei width;
+
+  // 背面の模様の縦の画素数
+  GLsizei height;
+
+  // 単一チャンネルの [0, 1] の模様の高さ
+  std::vector<GLfloat> data;
+
+public:
+
+  ///
+  /// 板の条件
+  ///
+  struct Plate
+  {
+    /// 鏡の直径 (mm), 画像の横幅に対応する
+    GLfloat diameter;
+
+    /// 模様の無いところの板の厚さ (mm)
+    GLfloat thickness;
+
+    /// 模様の高さが 1 のところで板の厚さに加える厚さ (mm)
+    GLfloat depth;
+
+    /// ヤング率 (GPa)
+    GLfloat modulus;
+
+    /// ポアソン比
+    GLfloat poisson;
+
+    /// 研磨の圧力 (kPa)
+    GLfloat pressure;
+  };
+
+  ///
+  /// コンストラクタ
+  ///
+  MirrorRelief();
+
+  ///
+  /// 画像ファイルから背面の模様を読み込むコンストラクタ
+  ///
+  /// @param name 読み込む画像ファイル名
+  ///
+  MirrorRelief(const std::string& name);
+
+  ///
+  /// デストラクタ
+  ///
+  virtual ~MirrorRelief();
+
+  ///
+  /// 画像ファイルから背面の模様を読み込む
+  ///
+  /// @param name 読み込む画像ファイル名
+  /// @return 読み込みに成功したら true
+  ///
+  /// @note
+  /// 最初のチャンネルの明るさを模様の高さにする.
+  ///
+  bool load(const std::string& name);
+
+  ///
+  /// 背面の模様が有効かどうか調べる
+  ///
+  /// @return 背面の模様が読み込まれていれば true
+  ///
+  explicit operator bool() const noexcept
+  {
+    return !data.empty();
+  }
+
+  ///
+  /// 背面の模様の横の画素数を得る
+  ///
+  auto getWidth() const
+  {
+    return width;
+  }
+
+  ///
+  /// 背面の模様の縦の画素数を得る
+  ///
+  auto getHeight() const
+  {
+    return height;
+  }
+
+  ///
+  /// 背面の模様のデータを取り出す
+  ///
+  const auto& get() const
+  {
+    return data;
+  }
+
+  ///
+  /// 研磨の圧力による板のたわみを求めて鏡の高さマップにする
+  ///
+  /// @param plate 板の条件
+  /// @param scale 高さマップの勾配が鏡のローカル座標系の勾配になる高さのスケールの格納先
+  /// @param cycles マルチグリッド法の V サイクルの反復回数の上限
+  /// @return 最大のたわみを 1 に正規化した 16bit の高さマップ, 背面の模様が無ければ nullptr
+  ///
+  /// @note
+  /// OpenGL を使わないので描画スレッド以外から呼び出してもよい.
+  /// 計算には ggParallelFor() のスレッドプールを使う.
+  ///
+  std::shared_ptr<HeightMap> solve(const Plate& plate, GLfloat& scale, int cycles = 20) const;
+};
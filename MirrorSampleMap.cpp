@@ -0,0 +1,88 @@
+﻿///
+/// 鏡の標本点マップクラスの実装
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 18, 2026
+///
+#include "MirrorSampleMap.h"
+
+//
+// コンストラクタ
+//
+MirrorSampleMap::MirrorSampleMap(GLsizei samples, GLsizei mirrors) :
+  width{ samples },
+  height{ mirrors },
+  fbo{ 0 },
+  textures{}
+{
+  // 標本点ごとのデータを格納するテクスチャを作成する
+  glGenTextures(ATTACHMENTS, textures.data());
+  for (const auto texture : textures)
+  {
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  }
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  // テクスチャをカラーバッファに使うフレームバッファオブジェクトを作成する
+  glGenFramebuffers(1, &fbo);
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+  for (int i = 0; i < ATTACHMENTS; ++i)
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, textures[i], 0);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+//
+// デストラクタ
+//
+MirrorSampleMap::~MirrorSampleMap()
+{
+  glDeleteFramebuffers(1, &fbo);
+  glDeleteTextures(ATTACHMENTS, textures.data());
+}
+
+//
+// 標本点ごとのデータの書き込みを開始する
+//
+void MirrorSampleMap::begin(GLsizei samples, GLsizei mirrors) const
+{
+  // すべてのテクスチャに書き込む
+  static constexpr GLenum buffers[]{ GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1,
+    GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3, GL_COLOR_ATTACHMENT4, GL_COLOR_ATTACHMENT5,
+    GL_COLOR_ATTACHMENT6, GL_COLOR_ATTACHMENT7 };
+  static_assert(ATTACHMENTS <= std::size(buffers));
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+  glDrawBuffers(ATTACHMENTS, buffers);
+
+  // 標本点の数と鏡のインスタンスの数の範囲だけを書き込む
+  glViewport(0, 0, std::min(samples, width), std::min(mirrors, height));
+
+  // 隠面消去処理は行わない
+  glDisable(GL_DEPTH_TEST);
+}
+
+//
+// 標本点ごとのデータの書き込みを終了する
+//
+void MirrorSampleMap::end() const
+{
+  glEnable(GL_DEPTH_TEST);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+//
+// 標本点ごとのデータのテクスチャを連続するテクスチャユニットに結合する
+//
+void MirrorSampleMap::bind(GLuint unit) const
+{
+  for (int i = 0; i < ATTACHMENTS; ++i)
+  {
+    glActiveTexture(GL_TEXTURE0 + unit + i);
+    glBindTexture(GL_TEXTURE_2D, textures[i]);
+  }
+}
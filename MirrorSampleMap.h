@@ -0,0 +1,100 @@
+﻿#pragma once
+
+///
+/// 鏡の標本点マップクラスの定義
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 18, 2026
+///
+
+// 補助プログラム
+#include "gg.h"
+using namespace gg;
+
+///
+/// 鏡の標本点マップ
+///
+/// @note
+/// 鏡の標本点ごとの視点座標系の位置や法線ベクトルのように受光面によらないデータを
+/// 毎フレーム一度だけ求めて, 横に標本点, 縦に鏡のインスタンスを並べた浮動小数点テクスチャに格納する.
+/// すべての受光面の描画で同じテクスチャを参照する.
+///
+class MirrorSampleMap
+{
+public:
+
+  /// 標本点ごとのデータの種類
+  enum Attachment
+  {
+    POSITION = 0,                                     ///< 視点座標系における標本点の位置
+    NORMAL,                                           ///< 視点座標系における標本点の法線ベクトル
+    LIGHT,                                            ///< 視点座標系における標本点から全体光源に向かう単位ベクトル
+    DIFFUSE,                                          ///< 標本点の全体光源による拡散反射光強度
+    REFLECTION,                                       ///< 標本点で反射した平行光線か点光源の光の方向
+    SLOPE,                                            ///< 標本点が受け持つ範囲の鏡のローカル座標系における勾配の共分散
+    ATTACHMENTS                                       ///< データの種類の数
+  };
+
+private:
+
+  // 横の画素数 (標本点の数の上限)
+  const GLsizei width;
+
+  // 縦の画素数 (鏡の数の上限)
+  const GLsizei height;
+
+  // フレームバッファオブジェクト
+  GLuint fbo;
+
+  // 標本点ごとのデータを格納するテクスチャ
+  std::array<GLuint, ATTACHMENTS> textures;
+
+public:
+
+  ///
+  /// コンストラクタ
+  ///
+  /// @param samples 標本点の数の上限
+  /// @param mirrors 鏡の数の上限
+  ///
+  MirrorSampleMap(GLsizei samples, GLsizei mirrors);
+
+  ///
+  /// コピーコンストラクタは使用しない
+  ///
+  MirrorSampleMap(const MirrorSampleMap& map) = delete;
+
+  ///
+  /// デストラクタ
+  ///
+  virtual ~MirrorSampleMap();
+
+  ///
+  /// 代入演算子は使用しない
+  ///
+  MirrorSampleMap& operator=(const MirrorSampleMap& map) = delete;
+
+  ///
+  /// 標本点ごとのデータの書き込みを開始する
+  ///
+  /// @param samples 標本点の数
+  /// @param mirrors 鏡のインスタンスの数
+  ///
+  /// @note
+  /// 書き込みが終わったら end() を呼び出してビューポートを元に戻す.
+  ///
+  void begin(GLsizei samples, GLsizei mirrors) const;
+
+  ///
+  /// 標本点ごとのデータの書き込みを終了する
+  ///
+  void end() const;
+
+  ///
+  /// 標本点ごとのデータのテクスチャを連続するテクスチャユニットに結合する
+  ///
+  /// @param unit 最初のデータ (POSITION) を結合するテクスチャユニットの番号
+  ///
+  void bind(GLuint unit) const;
+};
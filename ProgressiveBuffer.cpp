@@ -0,0 +1,152 @@
+﻿///
+/// 段階的詳細化の蓄積バッファクラスの実装
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 18, 2026
+///
+#include "ProgressiveBuffer.h"
+
+//
+// コンストラクタ
+//
+ProgressiveBuffer::ProgressiveBuffer() :
+  width{ 0 },
+  height{ 0 },
+  fbo{},
+  color{},
+  depth{ 0 },
+  frames{ 0 },
+  accumulated{ 0 },
+  revision{ 0 },
+  allocated{ false }
+{
+  // 描画先と蓄積先のカラーバッファに使うテクスチャを作成する
+  glGenTextures(static_cast<GLsizei>(color.size()), color.data());
+  for (const auto texture : color)
+  {
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  }
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  // 描画先のデプスバッファに使うレンダーバッファを作成する
+  glGenRenderbuffers(1, &depth);
+
+  // フレームバッファオブジェクトを作成する
+  glGenFramebuffers(static_cast<GLsizei>(fbo.size()), fbo.data());
+}
+
+//
+// デストラクタ
+//
+ProgressiveBuffer::~ProgressiveBuffer()
+{
+  glDeleteFramebuffers(static_cast<GLsizei>(fbo.size()), fbo.data());
+  glDeleteRenderbuffers(1, &depth);
+  glDeleteTextures(static_cast<GLsizei>(color.size()), color.data());
+}
+
+//
+// シーンが変化していないか調べる
+//
+bool ProgressiveBuffer::validate(GLsizei w, GLsizei h, const GgMatrix& v, unsigned int r)
+{
+  // 画素数が変わったら蓄積を捨ててバッファを作り直すようにする
+  if (w != width || h != height)
+  {
+    width = w;
+    height = h;
+    allocated = false;
+    reset();
+    return false;
+  }
+
+  // 視点かシーンの版数が変わったら蓄積を捨てる
+  if (v != view || r != revision)
+  {
+    view = v;
+    revision = r;
+    reset();
+    return false;
+  }
+
+  return true;
+}
+
+//
+// フレームごとの描画先への描画を開始する
+//
+void ProgressiveBuffer::begin()
+{
+  // 段階的に詳細化するときになってからバッファを作る
+  if (!allocated)
+  {
+    for (const auto texture : color)
+    {
+      glBindTexture(GL_TEXTURE_2D, texture);
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glBindRenderbuffer(GL_RENDERBUFFER, depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    // 描画先にだけデプスバッファを付ける
+    for (std::size_t i = 0; i < fbo.size(); ++i)
+    {
+      glBindFramebuffer(GL_FRAMEBUFFER, fbo[i]);
+      glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color[i], 0);
+      if (i == 0) glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+    }
+    allocated = true;
+  }
+
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo[0]);
+  glViewport(0, 0, width, height);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+//
+// 描画したフレームの蓄積を開始する
+//
+void ProgressiveBuffer::accumulate(GLuint unit) const
+{
+  // 描画したフレームのテクスチャを結合する
+  glActiveTexture(GL_TEXTURE0 + unit);
+  glBindTexture(GL_TEXTURE_2D, color[0]);
+
+  // 蓄積先に n 枚目のフレームを 1 / n の重みで混ぜる
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo[1]);
+  glDisable(GL_DEPTH_TEST);
+  glEnable(GL_BLEND);
+  glBlendColor(0.0f, 0.0f, 0.0f, 1.0f / static_cast<GLfloat>(frames + 1));
+  glBlendFunc(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA);
+}
+
+//
+// 描画したフレームの蓄積を終了する
+//
+void ProgressiveBuffer::end(GLsizei samples)
+{
+  glDisable(GL_BLEND);
+  glEnable(GL_DEPTH_TEST);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  ++frames;
+  accumulated += samples;
+}
+
+//
+// 蓄積した画像をデフォルトのフレームバッファに表示する
+//
+void ProgressiveBuffer::draw() const
+{
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo[1]);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+  glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
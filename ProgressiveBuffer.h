@@ -0,0 +1,138 @@
+﻿#pragma once
+
+///
+/// 段階的詳細化の蓄積バッファクラスの定義
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 18, 2026
+///
+
+// 補助プログラム
+#include "gg.h"
+using namespace gg;
+
+///
+/// 段階的詳細化の蓄積バッファ
+///
+/// @note
+/// シーンが変化していない間, フレームごとに異なる標本点で描いた受光面を
+/// 浮動小数点のテクスチャに平均して蓄積する. すべての標本点を使い終えたら
+/// 描画せずに蓄積した画像を表示するだけにする.
+///
+class ProgressiveBuffer
+{
+  // 蓄積バッファの画素数
+  GLsizei width, height;
+
+  // フレームごとの描画先と蓄積先のフレームバッファオブジェクト
+  std::array<GLuint, 2> fbo;
+
+  // フレームごとの描画先と蓄積先のカラーバッファに使うテクスチャ
+  std::array<GLuint, 2> color;
+
+  // フレームごとの描画先のデプスバッファに使うレンダーバッファ
+  GLuint depth;
+
+  // 蓄積したフレーム数
+  int frames;
+
+  // 蓄積した標本点数
+  GLsizei accumulated;
+
+  // 蓄積を始めたときのシーンの視点
+  GgMatrix view;
+
+  // 蓄積を始めたときのシーンの版数
+  unsigned int revision;
+
+  // 今の画素数でバッファを作っていれば true
+  bool allocated;
+
+public:
+
+  ///
+  /// コンストラクタ
+  ///
+  ProgressiveBuffer();
+
+  ///
+  /// コピーコンストラクタは使用しない
+  ///
+  ProgressiveBuffer(const ProgressiveBuffer& buffer) = delete;
+
+  ///
+  /// デストラクタ
+  ///
+  virtual ~ProgressiveBuffer();
+
+  ///
+  /// 代入演算子は使用しない
+  ///
+  ProgressiveBuffer& operator=(const ProgressiveBuffer& buffer) = delete;
+
+  ///
+  /// 蓄積を捨てる
+  ///
+  void reset()
+  {
+    frames = 0;
+    accumulated = 0;
+  }
+
+  ///
+  /// シーンが変化していないか調べる
+  ///
+  /// @param w 描画する画素の横の数
+  /// @param h 描画する画素の縦の数
+  /// @param v シーンの視点
+  /// @param r シーンの版数
+  /// @return 前に調べたときから変化していなければ true, 変化していれば蓄積を捨てて false
+  ///
+  bool validate(GLsizei w, GLsizei h, const GgMatrix& v, unsigned int r);
+
+  ///
+  /// 次のフレームで最初に使う標本点の番号を取り出す
+  ///
+  auto getOffset() const
+  {
+    return accumulated;
+  }
+
+  ///
+  /// すべての標本点を使い終えたか調べる
+  ///
+  /// @param total 標本点の総数
+  ///
+  bool isComplete(GLsizei total) const
+  {
+    return accumulated >= total;
+  }
+
+  ///
+  /// フレームごとの描画先への描画を開始する
+  ///
+  void begin();
+
+  ///
+  /// 描画したフレームの蓄積を開始する
+  ///
+  /// @param unit 描画したフレームのテクスチャを結合するテクスチャユニットの番号
+  ///
+  /// @note
+  /// この後で描画したフレームのテクスチャを画素単位に写すシェーダで画面全体を覆う矩形を描く.
+  ///
+  void accumulate(GLuint unit) const;
+
+  ///
+  /// 描画したフレームの蓄積を終了する
+  ///
+  /// @param samples このフレームで使った標本点数
+  ///
+  void end(GLsizei samples);
+
+  ///
+  /// 蓄積した画像をデフォルトのフレームバッファに表示する
+  ///
+  void draw() const;
+};
@@ -0,0 +1,437 @@
+﻿///
+/// 回帰試験クラスの実装
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 18, 2026
+///
+#include "Regression.h"
+
+// 標準ライブラリ
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+
+//
+// ファイル名から拡張子を除いた名前を取り出す
+//
+static std::string getStem(const std::string& path)
+{
+  return std::filesystem::u8path(path).stem().u8string();
+}
+
+//
+// ディレクトリの中のファイルのパスを作る
+//
+static std::string getPath(const std::string& directory, const std::string& name)
+{
+  return (std::filesystem::u8path(directory) / std::filesystem::u8path(name)).u8string();
+}
+
+//
+// 二つの RGB 画像の PSNR (dB) を求める
+//
+static double getPsnr(const std::vector<GLubyte>& a, const std::vector<GLubyte>& b)
+{
+  // 平均二乗誤差
+  double sum{ 0.0 };
+  for (std::size_t i = 0; i < a.size(); ++i)
+  {
+    const auto d{ static_cast<double>(a[i]) - static_cast<double>(b[i]) };
+    sum += d * d;
+  }
+  const auto mse{ sum / static_cast<double>(a.size()) };
+
+  // 一致していれば無限大になるので上限を設ける
+  return mse > 0.0 ? std::min(10.0 * std::log10(255.0 * 255.0 / mse), 100.0) : 100.0;
+}
+
+//
+// 二つの RGB 画像の輝度の SSIM を求める
+//
+// 8×8 画素の窓を 4 画素ずつずらしながら求めた SSIM の平均を返す.
+//
+static double getSsim(const std::vector<GLubyte>& a, const std::vector<GLubyte>& b, GLsizei width, GLsizei height)
+{
+  // 輝度に変換する
+  const auto size{ static_cast<std::size_t>(width) * height };
+  std::vector<double> ya(size), yb(size);
+  for (std::size_t i = 0; i < size; ++i)
+  {
+    ya[i] = 0.299 * a[i * 3 + 0] + 0.587 * a[i * 3 + 1] + 0.114 * a[i * 3 + 2];
+    yb[i] = 0.299 * b[i * 3 + 0] + 0.587 * b[i * 3 + 1] + 0.114 * b[i * 3 + 2];
+  }
+
+  // 分母が 0 にならないようにする定数
+  constexpr double c1{ (0.01 * 255.0) * (0.01 * 255.0) };
+  constexpr double c2{ (0.03 * 255.0) * (0.03 * 255.0) };
+  constexpr int window{ 8 }, stride{ 4 };
+  constexpr double n{ window * window };
+
+  double total{ 0.0 };
+  int count{ 0 };
+  for (int y = 0; y + window <= height; y += stride)
+  {
+    for (int x = 0; x + window <= width; x += stride)
+    {
+      // 窓の中の平均と分散と共分散
+      double sa{ 0.0 }, sb{ 0.0 }, saa{ 0.0 }, sbb{ 0.0 }, sab{ 0.0 };
+      for (int j = 0; j < window; ++j)
+      {
+        for (int i = 0; i < window; ++i)
+        {
+          const auto k{ static_cast<std::size_t>(y + j) * width + x + i };
+          sa += ya[k];
+          sb += yb[k];
+          saa += ya[k] * ya[k];
+          sbb += yb[k] * yb[k];
+          sab += ya[k] * yb[k];
+        }
+      }
+      const auto ma{ sa / n }, mb{ sb / n };
+      const auto va{ saa / n - ma * ma }, vb{ sbb / n - mb * mb }, cab{ sab / n - ma * mb };
+
+      total += (2.0 * ma * mb + c1) * (2.0 * cab + c2) / ((ma * ma + mb * mb + c1) * (va + vb + c2));
+      ++count;
+    }
+  }
+
+  // 窓が取れないほど小さければ一致しているかどうかだけを見る
+  return count > 0 ? total / count : a == b ? 1.0 : 0.0;
+}
+
+//
+// コンストラクタ
+//
+Regression::Regression(const std::string& filename, bool update) :
+  update{ update },
+  output{ "makyoh_regression_result.json" },
+  references{ "regression" },
+  differences{ "regression_diff" },
+  heightMaps{ "height_map_256.png", "terrain_256.png" },
+  receivers{ "plane.obj", "wall.obj", "logo.obj", "bunny.obj" },
+  orientations{ { "plane.obj", { 0.0f, 3.14159265f, 0.0f, 1.0f } } },
+  illuminantMaps{ "illuminant_map.png", "grid.png" },
+  samples{ 100 },
+  resolution{ 320, 180 },
+  frames{ 600 },
+  psnr{ 35.0 },
+  ssim{ 0.97 },
+  current{ 0 },
+  frame{ 0 },
+  failures{ 0 }
+{
+  // 仕様ファイルが読み込めなかったらデフォルト値の仕様ファイルを作る
+  if (!load(filename)) save(filename);
+
+  // 段階的詳細化を始めるには少なくとも 2 フレーム必要
+  samples = std::clamp(samples, 1, MAX_MIRROR_SAMPLES);
+  frames = std::max(frames, 2);
+
+  // 高さマップの読み込みがなるべく少なくなる順にすべての組み合わせを並べる
+  for (const auto& heightMap : heightMaps)
+  {
+    for (const auto& receiver : receivers)
+    {
+      for (const auto& illuminantMap : illuminantMaps)
+      {
+        const auto name{ getStem(heightMap) + "_" + getStem(receiver) + "_" + getStem(illuminantMap) };
+        const auto orientation{ orientations.find(receiver) };
+        const GgVector rotation{ orientation != orientations.end()
+          ? GgVector{ orientation->second.data() } : GgVector{ 0.0f, 0.0f, 0.0f, 1.0f } };
+        cases.emplace_back(Case{ heightMap, receiver, rotation, illuminantMap, name });
+      }
+    }
+  }
+}
+
+//
+// デストラクタ
+//
+Regression::~Regression()
+{
+}
+
+//
+// 仕様ファイルを読み込む
+//
+bool Regression::load(const std::string& filename)
+{
+  // 仕様ファイルを開く
+  std::ifstream file{ Utf8ToTChar(filename) };
+
+  // 開けなかったらエラー
+  if (!file) return false;
+
+  // JSON の読み込み
+  picojson::value value;
+  file >> value;
+  file.close();
+
+  // JSON として読めていなかったらエラー
+  if (!value.is<picojson::object>()) return false;
+
+  // 仕様の取り出し
+  const auto& object{ value.get<picojson::object>() };
+
+  // オブジェクトが空だったらエラー
+  if (object.empty()) return false;
+
+  // 試験結果の書き出し先と参照画像と差の画像のディレクトリ
+  getString(object, "output", output);
+  getString(object, "references", references);
+  getString(object, "differences", differences);
+
+  // 鏡の高さマップと受光面の形状と投影光源マップ
+  if (object.count("height_maps") > 0) heightMaps.clear();
+  getString(object, "height_maps", heightMaps);
+  if (object.count("receivers") > 0) receivers.clear();
+  getString(object, "receivers", receivers);
+  const auto found{ object.find("receiver_orientations") };
+  if (found != object.end() && found->second.is<picojson::object>())
+  {
+    const auto& orientation{ found->second.get<picojson::object>() };
+    orientations.clear();
+    for (const auto& o : orientation) getValue(orientation, o.first, orientations[o.first]);
+  }
+  if (object.count("illuminant_maps") > 0) illuminantMaps.clear();
+  getString(object, "illuminant_maps", illuminantMaps);
+
+  // 1 フレームで使う鏡の標本点数とウィンドウサイズ
+  getValue(object, "samples", samples);
+  getValue(object, "resolution", resolution);
+
+  // 組み合わせごとに描画するフレーム数の上限
+  getValue(object, "frames", frames);
+
+  // PSNR と SSIM の閾値
+  getValue(object, "psnr", psnr);
+  getValue(object, "ssim", ssim);
+
+  return true;
+}
+
+//
+// 仕様ファイルを書き出す
+//
+bool Regression::save(const std::string& filename) const
+{
+  // 仕様ファイルを開く
+  std::ofstream file{ Utf8ToTChar(filename) };
+
+  // 開けなかったらエラー
+  if (!file) return false;
+
+  // 仕様の書き出しに使うオブジェクト
+  picojson::object object;
+
+  // 試験結果の書き出し先と参照画像と差の画像のディレクトリ
+  setString(object, "output", output);
+  setString(object, "references", references);
+  setString(object, "differences", differences);
+
+  // 鏡の高さマップと受光面の形状と投影光源マップ
+  setString(object, "height_maps", heightMaps);
+  setString(object, "receivers", receivers);
+  picojson::object orientation;
+  for (const auto& [receiver, angles] : orientations) setValue(orientation, receiver, angles);
+  object.emplace("receiver_orientations", orientation);
+  setString(object, "illuminant_maps", illuminantMaps);
+
+  // 1 フレームで使う鏡の標本点数とウィンドウサイズ
+  setValue(object, "samples", samples);
+  setValue(object, "resolution", resolution);
+
+  // 組み合わせごとに描画するフレーム数の上限
+  setValue(object, "frames", frames);
+
+  // PSNR と SSIM の閾値
+  setValue(object, "psnr", psnr);
+  setValue(object, "ssim", ssim);
+
+  // 仕様をシリアライズして JSON で保存
+  picojson::value v{ object };
+  file << v.serialize(true);
+  file.close();
+
+  return true;
+}
+
+//
+// 描画した画像を参照画像と比べる
+//
+void Regression::compare(const std::vector<GLubyte>& image, GLsizei width, GLsizei height, picojson::object& result)
+{
+  const auto& c{ cases[current] };
+  const auto reference{ getPath(references, c.name + ".tga") };
+  setString(result, "reference", reference);
+
+  // 参照画像を更新するときは描画した画像を参照画像として保存する
+  std::error_code error;
+  if (update)
+  {
+    std::filesystem::create_directories(std::filesystem::u8path(references), error);
+    if (!ggSaveTga(reference, image.data(), width, height, 3))
+    {
+      setString(result, "error", "cannot write the reference image");
+      ++failures;
+      return;
+    }
+    setString(result, "status", "updated");
+    return;
+  }
+
+  // 参照画像が無ければ比べられないので失敗にする
+  if (!std::filesystem::exists(std::filesystem::u8path(reference), error))
+  {
+    setString(result, "error", "missing reference image");
+    ++failures;
+    return;
+  }
+
+  // 参照画像を読み込む
+  std::vector<GLubyte> expected;
+  GLsizei w, h;
+  GLenum format;
+  if (!ggReadImage(reference, expected, &w, &h, &format) || format != GL_BGR)
+  {
+    setString(result, "error", "cannot read the reference image");
+    ++failures;
+    return;
+  }
+
+  // 大きさが違えば比べられない
+  if (w != width || h != height)
+  {
+    setString(result, "error", "the reference image has a different size");
+    ++failures;
+    return;
+  }
+
+  // TGA ファイルの画素は BGR の順に並んでいるので RGB に並べ替える
+  for (std::size_t i = 0; i < expected.size(); i += 3) std::swap(expected[i], expected[i + 2]);
+
+  // PSNR と SSIM を求める
+  const auto p{ getPsnr(image, expected) };
+  const auto s{ getSsim(image, expected, width, height) };
+  setValue(result, "psnr", p);
+  setValue(result, "ssim", s);
+
+  // どちらも閾値以上なら合格
+  if (p >= psnr && s >= ssim)
+  {
+    setString(result, "status", "passed");
+    return;
+  }
+  setString(result, "status", "failed");
+  ++failures;
+
+  // 描画した画像と差を 4 倍に強調した画像を書き出す
+  std::vector<GLubyte> difference(image.size());
+  for (std::size_t i = 0; i < image.size(); ++i)
+    difference[i] = static_cast<GLubyte>(std::min(std::abs(image[i] - expected[i]) * 4, 255));
+  std::filesystem::create_directories(std::filesystem::u8path(differences), error);
+  const auto actual{ getPath(differences, c.name + "_actual.tga") };
+  const auto diff{ getPath(differences, c.name + "_diff.tga") };
+  if (ggSaveTga(actual, image.data(), width, height, 3)) setString(result, "actual", actual);
+  if (ggSaveTga(diff, difference.data(), width, height, 3)) setString(result, "difference", diff);
+}
+
+//
+// 試験している組み合わせの結果を残して次の組み合わせに進む
+//
+void Regression::next(picojson::object& result, const std::string& error)
+{
+  const auto& c{ cases[current] };
+
+  // 組み合わせの条件
+  setString(result, "height_map", c.heightMap);
+  setString(result, "receiver", c.receiver);
+  setString(result, "illuminant_map", c.illuminantMap);
+  setValue(result, "frames", frame);
+
+  // 試験できなかったらその理由を残して失敗にする
+  if (!error.empty())
+  {
+    setString(result, "error", error);
+    ++failures;
+  }
+  results.emplace_back(result);
+
+  // 次の組み合わせに進む
+  frame = 0;
+  ++current;
+}
+
+//
+// 試験している組み合わせを設定できなかったので飛ばす
+//
+void Regression::skip(const std::string& error)
+{
+  picojson::object result;
+  next(result, error);
+}
+
+//
+// フレームを描画したことを記録する
+//
+void Regression::record(bool converged, GLsizei width, GLsizei height)
+{
+  // すべての組み合わせを試験し終えていたら何もしない
+  if (!*this) return;
+
+  // 詳細化が終わっていなければ上限のフレーム数に達するまで描画を続ける
+  ++frame;
+  if (!converged)
+  {
+    if (frame < frames) return;
+    picojson::object result;
+    next(result, "the image did not converge");
+    return;
+  }
+
+  // カラーバッファを読み出す
+  std::vector<GLubyte> image(static_cast<std::size_t>(width) * height * 3);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, image.data());
+
+  // 参照画像と比べて次の組み合わせに進む
+  picojson::object result;
+  compare(image, width, height, result);
+  next(result);
+}
+
+//
+// 試験結果を JSON ファイルに書き出す
+//
+bool Regression::write() const
+{
+  // 結果のファイルを開く
+  std::ofstream file{ Utf8ToTChar(output) };
+
+  // 開けなかったらエラー
+  if (!file) return false;
+
+  // 試験した環境と条件
+  picojson::object object;
+  const auto* const renderer{ reinterpret_cast<const char*>(glGetString(GL_RENDERER)) };
+  const auto* const version{ reinterpret_cast<const char*>(glGetString(GL_VERSION)) };
+  setString(object, "renderer", renderer ? renderer : "");
+  setString(object, "version", version ? version : "");
+  setValue(object, "samples", samples);
+  setValue(object, "psnr", psnr);
+  setValue(object, "ssim", ssim);
+  setValue(object, "update", update);
+  setValue(object, "failures", failures);
+
+  // 組み合わせごとの結果
+  object.emplace("cases", results);
+
+  // 結果をシリアライズして JSON で保存
+  picojson::value v{ object };
+  file << v.serialize(true);
+  file.close();
+
+  return true;
+}
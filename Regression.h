@@ -0,0 +1,236 @@
+﻿#pragma once
+
+///
+/// 回帰試験クラスの定義
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 18, 2026
+///
+
+// メニューの描画
+#include "Menu.h"
+
+// 標準ライブラリ
+#include <map>
+
+///
+/// 回帰試験
+///
+/// @note
+/// 仕様ファイルに書かれた高さマップ, 受光面の形状, 投影光源マップのすべての組み合わせについて,
+/// 受光面の形状ごとに指定した向き (指定が無ければ回転しない) で全体光源を環境光だけにして,
+/// 段階的詳細化ですべての標本点を使い終えるまで描画した画像を保存してある参照画像と比べる.
+/// PSNR か SSIM が閾値を下回れば失敗とし, 描画した画像と参照画像との差の画像を書き出す.
+/// 参照画像が無い組み合わせも失敗とする. 参照画像は --update-references を付けて実行したときだけ,
+/// 描画した画像で作り直す. 既定の仕様の参照画像は regression ディレクトリに置いてある.
+/// GPU の無い環境でも LIBGL_ALWAYS_SOFTWARE=1 を設定して Mesa の llvmpipe を使えば,
+/// xvfb-run -a ./makyoh --regression のように仮想のディスプレイで実行できる. ctest でも実行できる.
+/// すべての組み合わせが合格すれば終了コードは 0, そうでなければ 1 になる.
+///
+class Regression
+{
+public:
+
+  ///
+  /// 試験する条件の組み合わせ
+  ///
+  struct Case
+  {
+    /// 鏡の高さマップのファイル名
+    std::string heightMap;
+
+    /// 受光面の形状ファイル名
+    std::string receiver;
+
+    /// 受光面の x, y, z 軸中心の回転角 (ラジアン) と拡大率
+    GgVector orientation;
+
+    /// 投影光源マップのファイル名
+    std::string illuminantMap;
+
+    /// 参照画像などのファイル名に使う組み合わせの名前
+    std::string name;
+  };
+
+private:
+
+  // 参照画像を描画した画像で作り直すなら true
+  const bool update;
+
+  // 試験結果の書き出し先のファイル名
+  std::string output;
+
+  // 参照画像を置くディレクトリ
+  std::string references;
+
+  // 失敗したときに描画した画像と差の画像を書き出すディレクトリ
+  std::string differences;
+
+  // 鏡の高さマップ
+  std::vector<std::string> heightMaps;
+
+  // 受光面の形状
+  std::vector<std::string> receivers;
+
+  // 受光面の形状ごとの x, y, z 軸中心の回転角 (ラジアン) と拡大率
+  std::map<std::string, std::array<GLfloat, 4>> orientations;
+
+  // 投影光源マップ
+  std::vector<std::string> illuminantMaps;
+
+  // 1 フレームで使う鏡の標本点数
+  int samples;
+
+  // ウィンドウサイズ
+  std::array<GLsizei, 2> resolution;
+
+  // 組み合わせごとに描画するフレーム数の上限
+  int frames;
+
+  // PSNR の閾値 (dB)
+  double psnr;
+
+  // SSIM の閾値
+  double ssim;
+
+  // 試験する条件の組み合わせ
+  std::vector<Case> cases;
+
+  // 試験している組み合わせの番号
+  std::size_t current;
+
+  // 試験している組み合わせで描画したフレーム数
+  int frame;
+
+  // 失敗した組み合わせの数
+  int failures;
+
+  // 試験を終えた組み合わせの結果
+  picojson::array results;
+
+  // 仕様ファイルを読み込む
+  bool load(const std::string& filename);
+
+  // 仕様ファイルを書き出す
+  bool save(const std::string& filename) const;
+
+  // 描画した画像を参照画像と比べる
+  void compare(const std::vector<GLubyte>& image, GLsizei width, GLsizei height, picojson::object& result);
+
+  // 試験している組み合わせの結果を残して次の組み合わせに進む
+  void next(picojson::object& result, const std::string& error = "");
+
+public:
+
+  ///
+  /// コンストラクタ
+  ///
+  /// @param filename 回帰試験の仕様ファイル名
+  /// @param update 参照画像を描画した画像で作り直すなら true
+  ///
+  /// @note
+  /// 仕様ファイルが読み込めなければデフォルトの仕様ファイルを作る.
+  ///
+  Regression(const std::string& filename, bool update = false);
+
+  ///
+  /// コピーコンストラクタは使用しない
+  ///
+  Regression(const Regression& regression) = delete;
+
+  ///
+  /// デストラクタ
+  ///
+  virtual ~Regression();
+
+  ///
+  /// 代入演算子は使用しない
+  ///
+  Regression& operator=(const Regression& regression) = delete;
+
+  ///
+  /// 試験していない組み合わせが残っているかどうか
+  ///
+  explicit operator bool() const
+  {
+    return current < cases.size();
+  }
+
+  ///
+  /// 試験している組み合わせの最初のフレームかどうか
+  ///
+  /// @return 条件を切り替えるフレームなら true
+  ///
+  bool isStarting() const
+  {
+    return frame == 0;
+  }
+
+  ///
+  /// 試験している組み合わせを取り出す
+  ///
+  const auto& getCase() const
+  {
+    return cases[current];
+  }
+
+  ///
+  /// 1 フレームで使う鏡の標本点数を取り出す
+  ///
+  auto getSamples() const
+  {
+    return samples;
+  }
+
+  ///
+  /// ウィンドウサイズを取り出す
+  ///
+  const auto& getResolution() const
+  {
+    return resolution;
+  }
+
+  ///
+  /// 試験している組み合わせを設定できなかったので飛ばす
+  ///
+  /// @param error 設定できなかった理由
+  ///
+  void skip(const std::string& error);
+
+  ///
+  /// フレームを描画したことを記録する
+  ///
+  /// @param converged 段階的詳細化ですべての標本点を使い終え, 読み込み中の資源も無ければ true
+  /// @param width フレームバッファの横の画素数
+  /// @param height フレームバッファの縦の画素数
+  ///
+  /// @note
+  /// シーンを描画した後, メニューを描画する前に毎フレーム一度呼び出す.
+  /// converged が true になるか描画したフレーム数が上限に達したらカラーバッファを読み出して参照画像と比べる.
+  ///
+  void record(bool converged, GLsizei width, GLsizei height);
+
+  ///
+  /// 試験結果を JSON ファイルに書き出す
+  ///
+  /// @return 書き出せたら true
+  ///
+  bool write() const;
+
+  ///
+  /// すべての組み合わせが合格したかどうか
+  ///
+  bool passed() const
+  {
+    return failures == 0;
+  }
+
+  ///
+  /// 試験結果の書き出し先のファイル名を取り出す
+  ///
+  const auto& getOutput() const
+  {
+    return output;
+  }
+};
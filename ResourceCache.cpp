@@ -0,0 +1,85 @@
+﻿///
+/// 資源キャッシュクラスの実装
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 18, 2026
+///
+#include "ResourceCache.h"
+
+// 標準ライブラリ
+#include <algorithm>
+
+//
+// コンストラクタ
+//
+ResourceCache::ResourceCache(std::size_t budget) :
+  budget{ budget },
+  used{ 0 }
+{
+}
+
+//
+// デストラクタ
+//
+ResourceCache::~ResourceCache()
+{
+}
+
+//
+// 容量の上限を超えていたら古い資源を破棄する
+//
+void ResourceCache::evict()
+{
+  // 最も長く使われていない資源から調べる
+  for (auto it = entries.end(); used > budget && it != entries.begin();)
+  {
+    --it;
+
+    // キャッシュの外で使われている資源は破棄しない
+    if (it->resource.use_count() > 1) continue;
+
+    // 資源を破棄する
+    used -= it->bytes;
+    it = entries.erase(it);
+  }
+}
+
+//
+// 資源がキャッシュにあるかどうか
+//
+bool ResourceCache::contains(const std::string& kind, const std::string& path, const std::string& variant) const
+{
+  // ファイルが無ければキャッシュにはない
+  std::error_code error;
+  const auto file{ std::filesystem::u8path(path) };
+  const auto time{ std::filesystem::last_write_time(file, error) };
+  if (error) return false;
+
+  // 正規化できなければ与えられたパスをそのまま使う
+  auto canonical{ std::filesystem::weakly_canonical(file, error).u8string() };
+  if (error) canonical = path;
+
+  // 更新されていない同じファイルの資源を探す
+  return std::any_of(entries.begin(), entries.end(), [&](const Entry& entry)
+    {
+      return entry.kind == kind && entry.variant == variant && entry.canonical == canonical && entry.time == time;
+    });
+}
+
+//
+// 最近使った資源の一覧を得る
+//
+std::vector<std::pair<std::string, std::string>> ResourceCache::getRecent() const
+{
+  std::vector<std::pair<std::string, std::string>> recent;
+
+  for (const auto& entry : entries)
+  {
+    // 同じファイルの資源がすでにあれば加えない
+    const std::pair<std::string, std::string> item{ entry.kind, entry.path };
+    if (std::find(recent.begin(), recent.end(), item) == recent.end()) recent.push_back(item);
+  }
+
+  return recent;
+}
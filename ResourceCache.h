@@ -0,0 +1,194 @@
+﻿#pragma once
+
+///
+/// 資源キャッシュクラスの定義
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 18, 2026
+///
+
+// 補助プログラム
+#include "gg.h"
+using namespace gg;
+
+// 標準ライブラリ
+#include <filesystem>
+#include <functional>
+#include <list>
+
+///
+/// 資源キャッシュ
+///
+/// @note
+/// テクスチャや形状データを正規化したパスと更新時刻をキーにして保持し,
+/// 同じファイルを読み直すときにディスクから読まずにすぐ切り替えられるようにする.
+/// 容量の上限を超えたら最も長く使われていない資源から破棄するが,
+/// キャッシュの外で使われている資源は破棄しない.
+///
+class ResourceCache
+{
+  // キャッシュの要素
+  struct Entry
+  {
+    // 資源の種類
+    std::string kind;
+
+    // 同じファイルから作る資源の作り方の違い
+    std::string variant;
+
+    // 読み込んだときのファイル名
+    std::string path;
+
+    // 正規化したファイルのパス
+    std::string canonical;
+
+    // ファイルの更新時刻
+    std::filesystem::file_time_type time;
+
+    // 資源
+    std::shared_ptr<void> resource;
+
+    // 資源が使うメモリのバイト数
+    std::size_t bytes;
+  };
+
+  // キャッシュの要素 (先頭ほど最近使ったもの)
+  std::list<Entry> entries;
+
+  // キャッシュの容量の上限のバイト数
+  std::size_t budget;
+
+  // キャッシュの使用量のバイト数
+  std::size_t used;
+
+  // 容量の上限を超えていたら古い資源を破棄する
+  void evict();
+
+public:
+
+  ///
+  /// コンストラクタ
+  ///
+  /// @param budget キャッシュの容量の上限のバイト数
+  ///
+  ResourceCache(std::size_t budget);
+
+  ///
+  /// デストラクタ
+  ///
+  virtual ~ResourceCache();
+
+  ///
+  /// 資源を取り出す
+  ///
+  /// @tparam T 資源のデータ型
+  /// @param kind 資源の種類
+  /// @param path 資源のファイル名
+  /// @param variant 同じファイルから作る資源の作り方の違い
+  /// @param load キャッシュに無いときに資源を作成する関数, 引数に資源のバイト数を格納する
+  /// @return 資源, 作成できなかったら nullptr
+  ///
+  /// @note
+  /// キャッシュにあってもファイルが更新されていれば作り直す.
+  ///
+  template <typename T>
+  std::shared_ptr<T> get(const std::string& kind, const std::string& path, const std::string& variant,
+    const std::function<std::shared_ptr<T>(std::size_t& bytes)>& load)
+  {
+    // ファイルの正規化したパスと更新時刻を求める
+    std::error_code error;
+    const auto file{ std::filesystem::u8path(path) };
+    const auto time{ std::filesystem::last_write_time(file, error) };
+
+    // ファイルが無ければキャッシュを使わずに作成する
+    if (error)
+    {
+      std::size_t bytes{ 0 };
+      return load(bytes);
+    }
+
+    // 正規化できなければ与えられたパスをそのまま使う
+    auto canonical{ std::filesystem::weakly_canonical(file, error).u8string() };
+    if (error) canonical = path;
+
+    // キャッシュを探す
+    for (auto it = entries.begin(); it != entries.end(); ++it)
+    {
+      if (it->kind != kind || it->variant != variant || it->canonical != canonical) continue;
+
+      // ファイルが更新されていなければキャッシュの資源を先頭に移して使う
+      if (it->time == time)
+      {
+        entries.splice(entries.begin(), entries, it);
+        return std::static_pointer_cast<T>(entries.front().resource);
+      }
+
+      // ファイルが更新されていればキャッシュから外す
+      used -= it->bytes;
+      entries.erase(it);
+      break;
+    }
+
+    // 資源を作成する
+    std::size_t bytes{ 0 };
+    const auto resource{ load(bytes) };
+    if (!resource) return nullptr;
+
+    // キャッシュの先頭に追加する
+    entries.push_front(Entry{ kind, variant, path, canonical, time, resource, bytes });
+    used += bytes;
+
+    // 容量を超えていたら古い資源を破棄する
+    evict();
+
+    return resource;
+  }
+
+  ///
+  /// 資源がキャッシュにあるかどうか
+  ///
+  /// @param kind 資源の種類
+  /// @param path 資源のファイル名
+  /// @param variant 同じファイルから作る資源の作り方の違い
+  /// @return ファイルが更新されていない資源がキャッシュにあれば true
+  ///
+  bool contains(const std::string& kind, const std::string& path, const std::string& variant) const;
+
+  ///
+  /// 最近使った資源の一覧を得る
+  ///
+  /// @return 最近使った順の資源の種類とファイル名の組
+  ///
+  /// @note
+  /// 作り方だけが違う同じファイルの資源はひとつにまとめる.
+  ///
+  std::vector<std::pair<std::string, std::string>> getRecent() const;
+
+  ///
+  /// キャッシュの容量の上限を設定する
+  ///
+  /// @param bytes キャッシュの容量の上限のバイト数
+  ///
+  void setBudget(std::size_t bytes)
+  {
+    budget = bytes;
+    evict();
+  }
+
+  ///
+  /// キャッシュの容量の上限のバイト数を得る
+  ///
+  auto getBudget() const
+  {
+    return budget;
+  }
+
+  ///
+  /// キャッシュの使用量のバイト数を得る
+  ///
+  auto getUsed() const
+  {
+    return used;
+  }
+};
@@ -0,0 +1,59 @@
+﻿///
+/// 標本点数の制御クラスの実装
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 18, 2026
+///
+#include "SampleController.h"
+
+// 標準ライブラリ
+#include <algorithm>
+#include <cmath>
+
+//
+// コンストラクタ
+//
+SampleController::SampleController(int samples, GLfloat kp, GLfloat ki) :
+  kp{ kp },
+  ki{ ki },
+  previous{ 0.0f },
+  count{ 0.0f }
+{
+  reset(samples);
+}
+
+//
+// デストラクタ
+//
+SampleController::~SampleController()
+{
+}
+
+//
+// 制御をやり直す
+//
+void SampleController::reset(int samples)
+{
+  previous = 0.0f;
+  count = std::log(static_cast<GLfloat>(std::max(samples, 1)));
+}
+
+//
+// 計測した描画時間から標本点数を更新する
+//
+int SampleController::update(GLfloat time, GLfloat budget, int minimum, int maximum)
+{
+  // 目標に対する余裕の割合 (大きく外れたときに一度に変えすぎないように制限する)
+  const auto error{ std::min(std::max((budget - time) / budget, -1.0f), 1.0f) };
+
+  // 速度形の PI 制御で標本点数の対数を更新する
+  count += kp * (error - previous) + ki * error;
+  previous = error;
+
+  // 標本点数の範囲に収める
+  count = std::min(std::max(count, std::log(static_cast<GLfloat>(minimum))),
+    std::log(static_cast<GLfloat>(maximum)));
+
+  return static_cast<int>(std::lround(std::exp(count)));
+}
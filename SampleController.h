@@ -0,0 +1,69 @@
+﻿#pragma once
+
+///
+/// 標本点数の制御クラスの定義
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 18, 2026
+///
+
+// 補助プログラム
+#include "gg.h"
+using namespace gg;
+
+///
+/// 描画時間を目標に合わせる標本点数の PI 制御
+///
+/// @note
+/// 受光面の描画時間はおおむね標本点数に比例するので, 標本点数の対数を速度形の PI 制御で操作する.
+/// 速度形なので標本点数が上限や下限に張り付いても積分項が溜まり続けることは無い.
+///
+class SampleController
+{
+  // 比例ゲイン
+  const GLfloat kp;
+
+  // 積分ゲイン
+  const GLfloat ki;
+
+  // 前回の偏差
+  GLfloat previous;
+
+  // 標本点数の対数
+  GLfloat count;
+
+public:
+
+  ///
+  /// コンストラクタ
+  ///
+  /// @param samples 標本点数の初期値
+  /// @param kp 比例ゲイン
+  /// @param ki 積分ゲイン
+  ///
+  SampleController(int samples, GLfloat kp = 0.5f, GLfloat ki = 0.2f);
+
+  ///
+  /// デストラクタ
+  ///
+  virtual ~SampleController();
+
+  ///
+  /// 制御をやり直す
+  ///
+  /// @param samples 標本点数の初期値
+  ///
+  void reset(int samples);
+
+  ///
+  /// 計測した描画時間から標本点数を更新する
+  ///
+  /// @param time 計測した描画時間
+  /// @param budget 目標の描画時間
+  /// @param minimum 標本点数の下限
+  /// @param maximum 標本点数の上限
+  /// @return 更新した標本点数
+  ///
+  int update(GLfloat time, GLfloat budget, int minimum, int maximum);
+};
@@ -0,0 +1,93 @@
+﻿///
+/// 描画するシーンのクラスの実装
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 18, 2026
+///
+#include "Scene.h"
+
+//
+// 受光面の描画に使う鏡の高さマップのタイルを要求する
+//
+void Scene::requestMirrorTiles(GLsizei offset, GLsizei count) const
+{
+  // タイル化していなければ何もしない
+  const auto& tiled{ menu.mirrorTiledHeightMap };
+  const auto& samples{ menu.mirrorSample };
+  if (!tiled || samples.empty()) return;
+
+  // 標本点マップは標本点の位置の高さマップを詳細度 0 で参照する (タイル化していれば鏡はひとつ)
+  const auto size{ static_cast<int>(samples.size()) };
+  for (int i = 0; i < std::min(count, size); ++i)
+  {
+    const auto& sample{ samples[(i + offset) % size] };
+    tiled->request(sample[0] * 0.5f + 0.5f, sample[1] * 0.5f + 0.5f, 0);
+  }
+}
+
+//
+// 鏡のインスタンスのユニフォームバッファオブジェクトを設定する
+//
+GLsizei Scene::setMirrorInstance(const GgMatrix& view, const GgMatrix& model) const
+{
+  // 受光面のモデルビュー変換行列
+  std::vector<GgMatrix> receivers;
+  for (const auto& pose : receiverPose) receivers.push_back(ggProduct(view, pose, model));
+
+  // 受光面を照らす可能性のある鏡だけを格納する
+  MirrorInstance instance;
+  GLsizei count{ 0 };
+  for (std::size_t i = 0; i < mirrorPose.size(); ++i)
+  {
+    // 鏡のモデルビュー変換行列
+    const auto mirror{ ggProduct(view, mirrorPose[i], model).evaluate() };
+
+    // どれかの受光面の境界球が鏡の表側にかかっていれば true
+    bool visible{ false };
+    for (std::size_t j = 0; j < receivers.size() && !visible; ++j)
+    {
+      // 受光面の境界球の半径 (形状は一辺の長さ 2 の立方体に収まるように正規化している)
+      const auto radius{ 1.7320508f * fabs(settings.receivers[j].orientation[3]) };
+
+      // 鏡の中心から受光面の中心に向かうベクトルの鏡の法線方向の成分
+      const auto& receiver{ receivers[j] };
+      const auto distance{ (receiver[12] - mirror[12]) * mirror[8]
+        + (receiver[13] - mirror[13]) * mirror[9] + (receiver[14] - mirror[14]) * mirror[10] };
+
+      // 受光面の境界球が鏡の裏側になければ光が届く可能性がある
+      visible = distance > -radius;
+    }
+
+    // どの受光面にも光が届かなければ格納しない
+    if (!visible) continue;
+
+    // 鏡の姿勢と高さマップのスケールとレイヤ番号を格納する
+    instance.pose[count] = mirror;
+    instance.param[count] = { settings.mirrors[i].heightScale, static_cast<GLfloat>(i), 0.0f, 0.0f };
+    ++count;
+  }
+
+  // ユニフォームバッファオブジェクトの前のフレームで使っていない領域に転送する
+  menu.mirrorInstanceBuffer.send(&instance);
+
+  return count;
+}
+
+//
+// 受光面を描画する
+//
+void Scene::drawReceiver(GLsizei index) const
+{
+  // 形状ファイルの材質を使うならそのまま描画する
+  const auto& model{ *menu.receiverModel[index] };
+  if (!settings.receivers[index].customMaterial)
+  {
+    model.draw();
+    return;
+  }
+
+  // 受光面ごとの材質で描画する
+  menu.receiverMaterial->select(index);
+  model.get()->draw();
+}
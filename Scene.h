@@ -0,0 +1,411 @@
+﻿#pragma once
+
+///
+/// 描画するシーンのクラスの定義
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 18, 2026
+///
+
+// メニューの描画
+#include "Menu.h"
+
+///
+/// 描画するシーン
+///
+/// @note
+/// メインスレッドがメニューを操作している間に描画スレッドが使うメニューの状態のフレームごとの複製.
+/// Menu::apply() で描画スレッドに送られたコマンドを実行した直後に排他制御の下で作る.
+/// 構成データと姿勢は複製し, テクスチャやバッファオブジェクトなどの OpenGL の資源はメニューのものを参照する.
+/// OpenGL の資源は描画スレッドでしか作り直さないので, 描画スレッドは排他制御なしに参照できる.
+///
+class Scene
+{
+  // 資源を参照するメニュー
+  Menu& menu;
+
+  // 構成データの複製
+  const Config settings;
+
+  // 投影光源の姿勢
+  const GgMatrix illuminantPose;
+
+  // 選択している受光面からの視界
+  const GgMatrix receiverView;
+
+  // 鏡ごとの姿勢
+  const std::vector<GgMatrix> mirrorPose;
+
+  // 受光面ごとの姿勢
+  const std::vector<GgMatrix> receiverPose;
+
+  // 描画モード
+  const Menu::DrawMode drawMode;
+
+  // シーンの版数
+  const unsigned int revision;
+
+public:
+
+  ///
+  /// コンストラクタ
+  ///
+  /// @param menu 複製するメニュー
+  ///
+  /// @note
+  /// メニューの排他制御の下で呼び出す.
+  ///
+  Scene(Menu& menu) :
+    menu{ menu },
+    settings{ menu.settings },
+    illuminantPose{ menu.illuminantPose },
+    receiverView{ menu.receiverView },
+    mirrorPose{ menu.mirrorPose },
+    receiverPose{ menu.receiverPose },
+    drawMode{ menu.drawMode },
+    revision{ menu.revision }
+  {
+  }
+
+  ///
+  /// 全体光源データを取り出す
+  ///
+  /// @return 全体光源データ
+  ///
+  const auto& getLight() const
+  {
+    return *menu.light;
+  }
+
+  ///
+  /// 投影光源データを取り出す
+  ///
+  /// @return 投影光源データ
+  ///
+  const auto& getIlluminantIntensity() const
+  {
+    return *menu.illuminant;
+  }
+
+  ///
+  /// 投影光源マップのテクスチャを取り出す
+  ///
+  /// @return 投影光源マップのテクスチャ
+  ///
+  GLuint getIlluminantMap() const
+  {
+    return menu.illuminantMap ? *menu.illuminantMap : 0;
+  }
+
+  ///
+  /// 投影光源の種類を取り出す
+  ///
+  auto getIlluminantType() const
+  {
+    return settings.illuminantType;
+  }
+
+  ///
+  /// 平行光線と点光源の鏡面の微細な粗さを表す指数を取り出す
+  ///
+  auto getIlluminantExponent() const
+  {
+    return settings.illuminantExponent;
+  }
+
+  ///
+  /// 投影光源マップを使わない投影光源の色と強度を取り出す
+  ///
+  auto getIlluminantColor() const
+  {
+    return settings.illuminantColor * settings.illuminantIntensity;
+  }
+
+  ///
+  /// 投影光源の姿勢を取り出す
+  ///
+  const auto& getIlluminantPose() const
+  {
+    return illuminantPose;
+  }
+
+  ///
+  /// 鏡の高さマップのテクスチャ配列を取り出す
+  ///
+  /// @note
+  /// 鏡の番号がテクスチャ配列のレイヤ番号になる.
+  /// タイル化した高さマップを使っているときは 0 を返す.
+  ///
+  GLuint getHeightMap() const
+  {
+    return menu.mirrorHeightMap ? *menu.mirrorHeightMap : 0;
+  }
+
+  ///
+  /// 鏡の高さマップの勾配の 1 次か 2 次のモーメントのテクスチャ配列を取り出す
+  ///
+  /// @param order 1 なら勾配, 2 なら勾配の積のテクスチャ配列を取り出す
+  ///
+  /// @note
+  /// 標本点が受け持つ範囲の勾配の分布で反射光を広げないときやタイル化した高さマップを使っているときは 0 を返す.
+  ///
+  GLuint getMomentMap(int order) const
+  {
+    const auto& map{ menu.mirrorMomentMap[order > 1] };
+    return map ? *map : 0;
+  }
+
+  ///
+  /// タイル化した鏡の高さマップを取り出す
+  ///
+  /// @return タイル化した鏡の高さマップ, タイル化していなければ nullptr
+  ///
+  auto getTiledHeightMap() const
+  {
+    return menu.mirrorTiledHeightMap.get();
+  }
+
+  ///
+  /// 受光面の描画に使う鏡の高さマップのタイルを要求する
+  ///
+  /// @param offset 最初に使う標本点の番号
+  /// @param count 使う標本点の数
+  ///
+  void requestMirrorTiles(GLsizei offset, GLsizei count) const;
+
+  ///
+  /// 鏡の数を取り出す
+  ///
+  auto getMirrorCount() const
+  {
+    return static_cast<GLsizei>(settings.mirrors.size());
+  }
+
+  ///
+  /// 鏡の姿勢を取り出す
+  ///
+  /// @param index 鏡の番号
+  ///
+  const auto& getMirrorPose(GLsizei index) const
+  {
+    return mirrorPose[index];
+  }
+
+  ///
+  /// 鏡のインスタンスのユニフォームバッファオブジェクトを設定する
+  ///
+  /// @param view 視野変換行列
+  /// @param model 鏡と受光面に共通のモデル変換行列
+  /// @return ユニフォームバッファオブジェクトに格納した鏡の数
+  ///
+  /// @note
+  /// どの受光面の境界球に対しても完全に裏側を向けている鏡は受光面を照らさないので格納しない.
+  ///
+  GLsizei setMirrorInstance(const GgMatrix& view, const GgMatrix& model) const;
+
+  ///
+  /// 鏡のインスタンスのユニフォームバッファオブジェクトを結合ポイントに結合する
+  ///
+  void bindMirrorInstance(GLuint bindingPoint) const
+  {
+    menu.mirrorInstanceBuffer.bind(bindingPoint);
+  }
+
+  ///
+  /// 鏡の材質のユニフォームバッファオブジェクトを結合ポイントに結合する
+  ///
+  void bindMirrorMaterial(GLuint bindingPoint) const
+  {
+    menu.mirrorMaterialBuffer.bind(bindingPoint);
+  }
+
+  ///
+  /// 鏡の標本点のユニフォームバッファオブジェクトを結合ポイントに結合する
+  ///
+  void bindMirrorSample(GLuint bindingPoint) const
+  {
+    glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, menu.mirrorSampleBuffer);
+  }
+
+  ///
+  /// 鏡の標本数を取り出す
+  ///
+  auto getMirrorSampleCount() const
+  {
+    return settings.mirrorSampleCount;
+  }
+
+  ///
+  /// 反射光の分散を見積もる試し描きに使う鏡の標本点数を取り出す
+  ///
+  /// @return 試し描きの標本点数, 画素ごとに標本点を配分しないか標本点数が少なくて配分できなければ 0
+  ///
+  /// @note
+  /// 標準偏差を求めるために試し描きには少なくとも 2 個の標本点を使う.
+  ///
+  int getVariancePilot() const
+  {
+    if (!settings.varianceSampling) return 0;
+    const auto pilot{ std::max(static_cast<int>(settings.mirrorSampleCount * settings.variancePilot), 2) };
+    return pilot < settings.mirrorSampleCount ? pilot : 0;
+  }
+
+  ///
+  /// 画素ごとに配分する鏡の標本点数の上限を取り出す
+  ///
+  int getVarianceLimit() const
+  {
+    return std::min(static_cast<int>(settings.mirrorSampleCount * settings.varianceLimit), MAX_MIRROR_SAMPLES);
+  }
+
+  ///
+  /// シーンが変化しなければ標本点を替えながら結果を蓄積するかどうかを取り出す
+  ///
+  auto getProgressiveRefinement() const
+  {
+    return settings.progressiveRefinement;
+  }
+
+  ///
+  /// 入力や読み込みが無い間は描画を止めてイベントを待つかどうかを取り出す
+  ///
+  auto getOnDemandRendering() const
+  {
+    return settings.onDemandRendering;
+  }
+
+  ///
+  /// 視点を動かしている間は前のフレームの反射光を再投影して混ぜるかどうかを取り出す
+  ///
+  auto getTemporalReprojection() const
+  {
+    return settings.temporalReprojection;
+  }
+
+  ///
+  /// 再投影して混ぜるフレーム数の上限を取り出す
+  ///
+  auto getTemporalFrames() const
+  {
+    return settings.temporalFrames;
+  }
+
+  ///
+  /// 投影光源による反射光を描く描画先の縮小率の逆数を取り出す
+  ///
+  /// @param still シーンが前のフレームから変化していなければ true
+  /// @return 縮小率の逆数, 縮小しなければ 1
+  ///
+  int getCausticScale(bool still) const
+  {
+    return settings.causticScaleInteractive && still ? 1 : settings.causticScale;
+  }
+
+  ///
+  /// 資源を別スレッドで読み込んでいるかどうか
+  ///
+  /// @return 読み込みが終わっていない資源があれば true
+  ///
+  /// @note
+  /// 読み込み中の資源は描画スレッドで切り替えるので, 描画スレッドは排他制御なしに調べられる.
+  ///
+  bool isLoading() const
+  {
+    return menu.pendingLoad.valid();
+  }
+
+  ///
+  /// シーンの版数を取り出す
+  ///
+  /// @note
+  /// メニューを操作したときやタイルの読み込みで描画結果が変わるときに進む.
+  ///
+  auto getRevision() const
+  {
+    return revision;
+  }
+
+  ///
+  /// 鏡の高さマップのスケールを取り出す
+  ///
+  /// @param index 鏡の番号
+  ///
+  auto getMirrorHeightScale(GLsizei index) const
+  {
+    return settings.mirrors[index].heightScale;
+  }
+
+  ///
+  /// 選択している受光面の視界を取り出す
+  ///
+  const auto& getReceiverView() const
+  {
+    return receiverView;
+  }
+
+  ///
+  /// 受光面の数を取り出す
+  ///
+  auto getReceiverCount() const
+  {
+    return static_cast<GLsizei>(menu.receiverModel.size());
+  }
+
+  ///
+  /// 受光面の姿勢を取り出す
+  ///
+  /// @param index 受光面の番号
+  ///
+  const auto& getReceiverPose(GLsizei index) const
+  {
+    return receiverPose[index];
+  }
+
+  ///
+  /// 受光面どうしの遮蔽を調べるかどうかを取り出す
+  ///
+  auto getReceiverShadow() const
+  {
+    return settings.receiverShadow;
+  }
+
+  ///
+  /// 受光面ごとの境界ボリューム階層の根の節点の番号と凸かどうかを取り出す
+  ///
+  /// @return 受光面ごとの根の節点の番号 (無ければ -1) と凸なら 1 の組の配列
+  ///
+  const auto& getOccluder() const
+  {
+    return menu.occluder;
+  }
+
+  ///
+  /// すべての受光面の境界ボリューム階層のバッファテクスチャを連続するテクスチャユニットに結合する
+  ///
+  /// @param unit 節点のバッファテクスチャを結合するテクスチャユニットの番号, 三角形はその次に結合する
+  ///
+  void bindOccluder(GLuint unit) const
+  {
+    for (std::size_t i = 0; i < menu.occluderTexture.size(); ++i)
+    {
+      glActiveTexture(GL_TEXTURE0 + unit + static_cast<GLuint>(i));
+      glBindTexture(GL_TEXTURE_BUFFER, menu.occluderTexture[i]);
+    }
+  }
+
+  ///
+  /// 受光面を描画する
+  ///
+  /// @param index 受光面の番号
+  ///
+  void drawReceiver(GLsizei index) const;
+
+  ///
+  /// 描画モードを取り出す
+  ///
+  auto getDrawMode() const
+  {
+    return drawMode;
+  }
+};
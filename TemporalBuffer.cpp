@@ -0,0 +1,140 @@
+﻿///
+/// 反射光の時間方向の再投影バッファクラスの実装
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 18, 2026
+///
+#include "TemporalBuffer.h"
+
+//
+// コンストラクタ
+//
+TemporalBuffer::TemporalBuffer() :
+  width{ 0 },
+  height{ 0 },
+  fbo{},
+  color{},
+  current{ 0 },
+  revision{ 0 },
+  valid{ false },
+  offset{ 0 }
+{
+  // 履歴の反射光と法線ベクトルと奥行きのテクスチャを作成する
+  for (auto& textures : color)
+  {
+    glGenTextures(static_cast<GLsizei>(textures.size()), textures.data());
+    for (const auto texture : textures)
+    {
+      glBindTexture(GL_TEXTURE_2D, texture);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+  }
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  // フレームバッファオブジェクトを作成する
+  glGenFramebuffers(static_cast<GLsizei>(fbo.size()), fbo.data());
+}
+
+//
+// デストラクタ
+//
+TemporalBuffer::~TemporalBuffer()
+{
+  glDeleteFramebuffers(static_cast<GLsizei>(fbo.size()), fbo.data());
+  for (auto& textures : color)
+    glDeleteTextures(static_cast<GLsizei>(textures.size()), textures.data());
+}
+
+//
+// 前のフレームの履歴が使えるか調べる
+//
+bool TemporalBuffer::validate(GLsizei w, GLsizei h, unsigned int r)
+{
+  // 画素数が変わったら履歴を捨ててバッファを作り直す
+  if (w != width || h != height)
+  {
+    width = w;
+    height = h;
+
+    // 反射光は半精度 (アルファに混ぜたフレーム数を入れる), 法線ベクトルと奥行きは単精度にする
+    static constexpr GLenum format[]{ GL_RGBA16F, GL_RGBA32F };
+    for (std::size_t i = 0; i < fbo.size(); ++i)
+    {
+      glBindFramebuffer(GL_FRAMEBUFFER, fbo[i]);
+      for (std::size_t j = 0; j < color[i].size(); ++j)
+      {
+        glBindTexture(GL_TEXTURE_2D, color[i][j]);
+        glTexImage2D(GL_TEXTURE_2D, 0, format[j], width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + static_cast<GLenum>(j),
+          GL_TEXTURE_2D, color[i][j], 0);
+      }
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    valid = false;
+  }
+
+  // シーンの版数が変わったら履歴を捨てる
+  if (r != revision)
+  {
+    revision = r;
+    valid = false;
+  }
+
+  return valid;
+}
+
+//
+// 履歴の更新を開始する
+//
+void TemporalBuffer::begin(GLuint unit)
+{
+  // 前のフレームの履歴を結合する
+  const auto& previous{ color[1 - current] };
+  for (std::size_t i = 0; i < previous.size(); ++i)
+  {
+    glActiveTexture(GL_TEXTURE0 + unit + static_cast<GLuint>(i));
+    glBindTexture(GL_TEXTURE_2D, previous[i]);
+  }
+
+  // このフレームの履歴に書き込む
+  static constexpr GLenum buffers[]{ GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo[current]);
+  glDrawBuffers(2, buffers);
+  glViewport(0, 0, width, height);
+  glDisable(GL_DEPTH_TEST);
+}
+
+//
+// 履歴の更新を終了する
+//
+void TemporalBuffer::end(const GgMatrix& v, GLsizei samples, GLsizei total)
+{
+  glEnable(GL_DEPTH_TEST);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+  // 書き込んだ履歴を次のフレームで読み出す
+  current = 1 - current;
+  view = v;
+  valid = true;
+
+  // 次のフレームでは続きの標本点を使う
+  offset = (offset + samples) % total;
+}
+
+//
+// 更新した履歴の反射光と法線ベクトルと奥行きのテクスチャを連続するテクスチャユニットに結合する
+//
+void TemporalBuffer::bind(GLuint unit) const
+{
+  const auto& latest{ color[1 - current] };
+  for (std::size_t i = 0; i < latest.size(); ++i)
+  {
+    glActiveTexture(GL_TEXTURE0 + unit + static_cast<GLuint>(i));
+    glBindTexture(GL_TEXTURE_2D, latest[i]);
+  }
+}
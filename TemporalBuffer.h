@@ -0,0 +1,129 @@
+﻿#pragma once
+
+///
+/// 反射光の時間方向の再投影バッファクラスの定義
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 18, 2026
+///
+
+// 補助プログラム
+#include "gg.h"
+using namespace gg;
+
+///
+/// 反射光の時間方向の再投影バッファ
+///
+/// @note
+/// 受光面の投影光源による反射光は受光面上に固定されていて第３者視点の視点には
+/// ほとんどよらないので, 視点を動かしている間は前のフレームまでに混ぜた反射光を
+/// 奥行きと前後のフレームの視点から再投影し, 標本点を替えながら描いた新しい反射光と
+/// 混ぜる. 奥行きや法線ベクトルが合わない画素は隠れていたものとして捨てる.
+///
+class TemporalBuffer
+{
+  // 履歴の画素数
+  GLsizei width, height;
+
+  // 履歴の書き込み先のフレームバッファオブジェクト
+  std::array<GLuint, 2> fbo;
+
+  // 履歴の反射光と法線ベクトルと奥行きのテクスチャ (フレームごとに交互に読み書きする)
+  std::array<std::array<GLuint, 2>, 2> color;
+
+  // 次に書き込む履歴の番号
+  std::size_t current;
+
+  // 前のフレームの履歴を書き込んだときのシーンの視点
+  GgMatrix view;
+
+  // 前のフレームの履歴を書き込んだときのシーンの版数
+  unsigned int revision;
+
+  // 前のフレームの履歴が使えるなら true
+  bool valid;
+
+  // 次のフレームで最初に使う標本点の番号
+  GLsizei offset;
+
+public:
+
+  ///
+  /// コンストラクタ
+  ///
+  TemporalBuffer();
+
+  ///
+  /// コピーコンストラクタは使用しない
+  ///
+  TemporalBuffer(const TemporalBuffer& buffer) = delete;
+
+  ///
+  /// デストラクタ
+  ///
+  virtual ~TemporalBuffer();
+
+  ///
+  /// 代入演算子は使用しない
+  ///
+  TemporalBuffer& operator=(const TemporalBuffer& buffer) = delete;
+
+  ///
+  /// 前のフレームの履歴が使えるか調べる
+  ///
+  /// @param w 履歴の横の画素数
+  /// @param h 履歴の縦の画素数
+  /// @param r シーンの版数
+  /// @return 画素数とシーンの版数が前のフレームと同じなら true, 違えば履歴を捨てて false
+  ///
+  /// @note
+  /// 視点の変化は再投影で補うので履歴を捨てる理由にはしない.
+  ///
+  bool validate(GLsizei w, GLsizei h, unsigned int r);
+
+  ///
+  /// 次のフレームで最初に使う標本点の番号を取り出す
+  ///
+  auto getOffset() const
+  {
+    return offset;
+  }
+
+  ///
+  /// このフレームの視点座標系から前のフレームの視点座標系への変換行列を求める
+  ///
+  /// @param v このフレームのシーンの視点
+  ///
+  GgMatrix getReprojection(const GgMatrix& v) const
+  {
+    return view * v.invert();
+  }
+
+  ///
+  /// 履歴の更新を開始する
+  ///
+  /// @param unit 前のフレームの履歴の反射光のテクスチャを結合するテクスチャユニットの番号
+  ///
+  /// @note
+  /// 前のフレームの反射光と法線ベクトルと奥行きを unit と unit + 1 に結合する.
+  /// この後で再投影して混ぜるシェーダで画面全体を覆う矩形を描き, end() を呼び出す.
+  ///
+  void begin(GLuint unit);
+
+  ///
+  /// 履歴の更新を終了する
+  ///
+  /// @param v このフレームのシーンの視点
+  /// @param samples このフレームで使った標本点数
+  /// @param total 標本点の総数
+  ///
+  void end(const GgMatrix& v, GLsizei samples, GLsizei total);
+
+  ///
+  /// 更新した履歴の反射光と法線ベクトルと奥行きのテクスチャを連続するテクスチャユニットに結合する
+  ///
+  /// @param unit 反射光のテクスチャを結合するテクスチャユニットの番号
+  ///
+  void bind(GLuint unit) const;
+};
@@ -0,0 +1,774 @@
+﻿///
+/// タイル化した高さマップクラスの実装
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 18, 2026
+///
+#include "TiledHeightMap.h"
+
+// 標準ライブラリ
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+// メモリマップ
+#if !defined(_MSC_VER)
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+///
+/// タイル化した高さマップのファイルのヘッダ
+///
+/// @note
+/// ヘッダの後に詳細度 0 から順に, 各詳細度のタイルを行優先で並べる.
+/// 各タイルは境界を含めた (payload + 2 * border) の二乗個の 16bit の画素からなる.
+///
+struct TiledHeader
+{
+  // 識別子
+  char magic[4];
+
+  // 版数
+  std::uint32_t version;
+
+  // 詳細度 0 の画素数
+  std::uint32_t width, height;
+
+  // タイルの有効な画素数
+  std::uint32_t payload;
+
+  // タイルの境界の画素数
+  std::uint32_t border;
+
+  // 詳細度の数
+  std::uint32_t levels;
+
+  // 予約
+  std::uint32_t reserved;
+};
+
+// ファイルの識別子
+constexpr char tiledMagic[4]{ 'M', 'K', 'Y', 'T' };
+
+// ファイルの版数
+constexpr std::uint32_t tiledVersion{ 1 };
+
+// タイルの位置の上限 (キーの x と y はそれぞれ 12bit)
+constexpr GLsizei maxTileIndex{ 4096 };
+
+///
+/// 詳細度ごとの画素数とタイル数を求める
+///
+/// @param width 詳細度 0 の横の画素数
+/// @param height 詳細度 0 の縦の画素数
+/// @param payload タイルの有効な画素数
+/// @param dims 詳細度ごとの画素数の格納先
+/// @param tiles 詳細度ごとのタイル数の格納先
+///
+/// @note
+/// 詳細度 l の画素数は詳細度 0 の画素数を 2^l で割って切り上げたものとし,
+/// タイルが一枚になる詳細度までを作る.
+///
+static void computeLevels(GLsizei width, GLsizei height, GLsizei payload,
+  std::vector<std::array<GLsizei, 2>>& dims, std::vector<std::array<GLsizei, 2>>& tiles)
+{
+  dims.clear();
+  tiles.clear();
+
+  for (std::array<GLsizei, 2> d{ width, height };; d = { (d[0] + 1) / 2, (d[1] + 1) / 2 })
+  {
+    dims.push_back(d);
+    tiles.push_back({ (d[0] + payload - 1) / payload, (d[1] + payload - 1) / payload });
+    if (tiles.back()[0] == 1 && tiles.back()[1] == 1) break;
+  }
+}
+
+///
+/// 2 のべき乗に切り上げる
+///
+static GLsizei ceilPowerOfTwo(GLsizei n)
+{
+  GLsizei p{ 1 };
+  while (p < n) p <<= 1;
+  return p;
+}
+
+//
+// コンストラクタ
+//
+TiledHeightMap::TiledHeightMap(const std::string& name, std::size_t budget) :
+  mapped{ nullptr },
+  mappedSize{ 0 },
+#if defined(_MSC_VER)
+  file{ INVALID_HANDLE_VALUE },
+  mapping{ nullptr },
+#endif
+  size{ 0, 0 },
+  payload{ 0 },
+  border{ 0 },
+  levels{ 0 },
+  atlas{ 0 },
+  slots{ 0, 0 },
+  pages{ 0 },
+  frame{ 1 },
+  running{ false },
+  feedbackBuffer{ 0 },
+  feedbackTexture{ 0 },
+  feedbackDepth{ 0 },
+  feedbackSize{ 0, 0 },
+  feedbackPixels{ 0, 0 },
+  feedbackPending{}
+{
+  //
+  // ファイルをメモリマップする
+  //
+
+#if defined(_MSC_VER)
+  file = CreateFile(Utf8ToTChar(name), GENERIC_READ, FILE_SHARE_READ, nullptr,
+    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) return;
+  LARGE_INTEGER length;
+  if (!GetFileSizeEx(file, &length))
+  {
+    close();
+    return;
+  }
+  mapping = CreateFileMapping(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping)
+  {
+    close();
+    return;
+  }
+  mapped = static_cast<const std::uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+  if (!mapped)
+  {
+    close();
+    return;
+  }
+  mappedSize = static_cast<std::size_t>(length.QuadPart);
+#else
+  const auto fd{ ::open(name.c_str(), O_RDONLY) };
+  if (fd < 0) return;
+  struct stat status;
+  if (fstat(fd, &status) != 0 || status.st_size <= 0)
+  {
+    ::close(fd);
+    return;
+  }
+  const auto memory{ mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_SHARED, fd, 0) };
+  ::close(fd);
+  if (memory == MAP_FAILED) return;
+  mapped = static_cast<const std::uint8_t*>(memory);
+  mappedSize = static_cast<std::size_t>(status.st_size);
+#endif
+
+  //
+  // ヘッダを調べる
+  //
+
+  // ヘッダが無ければ閉じる
+  if (mappedSize < sizeof(TiledHeader))
+  {
+    close();
+    return;
+  }
+
+  // ヘッダの内容を取り出す
+  TiledHeader header;
+  std::memcpy(&header, mapped, sizeof header);
+
+  // 識別子と版数が違っていたら閉じる
+  if (std::memcmp(header.magic, tiledMagic, sizeof tiledMagic) != 0
+    || header.version != tiledVersion)
+  {
+    close();
+    return;
+  }
+
+  // タイルの構成
+  size = { static_cast<GLsizei>(header.width), static_cast<GLsizei>(header.height) };
+  payload = static_cast<GLsizei>(header.payload);
+  border = static_cast<GLsizei>(header.border);
+  if (size[0] <= 0 || size[1] <= 0 || payload <= 0 || border < 2)
+  {
+    close();
+    return;
+  }
+
+  // 詳細度ごとのタイル数を求める
+  std::vector<std::array<GLsizei, 2>> dims;
+  computeLevels(size[0], size[1], payload, dims, tiles);
+  levels = static_cast<GLsizei>(tiles.size());
+  if (header.levels != static_cast<std::uint32_t>(levels)
+    || tiles[0][0] > maxTileIndex || tiles[0][1] > maxTileIndex)
+  {
+    close();
+    return;
+  }
+
+  // 詳細度ごとの最初のタイルの番号を求める
+  std::size_t count{ 0 };
+  for (const auto& t : tiles)
+  {
+    first.push_back(count);
+    count += static_cast<std::size_t>(t[0]) * t[1];
+  }
+
+  // ファイルが短ければ閉じる
+  const auto texels{ static_cast<std::size_t>(payload + border * 2) * (payload + border * 2) };
+  if (mappedSize < sizeof(TiledHeader) + count * texels * sizeof(GLushort))
+  {
+    close();
+    return;
+  }
+
+  //
+  // タイルキャッシュを作成する
+  //
+
+  // タイルの一辺の画素数
+  const auto side{ payload + border * 2 };
+
+  // テクスチャの最大サイズ
+  GLint maxSize;
+  glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+
+  // 一辺のスロット数の上限 (ページテーブルの要素が 8bit なので 255 まで)
+  const auto maxSlots{ std::min(maxSize / side, 255) };
+
+  // ビデオメモリの予算に収まるスロット数 (全部のタイルが入る数以上は作らない)
+  const auto wanted{ std::min(std::max(budget / (texels * sizeof(GLushort)),
+    static_cast<std::size_t>(levels) + 1), count) };
+
+  // スロットの配置
+  slots[0] = std::min(static_cast<GLsizei>(std::ceil(std::sqrt(static_cast<double>(wanted)))), maxSlots);
+  slots[1] = std::min(static_cast<GLsizei>((wanted + slots[0] - 1) / slots[0]), maxSlots);
+  slot.assign(static_cast<std::size_t>(slots[0]) * slots[1], Slot{ 0, 0, false, true });
+
+  // タイルキャッシュのテクスチャを作成する
+  glGenTextures(1, &atlas);
+  glBindTexture(GL_TEXTURE_2D, atlas);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_R16, slots[0] * side, slots[1] * side, 0,
+    GL_RED, GL_UNSIGNED_SHORT, nullptr);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+  //
+  // ページテーブルを作成する
+  //
+
+  // 詳細度 0 のページテーブルのサイズは 2 のべき乗にしてミップマップの大きさを揃える
+  const std::array<GLsizei, 2> base{ ceilPowerOfTwo(tiles[0][0]), ceilPowerOfTwo(tiles[0][1]) };
+
+  // ページテーブルのテクスチャを作成する
+  glGenTextures(1, &pages);
+  glBindTexture(GL_TEXTURE_2D, pages);
+  table.resize(levels);
+  for (GLsizei level = 0; level < levels; ++level)
+  {
+    const auto w{ std::max(base[0] >> level, 1) };
+    const auto h{ std::max(base[1] >> level, 1) };
+    table[level].resize(static_cast<std::size_t>(w) * h);
+    glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8UI, w, h, 0,
+      GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, nullptr);
+  }
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  // 最も粗い詳細度のタイルは常駐させてページテーブルの参照先が必ずあるようにする
+  const auto coarsest{ makeKey(levels - 1, 0, 0) };
+  store(coarsest, getTile(coarsest));
+  slot[resident[coarsest]].pinned = true;
+  updatePageTable();
+
+  //
+  // 読み込みスレッドを開始する
+  //
+
+  running = true;
+  worker = std::thread(&TiledHeightMap::stream, this);
+}
+
+//
+// デストラクタ
+//
+TiledHeightMap::~TiledHeightMap()
+{
+  // 読み込みスレッドを停止する
+  if (worker.joinable())
+  {
+    {
+      std::lock_guard<std::mutex> lock{ mutex };
+      running = false;
+    }
+    condition.notify_all();
+    worker.join();
+  }
+
+  // フィードバックのオブジェクトを削除する
+  glDeleteBuffers(2, feedbackPixels.data());
+  glDeleteRenderbuffers(1, &feedbackDepth);
+  glDeleteTextures(1, &feedbackTexture);
+  glDeleteFramebuffers(1, &feedbackBuffer);
+
+  // ページテーブルとタイルキャッシュを削除する
+  glDeleteTextures(1, &pages);
+  glDeleteTextures(1, &atlas);
+
+  // ファイルを閉じる
+  close();
+}
+
+//
+// ファイルを閉じる
+//
+void TiledHeightMap::close()
+{
+#if defined(_MSC_VER)
+  if (mapped) UnmapViewOfFile(mapped);
+  if (mapping) CloseHandle(mapping);
+  if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+  mapping = nullptr;
+  file = INVALID_HANDLE_VALUE;
+#else
+  if (mapped) munmap(const_cast<std::uint8_t*>(mapped), mappedSize);
+#endif
+  mapped = nullptr;
+  mappedSize = 0;
+}
+
+//
+// タイルのファイル上の画素データを得る
+//
+const GLushort* TiledHeightMap::getTile(Key key) const
+{
+  // キーからタイルの位置を取り出す
+  const auto level{ static_cast<GLsizei>(key >> 24) };
+  const auto y{ static_cast<GLsizei>(key >> 12 & 0xfff) };
+  const auto x{ static_cast<GLsizei>(key & 0xfff) };
+
+  // ファイル上のタイルの番号
+  const auto index{ first[level] + static_cast<std::size_t>(y) * tiles[level][0] + x };
+
+  // タイルの画素数
+  const auto side{ static_cast<std::size_t>(payload + border * 2) };
+
+  return reinterpret_cast<const GLushort*>(mapped + sizeof(TiledHeader))
+    + index * side * side;
+}
+
+//
+// タイルをタイルキャッシュのスロットに読み込む
+//
+bool TiledHeightMap::store(Key key, const GLushort* data)
+{
+  // 空きスロットがあればそれを使う
+  auto it{ std::find_if(slot.begin(), slot.end(), [](const Slot& s) { return s.empty; }) };
+
+  // 空きスロットがなければこのフレームで使っていない最も古いスロットを使う
+  if (it == slot.end())
+  {
+    it = std::min_element(slot.begin(), slot.end(), [](const Slot& a, const Slot& b)
+      { return (a.pinned ? UINT64_MAX : a.used) < (b.pinned ? UINT64_MAX : b.used); });
+    if (it->pinned || it->used >= frame) return false;
+
+    // 追い出すタイルを常駐から外す
+    resident.erase(it->key);
+  }
+
+  // スロットの番号
+  const auto index{ static_cast<GLsizei>(it - slot.begin()) };
+
+  // スロットにタイルを格納する
+  *it = Slot{ key, frame, false, false };
+  resident[key] = index;
+
+  // タイルキャッシュに転送する
+  const auto side{ payload + border * 2 };
+  glBindTexture(GL_TEXTURE_2D, atlas);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, index % slots[0] * side, index / slots[0] * side,
+    side, side, GL_RED, GL_UNSIGNED_SHORT, data);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  return true;
+}
+
+//
+// ページテーブルを更新する
+//
+void TiledHeightMap::updatePageTable()
+{
+  glBindTexture(GL_TEXTURE_2D, pages);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+  // 粗い詳細度から順に, 常駐していないタイルには親のタイルの参照を入れる
+  for (GLsizei level = levels - 1; level >= 0; --level)
+  {
+    const auto w{ std::max(ceilPowerOfTwo(tiles[0][0]) >> level, 1) };
+    const auto h{ std::max(ceilPowerOfTwo(tiles[0][1]) >> level, 1) };
+
+    for (GLsizei y = 0; y < h; ++y)
+    {
+      for (GLsizei x = 0; x < w; ++x)
+      {
+        auto& entry{ table[level][static_cast<std::size_t>(y) * w + x] };
+
+        // このタイルが常駐していればそのスロットを参照する
+        if (x < tiles[level][0] && y < tiles[level][1])
+        {
+          const auto found{ resident.find(makeKey(level, x, y)) };
+          if (found != resident.end())
+          {
+            entry =
+            {
+              static_cast<GLubyte>(found->second % slots[0]),
+              static_cast<GLubyte>(found->second / slots[0]),
+              static_cast<GLubyte>(level),
+              0
+            };
+            continue;
+          }
+        }
+
+        // 最も粗い詳細度で範囲外なら唯一のタイルを参照する
+        if (level == levels - 1)
+        {
+          const auto index{ resident.at(makeKey(level, 0, 0)) };
+          entry = { static_cast<GLubyte>(index % slots[0]), static_cast<GLubyte>(index / slots[0]),
+            static_cast<GLubyte>(level), 0 };
+          continue;
+        }
+
+        // 親のタイルの参照を使う
+        const auto pw{ std::max(w >> 1, 1) };
+        entry = table[level + 1][static_cast<std::size_t>(y >> 1) * pw + (x >> 1)];
+      }
+    }
+
+    glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, w, h,
+      GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, table[level].data());
+  }
+
+  glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+//
+// 読み込みスレッド
+//
+void TiledHeightMap::stream()
+{
+  // タイルの画素数
+  const auto texels{ static_cast<std::size_t>(payload + border * 2) * (payload + border * 2) };
+
+  std::unique_lock<std::mutex> lock{ mutex };
+
+  for (;;)
+  {
+    // 読み込むタイルが要求されるまで待つ
+    condition.wait(lock, [this] { return !running || !queue.empty(); });
+    if (!running) break;
+
+    // 読み込むタイルを取り出す
+    const auto key{ queue.front() };
+    queue.pop_front();
+
+    // メモリマップしたファイルからタイルを読み出す (ここでページフォルトが起こる)
+    lock.unlock();
+    const auto* const tile{ getTile(key) };
+    std::vector<GLushort> data(tile, tile + texels);
+    lock.lock();
+
+    // 読み込みが完了したタイルに加える
+    loaded.emplace_back(key, std::move(data));
+  }
+}
+
+//
+// 高さマップからタイル化した高さマップのファイルを作成する
+//
+bool TiledHeightMap::build(const HeightMap& source, const std::string& name,
+  GLsizei payload, GLsizei border)
+{
+  // 高さマップが無ければ戻る
+  if (!source || payload <= 0 || border < 2) return false;
+
+  // 詳細度ごとの画素数とタイル数を求める
+  std::vector<std::array<GLsizei, 2>> dims, tiles;
+  computeLevels(source.getWidth(), source.getHeight(), payload, dims, tiles);
+  if (tiles[0][0] > maxTileIndex || tiles[0][1] > maxTileIndex) return false;
+
+  // 詳細度 1 以降の画素を 2×2 画素の平均で作る
+  std::vector<std::vector<GLushort>> pyramid(dims.size());
+  std::vector<const GLushort*> level{ source.get().data() };
+  for (std::size_t l = 1; l < dims.size(); ++l)
+  {
+    const auto& [sw, sh]{ dims[l - 1] };
+    const auto& [w, h]{ dims[l] };
+    const auto* const src{ level.back() };
+    auto& dst{ pyramid[l] };
+    dst.resize(static_cast<std::size_t>(w) * h);
+
+    for (GLsizei y = 0; y < h; ++y)
+    {
+      const auto y0{ static_cast<std::size_t>(y * 2) * sw };
+      const auto y1{ static_cast<std::size_t>(std::min(y * 2 + 1, sh - 1)) * sw };
+      for (GLsizei x = 0; x < w; ++x)
+      {
+        const auto x0{ x * 2 };
+        const auto x1{ std::min(x * 2 + 1, sw - 1) };
+        dst[static_cast<std::size_t>(y) * w + x] = static_cast<GLushort>
+          ((src[y0 + x0] + src[y0 + x1] + src[y1 + x0] + src[y1 + x1] + 2u) / 4u);
+      }
+    }
+
+    level.push_back(dst.data());
+  }
+
+  // ファイルを開く
+  std::ofstream file{ Utf8ToTChar(name), std::ios::binary };
+  if (!file) return false;
+
+  // ヘッダを書き出す
+  TiledHeader header{};
+  std::memcpy(header.magic, tiledMagic, sizeof tiledMagic);
+  header.version = tiledVersion;
+  header.width = static_cast<std::uint32_t>(source.getWidth());
+  header.height = static_cast<std::uint32_t>(source.getHeight());
+  header.payload = static_cast<std::uint32_t>(payload);
+  header.border = static_cast<std::uint32_t>(border);
+  header.levels = static_cast<std::uint32_t>(dims.size());
+  file.write(reinterpret_cast<const char*>(&header), sizeof header);
+
+  // タイルを書き出す (範囲外の画素は端の画素を繰り返す)
+  const auto side{ payload + border * 2 };
+  std::vector<GLushort> tile(static_cast<std::size_t>(side) * side);
+  for (std::size_t l = 0; l < dims.size(); ++l)
+  {
+    const auto& [w, h]{ dims[l] };
+    for (GLsizei ty = 0; ty < tiles[l][1]; ++ty)
+    {
+      for (GLsizei tx = 0; tx < tiles[l][0]; ++tx)
+      {
+        for (GLsizei j = 0; j < side; ++j)
+        {
+          const auto y{ std::clamp(ty * payload + j - border, 0, h - 1) };
+          for (GLsizei i = 0; i < side; ++i)
+          {
+            const auto x{ std::clamp(tx * payload + i - border, 0, w - 1) };
+            tile[static_cast<std::size_t>(j) * side + i] = level[l][static_cast<std::size_t>(y) * w + x];
+          }
+        }
+        file.write(reinterpret_cast<const char*>(tile.data()), tile.size() * sizeof(GLushort));
+      }
+    }
+  }
+
+  return static_cast<bool>(file);
+}
+
+//
+// 高さマップのテクスチャ座標のタイルを要求する
+//
+void TiledHeightMap::request(GLfloat u, GLfloat v, GLsizei level)
+{
+  level = std::clamp(level, 0, levels - 1);
+
+  // 詳細度 level の画素位置
+  const auto scale{ std::ldexp(1.0f, -level) / payload };
+  const auto x{ static_cast<GLsizei>(std::clamp(u, 0.0f, 1.0f) * size[0] * scale) };
+  const auto y{ static_cast<GLsizei>(std::clamp(v, 0.0f, 1.0f) * size[1] * scale) };
+
+  // タイルを要求する
+  requested.insert(makeKey(level, std::min(x, tiles[level][0] - 1), std::min(y, tiles[level][1] - 1)));
+}
+
+//
+// フィードバックパスを開始する
+//
+void TiledHeightMap::beginFeedback(GLsizei width, GLsizei height)
+{
+  // フィードバックは縮小したフレームバッファに描く
+  const std::array<GLsizei, 2> reduced
+  {
+    std::max(width / feedbackReduction, 1),
+    std::max(height / feedbackReduction, 1)
+  };
+
+  // フィードバックのフレームバッファオブジェクトを作成する
+  if (feedbackBuffer == 0)
+  {
+    glGenFramebuffers(1, &feedbackBuffer);
+    glGenTextures(1, &feedbackTexture);
+    glGenRenderbuffers(1, &feedbackDepth);
+    glGenBuffers(2, feedbackPixels.data());
+  }
+
+  // サイズが変わっていたらカラーバッファとデプスバッファを作り直す
+  if (reduced != feedbackSize)
+  {
+    feedbackSize = reduced;
+
+    glBindTexture(GL_TEXTURE_2D, feedbackTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16UI, reduced[0], reduced[1], 0,
+      GL_RGBA_INTEGER, GL_UNSIGNED_SHORT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glBindRenderbuffer(GL_RENDERBUFFER, feedbackDepth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, reduced[0], reduced[1]);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, feedbackBuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, feedbackTexture, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, feedbackDepth);
+  }
+
+  // フィードバックのフレームバッファに切り替えて消去する
+  static constexpr GLuint zero[4]{ 0, 0, 0, 0 };
+  glBindFramebuffer(GL_FRAMEBUFFER, feedbackBuffer);
+  glViewport(0, 0, feedbackSize[0], feedbackSize[1]);
+  glClearBufferuiv(GL_COLOR, 0, zero);
+  glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+//
+// フィードバックパスを終了する
+//
+void TiledHeightMap::endFeedback()
+{
+  // このフレームのフィードバックをピクセルバッファオブジェクトに読み出す
+  const auto current{ static_cast<std::size_t>(frame & 1) };
+  const auto bytes{ static_cast<GLsizeiptr>(feedbackSize[0]) * feedbackSize[1] * sizeof(std::array<GLushort, 4>) };
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, feedbackPixels[current]);
+  glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+  glReadPixels(0, 0, feedbackSize[0], feedbackSize[1], GL_RGBA_INTEGER, GL_UNSIGNED_SHORT, nullptr);
+  feedbackPending[current] = feedbackSize;
+
+  // ひとつ前のフレームのフィードバックを取り出す
+  const auto previous{ current ^ 1 };
+  const auto& [w, h]{ feedbackPending[previous] };
+  if (w > 0 && h > 0)
+  {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, feedbackPixels[previous]);
+    const auto* const texel{ static_cast<const std::array<GLushort, 4>*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+      static_cast<GLsizeiptr>(w) * h * sizeof(std::array<GLushort, 4>), GL_MAP_READ_BIT)) };
+
+    if (texel)
+    {
+      // 鏡が描かれた画素のタイルを要求する
+      for (GLsizei i = 0; i < w * h; ++i)
+      {
+        const auto& [x, y, level, valid]{ texel[i] };
+        if (valid == 0 || level >= levels || x >= tiles[level][0] || y >= tiles[level][1]) continue;
+        requested.insert(makeKey(level, x, y));
+      }
+      glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+
+    feedbackPending[previous] = { 0, 0 };
+  }
+
+  // 通常のフレームバッファに戻す
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+//
+// タイルの読み込みとページテーブルの更新を行う
+//
+void TiledHeightMap::update(int uploads)
+{
+  // 要求されたタイルの祖先も要求する
+  std::vector<Key> wanted(requested.begin(), requested.end());
+  for (auto key : wanted)
+  {
+    for (auto level{ static_cast<GLsizei>(key >> 24) + 1 }; level < levels; ++level)
+    {
+      key = makeKey(level, (key & 0xfff) >> 1, (key >> 12 & 0xfff) >> 1);
+      if (!requested.insert(key).second) break;
+    }
+  }
+
+  // 常駐しているタイルはこのフレームで使ったことにし, 常駐していないタイルを集める
+  std::vector<Key> missing;
+  for (const auto key : requested)
+  {
+    const auto found{ resident.find(key) };
+    if (found != resident.end())
+      slot[found->second].used = frame;
+    else if (pending.count(key) == 0)
+      missing.push_back(key);
+  }
+
+  // 粗い詳細度のタイルから読み込む
+  std::sort(missing.begin(), missing.end(), [](Key a, Key b) { return (a >> 24) > (b >> 24); });
+
+  // このフレームで使っていないスロットの数だけ読み込む
+  const auto available{ std::count_if(slot.begin(), slot.end(), [this](const Slot& s)
+    { return s.empty || (!s.pinned && s.used < frame); }) };
+
+  // 完了したタイル
+  std::vector<std::pair<Key, std::vector<GLushort>>> done;
+
+  {
+    std::lock_guard<std::mutex> lock{ mutex };
+
+    // もう要求されていないタイルの読み込みは取り消す
+    for (auto it = queue.begin(); it != queue.end();)
+    {
+      if (requested.count(*it) == 0)
+      {
+        pending.erase(*it);
+        it = queue.erase(it);
+      }
+      else
+      {
+        ++it;
+      }
+    }
+
+    // 読み込むタイルを追加する
+    for (const auto key : missing)
+    {
+      if (static_cast<std::ptrdiff_t>(pending.size()) >= available) break;
+      queue.push_back(key);
+      pending.insert(key);
+    }
+
+    // 読み込みが完了したタイルを取り出す
+    const auto n{ std::min(loaded.size(), static_cast<std::size_t>(std::max(uploads, 0))) };
+    std::move(loaded.begin(), loaded.begin() + n, std::back_inserter(done));
+    loaded.erase(loaded.begin(), loaded.begin() + n);
+
+    // 読み込みスレッドに通知する
+    if (!queue.empty()) condition.notify_one();
+  }
+
+  // 完了したタイルをタイルキャッシュに格納する
+  bool changed{ false };
+  for (const auto& [key, data] : done)
+  {
+    pending.erase(key);
+    if (store(key, data.data())) changed = true;
+  }
+
+  // ページテーブルを更新する
+  if (changed) updatePageTable();
+
+  // 次のフレームに進む
+  requested.clear();
+  ++frame;
+}
@@ -0,0 +1,330 @@
+﻿#pragma once
+
+///
+/// タイル化した高さマップクラスの定義
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 18, 2026
+///
+
+// 高さマップ
+#include "HeightMap.h"
+
+// 標準ライブラリ
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+///
+/// タイル化した高さマップ
+///
+/// @note
+/// 一枚のテクスチャに収まらない高さマップを, 境界の画素を付けた 16bit のタイルの
+/// ミップマップピラミッドとしてファイルに保存しておき, それをメモリマップして
+/// 必要なタイルだけをタイルキャッシュ (アトラス) テクスチャに読み込む.
+/// シェーダはページテーブルのテクスチャを使ってアトラス上のタイルの位置を求める.
+/// ページテーブルの各要素はタイルのアトラス上のスロットと実際に常駐している詳細度を持ち,
+/// タイルが常駐していなければ常駐している最も近い祖先のタイルを指す.
+///
+class TiledHeightMap
+{
+  // タイルのキー (詳細度 << 24 | y << 12 | x)
+  using Key = std::uint32_t;
+
+  // メモリマップしたファイル
+  const std::uint8_t* mapped;
+
+  // メモリマップしたファイルのサイズ
+  std::size_t mappedSize;
+
+#if defined(_MSC_VER)
+  // メモリマップしたファイルのハンドル
+  void* file;
+
+  // ファイルマッピングオブジェクトのハンドル
+  void* mapping;
+#endif
+
+  // 詳細度 0 の高さマップの画素数
+  std::array<GLsizei, 2> size;
+
+  // タイルの有効な画素数
+  GLsizei payload;
+
+  // タイルの境界の画素数
+  GLsizei border;
+
+  // 詳細度の数
+  GLsizei levels;
+
+  // 詳細度ごとのタイル数
+  std::vector<std::array<GLsizei, 2>> tiles;
+
+  // 詳細度ごとの最初のタイルの番号
+  std::vector<std::size_t> first;
+
+  // タイルキャッシュのテクスチャ
+  GLuint atlas;
+
+  // タイルキャッシュのスロット数
+  std::array<GLsizei, 2> slots;
+
+  // スロットに格納されているタイル
+  struct Slot
+  {
+    // 格納しているタイルのキー
+    Key key;
+
+    // 最後に使われたフレーム
+    std::uint64_t used;
+
+    // 常駐させるなら true
+    bool pinned;
+
+    // 空きスロットなら true
+    bool empty;
+  };
+
+  // タイルキャッシュのスロット
+  std::vector<Slot> slot;
+
+  // 常駐しているタイルのスロット番号
+  std::unordered_map<Key, GLsizei> resident;
+
+  // ページテーブルのテクスチャ
+  GLuint pages;
+
+  // 詳細度ごとのページテーブル (スロットの x, y, 常駐している詳細度, 未使用)
+  std::vector<std::vector<std::array<GLubyte, 4>>> table;
+
+  // 現在のフレーム
+  std::uint64_t frame;
+
+  // このフレームで要求されたタイル
+  std::unordered_set<Key> requested;
+
+  // 読み込みを待っているタイル
+  std::deque<Key> queue;
+
+  // 読み込み中か読み込み済みのタイル
+  std::unordered_set<Key> pending;
+
+  // 読み込みが完了したタイル
+  std::vector<std::pair<Key, std::vector<GLushort>>> loaded;
+
+  // 読み込みスレッドとの排他制御
+  std::mutex mutex;
+
+  // 読み込みスレッドへの通知
+  std::condition_variable condition;
+
+  // 読み込みスレッドを実行中なら true
+  bool running;
+
+  // 読み込みスレッド
+  std::thread worker;
+
+  // フィードバックのフレームバッファオブジェクト
+  GLuint feedbackBuffer;
+
+  // フィードバックのカラーバッファ
+  GLuint feedbackTexture;
+
+  // フィードバックのデプスバッファ
+  GLuint feedbackDepth;
+
+  // フィードバックのサイズ
+  std::array<GLsizei, 2> feedbackSize;
+
+  // フィードバックを読み出すピクセルバッファオブジェクト
+  std::array<GLuint, 2> feedbackPixels;
+
+  // 読み出しを開始したピクセルバッファオブジェクトのフィードバックのサイズ
+  std::array<std::array<GLsizei, 2>, 2> feedbackPending;
+
+  // フィードバックの縮小率
+  static constexpr GLsizei feedbackReduction{ 8 };
+
+  // タイルのキーを作る
+  static Key makeKey(GLsizei level, GLsizei x, GLsizei y)
+  {
+    return static_cast<Key>(level) << 24 | static_cast<Key>(y) << 12 | static_cast<Key>(x);
+  }
+
+  // タイルのファイル上の画素データを得る
+  const GLushort* getTile(Key key) const;
+
+  // タイルをタイルキャッシュのスロットに読み込む
+  bool store(Key key, const GLushort* data);
+
+  // ページテーブルを更新する
+  void updatePageTable();
+
+  // 読み込みスレッド
+  void stream();
+
+  // ファイルを閉じる
+  void close();
+
+public:
+
+  ///
+  /// コンストラクタ
+  ///
+  /// @param name タイル化した高さマップのファイル名
+  /// @param budget タイルキャッシュに使うビデオメモリのバイト数
+  ///
+  TiledHeightMap(const std::string& name, std::size_t budget);
+
+  ///
+  /// デストラクタ
+  ///
+  virtual ~TiledHeightMap();
+
+  ///
+  /// コピーコンストラクタは使用しない
+  ///
+  TiledHeightMap(const TiledHeightMap&) = delete;
+
+  ///
+  /// 代入演算子は使用しない
+  ///
+  TiledHeightMap& operator=(const TiledHeightMap&) = delete;
+
+  ///
+  /// タイル化した高さマップが有効かどうか調べる
+  ///
+  /// @return タイル化した高さマップが使用可能なら true
+  ///
+  explicit operator bool() const noexcept
+  {
+    return atlas != 0;
+  }
+
+  ///
+  /// 高さマップからタイル化した高さマップのファイルを作成する
+  ///
+  /// @param source 高さマップ
+  /// @param name 作成するファイル名
+  /// @param payload タイルの有効な画素数
+  /// @param border タイルの境界の画素数
+  /// @return ファイルの作成に成功したら true
+  ///
+  static bool build(const HeightMap& source, const std::string& name,
+    GLsizei payload = 124, GLsizei border = 2);
+
+  ///
+  /// 高さマップのテクスチャ座標のタイルを要求する
+  ///
+  /// @param u テクスチャ座標の s
+  /// @param v テクスチャ座標の t
+  /// @param level 要求する詳細度
+  ///
+  void request(GLfloat u, GLfloat v, GLsizei level = 0);
+
+  ///
+  /// フィードバックパスを開始する
+  ///
+  /// @param width フレームバッファの横の画素数
+  /// @param height フレームバッファの縦の画素数
+  ///
+  /// @note
+  /// 縮小したフィードバック用のフレームバッファに切り替えるので,
+  /// endFeedback() の後にビューポートを元に戻す必要がある.
+  ///
+  void beginFeedback(GLsizei width, GLsizei height);
+
+  ///
+  /// フィードバックパスを終了する
+  ///
+  /// @note
+  /// ひとつ前のフレームのフィードバックを読み出してタイルを要求する.
+  ///
+  void endFeedback();
+
+  ///
+  /// タイルの読み込みとページテーブルの更新を行う
+  ///
+  /// @param uploads 1 フレームでタイルキャッシュに転送するタイル数の上限
+  ///
+  void update(int uploads = 16);
+
+  ///
+  /// タイルキャッシュのテクスチャを得る
+  ///
+  auto getAtlas() const
+  {
+    return atlas;
+  }
+
+  ///
+  /// ページテーブルのテクスチャを得る
+  ///
+  auto getPageTable() const
+  {
+    return pages;
+  }
+
+  ///
+  /// シェーダに渡すタイルの構成を得る
+  ///
+  /// @return 詳細度 0 の横と縦の画素数, タイルの有効な画素数, 境界の画素数
+  ///
+  std::array<GLfloat, 4> getTiling() const
+  {
+    return
+    {
+      static_cast<GLfloat>(size[0]),
+      static_cast<GLfloat>(size[1]),
+      static_cast<GLfloat>(payload),
+      static_cast<GLfloat>(border)
+    };
+  }
+
+  ///
+  /// 詳細度の数を得る
+  ///
+  auto getLevels() const
+  {
+    return levels;
+  }
+
+  ///
+  /// フィードバックパスで詳細度に加えるバイアスを得る
+  ///
+  static GLfloat getFeedbackBias()
+  {
+    return -std::log2(static_cast<GLfloat>(feedbackReduction));
+  }
+
+  ///
+  /// 常駐しているタイル数を得る
+  ///
+  auto getResidentCount() const
+  {
+    return static_cast<GLsizei>(resident.size());
+  }
+
+  ///
+  /// 読み込み中か転送を待っているタイルがあるかどうかを調べる
+  ///
+  /// @return 読み込みが終わっていないタイルがあれば true
+  ///
+  bool isLoading() const
+  {
+    return !pending.empty();
+  }
+
+  ///
+  /// タイルキャッシュのスロット数を得る
+  ///
+  auto getSlotCount() const
+  {
+    return static_cast<GLsizei>(slot.size());
+  }
+};
@@ -0,0 +1,130 @@
+﻿#pragma once
+
+///
+/// スレッド間でデータを受け渡す三重バッファクラスの定義
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 18, 2026
+///
+
+// 標準ライブラリ
+#include <array>
+#include <atomic>
+
+///
+/// スレッド間でデータを受け渡す三重バッファ
+///
+/// @note
+/// ひとつのスレッドが書き込み, 別のひとつのスレッドが読み出す. 書き込み側は書き終えたバッファを受け渡し用のバッファと,
+/// 読み出し側は受け渡し用のバッファに新しいデータがあればそれを読み出し用のバッファと交換する.
+/// 交換はバッファの番号を atomic に入れ替えるだけなので, どちらのスレッドも相手を待たない.
+/// 読み出し側が取り出す前に書き込み側が次のデータを渡すと, 取り出されなかったバッファが書き込み側に戻る.
+///
+template <typename T>
+class TripleBuffer
+{
+  // 受け渡し用のバッファの番号に付ける, 書き込んでからまだ読み出していないことを表すビット
+  static constexpr unsigned int fresh{ 4 };
+
+  // バッファ
+  std::array<T, 3> buffers;
+
+  // 書き込み用のバッファの番号
+  unsigned int back;
+
+  // 受け渡し用のバッファの番号
+  std::atomic<unsigned int> middle;
+
+  // 読み出し用のバッファの番号
+  unsigned int front;
+
+public:
+
+  ///
+  /// コンストラクタ
+  ///
+  TripleBuffer() :
+    buffers{},
+    back{ 0 },
+    middle{ 1 },
+    front{ 2 }
+  {
+  }
+
+  ///
+  /// コピーコンストラクタは使用しない
+  ///
+  TripleBuffer(const TripleBuffer& buffer) = delete;
+
+  ///
+  /// デストラクタ
+  ///
+  virtual ~TripleBuffer() = default;
+
+  ///
+  /// 代入演算子は使用しない
+  ///
+  TripleBuffer& operator=(const TripleBuffer& buffer) = delete;
+
+  ///
+  /// 書き込み用のバッファを取り出す
+  ///
+  /// @note
+  /// 書き込み側のスレッドだけが使う.
+  ///
+  T& getBack()
+  {
+    return buffers[back];
+  }
+
+  ///
+  /// 書き込んだバッファを読み出し側に渡す
+  ///
+  /// @return 前に渡したデータが読み出されていなければ true
+  ///
+  /// @note
+  /// true を返したときは読み出されなかったデータを書いたバッファが次の書き込み用のバッファになる.
+  ///
+  bool publish()
+  {
+    const auto previous{ middle.exchange(back | fresh, std::memory_order_acq_rel) };
+    back = previous & ~fresh;
+    return (previous & fresh) != 0;
+  }
+
+  ///
+  /// まだ読み出していないデータがあるかどうか
+  ///
+  /// @note
+  /// 読み出し側のスレッドだけが使う.
+  ///
+  bool isFresh() const
+  {
+    return (middle.load(std::memory_order_acquire) & fresh) != 0;
+  }
+
+  ///
+  /// まだ読み出していないデータがあれば読み出し用のバッファにする
+  ///
+  /// @return 新しいデータを読み出し用のバッファにしたら true, 無ければ false で読み出し用のバッファはそのまま
+  ///
+  bool acquire()
+  {
+    // 新しいデータを書き込み側が戻すことはないので, 見つけてから交換するまでに無くなることはない
+    if (!isFresh()) return false;
+    front = middle.exchange(front, std::memory_order_acq_rel) & ~fresh;
+    return true;
+  }
+
+  ///
+  /// 読み出し用のバッファを取り出す
+  ///
+  /// @note
+  /// 読み出し側のスレッドだけが使う.
+  ///
+  T& getFront()
+  {
+    return buffers[front];
+  }
+};
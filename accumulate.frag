@@ -0,0 +1,18 @@
+#version 410 core
+
+//
+// accumulate.frag
+//
+//   描画したフレームを画素単位に蓄積バッファに写すシェーダ
+//
+
+// テクスチャ
+uniform sampler2D image;                              // 描画したフレーム
+
+// フレームバッファに出力するデータ
+layout (location = 0) out vec4 fc;                    // フラグメントの色
+
+void main(void)
+{
+  fc = texelFetch(image, ivec2(gl_FragCoord.xy), 0);
+}
@@ -0,0 +1,40 @@
+#version 410 core
+
+//
+// feedback.frag
+//
+//   鏡の描画に必要な高さマップのタイルを書き出すシェーダ
+//
+
+// 高さマップのタイル
+uniform vec4 tiling;                                  // 詳細度 0 の画素数, タイルの有効画素数, 境界の画素数
+uniform int levels;                                   // 高さマップの詳細度の数
+uniform float bias;                                   // フィードバックの縮小率に合わせた詳細度のバイアス
+
+// ラスタライザから受け取る頂点属性の補間値
+in vec2 tc;                                           // テクスチャ座標
+
+// フレームバッファに出力するデータ
+layout (location = 0) out uvec4 fc;                   // タイルの位置, 詳細度, 有効なら 1
+
+void main(void)
+{
+  // 縮小したフレームバッファの画素間隔から元のフレームバッファでの詳細度を求める
+  vec2 texel = tc * tiling.xy;
+  float footprint = max(max(length(dFdx(texel)), length(dFdy(texel))), 1.0);
+  int level = clamp(int(max(log2(footprint) + bias, 0.0)), 0, levels - 1);
+
+  // テクスチャ座標を[-1, 1]に変換
+  vec2 radius = tc * vec2(2.0, -2.0) - vec2(1.0, -1.0);
+
+  // 円形の鏡の範囲外は捨てる
+  if (dot(radius, radius) > 1.0) discard;
+
+  // 詳細度 level のタイルの位置
+  float s = exp2(float(level));
+  vec2 t = clamp(tc, 0.0, 1.0) * tiling.xy / s;
+  uvec2 tile = uvec2(min(t / tiling.z, ceil(tiling.xy / (s * tiling.z)) - 1.0));
+
+  // 要求するタイルを出力する
+  fc = uvec4(tile, level, 1);
+}
@@ -41,6 +41,18 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <sstream>
 #include <limits>
 #include <map>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <exception>
+
+// SIMD 命令
+#if defined(GG_USE_SSE)
+#  include <immintrin.h>
+#elif defined(GG_USE_NEON)
+#  include <arm_neon.h>
+#endif
 
 /// @def Alias OBJ ファイルからテクスチャ座標も読み込むなら 1.
 #define READ_TEXTURE_COORDINATE_FROM_OBJ 0
@@ -1348,6 +1360,43 @@ PFNGLWINDOWRECTANGLESEXTPROC glWindowRectanglesEXT;
 /// 使用している GPU のバッファアライメント.
 GLint gg::ggBufferAlignment(0);
 
+//
+// OpenGL のデバッグ出力
+//
+//   コールバック関数はドライバのスレッドから呼ばれることがあるので排他制御して保持する
+//
+
+// 保持するメッセージの数
+static constexpr std::size_t debugCapacity{ 256 };
+
+// 受け取ったメッセージ (古いものから順)
+static std::deque<gg::GgDebugMessage> debugMessages;
+
+// 受け取ったメッセージの排他制御
+static std::mutex debugMutex;
+
+// デバッグ出力を受け取っていれば true
+static bool debugOutput{ false };
+
+#if !defined(GL3_PROTOTYPES) && !defined(GL_GLES_PROTOTYPES)
+// デバッグ出力のコールバック関数
+static void APIENTRY debugMessageCallback(GLenum source, GLenum type, GLuint id, GLenum severity,
+  GLsizei length, const GLchar* message, const void* userParam)
+{
+  const std::string text{ message, length >= 0 ? static_cast<std::size_t>(length) : std::char_traits<char>::length(message) };
+
+#  if defined(DEBUG)
+  // デバッグビルドではエラーを標準エラー出力にも出力する
+  if (type == GL_DEBUG_TYPE_ERROR) std::cerr << "OpenGL error: " << text << std::endl;
+#  endif
+
+  // 保持する数を超えたら古いものから捨てる
+  std::lock_guard<std::mutex> lock{ debugMutex };
+  debugMessages.push_back(gg::GgDebugMessage{ source, type, id, severity, text });
+  while (debugMessages.size() > debugCapacity) debugMessages.pop_front();
+}
+#endif
+
 //
 // ゲームグラフィックス特論の都合にもとづく初期化
 //
@@ -2597,6 +2646,279 @@ void gg::ggInit()
 
   // 使用している GPU のバッファアライメントを調べる
   glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &ggBufferAlignment);
+
+#if !defined(GL3_PROTOTYPES) && !defined(GL_GLES_PROTOTYPES)
+  // KHR_debug が使えればデバッグ出力のコールバック関数を登録する
+  if (glDebugMessageCallback && glDebugMessageControl)
+  {
+    glDebugMessageCallback(debugMessageCallback, nullptr);
+    glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_TRUE);
+    glEnable(GL_DEBUG_OUTPUT);
+    debugOutput = glGetError() == GL_NO_ERROR;
+  }
+#endif
+}
+
+//
+// OpenGL のデバッグ出力を受け取っているかどうか調べる
+//
+bool gg::ggDebugOutput()
+{
+  return debugOutput;
+}
+
+//
+// OpenGL のデバッグ出力で受け取ったメッセージを取り出す
+//
+std::vector<gg::GgDebugMessage> gg::ggGetDebugMessages()
+{
+  std::lock_guard<std::mutex> lock{ debugMutex };
+  return std::vector<GgDebugMessage>(debugMessages.begin(), debugMessages.end());
+}
+
+//
+// OpenGL のデバッグ出力で受け取ったメッセージを消去する
+//
+void gg::ggClearDebugMessages()
+{
+  std::lock_guard<std::mutex> lock{ debugMutex };
+  debugMessages.clear();
+}
+
+/// @cond
+
+//
+// ggParallelFor() が使うワークスティーリングのスレッドプール
+//
+//   仕事の区間を参加者 (ワーカースレッドと呼び出したスレッド) に均等に割り振り,
+//   自分の区間を使い切った参加者は他の参加者の区間の残りの後ろ半分を盗む.
+//
+namespace
+{
+  // このスレッドがスレッドプールの仕事を処理している最中なら true
+  thread_local bool inPool{ false };
+
+  class ThreadPool
+  {
+    // 参加者ごとの未処理の仕事の番号の区間 [next, last)
+    struct Slot
+    {
+      std::mutex mutex;
+      std::size_t next{ 0 }, last{ 0 };
+    };
+
+    // ワーカースレッド
+    std::vector<std::thread> workers;
+
+    // 参加者ごとの未処理の仕事 (最後の要素は呼び出したスレッドのもの)
+    std::vector<Slot> slots;
+
+    // 同時に一つの ggParallelFor() だけがプールを使う
+    std::mutex busy;
+
+    // 仕事の受け渡しの排他制御と条件変数
+    std::mutex mutex;
+    std::condition_variable wake, done;
+
+    // 実行中の仕事の処理と区間と一つの仕事の大きさ
+    const std::function<void(std::size_t, std::size_t)>* body{ nullptr };
+    std::size_t begin{ 0 }, end{ 0 }, grain{ 1 };
+
+    // 仕事を配るたびに進む番号
+    std::size_t generation{ 0 };
+
+    // 仕事を終えていないワーカースレッドの数
+    std::size_t running{ 0 };
+
+    // 最初に発生した例外
+    std::exception_ptr error;
+
+    // ワーカースレッドを終了するなら true
+    bool quit{ false };
+
+    // 自分の区間の先頭から仕事を取り出す
+    bool pop(std::size_t self, std::size_t& chunk)
+    {
+      auto& slot{ slots[self] };
+      std::lock_guard<std::mutex> lock{ slot.mutex };
+      if (slot.next >= slot.last) return false;
+      chunk = slot.next++;
+      return true;
+    }
+
+    // 他の参加者の区間の残りの後ろ半分を盗む
+    bool steal(std::size_t self, std::size_t& chunk)
+    {
+      const auto n{ slots.size() };
+      for (std::size_t k = 1; k < n; ++k)
+      {
+        // 盗む相手の区間を縮める
+        auto& victim{ slots[(self + k) % n] };
+        std::size_t first, last;
+        {
+          std::lock_guard<std::mutex> lock{ victim.mutex };
+          if (victim.next >= victim.last) continue;
+          last = victim.last;
+          first = last - (last - victim.next + 1) / 2;
+          victim.last = first;
+        }
+
+        // 盗んだ区間の先頭を処理して残りを自分の区間にする
+        auto& slot{ slots[self] };
+        std::lock_guard<std::mutex> lock{ slot.mutex };
+        slot.next = first + 1;
+        slot.last = last;
+        chunk = first;
+        return true;
+      }
+      return false;
+    }
+
+    // 仕事が無くなるまで処理する
+    void run(std::size_t self)
+    {
+      // 処理の中から ggParallelFor() が呼ばれてもプールを使わないようにする
+      inPool = true;
+      std::size_t chunk;
+      while (pop(self, chunk) || steal(self, chunk))
+      {
+        const auto first{ begin + chunk * grain };
+        const auto last{ std::min(first + grain, end) };
+        try
+        {
+          (*body)(first, last);
+        }
+        catch (...)
+        {
+          std::lock_guard<std::mutex> lock{ mutex };
+          if (!error) error = std::current_exception();
+        }
+      }
+      inPool = false;
+    }
+
+    // ワーカースレッド
+    void work(std::size_t self)
+    {
+      for (std::size_t seen{ 0 };;)
+      {
+        // 新しい仕事が配られるのを待つ
+        {
+          std::unique_lock<std::mutex> lock{ mutex };
+          wake.wait(lock, [&] { return quit || generation != seen; });
+          if (quit) return;
+          seen = generation;
+        }
+
+        run(self);
+
+        // すべてのワーカースレッドが終わったら呼び出したスレッドに知らせる
+        std::lock_guard<std::mutex> lock{ mutex };
+        if (--running == 0) done.notify_one();
+      }
+    }
+
+  public:
+
+    // コンストラクタ
+    ThreadPool() :
+      slots(std::max(std::thread::hardware_concurrency(), 1u))
+    {
+      for (std::size_t i = 0; i + 1 < slots.size(); ++i) workers.emplace_back(&ThreadPool::work, this, i);
+    }
+
+    // デストラクタ
+    ~ThreadPool()
+    {
+      {
+        std::lock_guard<std::mutex> lock{ mutex };
+        quit = true;
+      }
+      wake.notify_all();
+      for (auto& worker : workers) worker.join();
+    }
+
+    // 参加者の数
+    auto size() const
+    {
+      return slots.size();
+    }
+
+    // 区間 [first, last) を grain ずつの仕事に分けて並列に処理する, 他の呼び出しが使っていれば false
+    bool parallelFor(std::size_t first, std::size_t last, std::size_t size,
+      const std::function<void(std::size_t, std::size_t)>& func)
+    {
+      // プールの仕事の中から呼び出されたときは busy を所有しているかもしれないので触らない
+      if (inPool) return false;
+
+      // 他のスレッドが使っているときは使わない
+      std::unique_lock<std::mutex> guard{ busy, std::try_to_lock };
+      if (!guard) return false;
+
+      // 仕事を参加者に均等に割り振る
+      const auto chunks{ (last - first + size - 1) / size };
+      const auto n{ slots.size() };
+      for (std::size_t i = 0; i < n; ++i)
+      {
+        std::lock_guard<std::mutex> lock{ slots[i].mutex };
+        slots[i].next = chunks * i / n;
+        slots[i].last = chunks * (i + 1) / n;
+      }
+
+      // ワーカースレッドを起こす
+      {
+        std::lock_guard<std::mutex> lock{ mutex };
+        body = &func;
+        begin = first;
+        end = last;
+        grain = size;
+        error = nullptr;
+        running = workers.size();
+        ++generation;
+      }
+      wake.notify_all();
+
+      // 呼び出したスレッドも参加する
+      run(n - 1);
+
+      // すべてのワーカースレッドが終わるのを待つ
+      std::unique_lock<std::mutex> lock{ mutex };
+      done.wait(lock, [&] { return running == 0; });
+      body = nullptr;
+
+      // 処理中に発生した例外を呼び出し元に投げ直す
+      if (error) std::rethrow_exception(error);
+
+      return true;
+    }
+  };
+
+  // スレッドプールを得る
+  ThreadPool& getThreadPool()
+  {
+    static ThreadPool pool;
+    return pool;
+  }
+}
+
+/// @endcond
+
+//
+// 区間を小区間に分けて並列に処理する
+//
+void gg::ggParallelFor(std::size_t begin, std::size_t end, std::size_t grain,
+  const std::function<void(std::size_t, std::size_t)>& body)
+{
+  // 空の区間なら何もしない
+  if (begin >= end) return;
+
+  // 一つの仕事の大きさが指定されていなければ参加者あたり 8 個くらいの仕事に分ける
+  auto& pool{ getThreadPool() };
+  const auto count{ end - begin };
+  if (grain == 0) grain = std::max(count / (pool.size() * 8), static_cast<std::size_t>(1));
+
+  // 分けられないかプールが使えなければ呼び出したスレッドで処理する
+  if (count <= grain || pool.size() < 2 || !pool.parallelFor(begin, end, grain, body)) body(begin, end);
 }
 
 //
@@ -2704,15 +3026,43 @@ void gg::_ggFBOError(const std::string& name, unsigned int line)
   }
 }
 
+//
+// SIMD 命令による演算は a[0] * b[0] + a[4] * b[1] + a[8] * b[2] + a[12] * b[3] のように
+// スカラ演算と同じ順序で積和を求めるので, 積和の融合 (FMA) をしなければ結果はビット単位で一致する.
+// -ffp-contract=fast や -march=native でコンパイルしてもここから後では積和を融合させない
+// (makyoh_bench --check-math で GG_NO_SIMD を定義したスカラ演算の結果と比べて確かめる)
+//
+#if defined(__clang__)
+#  pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#  pragma GCC optimize("fp-contract=off")
+#elif defined(_MSC_VER)
+#  pragma fp_contract(off)
+#endif
+
 //
 // 変換行列：行列とベクトルの積 c ← a × b
 //
 void gg::GgMatrix::projection(GLfloat* c, const GLfloat* a, const GLfloat* b) const
 {
+#if defined(GG_USE_SSE)
+  __m128 t{ _mm_mul_ps(_mm_loadu_ps(a), _mm_set1_ps(b[0])) };
+  t = _mm_add_ps(t, _mm_mul_ps(_mm_loadu_ps(a + 4), _mm_set1_ps(b[1])));
+  t = _mm_add_ps(t, _mm_mul_ps(_mm_loadu_ps(a + 8), _mm_set1_ps(b[2])));
+  t = _mm_add_ps(t, _mm_mul_ps(_mm_loadu_ps(a + 12), _mm_set1_ps(b[3])));
+  _mm_storeu_ps(c, t);
+#elif defined(GG_USE_NEON)
+  float32x4_t t{ vmulq_n_f32(vld1q_f32(a), b[0]) };
+  t = vaddq_f32(t, vmulq_n_f32(vld1q_f32(a + 4), b[1]));
+  t = vaddq_f32(t, vmulq_n_f32(vld1q_f32(a + 8), b[2]));
+  t = vaddq_f32(t, vmulq_n_f32(vld1q_f32(a + 12), b[3]));
+  vst1q_f32(c, t);
+#else
   for (int i = 0; i < 4; ++i)
   {
     c[i] = a[0 + i] * b[0] + a[4 + i] * b[1] + a[8 + i] * b[2] + a[12 + i] * b[3];
   }
+#endif
 }
 
 //
@@ -2720,12 +3070,199 @@ void gg::GgMatrix::projection(GLfloat* c, const GLfloat* a, const GLfloat* b) co
 //
 void gg::GgMatrix::multiply(GLfloat* c, const GLfloat* a, const GLfloat* b) const
 {
+#if defined(GG_USE_SSE)
+  // a の列を読み込んでおく
+  const __m128 a0{ _mm_loadu_ps(a) };
+  const __m128 a1{ _mm_loadu_ps(a + 4) };
+  const __m128 a2{ _mm_loadu_ps(a + 8) };
+  const __m128 a3{ _mm_loadu_ps(a + 12) };
+
+  // c の列は a の列を b の列の要素で重み付けした和 (c が a や b と同じでもいいように全部求めてから書き込む)
+  __m128 t[4];
+  for (int k = 0; k < 4; ++k)
+  {
+    t[k] = _mm_mul_ps(a0, _mm_set1_ps(b[k * 4 + 0]));
+    t[k] = _mm_add_ps(t[k], _mm_mul_ps(a1, _mm_set1_ps(b[k * 4 + 1])));
+    t[k] = _mm_add_ps(t[k], _mm_mul_ps(a2, _mm_set1_ps(b[k * 4 + 2])));
+    t[k] = _mm_add_ps(t[k], _mm_mul_ps(a3, _mm_set1_ps(b[k * 4 + 3])));
+  }
+  for (int k = 0; k < 4; ++k) _mm_storeu_ps(c + k * 4, t[k]);
+#elif defined(GG_USE_NEON)
+  // a の列を読み込んでおく
+  const float32x4_t a0{ vld1q_f32(a) };
+  const float32x4_t a1{ vld1q_f32(a + 4) };
+  const float32x4_t a2{ vld1q_f32(a + 8) };
+  const float32x4_t a3{ vld1q_f32(a + 12) };
+
+  // c の列は a の列を b の列の要素で重み付けした和 (c が a や b と同じでもいいように全部求めてから書き込む)
+  float32x4_t t[4];
+  for (int k = 0; k < 4; ++k)
+  {
+    t[k] = vmulq_n_f32(a0, b[k * 4 + 0]);
+    t[k] = vaddq_f32(t[k], vmulq_n_f32(a1, b[k * 4 + 1]));
+    t[k] = vaddq_f32(t[k], vmulq_n_f32(a2, b[k * 4 + 2]));
+    t[k] = vaddq_f32(t[k], vmulq_n_f32(a3, b[k * 4 + 3]));
+  }
+  for (int k = 0; k < 4; ++k) vst1q_f32(c + k * 4, t[k]);
+#else
   for (int i = 0; i < 16; ++i)
   {
     int j = i & 3, k = i & ~3;
 
     c[i] = a[0 + j] * b[k + 0] + a[4 + j] * b[k + 1] + a[8 + j] * b[k + 2] + a[12 + j] * b[k + 3];
   }
+#endif
+}
+
+//
+// 変換行列の配列を左から順に乗じる c ← m[0] × m[1] × … × m[count - 1]
+//
+void gg::ggMultiplyChain(GgMatrix& c, const GgMatrix* m, std::size_t count)
+{
+#if defined(GG_USE_SSE)
+  // 途中の積の列はレジスタに置いたまま次の因子を乗じる
+  __m128 p0{ _mm_load_ps(m[0].data()) };
+  __m128 p1{ _mm_load_ps(m[0].data() + 4) };
+  __m128 p2{ _mm_load_ps(m[0].data() + 8) };
+  __m128 p3{ _mm_load_ps(m[0].data() + 12) };
+  for (std::size_t i = 1; i < count; ++i)
+  {
+    // multiply() と同じく積の列は途中の積の列を因子の列の要素で重み付けした和 (レジスタから溢れないように列ごとに書き下す)
+    const auto* const b{ m[i].data() };
+    const auto column{ [&](const GLfloat* e)
+      {
+        __m128 t{ _mm_mul_ps(p0, _mm_set1_ps(e[0])) };
+        t = _mm_add_ps(t, _mm_mul_ps(p1, _mm_set1_ps(e[1])));
+        t = _mm_add_ps(t, _mm_mul_ps(p2, _mm_set1_ps(e[2])));
+        return _mm_add_ps(t, _mm_mul_ps(p3, _mm_set1_ps(e[3])));
+      } };
+    const __m128 t0{ column(b) };
+    const __m128 t1{ column(b + 4) };
+    const __m128 t2{ column(b + 8) };
+    const __m128 t3{ column(b + 12) };
+    p0 = t0;
+    p1 = t1;
+    p2 = t2;
+    p3 = t3;
+  }
+  _mm_store_ps(c.data(), p0);
+  _mm_store_ps(c.data() + 4, p1);
+  _mm_store_ps(c.data() + 8, p2);
+  _mm_store_ps(c.data() + 12, p3);
+#elif defined(GG_USE_NEON)
+  // 途中の積の列はレジスタに置いたまま次の因子を乗じる
+  float32x4_t p0{ vld1q_f32(m[0].data()) };
+  float32x4_t p1{ vld1q_f32(m[0].data() + 4) };
+  float32x4_t p2{ vld1q_f32(m[0].data() + 8) };
+  float32x4_t p3{ vld1q_f32(m[0].data() + 12) };
+  for (std::size_t i = 1; i < count; ++i)
+  {
+    // multiply() と同じく積の列は途中の積の列を因子の列の要素で重み付けした和 (レジスタから溢れないように列ごとに書き下す)
+    const auto* const b{ m[i].data() };
+    const auto column{ [&](const GLfloat* e)
+      {
+        float32x4_t t{ vmulq_n_f32(p0, e[0]) };
+        t = vaddq_f32(t, vmulq_n_f32(p1, e[1]));
+        t = vaddq_f32(t, vmulq_n_f32(p2, e[2]));
+        return vaddq_f32(t, vmulq_n_f32(p3, e[3]));
+      } };
+    const float32x4_t t0{ column(b) };
+    const float32x4_t t1{ column(b + 4) };
+    const float32x4_t t2{ column(b + 8) };
+    const float32x4_t t3{ column(b + 12) };
+    p0 = t0;
+    p1 = t1;
+    p2 = t2;
+    p3 = t3;
+  }
+  vst1q_f32(c.data(), p0);
+  vst1q_f32(c.data() + 4, p1);
+  vst1q_f32(c.data() + 8, p2);
+  vst1q_f32(c.data() + 12, p3);
+#else
+  // 途中の積は行ごとに 4 要素だけ保持して次の因子を乗じる
+  for (int j = 0; j < 4; ++j)
+  {
+    GLfloat r[4]{ m[0][j], m[0][4 + j], m[0][8 + j], m[0][12 + j] };
+    for (std::size_t i = 1; i < count; ++i)
+    {
+      // multiply() と同じ順序で積和を求める
+      const auto* const b{ m[i].data() };
+      GLfloat t[4];
+      for (int k = 0; k < 4; ++k)
+        t[k] = r[0] * b[k * 4 + 0] + r[1] * b[k * 4 + 1] + r[2] * b[k * 4 + 2] + r[3] * b[k * 4 + 3];
+      std::copy(t, t + 4, r);
+    }
+    for (int k = 0; k < 4; ++k) c[k * 4 + j] = r[k];
+  }
+#endif
+}
+
+//
+// 変換行列：ベクトルの配列をまとめて投影変換する
+//
+void gg::GgMatrix::transform(const GgVector* src, GgVector* dst, std::size_t count) const
+{
+  std::size_t i{ 0 };
+
+#if defined(GG_USE_SSE)
+  // 変換行列の列を読み込んでおく
+  const __m128 a0{ _mm_load_ps(data()) };
+  const __m128 a1{ _mm_load_ps(data() + 4) };
+  const __m128 a2{ _mm_load_ps(data() + 8) };
+  const __m128 a3{ _mm_load_ps(data() + 12) };
+
+#  if defined(__AVX__)
+  // AVX が使えるならベクトルを二つずつ変換する (GgVector は 16 バイト境界にしか置かれない)
+  const __m256 b0{ _mm256_insertf128_ps(_mm256_castps128_ps256(a0), a0, 1) };
+  const __m256 b1{ _mm256_insertf128_ps(_mm256_castps128_ps256(a1), a1, 1) };
+  const __m256 b2{ _mm256_insertf128_ps(_mm256_castps128_ps256(a2), a2, 1) };
+  const __m256 b3{ _mm256_insertf128_ps(_mm256_castps128_ps256(a3), a3, 1) };
+  for (; i + 2 <= count; i += 2)
+  {
+    const __m256 v{ _mm256_loadu_ps(src[i].data()) };
+    __m256 t{ _mm256_mul_ps(b0, _mm256_permute_ps(v, 0x00)) };
+    t = _mm256_add_ps(t, _mm256_mul_ps(b1, _mm256_permute_ps(v, 0x55)));
+    t = _mm256_add_ps(t, _mm256_mul_ps(b2, _mm256_permute_ps(v, 0xaa)));
+    t = _mm256_add_ps(t, _mm256_mul_ps(b3, _mm256_permute_ps(v, 0xff)));
+    _mm256_storeu_ps(dst[i].data(), t);
+  }
+#  endif
+
+  for (; i < count; ++i)
+  {
+    const __m128 v{ _mm_load_ps(src[i].data()) };
+    __m128 t{ _mm_mul_ps(a0, _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0))) };
+    t = _mm_add_ps(t, _mm_mul_ps(a1, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))));
+    t = _mm_add_ps(t, _mm_mul_ps(a2, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2))));
+    t = _mm_add_ps(t, _mm_mul_ps(a3, _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))));
+    _mm_store_ps(dst[i].data(), t);
+  }
+#elif defined(GG_USE_NEON)
+  // 変換行列の列を読み込んでおく
+  const float32x4_t a0{ vld1q_f32(data()) };
+  const float32x4_t a1{ vld1q_f32(data() + 4) };
+  const float32x4_t a2{ vld1q_f32(data() + 8) };
+  const float32x4_t a3{ vld1q_f32(data() + 12) };
+
+  for (; i < count; ++i)
+  {
+    const float32x4_t v{ vld1q_f32(src[i].data()) };
+    float32x4_t t{ vmulq_laneq_f32(a0, v, 0) };
+    t = vaddq_f32(t, vmulq_laneq_f32(a1, v, 1));
+    t = vaddq_f32(t, vmulq_laneq_f32(a2, v, 2));
+    t = vaddq_f32(t, vmulq_laneq_f32(a3, v, 3));
+    vst1q_f32(dst[i].data(), t);
+  }
+#else
+  // src と dst が同じでもいいように一旦別の変数に求める
+  for (; i < count; ++i)
+  {
+    GgVector t;
+    projection(t.data(), data(), src[i].data());
+    dst[i] = t;
+  }
+#endif
 }
 
 //
@@ -2958,6 +3495,62 @@ gg::GgMatrix& gg::GgMatrix::loadInvert(const GLfloat* marray)
   }
 
   // LU 分解から逆行列を求める
+#if defined(GG_USE_SSE) || defined(GG_USE_NEON)
+  // 逆行列の k 列目は互いに独立なので, 各列の同じ行の要素 (*this)[i * 4 + k] を 4 列まとめて求める
+#  if defined(GG_USE_SSE)
+  using lane = __m128;
+  const auto set{ [](GLfloat a) { return _mm_set1_ps(a); } };
+  const auto sub{ [](lane a, lane b) { return _mm_sub_ps(a, b); } };
+  const auto mul{ [](lane a, lane b) { return _mm_mul_ps(a, b); } };
+  const auto div{ [](lane a, lane b) { return _mm_div_ps(a, b); } };
+#  else
+  using lane = float32x4_t;
+  const auto set{ [](GLfloat a) { return vdupq_n_f32(a); } };
+  const auto sub{ [](lane a, lane b) { return vsubq_f32(a, b); } };
+  const auto mul{ [](lane a, lane b) { return vmulq_f32(a, b); } };
+  const auto div{ [](lane a, lane b) { return vdivq_f32(a, b); } };
+#  endif
+  lane x[4];
+
+  // 行を入れ替えた単位行列を設定する
+  for (int i = 0; i < 4; ++i)
+  {
+    alignas(16) GLfloat e[4];
+    for (int k = 0; k < 4; ++k) e[k] = (plu[i] == lu + k * 5) ? 1.0f : 0.0f;
+#  if defined(GG_USE_SSE)
+    x[i] = _mm_load_ps(e);
+#  else
+    x[i] = vld1q_f32(e);
+#  endif
+  }
+
+  // lu から逆行列を求める
+  for (int i = 0; i < 4; ++i)
+  {
+    for (int j = i; ++j < 4;)
+    {
+      x[j] = sub(x[j], mul(x[i], set(plu[j][i])));
+    }
+  }
+  for (int i = 4; --i >= 0;)
+  {
+    for (int j = i; ++j < 4;)
+    {
+      x[i] = sub(x[i], mul(set(plu[i][j]), x[j]));
+    }
+    x[i] = div(x[i], set(plu[i][i]));
+  }
+
+  // 求めた逆行列を格納する
+  for (int i = 0; i < 4; ++i)
+  {
+#  if defined(GG_USE_SSE)
+    _mm_store_ps(data() + i * 4, x[i]);
+#  else
+    vst1q_f32(data() + i * 4, x[i]);
+#  endif
+  }
+#else
   for (int k = 0; k < 4; ++k)
   {
     // array に単位行列を設定する
@@ -2982,6 +3575,7 @@ gg::GgMatrix& gg::GgMatrix::loadInvert(const GLfloat* marray)
       (*this)[i * 4 + k] /= plu[i][i];
     }
   }
+#endif
 
   return *this;
 }
@@ -3203,10 +3797,33 @@ gg::GgMatrix& gg::GgMatrix::loadPerspective(
 //
 void gg::GgQuaternion::multiply(GLfloat* r, const GLfloat* p, const GLfloat* q) const
 {
+#if defined(GG_USE_SSE)
+  // r = ((a - b) + c) + d の順に求める (r[3] の c と d は符号を反転して加える)
+  const __m128 vp{ _mm_loadu_ps(p) };
+  const __m128 vq{ _mm_loadu_ps(q) };
+  const __m128 sign{ _mm_setr_ps(0.0f, 0.0f, 0.0f, -0.0f) };
+  const __m128 a{ _mm_mul_ps(_mm_shuffle_ps(vp, vp, _MM_SHUFFLE(3, 0, 2, 1)), _mm_shuffle_ps(vq, vq, _MM_SHUFFLE(3, 1, 0, 2))) };
+  const __m128 b{ _mm_mul_ps(_mm_shuffle_ps(vp, vp, _MM_SHUFFLE(0, 1, 0, 2)), _mm_shuffle_ps(vq, vq, _MM_SHUFFLE(0, 0, 2, 1))) };
+  const __m128 c{ _mm_xor_ps(_mm_mul_ps(_mm_shuffle_ps(vp, vp, _MM_SHUFFLE(1, 2, 1, 0)), _mm_shuffle_ps(vq, vq, _MM_SHUFFLE(1, 3, 3, 3))), sign) };
+  const __m128 d{ _mm_xor_ps(_mm_mul_ps(_mm_shuffle_ps(vp, vp, _MM_SHUFFLE(2, 3, 3, 3)), _mm_shuffle_ps(vq, vq, _MM_SHUFFLE(2, 2, 1, 0))), sign) };
+  _mm_storeu_ps(r, _mm_add_ps(_mm_add_ps(_mm_sub_ps(a, b), c), d));
+#elif defined(GG_USE_NEON)
+  // r = ((a - b) + c) + d の順に求める (r[3] の c と d は符号を反転して加える)
+  const GLfloat pa[]{ p[1], p[2], p[0], p[3] }, qa[]{ q[2], q[0], q[1], q[3] };
+  const GLfloat pb[]{ p[2], p[0], p[1], p[0] }, qb[]{ q[1], q[2], q[0], q[0] };
+  const GLfloat pc[]{ p[0], p[1], p[2], -p[1] }, qc[]{ q[3], q[3], q[3], q[1] };
+  const GLfloat pd[]{ p[3], p[3], p[3], -p[2] }, qd[]{ q[0], q[1], q[2], q[2] };
+  const float32x4_t a{ vmulq_f32(vld1q_f32(pa), vld1q_f32(qa)) };
+  const float32x4_t b{ vmulq_f32(vld1q_f32(pb), vld1q_f32(qb)) };
+  const float32x4_t c{ vmulq_f32(vld1q_f32(pc), vld1q_f32(qc)) };
+  const float32x4_t d{ vmulq_f32(vld1q_f32(pd), vld1q_f32(qd)) };
+  vst1q_f32(r, vaddq_f32(vaddq_f32(vsubq_f32(a, b), c), d));
+#else
   r[0] = p[1] * q[2] - p[2] * q[1] + p[0] * q[3] + p[3] * q[0];
   r[1] = p[2] * q[0] - p[0] * q[2] + p[1] * q[3] + p[3] * q[1];
   r[2] = p[0] * q[1] - p[1] * q[0] + p[2] * q[3] + p[3] * q[2];
   r[3] = p[3] * q[3] - p[0] * q[0] - p[1] * q[1] - p[2] * q[2];
+#endif
 }
 
 //
@@ -3214,6 +3831,26 @@ void gg::GgQuaternion::multiply(GLfloat* r, const GLfloat* p, const GLfloat* q)
 //
 void gg::GgQuaternion::toMatrix(GLfloat* m, const GLfloat* q) const
 {
+#if defined(GG_USE_SSE) || defined(GG_USE_NEON)
+  // 二乗 (xx, yy, zz), 隣り合う要素の積 (xy, yz, zx), w との積 (xw, yw, zw) をそれぞれまとめて求める
+  alignas(16) GLfloat s[4], t[4], u[4];
+#  if defined(GG_USE_SSE)
+  const __m128 v{ _mm_loadu_ps(q) };
+  const __m128 two{ _mm_set1_ps(2.0f) };
+  _mm_store_ps(s, _mm_mul_ps(_mm_mul_ps(v, v), two));
+  _mm_store_ps(t, _mm_mul_ps(_mm_mul_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 0, 2, 1))), two));
+  _mm_store_ps(u, _mm_mul_ps(_mm_mul_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))), two));
+#  else
+  const float32x4_t v{ vld1q_f32(q) };
+  const GLfloat r[]{ q[1], q[2], q[0], q[3] };
+  vst1q_f32(s, vmulq_n_f32(vmulq_f32(v, v), 2.0f));
+  vst1q_f32(t, vmulq_n_f32(vmulq_f32(v, vld1q_f32(r)), 2.0f));
+  vst1q_f32(u, vmulq_n_f32(vmulq_laneq_f32(v, v, 3), 2.0f));
+#  endif
+  const auto xx{ s[0] }, yy{ s[1] }, zz{ s[2] };
+  const auto xy{ t[0] }, yz{ t[1] }, zx{ t[2] };
+  const auto xw{ u[0] }, yw{ u[1] }, zw{ u[2] };
+#else
   const auto xx{ q[0] * q[0] * 2.0f };
   const auto yy{ q[1] * q[1] * 2.0f };
   const auto zz{ q[2] * q[2] * 2.0f };
@@ -3223,6 +3860,7 @@ void gg::GgQuaternion::toMatrix(GLfloat* m, const GLfloat* q) const
   const auto xw{ q[0] * q[3] * 2.0f };
   const auto yw{ q[1] * q[3] * 2.0f };
   const auto zw{ q[2] * q[3] * 2.0f };
+#endif
 
   m[ 0] = 1.0f - yy - zz;
   m[ 1] = xy + zw;
@@ -3581,15 +4219,18 @@ bool gg::ggSaveTga(
   const unsigned int size{ width * height * depth };
   if (type == 2)
   {
-    // フルカラー
+    // フルカラー (赤と青を入れ替える)
     std::vector<char> temp(size);
-    for (GLuint i = 0; i < size; i += depth)
-    {
-      temp[i + 2] = static_cast<const char*>(buffer)[i + 0];
-      temp[i + 1] = static_cast<const char*>(buffer)[i + 1];
-      temp[i + 0] = static_cast<const char*>(buffer)[i + 2];
-      if (depth == 4) temp[i + 3] = static_cast<const char*>(buffer)[i + 3];
-    }
+    ggParallelFor(0, static_cast<std::size_t>(width) * height, 0, [&](std::size_t first, std::size_t last)
+      {
+        for (auto i = first * depth; i < last * depth; i += depth)
+        {
+          temp[i + 2] = static_cast<const char*>(buffer)[i + 0];
+          temp[i + 1] = static_cast<const char*>(buffer)[i + 1];
+          temp[i + 0] = static_cast<const char*>(buffer)[i + 2];
+          if (depth == 4) temp[i + 3] = static_cast<const char*>(buffer)[i + 3];
+        }
+      });
     file.write(temp.data(), size);
   }
   else if (type == 3)
@@ -3914,6 +4555,7 @@ void gg::ggCreateNormalMap(
 
   // 法線マップのメモリを確保する
   nmap.resize(size);
+  if (size <= 0) return;
 
   // 画素のバイト数
   GLint stride;
@@ -3936,42 +4578,113 @@ void gg::ggCreateNormalMap(
     break;
   }
 
-  // 法線マップの作成
-  for (GLsizei i = 0; i < size; ++i)
-  {
-    const auto x{ i % width };
-    const auto y{ i - x };
-    const auto u0{ (y + (x - 1 + width) % width) * stride };
-    const auto u1{ (y + (x + 1) % width) * stride };
-    const auto v0{ ((y - width + size) % size + x) * stride };
-    const auto v1{ ((y + width) % size + x) * stride };
-
-    // 隣接する画素との値の差を法線の成分に用いる
-    nmap[i][0] = static_cast<GLfloat>(hmap[u0] - hmap[u1]);
-    nmap[i][1] = static_cast<GLfloat>(hmap[v0] - hmap[v1]);
-    nmap[i][2] = nz;
-    nmap[i][3] = hmap[i * stride];
-
-    // 法線ベクトルを正規化する
-    ggNormalize3(&nmap[i]);
-  }
-
   // 内部フォーマットが浮動小数点テクスチャでなければ [0,1] に正規化する
-  if (
+  const auto unit
+  {
     internal != GL_RGB16F &&
     internal != GL_RGBA16F &&
     internal != GL_RGB32F &&
     internal != GL_RGBA32F
-    )
-  {
-    for (GLsizei i = 0; i < size; ++i)
+  };
+  const GLfloat scale{ unit ? 0.5f : 1.0f };
+  const GLfloat bias{ unit ? 0.5f : 0.0f };
+  const GLfloat hscale{ unit ? 0.0039215686f : 1.0f }; // == 1/255
+
+  // 法線マップの作成 (行ごとに上下の行と左右の端の画素を先に求めておく)
+  ggParallelFor(0, height, std::max(16384 / std::max(width, 1), 1),
+    [&](std::size_t first, std::size_t last)
     {
-      nmap[i][0] = nmap[i][0] * 0.5f + 0.5f;
-      nmap[i][1] = nmap[i][1] * 0.5f + 0.5f;
-      nmap[i][2] = nmap[i][2] * 0.5f + 0.5f;
-      nmap[i][3] *= 0.0039215686f; // == 1/255
-    }
-  }
+      for (auto y{ static_cast<GLsizei>(first) }; y < static_cast<GLsizei>(last); ++y)
+      {
+        // この行と上下の行の先頭
+        const auto* const row{ hmap + static_cast<std::size_t>(y) * width * stride };
+        const auto* const up{ hmap + static_cast<std::size_t>((y - 1 + height) % height) * width * stride };
+        const auto* const down{ hmap + static_cast<std::size_t>((y + 1) % height) * width * stride };
+
+        // この行の法線マップの先頭
+        auto* const n{ nmap.data() + static_cast<std::size_t>(y) * width };
+
+        // 左右の画素 l, r と上下の画素の値の差を法線の成分に用いる
+        const auto pixel{ [&](GLsizei x, GLsizei l, GLsizei r)
+        {
+          GgVector& v{ n[x] };
+          v[0] = static_cast<GLfloat>(row[l * stride] - row[r * stride]);
+          v[1] = static_cast<GLfloat>(up[x * stride] - down[x * stride]);
+          v[2] = nz;
+          v[3] = row[x * stride];
+
+          // 法線ベクトルを正規化する
+          ggNormalize3(v.data());
+          v[0] = v[0] * scale + bias;
+          v[1] = v[1] * scale + bias;
+          v[2] = v[2] * scale + bias;
+          v[3] *= hscale;
+        } };
+
+        // 左端は右端の画素と隣接する
+        pixel(0, width - 1, 1 % width);
+
+        // 端以外の画素
+        GLsizei x{ 1 };
+#if defined(GG_USE_SSE) || defined(GG_USE_NEON)
+        // 4 画素ずつ成分ごとにまとめて求める
+        for (; x + 4 < width; x += 4)
+        {
+#  if defined(GG_USE_SSE)
+          // p の i 番目から 4 画素の値を読み出す
+          const auto load{ [stride](const GLubyte* p, GLsizei i)
+          {
+            p += i * stride;
+            return _mm_setr_ps(p[0], p[stride], p[stride * 2], p[stride * 3]);
+          } };
+          const auto dx{ _mm_sub_ps(load(row, x - 1), load(row, x + 1)) };
+          const auto dy{ _mm_sub_ps(load(up, x), load(down, x)) };
+          const auto dz{ _mm_set1_ps(nz) };
+          const auto length{ _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz))) };
+          const auto s{ _mm_set1_ps(scale) }, b{ _mm_set1_ps(bias) };
+          auto nx{ _mm_add_ps(_mm_mul_ps(_mm_div_ps(dx, length), s), b) };
+          auto ny{ _mm_add_ps(_mm_mul_ps(_mm_div_ps(dy, length), s), b) };
+          auto nw{ _mm_add_ps(_mm_mul_ps(_mm_div_ps(dz, length), s), b) };
+          auto h{ _mm_mul_ps(load(row, x), _mm_set1_ps(hscale)) };
+
+          // 画素ごとのベクトルに並べ替えて格納する
+          _MM_TRANSPOSE4_PS(nx, ny, nw, h);
+          _mm_storeu_ps(n[x].data(), nx);
+          _mm_storeu_ps(n[x + 1].data(), ny);
+          _mm_storeu_ps(n[x + 2].data(), nw);
+          _mm_storeu_ps(n[x + 3].data(), h);
+#  else
+          // p の i 番目から 4 画素の値を読み出す
+          const auto load{ [stride](const GLubyte* p, GLsizei i)
+          {
+            p += i * stride;
+            auto v{ vdupq_n_f32(p[0]) };
+            v = vsetq_lane_f32(p[stride], v, 1);
+            v = vsetq_lane_f32(p[stride * 2], v, 2);
+            return vsetq_lane_f32(p[stride * 3], v, 3);
+          } };
+          const auto dx{ vsubq_f32(load(row, x - 1), load(row, x + 1)) };
+          const auto dy{ vsubq_f32(load(up, x), load(down, x)) };
+          const auto dz{ vdupq_n_f32(nz) };
+          const auto length{ vsqrtq_f32(vaddq_f32(vaddq_f32(vmulq_f32(dx, dx), vmulq_f32(dy, dy)), vmulq_f32(dz, dz))) };
+          const auto s{ vdupq_n_f32(scale) }, b{ vdupq_n_f32(bias) };
+          float32x4x4_t v;
+          v.val[0] = vaddq_f32(vmulq_f32(vdivq_f32(dx, length), s), b);
+          v.val[1] = vaddq_f32(vmulq_f32(vdivq_f32(dy, length), s), b);
+          v.val[2] = vaddq_f32(vmulq_f32(vdivq_f32(dz, length), s), b);
+          v.val[3] = vmulq_n_f32(load(row, x), hscale);
+
+          // 画素ごとのベクトルに並べ替えて格納する
+          vst4q_f32(n[x].data(), v);
+#  endif
+        }
+#endif
+        for (; x < width - 1; ++x) pixel(x, x - 1, x + 1);
+
+        // 右端は左端の画素と隣接する
+        if (width > 1) pixel(width - 1, width - 2, 0);
+      }
+    });
 }
 
 //
@@ -4560,21 +5273,38 @@ namespace gg
       // 法線データ数の初期値は頂点数と同じでスムーズシェーディングのために初期値は 0
       norm.resize(pos.size(), { 0.0f, 0.0f, 0.0f });
 
-      // 面の法線の算出と頂点法線の算出
-      for (auto& f : face)
+      // 面の法線は三角形ごとに独立に求められるので並列に求めておく
+      std::vector<vec3> fnorm(face.size());
+      ggParallelFor(0, face.size(), 0, [&](std::size_t first, std::size_t last)
+        {
+          for (auto j = first; j < last; ++j)
+          {
+            // 頂点座標番号
+            const auto& f{ face[j] };
+            const auto v0{ f.p[0] - 1 };
+            const auto v1{ f.p[1] - 1 };
+            const auto v2{ f.p[2] - 1 };
+
+            // v1 - v0, v2 - v0 を求める
+            const GLfloat d1[]{ pos[v1][0] - pos[v0][0], pos[v1][1] - pos[v0][1], pos[v1][2] - pos[v0][2] };
+            const GLfloat d2[]{ pos[v2][0] - pos[v0][0], pos[v2][1] - pos[v0][1], pos[v2][2] - pos[v0][2] };
+
+            // 外積により面法線を求める
+            ggCross(fnorm[j].data(), d1, d2);
+          }
+        });
+
+      // 頂点法線の算出 (積算する順序で結果が変わらないように順番に処理する)
+      for (std::size_t j = 0; j < face.size(); ++j)
       {
         // 頂点座標番号
+        auto& f{ face[j] };
         const auto v0{ f.p[0] - 1 };
         const auto v1{ f.p[1] - 1 };
         const auto v2{ f.p[2] - 1 };
 
-        // v1 - v0, v2 - v0 を求める
-        const GLfloat d1[]{ pos[v1][0] - pos[v0][0], pos[v1][1] - pos[v0][1], pos[v1][2] - pos[v0][2] };
-        const GLfloat d2[]{ pos[v2][0] - pos[v0][0], pos[v2][1] - pos[v0][1], pos[v2][2] - pos[v0][2] };
-
-        // 外積により面法線を求める
-        vec3 n;
-        ggCross(n.data(), d1, d2);
+        // 面法線
+        const auto& n{ fnorm[j] };
 
         if (f.smooth)
         {
@@ -4606,7 +5336,10 @@ namespace gg
       }
 
       // 頂点の法線ベクトルを正規化する
-      for (auto& n : norm) ggNormalize3(n.data());
+      ggParallelFor(0, norm.size(), 0, [&](std::size_t first, std::size_t last)
+        {
+          for (auto i = first; i < last; ++i) ggNormalize3(norm[i].data());
+        });
     }
 
     // 図形の正規化
@@ -4629,12 +5362,16 @@ namespace gg
       const auto cz{ (bmax[2] + bmin[2]) * 0.5f };
 
       // 図形の大きさと位置を正規化する
-      for (auto& p : pos)
-      {
-        p[0] = (p[0] - cx) * scale;
-        p[1] = (p[1] - cy) * scale;
-        p[2] = (p[2] - cz) * scale;
-      }
+      ggParallelFor(0, pos.size(), 0, [&](std::size_t first, std::size_t last)
+        {
+          for (auto i = first; i < last; ++i)
+          {
+            auto& p{ pos[i] };
+            p[0] = (p[0] - cx) * scale;
+            p[1] = (p[1] - cy) * scale;
+            p[2] = (p[2] - cz) * scale;
+          }
+        });
     }
 
 #if defined(DEBUG)
@@ -6047,6 +6784,26 @@ gg::GgSimpleObj::GgSimpleObj(const std::string& name, bool normalize)
   }
 }
 
+//
+// Wavefront OBJ 形式のデータ：読み込み済みのデータからのコンストラクタ
+//
+gg::GgSimpleObj::GgSimpleObj(const std::vector<std::array<GLuint, 3>>& group,
+  const std::vector<GgSimpleShader::Material>& material,
+  const std::vector<GgVertex>& vert, const std::vector<GLuint>& face) :
+  group{ std::make_shared<std::vector<std::array<GLuint, 3>>>(group) }
+{
+  // 頂点バッファオブジェクトを作成する
+  data = std::make_shared<GgElements>(vert.data(), static_cast<GLsizei>(vert.size()),
+    face.data(), static_cast<GLsizei>(face.size()), GL_TRIANGLES);
+
+  // 描画するオブジェクトを切り替えるために頂点配列オブジェクトを閉じておく
+  glBindVertexArray(0);
+
+  // 材質データを設定する
+  this->material = std::make_shared<GgSimpleShader::MaterialBuffer>(material.data(),
+    static_cast<GLsizei>(material.size()));
+}
+
 //
 // Wavefront OBJ 形式のデータ：図形の描画
 //
@@ -35,9 +35,11 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 // 標準ライブラリ
 #include <cmath>
 #include <array>
+#include <algorithm>
 #include <vector>
 #include <string>
 #include <memory>
+#include <functional>
 #include <cassert>
 
 // Windows (Visual Studio) のとき
@@ -80,6 +82,15 @@ inline pathString Utf8ToTChar(const std::string& string) { return string; }
 inline std::string TCharToUtf8(const pathString& cstring) { return cstring; }
 #endif
 
+// ベクトルと変換行列と四元数の演算に SIMD 命令を使う (GG_NO_SIMD を定義すればスカラ演算にする)
+#if !defined(GG_NO_SIMD)
+#  if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define GG_USE_SSE
+#  elif (defined(__ARM_NEON) && defined(__aarch64__)) || defined(_M_ARM64)
+#    define GG_USE_NEON
+#  endif
+#endif
+
 /// @cond INCLUDE_OPENGL_FUNCTIONS
 
 // macOS で "OpenGL deprecated の警告を出さない
@@ -1365,6 +1376,21 @@ namespace gg
   ///
   extern void ggInit();
 
+  ///
+  /// 区間を小区間に分けて並列に処理する.
+  ///
+  /// @param begin 処理する区間の最初の番号.
+  /// @param end 処理する区間の最後の次の番号.
+  /// @param grain 一度に処理する小区間の番号の数, 0 なら参加するスレッドの数から決める.
+  /// @param body 小区間の最初の番号と最後の次の番号を引数にして小区間を処理する関数.
+  ///
+  /// @note
+  /// すべてのスレッドで共有するスレッドプールを使い, 自分の仕事を終えたスレッドは他のスレッドの残りの仕事を盗む.
+  /// すべての小区間の処理が終わるまで戻らない. body の中から呼び出したときは呼び出したスレッドで処理する.
+  ///
+  extern void ggParallelFor(std::size_t begin, std::size_t end, std::size_t grain,
+    const std::function<void(std::size_t, std::size_t)>& body);
+
   ///
   /// OpenGL のエラーをチェックする.
   ///
@@ -1419,6 +1445,41 @@ namespace gg
 #  define ggFBOError()
 #endif
 
+  ///
+  /// OpenGL のデバッグ出力のメッセージ.
+  ///
+  struct GgDebugMessage
+  {
+    GLenum source;                                    ///< メッセージの発生源 (GL_DEBUG_SOURCE_*).
+    GLenum type;                                      ///< メッセージの種類 (GL_DEBUG_TYPE_*).
+    GLuint id;                                        ///< メッセージの番号.
+    GLenum severity;                                  ///< メッセージの重大度 (GL_DEBUG_SEVERITY_*).
+    std::string message;                              ///< メッセージの本文.
+  };
+
+  ///
+  /// OpenGL のデバッグ出力を受け取っているかどうか調べる.
+  ///
+  /// @return ggInit() でデバッグ出力のコールバック関数を登録できていれば true.
+  ///
+  /// @note
+  /// KHR_debug が使えればエラーや性能の警告はドライバから非同期に通知されるので,
+  /// 毎フレーム glGetError() で問い合わせて描画を同期させる必要はない.
+  ///
+  extern bool ggDebugOutput();
+
+  ///
+  /// OpenGL のデバッグ出力で受け取ったメッセージを取り出す.
+  ///
+  /// @return 直近に受け取ったメッセージ (古いものから順), 保持する数を超えたものは捨てられている.
+  ///
+  extern std::vector<GgDebugMessage> ggGetDebugMessages();
+
+  ///
+  /// OpenGL のデバッグ出力で受け取ったメッセージを消去する.
+  ///
+  extern void ggClearDebugMessages();
+
   ///
   /// 3 要素の外積.
   ///
@@ -1568,7 +1629,10 @@ namespace gg
   ///
   /// 4 要素の単精度実数の配列.
   ///
-  class GgVector : public std::array<GLfloat, 4>
+  /// @note
+  /// SIMD 命令で読み書きできるように 16 バイト境界に置く.
+  ///
+  class alignas(16) GgVector : public std::array<GLfloat, 4>
   {
   public:
 
@@ -2119,7 +2183,10 @@ namespace gg
   ///
   /// 変換行列.
   ///
-  class GgMatrix : public std::array<GLfloat, 16>
+  /// @note
+  /// SIMD 命令で列ごとに読み書きできるように 16 バイト境界に置く.
+  ///
+  class alignas(16) GgMatrix : public std::array<GLfloat, 16>
   {
     // 行列 a とベクトル b の積をベクトル c に格納する
     void projection(GLfloat* c, const GLfloat* a, const GLfloat* b) const;
@@ -3063,6 +3130,15 @@ namespace gg
       projection(c.data(), v.data());
     }
 
+    ///
+    /// ベクトルの配列をまとめて投影変換する.
+    ///
+    /// @param src 元のベクトルの GgVector 型の配列.
+    /// @param dst 変換結果を格納する GgVector 型の配列, src と同じでもよい.
+    /// @param count 変換するベクトルの数.
+    ///
+    void transform(const GgVector* src, GgVector* dst, std::size_t count) const;
+
     ///
     /// ベクトルに対して投影変換を行う.
     ///
@@ -3097,15 +3173,149 @@ namespace gg
     }
   };
 
+  ///
+  /// 変換行列の配列を左から順に乗じる.
+  ///
+  /// @param c 積を格納する GgMatrix 型の変換行列.
+  /// @param m 因子の GgMatrix 型の変換行列の配列, c と重なっていてはいけない.
+  /// @param count 因子の数 (1 以上).
+  ///
+  /// @note
+  /// m[0] * m[1] * … * m[count - 1] と同じ順序で積和を求めるので結果はビット単位で一致するが,
+  /// 途中の積を GgMatrix 型の一時的な変換行列に書き出さずにレジスタに保持したまま次の因子を乗じる.
+  ///
+  extern void ggMultiplyChain(GgMatrix& c, const GgMatrix* m, std::size_t count);
+
+  ///
+  /// 変換行列の積の式.
+  ///
+  /// @note
+  /// 因子の変換行列を値で保持しておき, GgMatrix 型に変換するときに ggMultiplyChain() でまとめて計算する.
+  /// 因子を値で保持しているので, 式を変数に保存して因子の寿命を超えて使ってもよい.
+  ///
+  /// @tparam N 因子の数.
+  ///
+  template <std::size_t N>
+  class GgMatrixProduct
+  {
+    // 因子の変換行列
+    std::array<GgMatrix, N> factor;
+
+  public:
+
+    ///
+    /// コンストラクタ.
+    ///
+    /// @param m 因子の GgMatrix 型の変換行列, 左から順に N 個.
+    ///
+    template <typename... M>
+    explicit GgMatrixProduct(const M&... m) :
+      factor{ { m... } }
+    {
+      static_assert(sizeof...(M) == N, "GgMatrixProduct needs N factors");
+    }
+
+    ///
+    /// コンストラクタ.
+    ///
+    /// @param p 左の N - 1 個の因子の変換行列の積の式.
+    /// @param m 右端の因子の GgMatrix 型の変換行列.
+    ///
+    GgMatrixProduct(const GgMatrixProduct<N - 1>& p, const GgMatrix& m)
+    {
+      std::copy(p.begin(), p.end(), factor.begin());
+      factor[N - 1] = m;
+    }
+
+    ///
+    /// 因子の変換行列の配列の先頭を返す.
+    ///
+    const GgMatrix* begin() const
+    {
+      return factor.data();
+    }
+
+    ///
+    /// 因子の変換行列の配列の末尾の次を返す.
+    ///
+    const GgMatrix* end() const
+    {
+      return factor.data() + N;
+    }
+
+    ///
+    /// 式の右に変換行列を乗じた式を返す.
+    ///
+    /// @param m GgMatrix 型の変換行列.
+    /// @return 右に m を加えた変換行列の積の式.
+    ///
+    GgMatrixProduct<N + 1> operator*(const GgMatrix& m) const
+    {
+      return GgMatrixProduct<N + 1>{ *this, m };
+    }
+
+    ///
+    /// 変換行列の積をベクトルに乗じる.
+    ///
+    /// @param v 元のベクトルの GgVector 型の変数.
+    /// @return 変換結果の GgVector 型のベクトル.
+    ///
+    GgVector operator*(const GgVector& v) const
+    {
+      return evaluate() * v;
+    }
+
+    ///
+    /// 変換行列の積を計算する.
+    ///
+    /// @return 変換行列の積の GgMatrix 型の変換行列.
+    ///
+    GgMatrix evaluate() const
+    {
+      GgMatrix c;
+      ggMultiplyChain(c, factor.data(), N);
+      return c;
+    }
+
+    ///
+    /// 変換行列の積の GgMatrix 型への変換.
+    ///
+    operator GgMatrix() const
+    {
+      return evaluate();
+    }
+  };
+
+  ///
+  /// 変換行列の積の式を返す.
+  ///
+  /// @param m0 左端の GgMatrix 型の変換行列.
+  /// @param m 残りの GgMatrix 型の変換行列.
+  /// @return m0 と m を左から順に乗じる変換行列の積の式.
+  ///
+  /// @note
+  /// ggProduct(a, b, c) を GgMatrix 型に変換すると a * b * c とビット単位で同じ値になる.
+  ///
+  template <typename... M>
+  inline GgMatrixProduct<sizeof...(M) + 1> ggProduct(const GgMatrix& m0, const M&... m)
+  {
+    return GgMatrixProduct<sizeof...(M) + 1>{ m0, m... };
+  }
+
   ///
   /// 単位行列を返す.
   ///
   /// @return 単位行列.
   ///
-  inline GgMatrix ggIdentity()
+  constexpr GgMatrix ggIdentity()
   {
-    GgMatrix t;
-    return t.loadIdentity();
+    return GgMatrix
+    {
+      1.0f, 0.0f, 0.0f, 0.0f,
+      0.0f, 1.0f, 0.0f, 0.0f,
+      0.0f, 0.0f, 1.0f, 0.0f,
+      0.0f, 0.0f, 0.0f, 1.0f
+    };
   };
 
   ///
@@ -6113,6 +6323,193 @@ namespace gg
     }
   };
 
+  ///
+  /// 毎フレーム更新するバッファオブジェクトのリングバッファ.
+  ///
+  /// @note
+  /// バッファオブジェクトを三つの領域に分け, 更新するたびに次の領域に書き込む.
+  /// GPU がまだ読んでいる領域に書き込まないように, 領域を切り替えるときに前の領域にフェンスを置き,
+  /// 領域を再び使うときにそのフェンスを待つ. ARB_buffer_storage が使えればバッファオブジェクトを
+  /// 永続的にマップしたままにし, 使えなければ同期しない glMapBufferRange() でマップする.
+  ///
+  template <typename T>
+  class GgRingBuffer
+  {
+    // 領域の数
+    static constexpr int regions{ 3 };
+
+    // ターゲット
+    const GLenum target;
+
+    // データの数
+    const GLsizei count;
+
+    // バッファオブジェクトのアライメントを考慮した領域の間隔
+    const GLsizeiptr stride;
+
+    // バッファオブジェクト
+    const GLuint buffer;
+
+    // 永続的にマップしたメモリ (永続的にマップしていなければ nullptr)
+    char* memory;
+
+    // 領域ごとのフェンス
+    std::array<GLsync, regions> fences;
+
+    // 今使っている領域の番号
+    int current;
+
+  public:
+
+    ///
+    /// コンストラクタ.
+    ///
+    /// @param target バッファオブジェクトのターゲット.
+    /// @param count 一つの領域に格納するデータの数.
+    ///
+    GgRingBuffer<T>(GLenum target, GLsizei count = 1) :
+      target{ target },
+      count{ count },
+      stride{ ((static_cast<GLsizeiptr>(sizeof(T)) * count - 1) / ggBufferAlignment + 1) * ggBufferAlignment },
+      buffer{ [] { GLuint buffer; glGenBuffers(1, &buffer); return buffer; } () },
+      memory{ nullptr },
+      fences{},
+      current{ 0 }
+    {
+      glBindBuffer(target, buffer);
+
+#if !defined(GL3_PROTOTYPES) && !defined(GL_GLES_PROTOTYPES)
+      // ARB_buffer_storage が使えればメモリを確保して永続的にマップする
+      if (glBufferStorage)
+      {
+        const GLbitfield flags{ GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT };
+        glBufferStorage(target, stride * regions, nullptr, flags);
+        memory = static_cast<char*>(glMapBufferRange(target, 0, stride * regions, flags));
+      }
+#endif
+
+      // 永続的にマップできなければ普通にメモリを確保する
+      if (!memory) glBufferData(target, stride * regions, nullptr, GL_DYNAMIC_DRAW);
+
+      glBindBuffer(target, 0);
+    }
+
+    ///
+    /// コピーコンストラクタは使用しない.
+    ///
+    GgRingBuffer<T>(const GgRingBuffer<T>& buffer) = delete;
+
+    ///
+    /// デストラクタ.
+    ///
+    virtual ~GgRingBuffer<T>()
+    {
+      // フェンスを削除する
+      for (const auto fence : fences) if (fence) glDeleteSync(fence);
+
+      // 永続的にマップしていればアンマップしてからバッファオブジェクトを削除する
+      glBindBuffer(target, buffer);
+      if (memory) glUnmapBuffer(target);
+      glBindBuffer(target, 0);
+      glDeleteBuffers(1, &buffer);
+    }
+
+    ///
+    /// 代入演算子は使用しない.
+    ///
+    GgRingBuffer<T>& operator=(const GgRingBuffer<T>& buffer) = delete;
+
+    ///
+    /// バッファオブジェクト名を取り出す.
+    ///
+    /// @return このバッファオブジェクト名.
+    ///
+    const GLuint& getBuffer() const
+    {
+      return buffer;
+    }
+
+    ///
+    /// 永続的にマップしているかどうか調べる.
+    ///
+    /// @return 永続的にマップしていれば true.
+    ///
+    bool isPersistent() const
+    {
+      return memory != nullptr;
+    }
+
+    ///
+    /// 次の領域に切り替えてマップする.
+    ///
+    /// @return 次の領域の先頭のポインタ.
+    ///
+    /// @note
+    /// それまでに発行した描画命令は前の領域を使っているので, 前の領域にフェンスを置いてから切り替える.
+    /// 次の領域を GPU が使い終えていなければ待つ.
+    ///
+    T* map()
+    {
+      // 前の領域を使う描画命令の後にフェンスを置く
+      if (fences[current]) glDeleteSync(fences[current]);
+      fences[current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+      // 次の領域に切り替える
+      current = (current + 1) % regions;
+
+      // 次の領域を GPU が使い終えるのを待つ
+      if (fences[current])
+      {
+        while (glClientWaitSync(fences[current], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED);
+        glDeleteSync(fences[current]);
+        fences[current] = nullptr;
+      }
+
+      // 永続的にマップしていればその領域のポインタを返す
+      if (memory) return reinterpret_cast<T*>(memory + stride * current);
+
+      // フェンスで同期しているので GPU と同期せずにマップする
+      glBindBuffer(target, buffer);
+      return static_cast<T*>(glMapBufferRange(target, stride * current, sizeof(T) * count,
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+    }
+
+    ///
+    /// マップした領域をアンマップする.
+    ///
+    void unmap() const
+    {
+      // 永続的にマップしていればそのままにする
+      if (memory) return;
+
+      glBindBuffer(target, buffer);
+      glUnmapBuffer(target);
+      glBindBuffer(target, 0);
+    }
+
+    ///
+    /// 次の領域に切り替えてデータを転送する.
+    ///
+    /// @param data 転送元のデータが格納されている領域の先頭のポインタ.
+    ///
+    void send(const T* data)
+    {
+      auto* const destination{ map() };
+      if (destination) std::copy(data, data + count, destination);
+      unmap();
+    }
+
+    ///
+    /// 今使っている領域を結合ポイントに結合する.
+    ///
+    /// @param bindingPoint 結合ポイント.
+    ///
+    void bind(GLuint bindingPoint) const
+    {
+      glBindBufferRange(target, bindingPoint, buffer, stride * current, sizeof(T) * count);
+    }
+  };
+
   ///
   /// 頂点配列クラス.
   ///
@@ -8201,6 +8598,18 @@ namespace gg
     ///
     GgSimpleObj(const std::string& name, bool normalize = false);
 
+    ///
+    /// コンストラクタ.
+    ///
+    /// @param group ggLoadSimpleObj() で読み込んだポリゴングループごとの最初の三角形の番号と三角形数・材質番号.
+    /// @param material ggLoadSimpleObj() で読み込んだポリゴングループごとの材質.
+    /// @param vert ggLoadSimpleObj() で読み込んだ頂点属性.
+    /// @param face ggLoadSimpleObj() で読み込んだ三角形の頂点インデックス.
+    ///
+    GgSimpleObj(const std::vector<std::array<GLuint, 3>>& group,
+      const std::vector<GgSimpleShader::Material>& material,
+      const std::vector<GgVertex>& vert, const std::vector<GLuint>& face);
+
     ///
     /// デストラクタ.
     virtual ~GgSimpleObj()
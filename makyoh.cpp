@@ -15,6 +15,16 @@
 #  define CONFIG_FILE PROJECT_NAME "_config.json"
 #endif
 
+// ベンチマークの仕様ファイル名
+#if !defined(BENCHMARK_FILE)
+#  define BENCHMARK_FILE PROJECT_NAME "_benchmark.json"
+#endif
+
+// 回帰試験の仕様ファイル名
+#if !defined(REGRESSION_FILE)
+#  define REGRESSION_FILE PROJECT_NAME "_regression.json"
+#endif
+
 // 構成データ
 #include "Config.h"
 
@@ -24,6 +34,35 @@
 // 矩形オブジェクト
 #include "Rect.h"
 
+// 鏡の標本点マップ
+#include "MirrorSampleMap.h"
+
+// 段階的詳細化の蓄積バッファ
+#include "ProgressiveBuffer.h"
+
+// 縮小した反射光の描画先
+#include "CausticBuffer.h"
+
+// 反射光の時間方向の再投影バッファ
+#include "TemporalBuffer.h"
+
+// ベンチマーク
+#include "Benchmark.h"
+
+// 回帰試験
+#include "Regression.h"
+
+// 描画するシーン
+#include "Scene.h"
+
+// スレッド間でデータを受け渡す三重バッファ
+#include "TripleBuffer.h"
+
+// 標準ライブラリ
+#include <chrono>
+#include <condition_variable>
+#include <optional>
+
 
 // 鏡の材質のユニフォームバッファオブジェクトの結合ポイント
 constexpr GLuint mirrorMaterialBindingPoint{ 2 };
@@ -31,6 +70,81 @@ constexpr GLuint mirrorMaterialBindingPoint{ 2 };
 // 鏡の標本点のユニフォームバッファオブジェクトの結合ポイント
 constexpr GLuint mirrorSampleBindingPoint{ 3 };
 
+// 鏡のインスタンスのユニフォームバッファオブジェクトの結合ポイント
+constexpr GLuint mirrorInstanceBindingPoint{ 4 };
+
+// フレームごとのパラメータのユニフォームバッファオブジェクトの結合ポイント
+constexpr GLuint frameBindingPoint{ 5 };
+
+//
+// フレームごとのパラメータ (sample.frag と receiver.frag の Frame ブロックと同じ std140 の配置)
+//
+struct Frame
+{
+  // 投影光源の姿勢行列
+  GgMatrix ml;
+
+  // 視点座標系から受光面ごとのモデル座標系への変換行列
+  std::array<GgMatrix, MAX_RECEIVERS> occluder;
+
+  // 受光面ごとの境界ボリューム階層の根の節点の番号と凸なら 1
+  std::array<std::array<GLint, 4>, MAX_RECEIVERS> bvh;
+
+  // 平行光線と点光源の色と強度
+  std::array<GLfloat, 4> illuminant;
+
+  // 高さマップのタイルの設定
+  std::array<GLfloat, 4> tiling;
+
+  // 縮小した反射光と描画先の画素数の比
+  std::array<GLfloat, 2> ratio;
+
+  // 平行光線と点光源の鏡面の微細な粗さを表す指数
+  GLfloat exponent;
+
+  // 投影光源の種類
+  GLint type;
+
+  // 標本点の数と鏡のインスタンスの数
+  GLint samples, mirrors;
+
+  // 最初に使う標本点の番号
+  GLint offset;
+
+  // 高さマップの詳細度の数とタイルで参照するかどうか
+  GLint levels, tiled;
+
+  // 遮蔽を調べるかどうかと受光面の数
+  GLint shadow, occluders;
+
+  // 標本点ひとつが受け持つ鏡の範囲の一辺の長さ (テクスチャ座標), 勾配の分布で反射光を広げなければ 0
+  GLfloat footprint;
+
+  // 分散を見積もる試し描きの標本点の数 (0 なら配分しない) と画素ごとに配分する標本点の数の上限
+  GLint pilot, limit;
+};
+
+//
+// メインスレッドから描画スレッドに渡すフレームごとの入力
+//
+struct Input
+{
+  // メニューの描画データの複製
+  GgApp::MenuData menu;
+
+  // マウス操作によるシーン全体の視点移動
+  GgMatrix mv;
+
+  // フレームバッファの大きさ
+  std::array<GLsizei, 2> size;
+
+  // 反映したウィンドウサイズの変更の要求の番号
+  unsigned int resized;
+
+  // メニューの作成にかかった時間 (ミリ秒)
+  GLfloat menuTime;
+};
+
 //
 // アプリケーション本体
 //
@@ -39,12 +153,45 @@ int GgApp::main(int argc, const char* const* argv)
   // 設定を読み込む
   const Config config{ CONFIG_FILE };
 
+  // --benchmark [仕様ファイル名] が指定されていればベンチマークを実行する
+  // --regression [仕様ファイル名] が指定されていれば回帰試験を実行する
+  // --update-references も指定されていれば回帰試験の参照画像を作り直す
+  std::string benchmarkFile, regressionFile;
+  bool updateReferences{ false };
+  for (int i = 1; i < argc; ++i)
+  {
+    const std::string option{ argv[i] };
+    const auto hasFile{ i + 1 < argc && argv[i + 1][0] != '-' };
+    if (option == "--benchmark") benchmarkFile = hasFile ? argv[i + 1] : BENCHMARK_FILE;
+    else if (option == "--regression") regressionFile = hasFile ? argv[i + 1] : REGRESSION_FILE;
+    else if (option == "--update-references") updateReferences = true;
+  }
+
   // ウィンドウを作成する
   Window window{ PROJECT_NAME, config.getWidth(), config.getHeight() };
 
+  // ベンチマークでは垂直同期を待たない
+  std::unique_ptr<Benchmark> benchmark;
+  if (!benchmarkFile.empty())
+  {
+    benchmark = std::make_unique<Benchmark>(benchmarkFile);
+    glfwSwapInterval(0);
+  }
+
+  // 回帰試験でも垂直同期を待たない
+  std::unique_ptr<Regression> regression;
+  if (!regressionFile.empty() && !benchmark)
+  {
+    regression = std::make_unique<Regression>(regressionFile, updateReferences);
+    glfwSwapInterval(0);
+  }
+
   // メニューを初期化する
   Menu menu{ config };
 
+  // フレームの処理時間の計測
+  auto& timer{ menu.getTimer() };
+
   // 受光面のシェーダ
   const GgSimpleShader receiverShader{ "receiver.vert", "receiver.frag" };
 
@@ -52,31 +199,106 @@ int GgApp::main(int argc, const char* const* argv)
   const auto receiverMirrorMaterialIndex = glGetUniformBlockIndex(receiverShader.get(), "Mirror");
   glUniformBlockBinding(receiverShader.get(), receiverMirrorMaterialIndex, mirrorMaterialBindingPoint);
 
-  // 鏡の標本点のユニフォームバッファオブジェクトの結合ポイントを設定する
-  const auto receiverMirrorSampleIndex = glGetUniformBlockIndex(receiverShader.get(), "Sample");
-  glUniformBlockBinding(receiverShader.get(), receiverMirrorSampleIndex, mirrorSampleBindingPoint);
+  // 鏡のインスタンスのユニフォームバッファオブジェクトの結合ポイントを設定する
+  const auto receiverMirrorInstanceIndex = glGetUniformBlockIndex(receiverShader.get(), "Instance");
+  glUniformBlockBinding(receiverShader.get(), receiverMirrorInstanceIndex, mirrorInstanceBindingPoint);
 
-  // 鏡の標本点数の場所
-  const auto receiverCountLoc{ glGetUniformLocation(receiverShader.get(), "samples") };
+  // フレームごとのパラメータのユニフォームバッファオブジェクトの結合ポイントを設定する
+  const auto receiverFrameIndex = glGetUniformBlockIndex(receiverShader.get(), "Frame");
+  glUniformBlockBinding(receiverShader.get(), receiverFrameIndex, frameBindingPoint);
 
-  // 鏡の高さマップのスケールの場所
-  const auto receiverHeightScaleLoc{ glGetUniformLocation(receiverShader.get(), "scale") };
+  // テクスチャユニットは変わらないのでサンプラはあらかじめ設定しておく
+  glUseProgram(receiverShader.get());
+  glUniform1i(glGetUniformLocation(receiverShader.get(), "color"), 1);
+  glUniform1i(glGetUniformLocation(receiverShader.get(), "positions"), 4);
+  glUniform1i(glGetUniformLocation(receiverShader.get(), "normals"), 5);
+  glUniform1i(glGetUniformLocation(receiverShader.get(), "lights"), 6);
+  glUniform1i(glGetUniformLocation(receiverShader.get(), "diffuses"), 7);
+  glUniform1i(glGetUniformLocation(receiverShader.get(), "reflections"), 8);
+  glUniform1i(glGetUniformLocation(receiverShader.get(), "slopes"), 9);
+  glUniform1i(glGetUniformLocation(receiverShader.get(), "nodes"), 16);
+  glUniform1i(glGetUniformLocation(receiverShader.get(), "triangles"), 17);
+  glUniform1i(glGetUniformLocation(receiverShader.get(), "caustic"), 12);
+  glUniform1i(glGetUniformLocation(receiverShader.get(), "geometry"), 13);
+  glUniform1i(glGetUniformLocation(receiverShader.get(), "estimate"), 20);
+  glUniform1i(glGetUniformLocation(receiverShader.get(), "deviation"), 21);
 
-  // 鏡の高さマップのテクスチャのサンプラの場所
-  const auto receiverHeightLoc{ glGetUniformLocation(receiverShader.get(), "height") };
+  // 描画している受光面の番号の場所
+  const auto receiverSelfLoc{ glGetUniformLocation(receiverShader.get(), "self") };
 
-  // 投影光源マップのテクスチャのサンプラの場所
-  const auto receiverColorLoc{ glGetUniformLocation(receiverShader.get(), "color") };
+  // 縮小した反射光の描画パスの場所
+  const auto receiverPassLoc{ glGetUniformLocation(receiverShader.get(), "pass") };
 
-  // 鏡の姿勢行列の場所
-  const auto receiverMmLoc{ glGetUniformLocation(receiverShader.get(), "mm") };
+  // 縮小した反射光の描画先
+  CausticBuffer causticBuffer;
 
-  // 投影光源の姿勢行列の場所
-  const auto receiverMlLoc{ glGetUniformLocation(receiverShader.get(), "ml") };
+  // 反射光の試し描きの描画先 (標準偏差と受光面のある画素かどうかを描いてミップマップでタイルの平均を求める)
+  CausticBuffer varianceBuffer{ { GL_RGBA16F, GL_RG16F }, true };
+
+  // 鏡の標本点マップ
+  const MirrorSampleMap sampleMap{ MAX_MIRROR_SAMPLES, MAX_MIRRORS };
+
+  // 鏡の標本点マップのシェーダ
+  const GgSimpleShader sampleShader{ "sample.vert", "sample.frag" };
+
+  // 鏡の材質のユニフォームバッファオブジェクトの結合ポイントを設定する
+  const auto sampleMirrorMaterialIndex = glGetUniformBlockIndex(sampleShader.get(), "Mirror");
+  glUniformBlockBinding(sampleShader.get(), sampleMirrorMaterialIndex, mirrorMaterialBindingPoint);
+
+  // 鏡の標本点と鏡のインスタンスのユニフォームバッファオブジェクトの結合ポイントを設定する
+  const auto sampleMirrorSampleIndex = glGetUniformBlockIndex(sampleShader.get(), "Sample");
+  glUniformBlockBinding(sampleShader.get(), sampleMirrorSampleIndex, mirrorSampleBindingPoint);
+  const auto sampleMirrorInstanceIndex = glGetUniformBlockIndex(sampleShader.get(), "Instance");
+  glUniformBlockBinding(sampleShader.get(), sampleMirrorInstanceIndex, mirrorInstanceBindingPoint);
+
+  // フレームごとのパラメータのユニフォームバッファオブジェクトの結合ポイントを設定する
+  const auto sampleFrameIndex = glGetUniformBlockIndex(sampleShader.get(), "Frame");
+  glUniformBlockBinding(sampleShader.get(), sampleFrameIndex, frameBindingPoint);
+
+  // 鏡の高さマップのテクスチャ配列とタイルのサンプラをあらかじめ設定しておく
+  glUseProgram(sampleShader.get());
+  glUniform1i(glGetUniformLocation(sampleShader.get(), "height"), 0);
+  glUniform1i(glGetUniformLocation(sampleShader.get(), "pages"), 2);
+  glUniform1i(glGetUniformLocation(sampleShader.get(), "atlas"), 3);
+  glUniform1i(glGetUniformLocation(sampleShader.get(), "gradients"), 18);
+  glUniform1i(glGetUniformLocation(sampleShader.get(), "products"), 19);
+  glUseProgram(0);
+
+  // フレームごとのパラメータのリングバッファ
+  GgRingBuffer<Frame> frameBuffer{ GL_UNIFORM_BUFFER };
 
   // 鏡の矩形のオブジェクト
   const Rect mirror;
 
+  // 段階的詳細化の蓄積バッファ
+  ProgressiveBuffer progressive;
+
+  // 描画したフレームを蓄積するシェーダ
+  const GgShader accumulateShader{ "sample.vert", "accumulate.frag" };
+
+  // 描画したフレームのテクスチャのサンプラの場所
+  const auto accumulateImageLoc{ glGetUniformLocation(accumulateShader.get(), "image") };
+
+  // 反射光の時間方向の再投影バッファ
+  TemporalBuffer temporal;
+
+  // 前のフレームの反射光を再投影して混ぜるシェーダ
+  const GgShader temporalShader{ "sample.vert", "temporal.frag" };
+
+  // このフレームの反射光と前のフレームの履歴のテクスチャは決まったテクスチャユニットに結合する
+  glUseProgram(temporalShader.get());
+  glUniform1i(glGetUniformLocation(temporalShader.get(), "caustic"), 12);
+  glUniform1i(glGetUniformLocation(temporalShader.get(), "geometry"), 13);
+  glUniform1i(glGetUniformLocation(temporalShader.get(), "history"), 14);
+  glUniform1i(glGetUniformLocation(temporalShader.get(), "previous"), 15);
+  glUseProgram(0);
+
+  // 再投影の設定の場所
+  const auto temporalValidLoc{ glGetUniformLocation(temporalShader.get(), "valid") };
+  const auto temporalMpLoc{ glGetUniformLocation(temporalShader.get(), "mp") };
+  const auto temporalReprojectionLoc{ glGetUniformLocation(temporalShader.get(), "reprojection") };
+  const auto temporalFramesLoc{ glGetUniformLocation(temporalShader.get(), "frames") };
+
   // 鏡のシェーダ
   const GgSimpleShader mirrorShader{ "mirror.vert", "mirror.frag" };
 
@@ -87,7 +309,10 @@ int GgApp::main(int argc, const char* const* argv)
   // 鏡の高さマップのスケールの場所
   const auto mirrorHeightScaleLoc{ glGetUniformLocation(mirrorShader.get(), "scale") };
 
-  // 鏡の高さマップのテクスチャのサンプラの場所
+  // 鏡の高さマップのレイヤ番号の場所
+  const auto mirrorLayerLoc{ glGetUniformLocation(mirrorShader.get(), "layer") };
+
+  // 鏡の高さマップのテクスチャ配列のサンプラの場所
   const auto mirrorHeightLoc{ glGetUniformLocation(mirrorShader.get(), "height") };
 
   // 投影光源マップのテクスチャのサンプラの場所
@@ -96,8 +321,34 @@ int GgApp::main(int argc, const char* const* argv)
   // 投影光源の姿勢行列の場所
   const auto mirrorMlLoc{ glGetUniformLocation(mirrorShader.get(), "ml") };
 
-  // 第３者視点の視線方向
-  const auto eyePose{ ggLookat(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f) };
+  // 投影光源の種類と粗さの指数と色の場所
+  const auto mirrorTypeLoc{ glGetUniformLocation(mirrorShader.get(), "type") };
+  const auto mirrorExponentLoc{ glGetUniformLocation(mirrorShader.get(), "exponent") };
+  const auto mirrorIlluminantLoc{ glGetUniformLocation(mirrorShader.get(), "illuminant") };
+
+  // 鏡の高さマップのタイルの設定の場所
+  const auto mirrorTiledLoc{ glGetUniformLocation(mirrorShader.get(), "tiled") };
+  const auto mirrorPagesLoc{ glGetUniformLocation(mirrorShader.get(), "pages") };
+  const auto mirrorAtlasLoc{ glGetUniformLocation(mirrorShader.get(), "atlas") };
+  const auto mirrorTilingLoc{ glGetUniformLocation(mirrorShader.get(), "tiling") };
+  const auto mirrorLevelsLoc{ glGetUniformLocation(mirrorShader.get(), "levels") };
+
+  // 鏡の高さマップのタイルのフィードバックのシェーダ
+  const GgSimpleShader feedbackShader{ "mirror.vert", "feedback.frag" };
+
+  // フィードバックのタイルの設定の場所
+  const auto feedbackTilingLoc{ glGetUniformLocation(feedbackShader.get(), "tiling") };
+  const auto feedbackLevelsLoc{ glGetUniformLocation(feedbackShader.get(), "levels") };
+  const auto feedbackBiasLoc{ glGetUniformLocation(feedbackShader.get(), "bias") };
+
+  // 第３者視点の視線方向 (原点から z 軸の正の方向を見る ggLookat() の結果, y 軸中心に 180 度回転)
+  constexpr GgMatrix eyePose
+  {
+    -1.0f, 0.0f,  0.0f, 0.0f,
+     0.0f, 1.0f,  0.0f, 0.0f,
+     0.0f, 0.0f, -1.0f, 0.0f,
+     0.0f, 0.0f,  0.0f, 1.0f
+  };
 
   // 背景色を設定する
   glClearColor(0.1f, 0.2f, 0.3f, 0.0f);
@@ -106,68 +357,522 @@ int GgApp::main(int argc, const char* const* argv)
   glEnable(GL_DEPTH_TEST);
   glEnable(GL_CULL_FACE);
 
-  // ウィンドウが開いている間繰り返す
-  while (window)
+  // メインスレッドから描画スレッドに渡すフレームごとの入力
+  TripleBuffer<Input> inputs;
+
+  // 描画スレッドを止めるとき true
+  std::atomic<bool> stop{ false };
+
+  // 描画を止めている描画スレッドを新しい入力で起こす
+  std::mutex idleMutex;
+  std::condition_variable idleCondition;
+
+  // 描画スレッドからメインスレッドへのウィンドウサイズの変更の要求と要求の番号
+  std::mutex resizeMutex;
+  std::optional<std::array<GLsizei, 2>> resizeRequest;
+  unsigned int resizeSerial{ 0 };
+
+  // 描画スレッドでフレームを描画する
+  const auto render{ [&]() -> int
   {
-    // ウィンドウを消去する
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    // 描画を止めて新しい入力を待つとき true (最初の入力が来るまでは待つ)
+    bool idle{ true };
 
-    // メニューを表示する
-    menu.draw();
+    // 前に描画したフレームで描画を止めていれば true
+    bool rested{ false };
 
-    // 鏡の高さマップを読み込む
-    const auto height{ menu.getHeightMap() };
+    // 反映を待っているウィンドウサイズの変更の要求の番号
+    unsigned int requested{ 0 };
 
-    // 投影光源マップを読み込む
-    const auto color{ menu.getIlluminantMap() };
+    // ベンチマークや回帰試験の組み合わせの条件を設定したら true
+    bool prepared{ false };
 
-    // マウス操作によるシーン全体の視点移動
-    const auto& mv{ window.getTranslationMatrix(1) * window.getRotationMatrix(0) };
+    // ウィンドウサイズの変更をメインスレッドに要求する
+    const auto requestResize{ [&](const std::array<GLsizei, 2>& size)
+    {
+      std::lock_guard<std::mutex> lock{ resizeMutex };
+      resizeRequest = size;
+      requested = ++resizeSerial;
+      window.postRedraw();
+    } };
+
+    // 描画スレッドを止めるまで繰り返す
+    while (!stop)
+    {
+      // 描画を止めているなら新しい入力が来るまで待つ
+      if (idle)
+      {
+        std::unique_lock<std::mutex> lock{ idleMutex };
+        idleCondition.wait(lock, [&]() { return stop || inputs.isFresh(); });
+        if (stop) break;
+      }
+
+      // 新しい入力があれば受け取る
+      const auto fresh{ inputs.acquire() };
+      auto& input{ inputs.getFront() };
+
+      // ベンチマークや回帰試験の組み合わせが替わったら一度だけ条件を設定する
+      if (!prepared)
+      {
+        // ベンチマークで計測する組み合わせの条件を設定する
+        while (benchmark && *benchmark && benchmark->isStarting())
+        {
+          const auto& c{ benchmark->getCase() };
+          requestResize(c.resolution);
+          if (menu.setBenchmark(c.heightMap, c.samples, c.mode)) break;
+          benchmark->skip("cannot load the height map");
+        }
+
+        // 回帰試験で試験する組み合わせの条件を設定する
+        while (regression && *regression && regression->isStarting())
+        {
+          const auto& c{ regression->getCase() };
+          requestResize(regression->getResolution());
+          if (menu.setRegression(c.heightMap, c.receiver, c.orientation, c.illuminantMap, regression->getSamples())) break;
+          regression->skip("cannot load the scene");
+        }
+
+        prepared = true;
+      }
+
+      // 要求したウィンドウサイズの変更がまだ反映されていなければ反映した入力を待つ
+      const auto& size{ input.size };
+      idle = input.resized != requested;
+      if (idle) continue;
+
+      // 最小化していれば次の入力を待つ
+      idle = size[0] <= 0 || size[1] <= 0;
+      if (idle) continue;
+
+      // メインスレッドから受け取ったコマンドを実行してこのフレームで描画するシーンを複製する
+      const Scene scene{ menu.apply() };
+
+      // メニューの作成にかかった時間はメインスレッドで計測したものを使う
+      if (fresh) timer.set(FrameTimer::MENU, input.menuTime);
+
+      // ビューポートをフレームバッファ全体にする
+      const auto restoreViewport{ [&]() { glViewport(0, 0, size[0], size[1]); } };
+      restoreViewport();
+
+      // ウィンドウを消去する
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+      // 鏡の高さマップのテクスチャ配列を読み込む
+      const auto height{ scene.getHeightMap() };
+
+      // 投影光源マップを読み込む
+      const auto color{ scene.getIlluminantMap() };
+
+      // タイル化した鏡の高さマップを取り出す
+      auto* const tiled{ scene.getTiledHeightMap() };
+
+      // タイル化した鏡の高さマップの構成
+      const auto tiling{ tiled ? tiled->getTiling() : std::array<GLfloat, 4>{} };
+      const auto levels{ tiled ? tiled->getLevels() : 0 };
+
+      // マウス操作かベンチマークの経路によるシーン全体の視点移動
+      const auto& mv{ benchmark ? benchmark->getModelView() : regression ? ggIdentity() : input.mv };
+
+      // 投影変換行列を設定する
+      const GgMatrix&& mp{ ggPerspective(0.5f,
+        static_cast<GLfloat>(size[0]) / static_cast<GLfloat>(size[1]), 1.0f, 15.0f) };
+
+      // 鏡の材質を設定する
+      scene.bindMirrorMaterial(mirrorMaterialBindingPoint);
+
+      // 鏡の高さマップのテクスチャ配列を設定する
+      glActiveTexture(GL_TEXTURE0);
+      glBindTexture(GL_TEXTURE_2D_ARRAY, height);
+
+      // 鏡の高さマップの勾配の 1 次と 2 次のモーメントのテクスチャ配列を設定する
+      glActiveTexture(GL_TEXTURE18);
+      glBindTexture(GL_TEXTURE_2D_ARRAY, scene.getMomentMap(1));
+      glActiveTexture(GL_TEXTURE19);
+      glBindTexture(GL_TEXTURE_2D_ARRAY, scene.getMomentMap(2));
+
+      // タイル化した鏡の高さマップのタイルキャッシュを設定する
+      glActiveTexture(GL_TEXTURE3);
+      glBindTexture(GL_TEXTURE_2D, tiled ? tiled->getAtlas() : 0);
+
+      // 鏡の高さマップのページテーブルを設定する
+      glActiveTexture(GL_TEXTURE2);
+      glBindTexture(GL_TEXTURE_2D, tiled ? tiled->getPageTable() : 0);
+
+      // 投影光源マップを設定する
+      glActiveTexture(GL_TEXTURE1);
+      glBindTexture(GL_TEXTURE_2D, color);
+
+      // 段階的に詳細化しているとき true
+      auto refining{ false };
+
+      // 描画
+      if (scene.getDrawMode() == Menu::DRAW_MIRROR)
+      {
+        timer.begin(FrameTimer::MIRROR);
+
+        // タイル化した高さマップなら鏡の描画に必要なタイルを求める (鏡はひとつ)
+        if (tiled)
+        {
+          const auto mirrorView{ scene.getReceiverView() * scene.getMirrorPose(0) };
+          tiled->beginFeedback(size[0], size[1]);
+          feedbackShader.use(mp, mirrorView, scene.getLight());
+          glUniform4fv(feedbackTilingLoc, 1, tiling.data());
+          glUniform1i(feedbackLevelsLoc, levels);
+          glUniform1f(feedbackBiasLoc, TiledHeightMap::getFeedbackBias());
+          mirror.draw();
+          tiled->endFeedback();
+          restoreViewport();
+        }
+
+        // 鏡だけを描画する
+        for (GLsizei i = 0; i < scene.getMirrorCount(); ++i)
+        {
+          mirrorShader.use(mp, scene.getReceiverView() * scene.getMirrorPose(i), scene.getLight());
+          glUniform1f(mirrorHeightScaleLoc, scene.getMirrorHeightScale(i));
+          glUniform1f(mirrorLayerLoc, static_cast<GLfloat>(i));
+          glUniform1i(mirrorHeightLoc, 0);
+          glUniform1i(mirrorColorLoc, 1);
+          glUniform1i(mirrorTiledLoc, tiled != nullptr);
+          glUniform1i(mirrorPagesLoc, 2);
+          glUniform1i(mirrorAtlasLoc, 3);
+          glUniform4fv(mirrorTilingLoc, 1, tiling.data());
+          glUniform1i(mirrorLevelsLoc, levels);
+          glUniformMatrix4fv(mirrorMlLoc, 1, GL_FALSE, scene.getIlluminantPose().get());
+          glUniform1i(mirrorTypeLoc, scene.getIlluminantType());
+          glUniform1f(mirrorExponentLoc, scene.getIlluminantExponent());
+          glUniform4fv(mirrorIlluminantLoc, 1, scene.getIlluminantColor().data());
+          mirror.draw();
+        }
+
+        timer.end(FrameTimer::MIRROR);
+      }
+      else if (scene.getDrawMode() == Menu::DRAW_RECEIVER)
+      {
+        // 鏡の標本点を設定する
+        scene.bindMirrorSample(mirrorSampleBindingPoint);
+
+        // 受光面を照らす可能性のある鏡のインスタンスを設定する
+        const auto instances{ scene.setMirrorInstance(eyePose, mv) };
+        scene.bindMirrorInstance(mirrorInstanceBindingPoint);
+
+        // シーンが前のフレームから変化していないか調べる
+        const auto still{ progressive.validate(size[0], size[1], mv, scene.getRevision()) };
+
+        // シーンが静止していれば標本点を替えながら結果を蓄積する
+        refining = scene.getProgressiveRefinement() && still;
+
+        // 詳細化していない間は前のフレームの反射光を再投影して新しい標本点の反射光と混ぜる
+        const auto reprojecting{ scene.getTemporalReprojection() && !refining };
+
+        // このフレームで最初に使う標本点の番号
+        const auto offset{ refining ? progressive.getOffset() : reprojecting ? temporal.getOffset() : 0 };
+
+        // すべての標本点を使い終えていれば蓄積した画像を表示するだけにする
+        if (refining && progressive.isComplete(MAX_MIRROR_SAMPLES))
+        {
+          progressive.draw();
+        }
+        else
+        {
+          // 反射光の描画先の縮小率の逆数と縮小した描画先の画素数
+          const auto scale{ scene.getCausticScale(still) };
+          const auto causticWidth{ (size[0] + scale - 1) / scale };
+          const auto causticHeight{ (size[1] + scale - 1) / scale };
+
+          // 遮蔽を調べるかどうか
+          const auto shadow{ scene.getReceiverShadow() };
+
+          // 詳細化していなければ試し描きした反射光の分散に合わせて画素ごとに標本点を配分する
+          const auto pilot{ refining ? 0 : scene.getVariancePilot() };
+
+          // 標本点マップに用意する標本点の数
+          const auto limit{ pilot > 0 ? scene.getVarianceLimit() : scene.getMirrorSampleCount() };
+
+          // このフレームのパラメータをリングバッファの空いている領域に書き込む
+          auto* const frame{ frameBuffer.map() };
+          frame->ml = ggProduct(eyePose, scene.getIlluminantPose(), mv);
+          frame->bvh = {};
+          if (shadow)
+          {
+            // 視点座標系から受光面ごとのモデル座標系への変換行列を求める
+            for (GLsizei i = 0; i < scene.getReceiverCount(); ++i)
+            {
+              frame->occluder[i] = ggProduct(eyePose, scene.getReceiverPose(i), mv).evaluate().invert();
+              frame->bvh[i] = { scene.getOccluder()[i][0], scene.getOccluder()[i][1], 0, 0 };
+            }
+          }
+          frame->illuminant = scene.getIlluminantColor();
+          frame->tiling = tiling;
+          frame->ratio =
+          {
+            static_cast<GLfloat>(causticWidth) / static_cast<GLfloat>(size[0]),
+            static_cast<GLfloat>(causticHeight) / static_cast<GLfloat>(size[1])
+          };
+          frame->exponent = scene.getIlluminantExponent();
+          frame->type = scene.getIlluminantType();
+          frame->samples = scene.getMirrorSampleCount();
+          frame->mirrors = instances;
+          frame->offset = offset;
+          frame->levels = levels;
+          frame->tiled = tiled != nullptr;
+          frame->shadow = shadow;
+          frame->occluders = scene.getReceiverCount();
+
+          // ひとつの画素に蓄積される標本点の数で鏡の円の面積 (テクスチャ座標で π / 4) を分け合う
+          const auto accumulated{ refining ? MAX_MIRROR_SAMPLES : reprojecting
+            ? std::min(scene.getMirrorSampleCount() * scene.getTemporalFrames(), MAX_MIRROR_SAMPLES)
+            : scene.getMirrorSampleCount() };
+          frame->footprint = scene.getMomentMap(1) ? std::sqrt(0.785398163f / accumulated) : 0.0f;
+          frame->pilot = pilot;
+          frame->limit = limit;
+          frameBuffer.unmap();
+          frameBuffer.bind(frameBindingPoint);
+
+          // 鏡の標本点ごとの受光面によらないデータをすべての受光面に先立って一度だけ求める
+          if (instances > 0)
+          {
+            timer.begin(FrameTimer::SAMPLE);
+            sampleMap.begin(limit, instances);
+            sampleShader.use(mp, eyePose * mv, scene.getLight());
+            mirror.draw();
+            sampleMap.end();
+            restoreViewport();
+            timer.end(FrameTimer::SAMPLE);
+          }
+
+          // 鏡の標本点マップを設定する
+          sampleMap.bind(4);
+
+          // 遮蔽を調べるなら受光面の境界ボリューム階層を設定する
+          if (shadow) scene.bindOccluder(16);
+
+          // すべての受光面を描画する
+          const auto drawReceivers{ [&](int pass)
+          {
+            for (GLsizei i = 0; i < scene.getReceiverCount(); ++i)
+            {
+              receiverShader.use(mp, ggProduct(eyePose, scene.getReceiverPose(i), mv), scene.getLight());
+              glUniform1i(receiverSelfLoc, i);
+              glUniform1i(receiverPassLoc, pass);
+              scene.drawReceiver(i);
+            }
+          } };
+
+          // 分散に合わせて配分するなら反射光を描く解像度で試し描きする
+          if (pilot > 0)
+          {
+            timer.begin(FrameTimer::PILOT);
+            varianceBuffer.begin(causticWidth, causticHeight);
+            drawReceivers(3);
+            varianceBuffer.end();
+            varianceBuffer.bind(20);
+            restoreViewport();
+            timer.end(FrameTimer::PILOT);
+          }
+
+          // 縮小するか再投影するなら投影光源による反射光を別の描画先に描く
+          const auto separate{ scale > 1 || reprojecting };
+          if (separate)
+          {
+            timer.begin(FrameTimer::CAUSTIC);
+            causticBuffer.begin(causticWidth, causticHeight);
+            drawReceivers(1);
+            causticBuffer.end();
+            causticBuffer.bind(12);
+
+            // 前のフレームまでの反射光を再投影して混ぜたものを拡大に使う
+            if (reprojecting)
+            {
+              const auto view{ eyePose * mv };
+              const auto valid{ temporal.validate(causticWidth, causticHeight, scene.getRevision()) };
+              temporal.begin(14);
+              temporalShader.use();
+              glUniform1i(temporalValidLoc, valid);
+              glUniformMatrix4fv(temporalMpLoc, 1, GL_FALSE, mp.get());
+              glUniformMatrix4fv(temporalReprojectionLoc, 1, GL_FALSE, temporal.getReprojection(view).get());
+              glUniform1f(temporalFramesLoc, static_cast<GLfloat>(scene.getTemporalFrames()));
+              mirror.draw();
+              temporal.end(view, scene.getMirrorSampleCount(), MAX_MIRROR_SAMPLES);
+              temporal.bind(12);
+            }
+
+            restoreViewport();
+            timer.end(FrameTimer::CAUSTIC);
+          }
+
+          // 別に描いた反射光を拡大して全体光源による陰影と合成するか, すべてを元の解像度で描く
+          timer.begin(FrameTimer::RECEIVER);
+          if (refining) progressive.begin();
+          drawReceivers(separate ? 2 : 0);
+
+          // 段階的に詳細化しているなら描画したフレームを蓄積して表示する
+          if (refining)
+          {
+            progressive.accumulate(11);
+            accumulateShader.use();
+            glUniform1i(accumulateImageLoc, 11);
+            mirror.draw();
+            progressive.end(scene.getMirrorSampleCount());
+            progressive.draw();
+          }
+          timer.end(FrameTimer::RECEIVER);
+
+          // 標本点マップの描画に必要なタイルを要求する
+          scene.requestMirrorTiles(offset, limit);
+        }
+      }
+
+      // 要求されたタイルを読み込む
+      if (tiled) tiled->update();
+
+      // 回帰試験では詳細化が終わってメニューを描く前のカラーバッファを参照画像と比べる
+      if (regression)
+      {
+        const auto converged{ refining && progressive.isComplete(MAX_MIRROR_SAMPLES)
+          && !scene.isLoading() && !(tiled && tiled->isLoading()) };
+        regression->record(converged, size[0], size[1]);
+        prepared = false;
+      }
+
+      // 必要なときだけ描画するなら, 詳細化の途中やタイルや資源の読み込み中でなければ新しい入力が来るまで描画を止める
+      const auto rest{ scene.getOnDemandRendering() && !benchmark && !regression
+        && !(refining && !progressive.isComplete(MAX_MIRROR_SAMPLES))
+        && !(tiled && tiled->isLoading()) && !scene.isLoading() };
+
+      // 描画を続けるときや止めるときはメインスレッドにも次のフレームのメニューを作らせる
+      if (!rest || !rested) window.postRedraw();
+      idle = rested = rest;
+
+      // メニューを描画する
+      timer.begin(FrameTimer::IMGUI);
+      window.drawMenu(input.menu);
+      timer.end(FrameTimer::IMGUI);
+
+      // カラーバッファを入れ替える
+      timer.begin(FrameTimer::SWAP);
+      window.swapBuffers(false);
+      timer.end(FrameTimer::SWAP);
+
+      // ベンチマークではフレームの処理時間に描画の完了までを含める
+      if (benchmark) glFinish();
+
+      // このフレームの計測を終える
+      menu.updateTimer();
+
+      // ベンチマークの計測結果を記録してすべての組み合わせを計測し終えたら書き出して終了する
+      if (benchmark)
+      {
+        benchmark->record(timer, size[0], size[1]);
+        prepared = false;
+        if (*benchmark) continue;
+        if (!benchmark->write()) throw std::runtime_error("Can't write the benchmark result: " + benchmark->getOutput());
+        break;
+      }
+
+      // 回帰試験ですべての組み合わせを試験し終えたら結果を書き出して終了する
+      if (regression && !*regression)
+      {
+        if (!regression->write()) throw std::runtime_error("Can't write the regression result: " + regression->getOutput());
+        return regression->passed() ? 0 : 1;
+      }
+
+      // 段階的に詳細化していなければ描画時間に合わせて標本点数を調整する
+      if (!refining) menu.adaptMirrorSampleCount();
+    }
 
-    // 投影変換行列を設定する
-    const GgMatrix&& mp{ ggPerspective(0.5f, window.getAspect(), 1.0f, 15.0f) };
+    return 0;
+  } };
 
-    // 鏡の材質を設定する
-    menu.bindMirrorMaterial(mirrorMaterialBindingPoint);
+  // OpenGL のコンテキストを描画スレッドに渡す
+  window.releaseContext();
 
-    // 鏡の高さマップを設定する
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, height);
+  // 描画スレッドを起動する
+  auto renderer{ std::async(std::launch::async, [&]()
+  {
+    // 描画を終えたらコンテキストを外してメインスレッドのループを終わらせる
+    const auto finish{ [&]()
+    {
+      glfwMakeContextCurrent(nullptr);
+      window.setClose();
+      glfwPostEmptyEvent();
+    } };
 
-    // 投影光源マップを設定する
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, color);
+    // 描画スレッドで OpenGL のコンテキストを使う
+    window.makeContextCurrent();
 
-    // 描画
-    if (menu.getDrawMode() == Menu::DRAW_MIRROR)
+    try
+    {
+      const auto status{ render() };
+      finish();
+      return status;
+    }
+    catch (...)
     {
-      // 鏡だけを描画する
-      mirrorShader.use(mp, menu.getReceiverView() * menu.getMirrorPose(), menu.getLight());
-      glUniform1f(mirrorHeightScaleLoc, menu.getMirrorHeightScale());
-      glUniform1i(mirrorHeightLoc, 0);
-      glUniform1i(mirrorColorLoc, 1);
-      glUniformMatrix4fv(mirrorMlLoc, 1, GL_FALSE, menu.getIlluminantPose().get());
-      mirror.draw();
+      finish();
+      throw;
     }
-    else if (menu.getDrawMode() == Menu::DRAW_RECEIVER)
+  }) };
+
+  // 描画スレッドを止めてコンテキストをメインスレッドに戻す
+  const auto join{ [&]()
+  {
+    stop = true;
     {
-      // 鏡の標本点を設定する
-      menu.bindMirrorSample(mirrorSampleBindingPoint);
-
-      // 受光面だけを描画する
-      receiverShader.use(mp, eyePose * menu.getReceiverPose() * mv, menu.getLight());
-      glUniform1i(receiverCountLoc, menu.getMirrorSampleCount());
-      glUniform1f(receiverHeightScaleLoc, menu.getMirrorHeightScale());
-      glUniform1i(receiverHeightLoc, 0);
-      glUniform1i(receiverColorLoc, 1);
-      glUniformMatrix4fv(receiverMmLoc, 1, GL_FALSE, (eyePose * menu.getMirrorPose() * mv).get());
-      glUniformMatrix4fv(receiverMlLoc, 1, GL_FALSE, (eyePose * menu.getIlluminantPose() * mv).get());
-      menu.getReceiverModel().draw();
+      std::lock_guard<std::mutex> lock{ idleMutex };
     }
+    idleCondition.notify_one();
+    renderer.wait();
+    window.makeContextCurrent();
+  } };
+
+  // 入力が無い間はイベントを待ち, 描画スレッドが描画を続けるときは requestRedraw() で起こされる
+  window.setWaitTimeout(0.5);
 
-    // カラーバッファを入れ替えてイベントを取り出す
-    window.swapBuffers();
+  try
+  {
+    // ウィンドウが開いている間繰り返す
+    while (window)
+    {
+      // 描画スレッドから要求されたウィンドウサイズに変更する
+      std::optional<std::array<GLsizei, 2>> resize;
+      unsigned int serial;
+      {
+        std::lock_guard<std::mutex> lock{ resizeMutex };
+        resize.swap(resizeRequest);
+        serial = resizeSerial;
+      }
+      if (resize) glfwSetWindowSize(window.get(), (*resize)[0], (*resize)[1]);
+
+      // メニューを作る
+      const auto start{ std::chrono::steady_clock::now() };
+      menu.draw();
+      auto& input{ inputs.getBack() };
+      input.menuTime = std::chrono::duration<GLfloat, std::milli>(std::chrono::steady_clock::now() - start).count();
+      window.renderMenu(input.menu);
+
+      // マウス操作によるシーン全体の視点移動とフレームバッファの大きさ
+      input.mv = window.getTranslationMatrix(1) * window.getRotationMatrix(0);
+      input.size = window.getFboSize();
+      input.resized = serial;
+
+      // メニューの操作中は入力が無くても次のフレームを作る
+      if (ImGui::IsAnyItemActive()) window.requestRedraw();
+
+      // 描画スレッドに入力を渡して起こす
+      inputs.publish();
+      {
+        std::lock_guard<std::mutex> lock{ idleMutex };
+      }
+      idleCondition.notify_one();
+    }
+  }
+  catch (...)
+  {
+    join();
+    throw;
   }
 
-  return 0;
+  // 描画スレッドの終了を待って描画スレッドの例外か終了コードを返す
+  join();
+  return renderer.get();
 }
@@ -0,0 +1,580 @@
+﻿///
+/// 資源の読み込みと数学関数のマイクロベンチマーク
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 18, 2026
+///
+/// @note
+/// makyoh_bench [結果のファイル名] で実行すると, OBJ ファイルと画像ファイルの読み込み,
+/// 法線マップの作成, 構成ファイルの読み込み, 変換行列と四元数の演算の処理時間を計測して JSON ファイルに書き出す.
+/// 素材のファイルを相対パスで開くので, 素材のあるディレクトリで実行する.
+///
+/// makyoh_bench --dump-math [ファイル名] は乱数で作った入力に対する変換行列と四元数の演算と法線マップの作成の結果を
+/// ファイルに書き出し, makyoh_bench --check-math [ファイル名] はそれを自分の演算結果とビット単位で比べる.
+/// GG_NO_SIMD を定義したスカラ演算の実行ファイルで書き出した結果を SIMD 命令を使う実行ファイルで比べれば,
+/// SIMD 命令による演算がスカラ演算と同じ結果になることを確かめられる. 一致しなければ終了コードは 1 になる.
+///
+
+// 構成データ
+#include "Config.h"
+
+// 画像の読み込みライブラリ
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_NO_FAILURE_STRINGS
+#include "stb_image.h"
+
+// 標準ライブラリ
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+// 結果のファイル名
+#if !defined(BENCH_RESULT_FILE)
+#  define BENCH_RESULT_FILE "makyoh_bench_result.json"
+#endif
+
+// 演算結果のファイル名
+#if !defined(BENCH_MATH_FILE)
+#  define BENCH_MATH_FILE "makyoh_bench_math.bin"
+#endif
+
+// 計測する最小の回数と最小の時間 (秒) と最大の回数
+constexpr std::size_t minIterations{ 3 };
+constexpr double minSeconds{ 0.5 };
+constexpr std::size_t maxIterations{ 1000 };
+
+// 最適化で計算が消されないように結果を書き込む先
+static volatile float sink;
+
+//
+// 計測結果
+//
+struct Result
+{
+  // 計測した処理の分類と名前
+  std::string group, name;
+
+  // 画像の一辺の画素数や三角形数などの計測の条件
+  double parameter;
+
+  // 計測した回数
+  std::size_t iterations;
+
+  // 1 回の処理時間の中央値と最小値と平均値 (ミリ秒)
+  double median, minimum, mean;
+};
+
+//
+// 処理時間を計測する
+//
+//   group 計測する処理の分類
+//   name 計測する処理の名前
+//   parameter 計測の条件
+//   batch func() を 1 回呼び出したときに処理を繰り返す回数
+//   func 計測する処理
+//
+template <typename Func>
+static Result measure(const std::string& group, const std::string& name, double parameter, std::size_t batch, Func&& func)
+{
+  using clock = std::chrono::steady_clock;
+
+  // 最初の 1 回はキャッシュやメモリの確保の影響を受けるので捨てる
+  func();
+
+  // 最小の回数と最小の時間の両方を満たすまで繰り返す
+  std::vector<double> times;
+  const auto start{ clock::now() };
+  while (times.size() < minIterations
+    || (times.size() < maxIterations && std::chrono::duration<double>(clock::now() - start).count() < minSeconds))
+  {
+    const auto begin{ clock::now() };
+    func();
+    const auto end{ clock::now() };
+    times.push_back(std::chrono::duration<double, std::milli>(end - begin).count() / static_cast<double>(batch));
+  }
+
+  // 中央値と最小値と平均値を求める
+  std::sort(times.begin(), times.end());
+  double total{ 0.0 };
+  for (const auto time : times) total += time;
+  const Result result{ group, name, parameter, times.size(), times[times.size() / 2], times.front(), total / times.size() };
+
+  // 進み具合を表示する
+  std::cout << group << ' ' << name << ' ' << parameter << ": " << result.median << " ms\n";
+
+  return result;
+}
+
+//
+// 一時ディレクトリのファイルのパスを得る
+//
+static std::string getTemporaryPath(const std::string& name)
+{
+  std::error_code error;
+  const auto directory{ std::filesystem::temp_directory_path(error) };
+  return (error ? std::filesystem::u8path(name) : directory / name).u8string();
+}
+
+//
+// 一辺の頂点数が n の格子を三角形分割した OBJ ファイルを作る
+//
+static bool generateObj(int n, const std::string& filename)
+{
+  std::ofstream file{ Utf8ToTChar(filename) };
+  if (!file) return false;
+
+  // 頂点の位置と法線
+  file << std::fixed << std::setprecision(6);
+  for (int j = 0; j < n; ++j)
+  {
+    for (int i = 0; i < n; ++i)
+    {
+      const auto x{ static_cast<float>(i) / static_cast<float>(n - 1) * 2.0f - 1.0f };
+      const auto y{ static_cast<float>(j) / static_cast<float>(n - 1) * 2.0f - 1.0f };
+      const auto z{ 0.1f * std::sin(8.0f * x) * std::cos(8.0f * y) };
+      file << "v " << x << ' ' << y << ' ' << z << "\nvn 0 0 1\n";
+    }
+  }
+
+  // 三角形
+  for (int j = 0; j < n - 1; ++j)
+  {
+    for (int i = 0; i < n - 1; ++i)
+    {
+      const auto a{ j * n + i + 1 }, b{ a + 1 }, c{ a + n }, d{ c + 1 };
+      file << "f " << a << "//" << a << ' ' << b << "//" << b << ' ' << d << "//" << d << '\n'
+        << "f " << a << "//" << a << ' ' << d << "//" << d << ' ' << c << "//" << c << '\n';
+    }
+  }
+
+  return !file.bad();
+}
+
+//
+// 一辺の画素数が size の RGB の TGA ファイルを作る
+//
+static bool generateTga(int size, const std::string& filename)
+{
+  std::vector<GLubyte> image(static_cast<std::size_t>(size) * size * 3);
+  for (std::size_t i = 0; i < image.size(); ++i) image[i] = static_cast<GLubyte>((i * 2654435761u) >> 24);
+  return ggSaveTga(filename, image.data(), size, size, 3);
+}
+
+//
+// OBJ ファイルの読み込みを計測する
+//
+static void measureObj(std::vector<Result>& results)
+{
+  // 読み込みの処理時間を計測する
+  const auto load{ [&results](const std::string& name, const std::string& path)
+  {
+    std::vector<std::array<GLuint, 3>> group;
+    std::vector<GgSimpleShader::Material> material;
+    std::vector<GgVertex> vert;
+    std::vector<GLuint> face;
+    if (!ggLoadSimpleObj(path, group, material, vert, face, true)) return;
+    const auto triangles{ static_cast<double>(face.size() / 3) };
+    results.emplace_back(measure("obj", name, triangles, 1, [&]()
+      {
+        ggLoadSimpleObj(path, group, material, vert, face, true);
+        sink = vert.empty() ? 0.0f : vert.back().position[0];
+      }));
+  } };
+
+  // 同梱の OBJ ファイル
+  for (const auto* const name : { "plane.obj", "wall.obj", "logo.obj", "bunny.obj" }) load(name, name);
+
+  // 数百万の三角形の OBJ ファイル
+  for (const auto n : { 256, 724, 1024, 1448 })
+  {
+    const auto path{ getTemporaryPath("makyoh_bench_" + std::to_string(n) + ".obj") };
+    std::error_code error;
+    if (!std::filesystem::exists(std::filesystem::u8path(path), error) && !generateObj(n, path)) continue;
+    load("synthetic", path);
+  }
+}
+
+//
+// 画像ファイルの読み込みを計測する
+//
+static void measureImage(std::vector<Result>& results)
+{
+  // 同梱の PNG ファイルは stb_image でしか読めない
+  for (const auto* const name : { "height_map_512.png", "terrain_512.png", "illuminant_map.png", "grid.png" })
+  {
+    int width, height, channels;
+    auto* const image{ stbi_load(name, &width, &height, &channels, 0) };
+    if (!image) continue;
+    stbi_image_free(image);
+    results.emplace_back(measure("image", std::string("stbi_load ") + name, width, 1, [&]()
+      {
+        auto* const pixels{ stbi_load(name, &width, &height, &channels, 0) };
+        sink = pixels ? pixels[0] : 0;
+        stbi_image_free(pixels);
+      }));
+  }
+
+  // 同じ TGA ファイルを stb_image と ggReadImage() で読む
+  for (const auto size : { 256, 512, 1024, 2048, 4096 })
+  {
+    const auto path{ getTemporaryPath("makyoh_bench_" + std::to_string(size) + ".tga") };
+    std::error_code error;
+    if (!std::filesystem::exists(std::filesystem::u8path(path), error) && !generateTga(size, path)) continue;
+
+    results.emplace_back(measure("image", "stbi_load tga", size, 1, [&]()
+      {
+        int width, height, channels;
+        auto* const pixels{ stbi_load(path.c_str(), &width, &height, &channels, 0) };
+        sink = pixels ? pixels[0] : 0;
+        stbi_image_free(pixels);
+      }));
+
+    std::vector<GLubyte> image;
+    results.emplace_back(measure("image", "ggReadImage tga", size, 1, [&]()
+      {
+        GLsizei width, height;
+        GLenum format;
+        ggReadImage(path, image, &width, &height, &format);
+        sink = image.empty() ? 0 : image[0];
+      }));
+  }
+}
+
+//
+// 法線マップの作成を計測する
+//
+static void measureNormalMap(std::vector<Result>& results)
+{
+  for (GLsizei size = 128; size <= 8192; size *= 2)
+  {
+    // 正弦波の高さマップ
+    std::vector<GLubyte> hmap(static_cast<std::size_t>(size) * size);
+    for (GLsizei y = 0; y < size; ++y)
+      for (GLsizei x = 0; x < size; ++x)
+        hmap[static_cast<std::size_t>(y) * size + x] = static_cast<GLubyte>(127.5f
+          + 127.5f * std::sin(0.05f * static_cast<float>(x)) * std::cos(0.03f * static_cast<float>(y)));
+
+    std::vector<GgVector> nmap;
+    results.emplace_back(measure("normal_map", "ggCreateNormalMap", size, 1, [&]()
+      {
+        ggCreateNormalMap(hmap.data(), size, size, GL_RED, 1.0f, GL_RGBA, nmap);
+        sink = nmap.back()[0];
+      }));
+  }
+}
+
+//
+// 構成ファイルの読み込みを計測する
+//
+static void measureConfig(std::vector<Result>& results)
+{
+  Config config;
+  if (!config.load("makyoh_config.json")) return;
+  results.emplace_back(measure("config", "Config::load", 1, 1, [&]()
+    {
+      config.load("makyoh_config.json");
+      sink = static_cast<float>(config.getWidth());
+    }));
+}
+
+//
+// 変換行列と四元数の演算を計測する
+//
+static void measureMath(std::vector<Result>& results)
+{
+  // 1 回の計測で繰り返す回数
+  constexpr std::size_t batch{ 100000 };
+
+  // 回転の変換行列なら繰り返し掛けても発散しない
+  const auto a{ ggRotate(0.3f, 0.5f, 0.8f, 0.01f) };
+  const auto b{ ggRotate(0.8f, 0.1f, 0.6f, 0.02f) };
+  const auto c{ ggRotate(0.2f, 0.9f, 0.4f, 0.03f) };
+
+  results.emplace_back(measure("math", "GgMatrix::operator*", 1, batch, [&]()
+    {
+      auto m{ a };
+      for (std::size_t i = 0; i < batch; ++i) m = m * b;
+      sink = m[0];
+    }));
+
+  results.emplace_back(measure("math", "GgMatrix chain a*b*c", 1, batch, [&]()
+    {
+      auto m{ a };
+      for (std::size_t i = 0; i < batch; ++i) m = m * b * c;
+      sink = m[0];
+    }));
+
+  results.emplace_back(measure("math", "ggProduct(a, b, c)", 1, batch, [&]()
+    {
+      auto m{ a };
+      for (std::size_t i = 0; i < batch; ++i) m = ggProduct(m, b, c);
+      sink = m[0];
+    }));
+
+  results.emplace_back(measure("math", "GgMatrix::invert", 1, batch, [&]()
+    {
+      auto m{ a * ggTranslate(0.1f, 0.2f, 0.3f) };
+      for (std::size_t i = 0; i < batch; ++i) m = m.invert();
+      sink = m[0];
+    }));
+
+  results.emplace_back(measure("math", "GgMatrix * GgVector", 1, batch, [&]()
+    {
+      GgVector v{ 1.0f, 2.0f, 3.0f, 1.0f };
+      for (std::size_t i = 0; i < batch; ++i) v = a * v;
+      sink = v[0];
+    }));
+
+  std::vector<GgVector> vectors(1024, GgVector{ 1.0f, 2.0f, 3.0f, 1.0f });
+  results.emplace_back(measure("math", "GgMatrix::transform", static_cast<double>(vectors.size()), batch / vectors.size(), [&]()
+    {
+      for (std::size_t i = 0; i < batch / vectors.size(); ++i) a.transform(vectors.data(), vectors.data(), vectors.size());
+      sink = vectors[0][0];
+    }));
+
+  const auto p{ ggRotateQuaternion(0.3f, 0.5f, 0.8f, 0.01f) };
+  const auto q{ ggRotateQuaternion(0.8f, 0.1f, 0.6f, 0.02f) };
+
+  results.emplace_back(measure("math", "GgQuaternion::operator*", 1, batch, [&]()
+    {
+      auto r{ p };
+      for (std::size_t i = 0; i < batch; ++i) r = r * q;
+      sink = r[0];
+    }));
+
+  results.emplace_back(measure("math", "GgQuaternion::getMatrix", 1, batch, [&]()
+    {
+      auto r{ p };
+      GgMatrix m;
+      for (std::size_t i = 0; i < batch; ++i)
+      {
+        r.getMatrix(m);
+        r[0] += m[1] * 1.0e-6f;
+      }
+      sink = m[0];
+    }));
+
+  results.emplace_back(measure("math", "ggSlerp", 1, batch, [&]()
+    {
+      auto r{ p };
+      for (std::size_t i = 0; i < batch; ++i) r = ggSlerp(r, q, 0.5f);
+      sink = r[0];
+    }));
+}
+
+//
+// 演算結果
+//
+struct Output
+{
+  // 演算の名前
+  std::string name;
+
+  // 演算結果を並べたもの
+  std::vector<GLfloat> values;
+};
+
+//
+// 乱数で作った入力に対する変換行列と四元数の演算と法線マップの作成の結果を求める
+//
+static std::vector<Output> computeMath()
+{
+  // 入力の組の数
+  constexpr int count{ 10000 };
+
+  // 標準ライブラリの分布の実装に依らないように [-1, 1) の一様乱数は自分で作る
+  std::mt19937 engine{ 20261018u };
+  const auto random{ [&engine]() { return static_cast<GLfloat>(engine() >> 8) * 0x1p-23f - 1.0f; } };
+  const auto matrix{ [&random]() { GgMatrix m; for (auto& e : m) e = random(); return m; } };
+
+  std::vector<Output> outputs
+  {
+    { "GgMatrix::multiply", {} },
+    { "GgMatrix::projection", {} },
+    { "GgMatrix::loadInvert", {} },
+    { "ggMultiplyChain", {} },
+    { "GgQuaternion::multiply", {} },
+    { "GgQuaternion::toMatrix", {} },
+    { "GgMatrix::transform", {} },
+    { "ggCreateNormalMap", {} }
+  };
+  const auto append{ [&outputs](std::size_t i, const GLfloat* data, std::size_t size)
+  {
+    outputs[i].values.insert(outputs[i].values.end(), data, data + size);
+  } };
+
+  for (int i = 0; i < count; ++i)
+  {
+    const auto a{ matrix() }, b{ matrix() }, c{ matrix() }, d{ matrix() };
+    const GgVector v{ random(), random(), random(), random() };
+    append(0, (a * b).data(), 16);
+    append(1, (a * v).data(), 4);
+    append(2, a.invert().data(), 16);
+    append(3, ggProduct(a, b, c, d).evaluate().data(), 16);
+
+    const GgQuaternion p{ random(), random(), random(), random() };
+    const GgQuaternion q{ random(), random(), random(), random() };
+    append(4, (p * q).data(), 4);
+    append(5, p.getMatrix().data(), 16);
+  }
+
+  // 端数の出る個数のベクトルをまとめて変換する
+  std::vector<GgVector> vectors(count + 3);
+  for (auto& v : vectors) v = GgVector{ random(), random(), random(), random() };
+  matrix().transform(vectors.data(), vectors.data(), vectors.size());
+  for (const auto& v : vectors) append(6, v.data(), 4);
+
+  // 端数の出る幅の乱数の高さマップから法線マップを作る
+  constexpr GLsizei width{ 67 }, height{ 37 };
+  std::vector<GLubyte> hmap(static_cast<std::size_t>(width) * height);
+  for (auto& h : hmap) h = static_cast<GLubyte>(engine() >> 24);
+  std::vector<GgVector> nmap;
+  ggCreateNormalMap(hmap.data(), width, height, GL_RED, 1.0f, GL_RGBA, nmap);
+  for (const auto& n : nmap) append(7, n.data(), 4);
+
+  return outputs;
+}
+
+//
+// 演算結果をファイルに書き出す
+//
+static bool dumpMath(const std::string& filename)
+{
+  std::ofstream file{ Utf8ToTChar(filename), std::ios::binary };
+  if (!file) return false;
+
+  for (const auto& output : computeMath())
+    file.write(reinterpret_cast<const char*>(output.values.data()), output.values.size() * sizeof(GLfloat));
+
+  return !file.bad();
+}
+
+//
+// 演算結果をファイルに書き出したものとビット単位で比べる
+//
+static bool checkMath(const std::string& filename)
+{
+  std::ifstream file{ Utf8ToTChar(filename), std::ios::binary };
+  if (!file)
+  {
+    std::cerr << "Can't read the math result: " << filename << '\n';
+    return false;
+  }
+
+  bool passed{ true };
+  for (const auto& output : computeMath())
+  {
+    std::vector<GLfloat> reference(output.values.size());
+    file.read(reinterpret_cast<char*>(reference.data()), reference.size() * sizeof(GLfloat));
+    if (!file)
+    {
+      std::cerr << output.name << ": the math result is too short\n";
+      return false;
+    }
+
+    // NaN も含めてビット単位で比べる
+    std::size_t mismatches{ 0 };
+    for (std::size_t i = 0; i < reference.size(); ++i)
+    {
+      if (std::memcmp(&reference[i], &output.values[i], sizeof(GLfloat)) == 0) continue;
+      if (mismatches++ == 0) std::cerr << output.name << '[' << i << "]: " << std::hexfloat
+        << output.values[i] << " != " << reference[i] << std::defaultfloat << '\n';
+    }
+    std::cout << output.name << ": " << mismatches << " / " << reference.size() << " mismatches\n";
+    if (mismatches > 0) passed = false;
+  }
+
+  return passed;
+}
+
+//
+// 計測結果を JSON ファイルに書き出す
+//
+static bool write(const std::vector<Result>& results, const std::string& filename)
+{
+  std::ofstream file{ Utf8ToTChar(filename) };
+  if (!file) return false;
+
+  // 計測した環境
+  picojson::object object;
+#if defined(__clang__)
+  setString(object, "compiler", "clang " __clang_version__);
+#elif defined(__GNUC__)
+  setString(object, "compiler", "gcc " __VERSION__);
+#elif defined(_MSC_VER)
+  setValue(object, "msc_version", _MSC_VER);
+#endif
+#if defined(GG_USE_SSE)
+  setString(object, "simd", "sse");
+#elif defined(GG_USE_NEON)
+  setString(object, "simd", "neon");
+#else
+  setString(object, "simd", "none");
+#endif
+
+  // 計測結果
+  picojson::array array;
+  for (const auto& result : results)
+  {
+    picojson::object element;
+    setString(element, "group", result.group);
+    setString(element, "name", result.name);
+    setValue(element, "parameter", result.parameter);
+    setValue(element, "iterations", result.iterations);
+    setValue(element, "median_ms", result.median);
+    setValue(element, "min_ms", result.minimum);
+    setValue(element, "mean_ms", result.mean);
+    array.emplace_back(element);
+  }
+  object.emplace("results", array);
+
+  // 結果をシリアライズして JSON で保存
+  picojson::value v{ object };
+  file << v.serialize(true);
+  file.close();
+
+  return true;
+}
+
+//
+// メインプログラム
+//
+int main(int argc, const char* const* argv)
+{
+  // 演算結果を書き出すか比べる
+  const std::string mode{ argc > 1 ? argv[1] : "" };
+  if (mode == "--dump-math" || mode == "--check-math")
+  {
+    const std::string filename{ argc > 2 ? argv[2] : BENCH_MATH_FILE };
+    if (mode == "--check-math") return checkMath(filename) ? 0 : EXIT_FAILURE;
+    if (dumpMath(filename)) return 0;
+    std::cerr << "Can't write the math result: " << filename << '\n';
+    return EXIT_FAILURE;
+  }
+
+  // 結果のファイル名
+  const std::string output{ argc > 1 ? argv[1] : BENCH_RESULT_FILE };
+
+  // すべての計測を行う
+  std::vector<Result> results;
+  measureObj(results);
+  measureImage(results);
+  measureNormalMap(results);
+  measureConfig(results);
+  measureMath(results);
+
+  // 結果を書き出す
+  if (!write(results, output))
+  {
+    std::cerr << "Can't write the benchmark result: " << output << '\n';
+    return EXIT_FAILURE;
+  }
+
+  return 0;
+}
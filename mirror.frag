@@ -35,11 +35,24 @@ layout (std140) uniform Mirror
 
 // パラメータ
 uniform float scale;                                  // 鏡の高さマップのスケール
+uniform float layer;                                  // 鏡の高さマップのレイヤ番号
+
+// 投影光源
+uniform int type;                                     // 投影光源の種類 (0: 矩形, 1: 平行光線, 2: 点光源)
+uniform float exponent;                               // 平行光線と点光源の鏡面の微細な粗さを表す指数
+uniform vec4 illuminant;                              // 平行光線と点光源の色と強度
 
 // テクスチャ
-uniform sampler2D height;                             // 鏡の高さマップ
+uniform sampler2DArray height;                        // 鏡の高さマップのテクスチャ配列
 uniform sampler2D color;                              // 投影光源マップ
 
+// 高さマップのタイル
+uniform bool tiled;                                   // 高さマップをタイルで参照するなら true
+uniform usampler2D pages;                             // 高さマップのページテーブル
+uniform sampler2D atlas;                              // 高さマップのタイルキャッシュ
+uniform vec4 tiling;                                  // 詳細度 0 の画素数, タイルの有効画素数, 境界の画素数
+uniform int levels;                                   // 高さマップの詳細度の数
+
 // 変換行列
 uniform mat4 mn;                                      // 法線変換行列
 uniform mat4 ml;                                      // 光源の姿勢行列
@@ -52,8 +65,45 @@ in vec4 vl;                                           // 視点座標系にお
 // フレームバッファに出力するデータ
 layout (location = 0) out vec4 fc;                    // フラグメントの色
 
+// 鏡の高さマップのレイヤ layer の勾配 (右 - 左, 上 - 下) を詳細度 0 の画素間隔で求める
+vec2 slope(in vec2 uv, in float layer, in int level)
+{
+  // タイル化していなければ高さマップのテクスチャ配列を直接参照する
+  if (!tiled) return vec2(
+    textureOffset(height, vec3(uv, layer), ivec2(1, 0)).r - textureOffset(height, vec3(uv, layer), ivec2(-1, 0)).r,
+    textureOffset(height, vec3(uv, layer), ivec2(0, 1)).r - textureOffset(height, vec3(uv, layer), ivec2(0, -1)).r);
+
+  // 要求する詳細度の画素位置とタイル
+  float s = exp2(float(level));
+  vec2 t = clamp(uv, 0.0, 1.0) * tiling.xy / s;
+  ivec2 tile = min(ivec2(t / tiling.z), ivec2(ceil(tiling.xy / (s * tiling.z))) - 1);
+
+  // ページテーブルからタイルキャッシュのスロットと常駐している詳細度を求める
+  uvec4 page = texelFetch(pages, tile, level);
+  int shift = int(page.z) - level;
+
+  // 常駐している詳細度のタイル内の画素位置
+  float r = exp2(float(shift));
+  vec2 local = t / r - vec2(tile >> shift) * tiling.z;
+
+  // タイルキャッシュのテクスチャ座標と画素間隔
+  vec2 size = vec2(textureSize(atlas, 0));
+  vec2 a = (vec2(page.xy) * (tiling.z + 2.0 * tiling.w) + tiling.w + local) / size;
+  vec2 d = 1.0 / size;
+
+  // 常駐している詳細度の画素間隔を詳細度 0 の画素間隔に換算する
+  return vec2(
+    textureLod(atlas, a + vec2(d.x, 0.0), 0.0).r - textureLod(atlas, a - vec2(d.x, 0.0), 0.0).r,
+    textureLod(atlas, a + vec2(0.0, d.y), 0.0).r - textureLod(atlas, a - vec2(0.0, d.y), 0.0).r) / (s * r);
+}
+
 void main(void)
 {
+  // 画面上の画素間隔に合わせた高さマップの詳細度
+  vec2 texel = tc * tiling.xy;
+  float footprint = max(max(length(dFdx(texel)), length(dFdy(texel))), 1.0);
+  int level = clamp(int(log2(footprint)), 0, max(levels - 1, 0));
+
   // テクスチャ座標を[-1, 1]に変換
   vec2 radius = tc * vec2(2.0, -2.0) - vec2(1.0, -1.0);
 
@@ -61,9 +111,8 @@ void main(void)
   if (dot(radius, radius) > 1.0) discard;
 
   // 視点座標系における法線ベクトル
-  vec3 dx = vec3(1.0, 0.0, (textureOffset(height, tc, ivec2(1, 0)).r - textureOffset(height, tc, ivec2(-1, 0)).r) * scale);
-  vec3 dy = vec3(0.0, 1.0, (textureOffset(height, tc, ivec2(0, 1)).r - textureOffset(height, tc, ivec2(0, -1)).r) * scale);
-  vec3 n = mat3(mn) * normalize(cross(dx, dy));
+  vec2 g = slope(tc, layer, level) * scale;
+  vec3 n = mat3(mn) * normalize(cross(vec3(1.0, 0.0, g.x), vec3(0.0, 1.0, g.y)));
 
   // 視点座標系における光線ベクトル
   vec3 l = normalize((vl * vp.w - vp * vl.w).xyz);
@@ -85,6 +134,17 @@ void main(void)
   // 視線の反射ベクトル
   vec3 d = reflect(vp.xyz, n);
 
+  // 平行光線か点光源なら視線の反射ベクトルと光源の方向の内積から映り込みを求める
+  if (type != 0)
+  {
+    // 反射位置から光源に向かう方向
+    vec3 s = type == 1 ? -ml[2].xyz : normalize((ml[3] * vp.w - vp * ml[3].w).xyz);
+
+    // 鏡面の微細な粗さによって広がった光源色
+    fc += mspec * illuminant * pow(max(dot(normalize(d), s), 0.0), exponent);
+    return;
+  }
+
   // 法線ベクトルと視線の反射ベクトルの内積
   float k = dot(ml[2].xyz, d);
 
@@ -106,8 +166,8 @@ void main(void)
   // 矩形と交差していなければ環境光のみにする
   if (any(lessThan(vec4(1.0 + p.yz, 1.0 - p.yz), vec4(0.0)))) return;
 
-  // 光源色
-  vec4 lc = texture(color, p.yz * 0.5 + 0.5);
+  // 光源色 (分岐の後なのでミップマップは参照しない)
+  vec4 lc = textureLod(color, p.yz * 0.5 + 0.5, 0.0);
 
   // 画素の陰影を求める
   fc += mspec * lc;
@@ -33,24 +33,63 @@ layout (std140) uniform Mirror
   float mshi;                                         // 輝き係数
 };
 
-// 標本点
-layout (std140) uniform Sample
+// 鏡のインスタンス
+layout (std140) uniform Instance
 {
-  vec4 point[1000];                                   // 標本点の位置
+  mat4 pose[32];                                      // 視点座標系における鏡の姿勢行列
+  vec4 param[32];                                     // 鏡の高さスケール, 高さマップのレイヤ番号
 };
 
-// パラメータ
-uniform int samples;                                  // 標本点の数
-uniform float scale;                                  // 鏡の高さスケール
+// フレームごとのパラメータ
+layout (std140) uniform Frame
+{
+  mat4 ml;                                            // 投影光源の姿勢行列
+  mat4 occluder[16];                                  // 視点座標系から受光面ごとのモデル座標系への変換行列
+  ivec4 bvh[16];                                      // 受光面ごとの境界ボリューム階層の根の節点の番号と凸なら 1
+  vec4 illuminant;                                    // 平行光線と点光源の色と強度
+  vec4 tiling;                                        // 詳細度 0 の画素数, タイルの有効画素数, 境界の画素数
+  vec2 ratio;                                         // 縮小した反射光と描画先の画素数の比
+  float exponent;                                     // 平行光線と点光源の鏡面の微細な粗さを表す指数
+  int type;                                           // 投影光源の種類 (0: 矩形, 1: 平行光線, 2: 点光源)
+  int samples;                                        // 標本点の数
+  int mirrors;                                        // 鏡のインスタンスの数
+  int offset;                                         // 最初に使う標本点の番号
+  int levels;                                         // 高さマップの詳細度の数
+  bool tiled;                                         // 高さマップをタイルで参照するなら true
+  bool shadow;                                        // 遮蔽を調べるなら true
+  int occluders;                                      // 受光面の数
+  float footprint;                                    // 標本点ひとつが受け持つ鏡の範囲の一辺の長さ (0 なら広げない)
+  int pilot;                                          // 分散を見積もる試し描きの標本点の数 (0 なら配分しない)
+  int limit;                                          // 画素ごとに配分する標本点の数の上限
+};
 
 // テクスチャ
-uniform sampler2D height;                             // 鏡の高さマップ
 uniform sampler2D color;                              // 投影光源マップ
 
+// 鏡の標本点マップ (横が標本点, 縦が鏡のインスタンス)
+uniform sampler2D positions;                          // 視点座標系における標本点の位置
+uniform sampler2D normals;                            // 視点座標系における標本点の法線ベクトル
+uniform sampler2D lights;                             // 視点座標系における標本点から全体光源に向かう単位ベクトル
+uniform sampler2D diffuses;                           // 標本点の全体光源による拡散反射光強度
+uniform sampler2D reflections;                        // 標本点で反射した平行光線か点光源の光の方向
+uniform sampler2D slopes;                             // 標本点が受け持つ範囲の鏡のローカル座標系における勾配の共分散
+
+// 受光面による遮蔽
+uniform int self;                                     // 描画している受光面の番号
+uniform samplerBuffer nodes;                          // 境界ボリューム階層の節点
+uniform samplerBuffer triangles;                      // 境界ボリューム階層の葉の三角形
+
+// 縮小した投影光源による反射光
+uniform int pass;                                     // 0: すべて, 1: 投影光源による反射光だけ, 2: 縮小した反射光を拡大して合成, 3: 試し描き
+uniform sampler2D caustic;                            // 縮小した投影光源による反射光
+uniform sampler2D geometry;                           // 縮小した反射光の画素の法線ベクトルと奥行き
+
+// 分散に合わせた標本点の配分
+uniform sampler2D estimate;                           // 試し描きの投影光源による反射光
+uniform sampler2D deviation;                          // 試し描きの標本点ごとの輝度の標準偏差と受光面のある画素なら 1
+
 // 変換行列
 uniform mat4 mn;                                      // 法線変換行列
-uniform mat4 mm;                                      // 鏡の姿勢行列
-uniform mat4 ml;                                      // 投影光源の姿勢行列
 
 // ラスタライザから受け取る頂点属性の補間値
 in vec4 vp;                                           // 視点座標系における頂点位置
@@ -59,81 +98,250 @@ in vec3 vn;                                           // 視点座標系にお
 
 // フレームバッファに出力するデータ
 layout (location = 0) out vec4 fc;                    // フラグメントの色
+layout (location = 1) out vec4 fg;                    // pass == 1 なら法線ベクトルと奥行き, pass == 3 なら輝度の標準偏差
 
-// 受光面上の点 vp から direction 方向を見た放射輝度
-vec4 radiance(in vec3 direction, in vec3 view, in vec3 normal)
+// 視点座標系の中間ベクトル h を法線ベクトルとする微小面の割合
+//   frame: 視点座標系における鏡のローカル座標系の軸
+//   mean, sigma: 鏡のローカル座標系における勾配の平均と共分散 (xx, yy, xy)
+//   variance: 畳み込む鏡面の粗さの勾配の分散
+float lobe(in vec3 h, in mat3 frame, in vec2 mean, in vec3 sigma, in float variance)
 {
-  // 視点座標系の受光面の位置から鏡の中心に向かうベクトル
-  vec3 t0 = (vp * mm[3].w - mm[3] * vp.w).xyz;
+  // 鏡のローカル座標系における中間ベクトル
+  vec3 l = h * frame;
+  if (l.z <= 0.0) return 0.0;
 
-  // 視点座標系の受光面の位置から鏡の中心に向かうベクトルと鏡面上の１点に向かうベクトルの外積
-  vec3 m0 = cross(t0, direction);
+  // 中間ベクトルを法線ベクトルとする微小面の勾配と平均の勾配の差
+  vec2 d = -l.xy / l.z - mean;
 
-  // 鏡の法線ベクトルと鏡面上の１点に向かうベクトルの内積
-  float k0 = dot(mm[2].xyz, direction);
+  // 粗さを畳み込んだ共分散行列の行列式
+  vec3 s = sigma + vec3(variance, variance, 0.0);
+  float det = s.x * s.y - s.z * s.z;
 
-  // 鏡の交点のパラメータ座標（テクスチャ座標なので Y 軸は反転）
-  vec3 p0 = vec3(-dot(t0, mm[2].xyz), -dot(m0, mm[1].xyz), dot(m0, mm[0].xyz)) / k0;
+  // 勾配の正規分布を共分散が 0 のときに中心で 1 になるように正規化する
+  return exp(-0.5 * (d.x * d.x * s.y - 2.0 * d.x * d.y * s.z + d.y * d.y * s.x) / det) * variance / sqrt(det);
+}
 
-  // 鏡の交点までの距離が負なら反対側なので反射光はない
-  if (p0.x < 0.0) return vec4(0.0);
+// 鏡の標本点 index の全体光源による反射光強度
+vec4 shade(in ivec2 index, in vec3 n, in vec3 v, in mat3 frame, in vec2 mean, in vec3 sigma)
+{
+  // 毎フレーム一度だけ求めた鏡の交点の視点座標系における光線ベクトル
+  vec3 l = texelFetch(lights, index, 0).xyz;
 
-  // 鏡と交差していなければ反射光はない
-  if (dot(p0.yz, p0.yz) > 1.0) return vec4(0.0);
+  // 鏡の視点座標系における中間ベクトル
+  vec3 h = normalize(l - v);
 
-  // 鏡の交点の視点座標系の位置
-  vec4 v0 = mm * vec4(p0.yz, 0.0, 1.0);
+  // 勾配の分布で広げるなら輝き係数を勾配の分散に換算して畳み込む
+  float specular = footprint > 0.0
+    ? lobe(h, frame, mean, sigma, 1.0 / max(mshi, 1.0e-3))
+    : pow(max(dot(n, h), 0.0), mshi);
 
-  // 視点座標系における鏡の法線ベクトル
-  float dx = textureOffset(height, p0.yz, ivec2(-1, 0)).r - textureOffset(height, p0.yz, ivec2(1, 0)).r;
-  float dy = textureOffset(height, p0.yz, ivec2(0, -1)).r - textureOffset(height, p0.yz, ivec2(0, 1)).r;
-  vec3 n = mat3(mn) * (normalize(vec3(vec2(dx, dy) * scale, 1.0)));
+  // 全体光源の陰影計算 (拡散反射光は毎フレーム一度だけ求めたもの)
+  vec4 idiff = texelFetch(diffuses, index, 0);
+  vec4 ispec = (mshi + 8.0) * specular * mspec * lspec * 0.0397887358;
 
-  // 鏡の交点の視点座標系における視線ベクトル
-  vec3 v = normalize((v0 * vp.w - vp * v0.w).xyz);
+  // 鏡の全体光源による反射光強度
+  return idiff + ispec;
+}
 
-  // 鏡の交点の視点座標系における視線ベクトルの反射ベクトル
-  vec3 d = reflect(v.xyz, n);
+// 境界ボリューム階層の根 root 以下の三角形が o から o + d までの線分を遮るなら true
+bool hit(in vec3 o, in vec3 d, in int root)
+{
+  // 線分の端点は受光面上にあるので少しだけ縮める
+  const float epsilon = 1.0e-3;
 
-  // 鏡の交点の視点座標系における法線ベクトルと視線の反射ベクトルの内積
-  float k = dot(ml[2].xyz, d);
+  // 境界箱との交差判定に使う方向ベクトルの逆数
+  vec3 r = 1.0 / d;
 
-  // 鏡の反射光強度
-  vec4 intensity = mamb * lamb;
+  // まだたどっていない節点のスタック
+  int stack[32];
+  int top = 0;
+  stack[top++] = root;
 
-  // 鏡の交点の視点座標系における法線ベクトルと視線の反射ベクトルの内積が向かい合っていなければ映り込みは無い
-  if (k >= 0.0) return intensity;
+  while (top > 0)
+  {
+    // 節点を取り出す
+    int node = stack[--top];
+    vec4 lower = texelFetch(nodes, node * 2);
+    vec4 upper = texelFetch(nodes, node * 2 + 1);
+
+    // 線分が境界箱と交わらなければこの節点以下は調べない
+    vec3 t0 = (lower.xyz - o) * r;
+    vec3 t1 = (upper.xyz - o) * r;
+    vec3 tmin = min(t0, t1);
+    vec3 tmax = max(t0, t1);
+    float enter = max(max(tmin.x, tmin.y), max(tmin.z, epsilon));
+    float leave = min(min(tmax.x, tmax.y), min(tmax.z, 1.0 - epsilon));
+    if (enter > leave) continue;
+
+    int count = int(upper.w);
+    if (count == 0)
+    {
+      // 内部節点なら右の子と左の子を積む
+      if (top < 31)
+      {
+        stack[top++] = int(lower.w);
+        stack[top++] = node + 1;
+      }
+      continue;
+    }
+
+    // 葉なら三角形と交差判定する (Möller-Trumbore)
+    int first = int(lower.w);
+    for (int i = first; i < first + count; ++i)
+    {
+      vec3 a = texelFetch(triangles, i * 3).xyz;
+      vec3 e1 = texelFetch(triangles, i * 3 + 1).xyz - a;
+      vec3 e2 = texelFetch(triangles, i * 3 + 2).xyz - a;
+      vec3 p = cross(d, e2);
+      float det = dot(e1, p);
+      if (abs(det) < 1.0e-12) continue;
+      vec3 s = (o - a) / det;
+      float u = dot(s, p);
+      if (u < 0.0 || u > 1.0) continue;
+      vec3 q = cross(s, e1);
+      float v = dot(d, q);
+      if (v < 0.0 || u + v > 1.0) continue;
+      float t = dot(e2, q);
+      if (t > epsilon && t < 1.0 - epsilon) return true;
+    }
+  }
 
-  // 鏡の交点の視点座標系における光線ベクトル
-  vec3 l = normalize((vl * v0.w - v0 * vl.w).xyz);
+  return false;
+}
 
-  // 鏡の視点座標系における中間ベクトル
-  vec3 h = normalize(l - v);
+// 受光面上の点 vp から鏡の標本点 v0 までの間を受光面が遮るなら true
+bool occluded(in vec4 v0)
+{
+  for (int k = 0; k < occluders; ++k)
+  {
+    // 境界ボリューム階層が無い受光面と凸な自分自身は遮らない
+    if (bvh[k].x < 0 || (k == self && bvh[k].y != 0)) continue;
+
+    // 受光面のモデル座標系における線分
+    vec4 a = occluder[k] * vp;
+    vec4 b = occluder[k] * v0;
+    vec3 o = a.xyz / a.w;
+    if (hit(o, b.xyz / b.w - o, bvh[k].x)) return true;
+  }
+
+  return false;
+}
 
-  // 全体光源の陰影計算
-  vec4 idiff = max(dot(n, l), 0.0) * mdiff * ldiff * 0.318309886;
-  vec4 ispec = (mshi + 8.0) * pow(max(dot(n, h), 0.0), mshi) * mspec * lspec * 0.0397887358;
+// 受光面上の点 vp から鏡の標本点 index を見た放射輝度
+vec4 radiance(in ivec2 index, in vec3 view, in vec3 normal)
+{
+  // 毎フレーム一度だけ求めた視点座標系における標本点の位置と法線ベクトル
+  vec4 v0 = texelFetch(positions, index, 0);
+  vec3 n = texelFetch(normals, index, 0).xyz;
 
-  // 鏡の全体光源による反射光強度
-  intensity += idiff + ispec;
+  // 視点座標系の受光面の位置から鏡の標本点に向かうベクトル
+  vec3 direction = (v0 * vp.w - vp * v0.w).xyz;
 
-  // 投影光源の中心から鏡の交点に向かうベクトル（元の式とは向きを反転している）
-  vec3 t = (ml[3] * v0.w - v0 * ml[3].w).xyz;
+  // 鏡の標本点が受光面に遮られていれば届く光は無い
+  if (shadow && occluded(v0)) return vec4(0.0);
+
+  // 鏡の交点の視点座標系における視線ベクトル
+  vec3 v = normalize(direction);
 
-  // 反射位置から投影光源の中心に向かうベクトルと視線の反射ベクトルの外積
-  vec3 m = cross(t, d);
+  // 標本点が受け持つ範囲の勾配の共分散と視点座標系における鏡のローカル座標系の軸
+  vec3 sigma = texelFetch(slopes, index, 0).xyz;
+  mat3 frame = mat3(pose[index.y]);
 
-  // 投影光源の交点のパラメータ座標（テクスチャ座標なので Y 軸は反転）
-  vec3 p = vec3(dot(t, ml[2].xyz), dot(m, ml[1].xyz), dot(m, ml[0].xyz)) / k;
+  // 鏡のローカル座標系における勾配の平均
+  vec3 local = n * frame;
+  vec2 mean = -local.xy / local.z;
 
-  // 投影光源の交点までの距離が負なら反対側なので全体光源の反射光のみにする
-  if (p.x < 0.0) return intensity;
+  // 鏡の反射光強度
+  vec4 intensity = mamb * lamb;
 
-  // 投影光源と交差していなければ全体光源の反射光のみにする
-  if (any(lessThan(vec4(1.0 + p.yz, 1.0 - p.yz), vec4(0.0)))) return intensity;
+  // 鏡の交点に映る投影光源の色
+  vec4 lc;
 
-  // 投影光源色
-  vec4 lc = texture(color, p.yz * 0.5 + 0.5);
+  if (type == 0)
+  {
+    // 鏡の交点の視点座標系における視線ベクトルの反射ベクトル
+    vec3 d = reflect(v.xyz, n);
+
+    // 鏡の交点の視点座標系における法線ベクトルと視線の反射ベクトルの内積
+    float k = dot(ml[2].xyz, d);
+
+    // 鏡の交点の視点座標系における法線ベクトルと視線の反射ベクトルの内積が向かい合っていなければ映り込みは無い
+    if (k >= 0.0) return intensity;
+
+    // 鏡の全体光源による反射光強度
+    intensity += shade(index, n, v, frame, mean, sigma);
+
+    // 投影光源の中心から鏡の交点に向かうベクトル（元の式とは向きを反転している）
+    vec3 t = (ml[3] * v0.w - v0 * ml[3].w).xyz;
+
+    // 反射位置から投影光源の中心に向かうベクトルと視線の反射ベクトルの外積
+    vec3 m = cross(t, d);
+
+    // 投影光源の交点のパラメータ座標（テクスチャ座標なので Y 軸は反転）
+    vec3 p = vec3(dot(t, ml[2].xyz), dot(m, ml[1].xyz), dot(m, ml[0].xyz)) / k;
+
+    // 投影光源の交点までの距離が負なら反対側なので全体光源の反射光のみにする
+    if (p.x < 0.0) return intensity;
+
+    // 投影光源と交差していなければ全体光源の反射光のみにする
+    if (any(lessThan(vec4(1.0 + p.yz, 1.0 - p.yz), vec4(0.0)))) return intensity;
+
+    // 投影光源マップのテクスチャ座標
+    vec2 uv = p.yz * 0.5 + 0.5;
+
+    if (footprint > 0.0)
+    {
+      // 勾配の共分散をコレスキー分解した列だけ勾配をずらした法線ベクトル
+      float a = sqrt(max(sigma.x, 1.0e-12));
+      float b = sigma.z / a;
+      vec3 nx = frame * normalize(vec3(-mean - vec2(a, b), 1.0));
+      vec3 ny = frame * normalize(vec3(-mean - vec2(0.0, sqrt(max(sigma.y - b * b, 0.0))), 1.0));
+
+      // ずらした法線ベクトルで反射した視線ベクトルと投影光源の交点のテクスチャ座標
+      vec3 dx = reflect(v.xyz, nx);
+      vec3 dy = reflect(v.xyz, ny);
+      vec3 mx = cross(t, dx);
+      vec3 my = cross(t, dy);
+      vec2 ux = vec2(dot(mx, ml[1].xyz), dot(mx, ml[0].xyz)) / dot(ml[2].xyz, dx) * 0.5 + 0.5;
+      vec2 uy = vec2(dot(my, ml[1].xyz), dot(my, ml[0].xyz)) / dot(ml[2].xyz, dy) * 0.5 + 0.5;
+
+      // 勾配の標準偏差の 2 倍の範囲で反射した投影光源色の平均
+      lc = textureGrad(color, uv, 2.0 * (ux - uv), 2.0 * (uy - uv));
+    }
+    else
+    {
+      // 投影光源色
+      lc = textureLod(color, uv, 0.0);
+    }
+  }
+  else
+  {
+    // 鏡の全体光源による反射光強度
+    intensity += shade(index, n, v, frame, mean, sigma);
+
+    // 毎フレーム一度だけ求めた標本点で反射した光の方向
+    vec3 r = texelFetch(reflections, index, 0).xyz;
+
+    if (footprint > 0.0)
+    {
+      // 反射した光の方向を平均の法線ベクトルで反射すれば入射した光の方向に戻る
+      vec3 h = normalize(-reflect(r, n) - v);
+
+      // 勾配の分布に鏡面の微細な粗さを勾配の分散に換算して畳み込んで広げた投影光源色
+      lc = illuminant * lobe(h, frame, mean, sigma, 0.25 / max(exponent, 1.0e-3));
+    }
+    else
+    {
+      // 反射した光の方向と標本点から受光面上の点に向かう方向の内積
+      float c = -dot(r, v);
+
+      // 反射した光が受光面上の点に向かっていなければ全体光源の反射光のみにする
+      if (c <= 0.0) return intensity;
+
+      // 鏡面の微細な粗さによって広がった投影光源色
+      lc = illuminant * pow(c, exponent);
+    }
+  }
 
   // 視点座標系の受光面の位置から鏡面上の１点に向かうベクトルと視線ベクトルの中間ベクトル
   vec3 halfway = normalize(direction - view);
@@ -146,6 +354,139 @@ vec4 radiance(in vec3 direction, in vec3 view, in vec3 normal)
   return intensity + (kamb + mdiff + mspec) * lc;
 }
 
+// 縮小した投影光源による反射光を法線ベクトル n と奥行き z を手がかりに結合バイラテラルフィルタで拡大する
+vec4 upsample(in vec3 n, in float z)
+{
+  // 縮小した反射光の画素中心を基準にした位置
+  vec2 p = gl_FragCoord.xy * ratio - 0.5;
+  ivec2 base = ivec2(floor(p));
+  vec2 f = p - vec2(base);
+  ivec2 last = textureSize(caustic, 0) - 1;
+
+  // 近傍の 4 画素を双線形補間の重みと法線ベクトルと奥行きの近さで重み付けして平均する
+  vec4 sum = vec4(0.0);
+  float total = 0.0;
+  float nearest = 0.0;
+  vec4 fallback = vec4(0.0);
+  for (int j = 0; j < 2; ++j)
+  {
+    for (int i = 0; i < 2; ++i)
+    {
+      ivec2 t = clamp(base + ivec2(i, j), ivec2(0), last);
+      vec4 g = texelFetch(geometry, t, 0);
+      vec4 c = texelFetch(caustic, t, 0);
+
+      // 双線形補間の重み
+      float wb = (i == 0 ? 1.0 - f.x : f.x) * (j == 0 ? 1.0 - f.y : f.y);
+
+      // 法線ベクトルと奥行きの近さの重み (受光面の無い画素は奥行きが 0)
+      float wn = pow(max(dot(n, g.xyz), 0.0), 16.0);
+      float wz = g.w > 0.0 ? exp(-abs(z - g.w) / (0.01 * z)) : 0.0;
+      float w = wb * wn * wz;
+      sum += c * w;
+      total += w;
+
+      // どの画素とも似ていなければ最も似ている画素を使う
+      if (wn * wz > nearest)
+      {
+        nearest = wn * wz;
+        fallback = c;
+      }
+    }
+  }
+
+  return total > 1.0e-6 ? sum / total : fallback;
+}
+
+// 受光面上の点 vp における投影光源による反射光強度を最初の pilot 個の標本点で試し描きする
+//   stddev: 標本点ごとの輝度の標準偏差
+vec4 explore(in vec3 v, in vec3 n, out float stddev)
+{
+  // 投影光源による反射光強度と標本点ごとの輝度の分散
+  vec4 intensity = vec4(0.0);
+  float variance = 0.0;
+
+  // 鏡ごとの反射光強度を合計する
+  for (int j = 0; j < mirrors; ++j)
+  {
+    // 視点座標系における鏡の姿勢
+    mat4 mm = pose[j];
+
+    // 受光面上の点が鏡の裏側にあればこの鏡からの光は届かない
+    if (dot((vp * mm[3].w - mm[3] * vp.w).xyz, mm[2].xyz) <= 0.0) continue;
+
+    // この鏡の反射光強度と輝度の和と 2 乗和
+    vec4 sum = vec4(0.0);
+    float s1 = 0.0, s2 = 0.0;
+
+    // 各標本点における反射光強度と輝度を合計する
+    for (int i = 0; i < pilot; ++i)
+    {
+      vec4 c = radiance(ivec2(i, j), v, n);
+      float y = dot(c.rgb, vec3(0.2126, 0.7152, 0.0722));
+      sum += c;
+      s1 += y;
+      s2 += y * y;
+    }
+    intensity += sum;
+
+    // 鏡ごとの標本点は独立なので不偏分散を合計する
+    variance += max(s2 - s1 * s1 / float(pilot), 0.0) / float(pilot - 1);
+  }
+
+  // 標本点の数で割る
+  stddev = sqrt(variance);
+  return intensity / float(pilot);
+}
+
+// 試し描きした輝度の標準偏差に比例して画素に配分する標本点の数
+int allot()
+{
+  // 画素ごとの標準偏差は標本点が少なくてばらつくので 4 x 4 画素のタイルの平均を使う
+  ivec2 p = ivec2(gl_FragCoord.xy);
+  vec2 tile = texelFetch(deviation, min(p >> 2, textureSize(deviation, 2) - 1), 2).xy;
+
+  // 最も粗い詳細度の標準偏差を受光面のある画素の割合で割れば受光面のある画素の平均になる
+  ivec2 size = textureSize(deviation, 0);
+  vec2 total = texelFetch(deviation, ivec2(0), int(log2(float(max(size.x, size.y))))).xy;
+  if (tile.y <= 0.0 || total.x <= 0.0) return pilot;
+
+  // 試し描きの標準誤差が 8bit の量子化誤差より小さければ標本点を追加しない
+  float sigma = tile.x / tile.y;
+  if (sigma < sqrt(float(pilot)) * 0.5 / 255.0) return pilot;
+
+  // 残りの標本点を受光面のある画素の平均に対する標準偏差の比で配分する
+  return clamp(pilot + int(float(samples - pilot) * sigma * total.y / total.x + 0.5), pilot, limit);
+}
+
+// 受光面上の点 vp における投影光源による反射光強度
+vec4 reflected(in vec3 v, in vec3 n)
+{
+  // 試し描きしていれば最初の pilot 個の標本点の反射光はそれを使い, 残りの標本点は分散に合わせて配分する
+  int count = pilot > 0 ? allot() : samples;
+  vec4 intensity = pilot > 0 ? texelFetch(estimate, ivec2(gl_FragCoord.xy), 0) * float(pilot) : vec4(0.0);
+
+  // 鏡ごとの反射光強度を合計する
+  for (int j = 0; j < mirrors; ++j)
+  {
+    // 視点座標系における鏡の姿勢
+    mat4 mm = pose[j];
+
+    // 受光面上の点が鏡の裏側にあればこの鏡からの光は届かない
+    if (dot((vp * mm[3].w - mm[3] * vp.w).xyz, mm[2].xyz) <= 0.0) continue;
+
+    // 各標本点における反射光強度を合計する
+    for (int i = pilot; i < count; ++i)
+    {
+      // 標本点からの放射輝度を加算
+      intensity += radiance(ivec2(i, j), v, n);
+    }
+  }
+
+  // 標本点の数で割る
+  return intensity / float(count);
+}
+
 void main(void)
 {
   // 視点座標系における各種ベクトル
@@ -154,29 +495,33 @@ void main(void)
   vec3 v = normalize(vp.xyz);                         // 視点座標系における視線ベクトル
   vec3 h = normalize(l - v);                          // 視点座標系における中間ベクトル
 
+  // 視点座標系における奥行き
+  float z = -vp.z / vp.w;
+
+  // 試し描きでは投影光源による反射光と標本点ごとの輝度の標準偏差だけを出力する
+  if (pass == 3)
+  {
+    float stddev;
+    fc = explore(v, n, stddev);
+    fg = vec4(stddev, 1.0, 0.0, 0.0);
+    return;
+  }
+
+  // 縮小した描画先には投影光源による反射光と拡大に使う法線ベクトルと奥行きだけを出力する
+  if (pass == 1)
+  {
+    fc = reflected(v, n);
+    fg = vec4(n, z);
+    return;
+  }
+
   // 陰影計算
   vec4 iamb = kamb * lamb;
   vec4 idiff = max(dot(n, l), 0.0) * kdiff * ldiff;
   vec4 ispec = pow(max(dot(n, h), 0.0), kshi) * kspec * lspec;
 
   // 投影光源による反射光強度
-  vec4 intensity = vec4(0.0);
-
-  // 各標本点における反射光強度を合計する
-  for (int i = 0; i < samples; ++i)
-  {
-    // 視点座標系における標本点の位置
-    vec4 sp = mm * vec4(point[i]);
-
-    // 観測位置から視点座標系における標本点に向かうベクトル
-    vec3 direction = (sp * vp.w - vp * sp.w).xyz;
-
-    // 標本点からの放射輝度を加算
-    intensity += radiance(direction, v, n);
-  }
-
-  // 標本点の数で割る
-  intensity /= float(samples);
+  vec4 intensity = pass == 2 ? upsample(n, z) : reflected(v, n);
 
   // 画素の陰影を求める
   fc = intensity + iamb + idiff + ispec;
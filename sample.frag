@@ -0,0 +1,179 @@
+#version 410 core
+
+//
+// sample.frag
+//
+//   鏡の標本点ごとに受光面によらないデータを求めるシェーダ
+//
+
+// 全体光源
+layout (std140) uniform Light
+{
+  vec4 lamb;                                          // 環境光成分
+  vec4 ldiff;                                         // 拡散反射光成分
+  vec4 lspec;                                         // 鏡面反射光成分
+  vec4 lpos;                                          // 位置
+};
+
+// 鏡
+layout (std140) uniform Mirror
+{
+  vec4 mamb;                                          // 環境光の反射係数
+  vec4 mdiff;                                         // 拡散反射係数
+  vec4 mspec;                                         // 鏡面反射係数
+  float mshi;                                         // 輝き係数
+};
+
+// 標本点
+layout (std140) uniform Sample
+{
+  vec4 point[1000];                                   // 標本点の位置
+};
+
+// 鏡のインスタンス
+layout (std140) uniform Instance
+{
+  mat4 pose[32];                                      // 視点座標系における鏡の姿勢行列
+  vec4 param[32];                                     // 鏡の高さスケール, 高さマップのレイヤ番号
+};
+
+// フレームごとのパラメータ
+layout (std140) uniform Frame
+{
+  mat4 ml;                                            // 投影光源の姿勢行列
+  mat4 occluder[16];                                  // 視点座標系から受光面ごとのモデル座標系への変換行列
+  ivec4 bvh[16];                                      // 受光面ごとの境界ボリューム階層の根の節点の番号と凸なら 1
+  vec4 illuminant;                                    // 平行光線と点光源の色と強度
+  vec4 tiling;                                        // 詳細度 0 の画素数, タイルの有効画素数, 境界の画素数
+  vec2 ratio;                                         // 縮小した反射光と描画先の画素数の比
+  float exponent;                                     // 平行光線と点光源の鏡面の微細な粗さを表す指数
+  int type;                                           // 投影光源の種類 (0: 矩形, 1: 平行光線, 2: 点光源)
+  int samples;                                        // 標本点の数
+  int mirrors;                                        // 鏡のインスタンスの数
+  int offset;                                         // 最初に使う標本点の番号
+  int levels;                                         // 高さマップの詳細度の数
+  bool tiled;                                         // 高さマップをタイルで参照するなら true
+  bool shadow;                                        // 遮蔽を調べるなら true
+  int occluders;                                      // 受光面の数
+  float footprint;                                    // 標本点ひとつが受け持つ鏡の範囲の一辺の長さ (0 なら広げない)
+  int pilot;                                          // 分散を見積もる試し描きの標本点の数 (0 なら配分しない)
+  int limit;                                          // 画素ごとに配分する標本点の数の上限
+};
+
+// 変換行列
+uniform mat4 mv;                                      // シーンのモデルビュー変換行列
+
+// テクスチャ
+uniform sampler2DArray height;                        // 鏡の高さマップのテクスチャ配列
+
+// 高さマップのタイル
+uniform usampler2D pages;                             // 高さマップのページテーブル
+uniform sampler2D atlas;                              // 高さマップのタイルキャッシュ
+
+// 高さマップの勾配のモーメント
+uniform sampler2DArray gradients;                     // 勾配 (右 - 左, 上 - 下) の平均
+uniform sampler2DArray products;                      // 勾配の積 (x², y², xy) の平均
+
+// フレームバッファに出力するデータ
+layout (location = 0) out vec4 position;              // 視点座標系における標本点の位置
+layout (location = 1) out vec4 normal;                // 視点座標系における標本点の法線ベクトル
+layout (location = 2) out vec4 light;                 // 視点座標系における標本点から全体光源に向かう単位ベクトル
+layout (location = 3) out vec4 diffuse;               // 標本点の全体光源による拡散反射光強度
+layout (location = 4) out vec4 reflection;            // 標本点で反射した平行光線か点光源の光の方向
+layout (location = 5) out vec4 covariance;            // 標本点が受け持つ範囲の鏡のローカル座標系における勾配の共分散
+
+// 鏡の高さマップのレイヤ layer の勾配 (右 - 左, 上 - 下) を詳細度 0 の画素間隔で求める
+vec2 slope(in vec2 uv, in float layer, in int level)
+{
+  // タイル化していなければ高さマップのテクスチャ配列を直接参照する
+  if (!tiled) return vec2(
+    textureOffset(height, vec3(uv, layer), ivec2(1, 0)).r - textureOffset(height, vec3(uv, layer), ivec2(-1, 0)).r,
+    textureOffset(height, vec3(uv, layer), ivec2(0, 1)).r - textureOffset(height, vec3(uv, layer), ivec2(0, -1)).r);
+
+  // 要求する詳細度の画素位置とタイル
+  float s = exp2(float(level));
+  vec2 t = clamp(uv, 0.0, 1.0) * tiling.xy / s;
+  ivec2 tile = min(ivec2(t / tiling.z), ivec2(ceil(tiling.xy / (s * tiling.z))) - 1);
+
+  // ページテーブルからタイルキャッシュのスロットと常駐している詳細度を求める
+  uvec4 page = texelFetch(pages, tile, level);
+  int shift = int(page.z) - level;
+
+  // 常駐している詳細度のタイル内の画素位置
+  float r = exp2(float(shift));
+  vec2 local = t / r - vec2(tile >> shift) * tiling.z;
+
+  // タイルキャッシュのテクスチャ座標と画素間隔
+  vec2 size = vec2(textureSize(atlas, 0));
+  vec2 a = (vec2(page.xy) * (tiling.z + 2.0 * tiling.w) + tiling.w + local) / size;
+  vec2 d = 1.0 / size;
+
+  // 常駐している詳細度の画素間隔を詳細度 0 の画素間隔に換算する
+  return vec2(
+    textureLod(atlas, a + vec2(d.x, 0.0), 0.0).r - textureLod(atlas, a - vec2(d.x, 0.0), 0.0).r,
+    textureLod(atlas, a + vec2(0.0, d.y), 0.0).r - textureLod(atlas, a - vec2(0.0, d.y), 0.0).r) / (s * r);
+}
+
+void main(void)
+{
+  // 横が標本点, 縦が鏡のインスタンス
+  ivec2 index = ivec2(gl_FragCoord.xy);
+
+  // 鏡の姿勢と高さマップのパラメータ
+  mat4 mm = pose[index.y];
+  vec4 mirror = param[index.y];
+
+  // 鏡のローカル座標系における標本点の位置
+  vec4 p = point[(index.x + offset) % point.length()];
+
+  // 視点座標系における標本点の位置
+  position = mm * p;
+
+  // 標本点のテクスチャ座標（鏡の描画と同じく Y 軸は反転しない）
+  vec2 uv = p.xy * 0.5 + 0.5;
+
+  // 標本点の勾配
+  vec2 g;
+
+  if (footprint > 0.0)
+  {
+    // 標本点が受け持つ範囲に合わせた詳細度で勾配とその積の平均を求める (LEAN mapping)
+    vec2 size = vec2(textureSize(gradients, 0).xy);
+    float lod = log2(footprint * max(size.x, size.y));
+    vec2 b = textureLod(gradients, vec3(uv, mirror.y), lod).xy;
+    vec3 m = textureLod(products, vec3(uv, mirror.y), lod).xyz;
+
+    // 勾配の共分散 (xx, yy, xy) は高さのスケールの 2 乗に比例する (丸め誤差で半正定値でなくならないようにする)
+    vec2 v = max(m.xy - b * b, 0.0);
+    float r = sqrt(v.x * v.y);
+    vec3 sigma = vec3(v, clamp(m.z - b.x * b.y, -r, r)) * mirror.x * mirror.x;
+    covariance = vec4(sigma, 0.0);
+    g = b;
+  }
+  else
+  {
+    // 勾配の分布で広げないなら標本点の位置の勾配だけを使う
+    covariance = vec4(0.0);
+    g = slope(uv, mirror.y, 0);
+  }
+
+  // 視点座標系における標本点の法線ベクトル
+  vec3 n = mat3(mm) * normalize(vec3(-g * mirror.x, 1.0));
+  normal = vec4(n, 0.0);
+
+  // 視点座標系における全体光源の位置
+  vec4 vl = mv * lpos;
+
+  // 視点座標系における標本点から全体光源に向かう単位ベクトル
+  vec3 l = normalize((vl * position.w - position * vl.w).xyz);
+  light = vec4(l, 0.0);
+
+  // 全体光源による拡散反射光強度は受光面によらない
+  diffuse = max(dot(n, l), 0.0) * mdiff * ldiff * 0.318309886;
+
+  // 平行光線は投影光源の向き, 点光源は投影光源の位置から標本点に向かう方向に入射する
+  vec3 incident = type == 1 ? ml[2].xyz : normalize((position * ml[3].w - ml[3] * position.w).xyz);
+
+  // 反射した光の方向は受光面によらない (矩形の投影光源では使わない)
+  reflection = vec4(reflect(incident, n), 0.0);
+}
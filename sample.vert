@@ -0,0 +1,16 @@
+#version 410 core
+
+//
+// sample.vert
+//
+//   鏡の標本点マップ全体を覆う矩形を描画するシェーダ
+//
+
+void main(void)
+{
+  // 矩形の頂点のテクスチャ座標
+  vec2 tc = vec2(gl_VertexID % 2, gl_VertexID / 2);
+
+  // 標本点マップ全体を覆うクリッピング座標系の頂点位置
+  gl_Position = vec4(tc * 2.0 - 1.0, 0.0, 1.0);
+}
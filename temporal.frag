@@ -0,0 +1,67 @@
+#version 410 core
+
+//
+// temporal.frag
+//
+//   前のフレームまでに混ぜた反射光を再投影してこのフレームの反射光と混ぜるシェーダ
+//
+
+// このフレームの投影光源による反射光
+uniform sampler2D caustic;                            // このフレームの反射光
+uniform sampler2D geometry;                           // このフレームの画素の法線ベクトルと奥行き
+
+// 前のフレームの履歴
+uniform sampler2D history;                            // 前のフレームまでに混ぜた反射光 (a は混ぜたフレーム数)
+uniform sampler2D previous;                           // 前のフレームの画素の法線ベクトルと奥行き
+uniform bool valid;                                   // 前のフレームの履歴が使えるなら true
+
+// 変換行列
+uniform mat4 mp;                                      // 投影変換行列
+uniform mat4 reprojection;                            // このフレームの視点座標系から前のフレームの視点座標系への変換行列
+
+// 混ぜるフレーム数の上限
+uniform float frames;
+
+// フレームバッファに出力するデータ
+layout (location = 0) out vec4 fc;                    // 混ぜた反射光と混ぜたフレーム数
+layout (location = 1) out vec4 fg;                    // 画素の法線ベクトルと奥行き
+
+void main(void)
+{
+  // このフレームの反射光と法線ベクトルと奥行き
+  ivec2 p = ivec2(gl_FragCoord.xy);
+  vec4 c = texelFetch(caustic, p, 0);
+  vec4 g = texelFetch(geometry, p, 0);
+
+  // 履歴が使えないか受光面の無い画素 (奥行きが 0) ならこのフレームの反射光だけにする
+  fc = vec4(c.rgb, 1.0);
+  fg = g;
+  if (!valid || g.w <= 0.0) return;
+
+  // 画素の視点座標系における位置を奥行きから復元する
+  vec2 ndc = gl_FragCoord.xy / vec2(textureSize(geometry, 0)) * 2.0 - 1.0;
+  vec4 vp = vec4(ndc.x * g.w / mp[0][0], ndc.y * g.w / mp[1][1], -g.w, 1.0);
+
+  // 前のフレームの視点座標系における位置と画面上の位置
+  vec4 q = reprojection * vp;
+  vec4 r = mp * q;
+  if (r.w <= 0.0) return;
+  vec2 t = r.xy / r.w * 0.5 + 0.5;
+
+  // 前のフレームの画面の外なら捨てる
+  if (any(lessThan(t, vec2(0.0))) || any(greaterThanEqual(t, vec2(1.0)))) return;
+
+  // 前のフレームの同じ位置の画素
+  ivec2 s = ivec2(t * vec2(textureSize(previous, 0)));
+  vec4 h = texelFetch(previous, s, 0);
+
+  // 奥行きか法線ベクトルが合わなければ前のフレームでは隠れていたものとして捨てる
+  float z = -q.z / q.w;
+  if (h.w <= 0.0 || abs(h.w - z) > 0.02 * z) return;
+  if (dot(mat3(reprojection) * g.xyz, h.xyz) < 0.9) return;
+
+  // 混ぜたフレーム数に応じた重みでこのフレームの反射光を混ぜる
+  vec4 a = texelFetch(history, s, 0);
+  float n = min(a.a + 1.0, frames);
+  fc = vec4(mix(a.rgb, c.rgb, 1.0 / n), n);
+}